@@ -48,6 +48,9 @@
 #include "libslic3r/Thread.hpp"
 #include "libslic3r/BlacklistedLibraryCheck.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include "PrusaSlicer.hpp"
 
 #ifdef SLIC3R_GUI
@@ -486,20 +489,8 @@ int CLI::run(int argc, char **argv)
                 // is supplied); if any object has no instances, it will get a default one
                 // and all instances will be rearranged (unless --dont-arrange is supplied).
                 std::string outfile = m_config.opt_string("output");
-                Print       fff_print;
-                SLAPrint    sla_print;
-                std::shared_ptr<SLAAbstractArchive> sla_archive = Slic3r::get_output_format(m_print_config);
-
-                sla_print.set_printer(sla_archive);
-                sla_print.set_status_callback(
-                            [](const PrintBase::SlicingStatus& s)
-                {
-                    if(s.percent >= 0 && s.args.empty()) // FIXME: is this sufficient?
-                        printf("%3d%s %s\n", s.percent, "% =>", s.main_text.c_str());
-                });
-
-                PrintBase  *print = (printer_technology == ptFFF) ? static_cast<PrintBase*>(&fff_print) : static_cast<PrintBase*>(&sla_print);
-                
+                // The plates of the model with --plates, each one is printed separately.
+                std::vector<Model> plates;
                 if (! m_config.opt_bool("dont_arrange")) {
                     ArrangeParams arrange_cfg;
                     arrange_cfg.min_obj_distance = scaled(min_object_distance(&m_print_config)) * 2;
@@ -507,61 +498,49 @@ int CLI::run(int argc, char **argv)
                         arrange_cfg.min_obj_distance += scaled(m_print_config.opt_float("duplicate_distance"));
                     else
                         arrange_cfg.min_obj_distance += 6;
-                    if (dups > 1) {
-                            try {
-                            // if all input objects have defined position(s) apply duplication to the whole model
-                            duplicate(model, size_t(dups), bed, arrange_cfg);
+                    if (m_config.opt_bool("plates")) {
+                        if (user_center_specified) {
+                            boost::nowide::cerr << "error: --center can't be combined with --plates, the plates are arranged on the bed" << std::endl;
+                            return 1;
+                        }
+                        // The copies are arranged with the other objects, over as many beds as needed.
+                        try {
+                            if (dups > 1)
+                                duplicate_objects(model, size_t(dups));
+                            plates = arrange_plates(model, bed, arrange_cfg);
                         } catch (std::exception & ex) {
                             boost::nowide::cerr << "error: " << ex.what() << std::endl;
                             return 1;
                         }
-                    }
-                    if (user_center_specified) {
-                        Vec2d c = m_config.option<ConfigOptionPoint>("center")->value;
-                        arrange_objects(model, InfiniteBed{scaled(c)}, arrange_cfg);
-                    } else
-                        arrange_objects(model, bed, arrange_cfg);
-                }
-                if (printer_technology == ptFFF) {
-                    for (auto* mo : model.objects)
-                        fff_print.auto_assign_extruders(mo);
-                }
-                print->apply(model, m_print_config);
-                std::pair<PrintBase::PrintValidationError, std::string> err = print->validate();
-                if (err.first != PrintBase::PrintValidationError::pveNone) {
-                    boost::nowide::cerr << err.second << std::endl;
-                    return 1;
-                }
-                if (print->empty())
-                    boost::nowide::cout << "Nothing to print for " << outfile << " . Either the print is empty or no object is fully inside the print volume." << std::endl;
-                else
-                    try {
-                        std::string outfile_final;
-                        print->process();
-                        if (printer_technology == ptFFF) {
-                            // The outfile is processed by a PlaceholderParser.
-                            outfile = fff_print.export_gcode(outfile, nullptr, nullptr);
-                            outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
-                        } else if (printer_technology == ptSLA) {
-                            outfile = sla_print.output_filepath(outfile);
-                            // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
-                            outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
-                            sla_archive->export_print(outfile_final, sla_print);
-                        }
-                        if (outfile != outfile_final) {
-                            if (Slic3r::rename_file(outfile, outfile_final)) {
-                                boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
+                    } else {
+                        if (dups > 1) {
+                            try {
+                                // if all input objects have defined position(s) apply duplication to the whole model
+                                duplicate(model, size_t(dups), bed, arrange_cfg);
+                            } catch (std::exception & ex) {
+                                boost::nowide::cerr << "error: " << ex.what() << std::endl;
                                 return 1;
                             }
-                            outfile = outfile_final;
                         }
-                        // Run the post-processing scripts if defined.
-                        run_post_process_scripts(outfile, fff_print.full_print_config());
-                        boost::nowide::cout << "Slicing result exported to " << outfile << std::endl;
-                    } catch (const std::exception &ex) {
-                        boost::nowide::cerr << ex.what() << std::endl;
-                        return 1;
+                        if (user_center_specified) {
+                            Vec2d c = m_config.option<ConfigOptionPoint>("center")->value;
+                            arrange_objects(model, InfiniteBed{scaled(c)}, arrange_cfg);
+                        } else
+                            arrange_objects(model, bed, arrange_cfg);
                     }
+                }
+                if (plates.size() > 1) {
+                    // Slice the plates concurrently, sharing the meshes and the configuration, one output file per plate.
+                    std::vector<char> exported(plates.size(), false);
+                    tbb::parallel_for(tbb::blocked_range<size_t>(0, plates.size(), 1),
+                        [this, &plates, &exported, &outfile, printer_technology](const tbb::blocked_range<size_t> &range) {
+                            for (size_t plate_idx = range.begin(); plate_idx < range.end(); ++ plate_idx)
+                                exported[plate_idx] = this->export_print(plates[plate_idx], printer_technology, outfile, plate_idx + 1);
+                        });
+                    if (std::find(exported.begin(), exported.end(), false) != exported.end())
+                        return 1;
+                } else if (! this->export_print(plates.empty() ? model : plates.front(), printer_technology, outfile))
+                    return 1;
 /*
                 print.center = ! m_config.has("center")
                     && ! m_config.has("align_xy")
@@ -712,6 +691,7 @@ bool CLI::setup(int argc, char **argv)
             m_config.option(optdef.first, true);
 
     set_data_dir(m_config.opt_string("datadir"));
+    set_slicing_cache_dir(m_config.opt_string("slicing_cache"));
     
     //FIXME Validating at this stage most likely does not make sense, as the config is not fully initialized yet.
     if (!validity.empty()) {
@@ -767,6 +747,77 @@ void CLI::print_help(bool include_print_options, PrinterTechnology printer_techn
     }
 }
 
+bool CLI::export_print(Model &model, PrinterTechnology printer_technology, std::string outfile, size_t plate) const
+{
+    Print       fff_print;
+    SLAPrint    sla_print;
+    // The same part is often loaded several times from separate files, slice it only once.
+    fff_print.set_merge_identical_objects(true);
+    // Spill the sliced layers to a scratch file over the memory budget.
+    fff_print.set_layer_memory_budget(size_t(std::max(m_config.opt_int("layer_memory"), 0)) << 20);
+    // Write the G-code next to the output only once, with its time estimates.
+    fff_print.set_gcode_spool(m_config.opt_bool("gcode_spool"));
+    std::shared_ptr<SLAAbstractArchive> sla_archive = Slic3r::get_output_format(m_print_config);
+    // Rasterize the layers while writing the archive, not to keep all of them in memory.
+    sla_archive->set_streaming(size_t(std::max(m_config.opt_int("sla_archive_memory"), 0)) << 20);
+
+    sla_print.set_printer(sla_archive);
+    sla_print.set_status_callback(
+                [](const PrintBase::SlicingStatus& s)
+    {
+        if(s.percent >= 0 && s.args.empty()) // FIXME: is this sufficient?
+            printf("%3d%s %s\n", s.percent, "% =>", s.main_text.c_str());
+    });
+
+    PrintBase  *print = (printer_technology == ptFFF) ? static_cast<PrintBase*>(&fff_print) : static_cast<PrintBase*>(&sla_print);
+    if (printer_technology == ptFFF) {
+        for (auto* mo : model.objects)
+            fff_print.auto_assign_extruders(mo);
+    }
+    print->apply(model, m_print_config);
+    std::pair<PrintBase::PrintValidationError, std::string> err = print->validate();
+    if (err.first != PrintBase::PrintValidationError::pveNone) {
+        boost::nowide::cerr << err.second << std::endl;
+        return false;
+    }
+    if (plate > 0) {
+        // One output file per plate.
+        boost::filesystem::path path(print->output_filepath(outfile));
+        outfile = (path.parent_path() / (path.stem().string() + "_plate" + std::to_string(plate) + path.extension().string())).string();
+    }
+    if (print->empty())
+        boost::nowide::cout << "Nothing to print for " << outfile << " . Either the print is empty or no object is fully inside the print volume." << std::endl;
+    else
+        try {
+            std::string outfile_final;
+            print->process();
+            if (printer_technology == ptFFF) {
+                // The outfile is processed by a PlaceholderParser.
+                outfile = fff_print.export_gcode(outfile, nullptr, nullptr);
+                outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
+            } else if (printer_technology == ptSLA) {
+                outfile = sla_print.output_filepath(outfile);
+                // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
+                outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
+                sla_archive->export_print(outfile_final, sla_print);
+            }
+            if (outfile != outfile_final) {
+                if (Slic3r::rename_file(outfile, outfile_final)) {
+                    boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
+                    return false;
+                }
+                outfile = outfile_final;
+            }
+            // Run the post-processing scripts if defined.
+            run_post_process_scripts(outfile, fff_print.full_print_config());
+            boost::nowide::cout << "Slicing result exported to " << outfile << std::endl;
+        } catch (const std::exception &ex) {
+            boost::nowide::cerr << ex.what() << std::endl;
+            return false;
+        }
+    return true;
+}
+
 bool CLI::export_models(IO::ExportFormat format)
 {
     for (Model &model : m_models) {
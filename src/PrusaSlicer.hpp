@@ -39,6 +39,10 @@ private:
     
     /// Exports loaded models to a file of the specified format, according to the options affecting output filename.
     bool export_models(IO::ExportFormat format);
+
+    /// Slices a model and exports the G-code or the SLA archive, the output file of a plate of a batch (plate > 0) is suffixed with its number.
+    /// Each call has its own Print, the configuration and the meshes of the model are only read: the plates are sliced and exported concurrently.
+    bool export_print(Model &model, PrinterTechnology printer_technology, std::string outfile, size_t plate = 0) const;
     
     bool has_print_action() const { return m_config.opt_bool("export_gcode") || m_config.opt_bool("export_sla"); }
     
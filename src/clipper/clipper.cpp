@@ -40,6 +40,8 @@
 
 #include "clipper.hpp"
 #include <cmath>
+#include <cstddef>
+#include <new>
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
@@ -776,6 +778,77 @@ TEdge* ClipperBase::ProcessBound(TEdge* E, bool NextIsForward)
 }
 //------------------------------------------------------------------------------
 
+MemoryArena::~MemoryArena()
+{
+  assert(m_users == 0);
+  for (Block &block : m_blocks)
+    ::operator delete(block.data);
+}
+//------------------------------------------------------------------------------
+
+void* MemoryArena::Allocate(size_t size, size_t align)
+{
+  // The blocks are allocated by operator new, which aligns them for any fundamental type.
+  assert(align <= alignof(std::max_align_t) && (align & (align - 1)) == 0);
+  for (;;) {
+    if (m_block == m_blocks.size()) {
+      // No more free memory, allocate a new block (bigger than BlockSize for a big array).
+      size_t block_size = std::max(size, BlockSize);
+      m_blocks.push_back({ static_cast<char*>(::operator new(block_size)), block_size });
+      m_offset = 0;
+    }
+    const Block &block  = m_blocks[m_block];
+    size_t       offset = (m_offset + align - 1) & ~(align - 1);
+    if (offset + size <= block.size) {
+      m_offset = offset + size;
+      return block.data + offset;
+    }
+    // The rest of this block is too small, continue with the next one.
+    ++ m_block;
+    m_offset = 0;
+  }
+}
+//------------------------------------------------------------------------------
+
+size_t MemoryArena::Capacity() const
+{
+  size_t capacity = 0;
+  for (const Block &block : m_blocks)
+    capacity += block.size;
+  return capacity;
+}
+//------------------------------------------------------------------------------
+
+void MemoryArena::Rewind()
+{
+  size_t retained = 0;
+  size_t num_retained = 0;
+  for (; num_retained < m_blocks.size() && retained + m_blocks[num_retained].size <= MaxRetained; ++ num_retained)
+    retained += m_blocks[num_retained].size;
+  for (size_t i = num_retained; i < m_blocks.size(); ++ i)
+    ::operator delete(m_blocks[i].data);
+  m_blocks.resize(num_retained);
+  m_block  = 0;
+  m_offset = 0;
+}
+//------------------------------------------------------------------------------
+
+MemoryArena& MemoryArena::ThreadArena()
+{
+  static thread_local MemoryArena arena;
+  return arena;
+}
+//------------------------------------------------------------------------------
+
+TEdge* ClipperBase::AllocateEdges(size_t num_edges)
+{
+  if (m_arena)
+    return m_arena->AllocateArray<TEdge>(num_edges);
+  m_edges.emplace_back(num_edges);
+  return m_edges.back().data();
+}
+//------------------------------------------------------------------------------
+
 bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
 {
   CLIPPERLIB_PROFILE_FUNC();
@@ -791,12 +864,12 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
     return false;
 
   // Allocate a new edge array.
-  std::vector<TEdge> edges(highI + 1);
+  TEdge *edges = AllocateEdges(highI + 1);
   // Fill in the edge array.
-  bool result = AddPathInternal(pg, highI, PolyTyp, Closed, edges.data());
-  if (result)
-    // Success, remember the edge array.
-    m_edges.emplace_back(std::move(edges));
+  bool result = AddPathInternal(pg, highI, PolyTyp, Closed, edges);
+  if (! result)
+    // Failure, forget the edge array.
+    FreeLastEdges();
   return result;
 }
 
@@ -1064,8 +1137,8 @@ IntRect ClipperBase::GetBounds()
 // TClipper methods ...
 //------------------------------------------------------------------------------
 
-Clipper::Clipper(int initOptions) : 
-  ClipperBase(),
+Clipper::Clipper(int initOptions, MemoryArena *arena) : 
+  ClipperBase(arena),
   m_OutPtsFree(nullptr),
   m_OutPtsChunkSize(32),
   m_OutPtsChunkLast(32),
@@ -1211,7 +1284,7 @@ OutPt* Clipper::AllocateOutPt()
     pt = m_OutPts.back() + (m_OutPtsChunkLast ++);
   } else {
     // The last chunk is full. Allocate a new one.
-    m_OutPts.push_back(new OutPt[m_OutPtsChunkSize]);
+    m_OutPts.push_back(m_arena ? m_arena->AllocateArray<OutPt>(m_OutPtsChunkSize) : new OutPt[m_OutPtsChunkSize]);
     m_OutPtsChunkLast = 1;
     pt = m_OutPts.back();
   }
@@ -1220,10 +1293,13 @@ OutPt* Clipper::AllocateOutPt()
 
 void Clipper::DisposeAllOutRecs()
 {
-  for (OutPt *pts : m_OutPts)
-    delete[] pts;
-  for (OutRec *rec : m_PolyOuts)
-    delete rec;
+  // The output points & records allocated from the arena are released by the arena.
+  if (! m_arena) {
+    for (OutPt *pts : m_OutPts)
+      delete[] pts;
+    for (OutRec *rec : m_PolyOuts)
+      delete rec;
+  }
   m_OutPts.clear();
   m_OutPtsFree = nullptr;
   m_OutPtsChunkLast = m_OutPtsChunkSize;
@@ -2010,7 +2086,7 @@ void Clipper::AppendPolygon(TEdge *e1, TEdge *e2) const
 
 OutRec* Clipper::CreateOutRec()
 {
-  OutRec* result = new OutRec;
+  OutRec* result = m_arena ? new (m_arena->Allocate(sizeof(OutRec), alignof(OutRec))) OutRec : new OutRec;
   result->IsHole = false;
   result->IsOpen = false;
   result->FirstLeft = 0;
@@ -3376,7 +3452,10 @@ DoublePoint GetUnitNormal(const IntPoint &pt1, const IntPoint &pt2)
 void ClipperOffset::Clear()
 {
   for (int i = 0; i < m_polyNodes.ChildCount(); ++i)
-    delete m_polyNodes.Childs[i];
+    if (m_arena)
+      m_polyNodes.Childs[i]->~PolyNode();
+    else
+      delete m_polyNodes.Childs[i];
   m_polyNodes.Childs.clear();
   m_lowest.x() = -1;
 }
@@ -3386,7 +3465,7 @@ void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType
 {
   int highI = (int)path.size() - 1;
   if (highI < 0) return;
-  PolyNode* newNode = new PolyNode();
+  PolyNode* newNode = m_arena ? new (m_arena->Allocate(sizeof(PolyNode), alignof(PolyNode))) PolyNode() : new PolyNode();
   newNode->m_jointype = joinType;
   newNode->m_endtype = endType;
 
@@ -3426,7 +3505,10 @@ void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType
   }
   if (endType == etClosedPolygon && j < 2)
   {
-    delete newNode;
+    if (m_arena)
+      newNode->~PolyNode();
+    else
+      delete newNode;
     return;
   }
   m_polyNodes.AddChild(*newNode);
@@ -3479,7 +3561,7 @@ void ClipperOffset::Execute(Paths& solution, double delta)
   DoOffset(delta);
   
   //now clean up 'corners' ...
-  Clipper clpr;
+  Clipper clpr(0, m_arena);
   clpr.AddPaths(m_destPolys, ptSubject, true);
   if (delta > 0)
   {
@@ -3510,7 +3592,7 @@ void ClipperOffset::Execute(PolyTree& solution, double delta)
   DoOffset(delta);
 
   //now clean up 'corners' ...
-  Clipper clpr;
+  Clipper clpr(0, m_arena);
   clpr.AddPaths(m_destPolys, ptSubject, true);
   if (delta > 0)
   {
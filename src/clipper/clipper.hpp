@@ -287,18 +287,64 @@ enum EdgeSide { esLeft = 1, esRight = 2};
 
 //------------------------------------------------------------------------------
 
+// Monotonic memory arena for the working structures of Clipper and ClipperOffset (edges, output records & points, offset contours):
+// the many small allocations of an operation become pointer bumps in big blocks, which don't hit the (contended) global heap.
+// The memory is rewound, not freed, when the last Clipper / ClipperOffset using the arena is destroyed,
+// to be reused by the next operation. It's not thread safe: use the arena of the calling thread, see ThreadArena().
+class MemoryArena
+{
+public:
+  MemoryArena() = default;
+  ~MemoryArena();
+  MemoryArena(const MemoryArena &) = delete;
+  MemoryArena& operator=(const MemoryArena &) = delete;
+
+  // The memory is not initialized.
+  void*       Allocate(size_t size, size_t align);
+  template<typename T>
+  T*          AllocateArray(size_t n) { return static_cast<T*>(Allocate(n * sizeof(T), alignof(T))); }
+  // Called by the Clippers using the arena, the memory is rewound when the last one releases it.
+  void        Acquire() { ++ m_users; }
+  void        Release() { if (-- m_users == 0) Rewind(); }
+  // Size of the blocks allocated so far.
+  size_t      Capacity() const;
+
+  // Arena of the calling thread, created at the first call.
+  static MemoryArena& ThreadArena();
+
+  static constexpr const size_t BlockSize   = 256 * 1024;
+  // Blocks over this size are freed when rewinding, so that a single big operation doesn't keep its memory for the lifetime of the thread.
+  static constexpr const size_t MaxRetained = 16 * 1024 * 1024;
+
+private:
+  void        Rewind();
+
+  struct Block {
+    char   *data;
+    size_t  size;
+  };
+  std::vector<Block> m_blocks;
+  // Current block and the first free byte in it.
+  size_t             m_block  { 0 };
+  size_t             m_offset { 0 };
+  int                m_users  { 0 };
+};
+
+//------------------------------------------------------------------------------
+
 //ClipperBase is the ancestor to the Clipper class. It should not be
 //instantiated directly. This class simply abstracts the conversion of sets of
 //polygon coordinates into edge objects that are stored in a LocalMinima list.
 class ClipperBase
 {
 public:
-  ClipperBase() : 
+  // If arena is set, the edges are allocated from the arena.
+  ClipperBase(MemoryArena *arena = nullptr) : 
 #ifndef CLIPPERLIB_INT32
     m_UseFullRange(false), 
 #endif // CLIPPERLIB_INT32
-    m_HasOpenPaths(false) {}
-  ~ClipperBase() { Clear(); }
+    m_HasOpenPaths(false), m_arena(arena) { if (m_arena) m_arena->Acquire(); }
+  ~ClipperBase() { Clear(); if (m_arena) m_arena->Release(); }
   bool AddPath(const Path &pg, PolyType PolyTyp, bool Closed);
 
   template<typename PathsProvider>
@@ -331,10 +377,10 @@ public:
       return false;
 
     // Allocate a new edge array.
-    std::vector<TEdge> edges(num_edges_total);
+    TEdge *edges = AllocateEdges(num_edges_total);
     // Fill in the edge array.
     bool result = false;
-    TEdge *p_edge = edges.data();
+    TEdge *p_edge = edges;
     i = 0;
     for (const Path &pg : paths_provider) {
       if (num_edges[i]) {
@@ -346,9 +392,9 @@ public:
       }
       ++ i;
     }
-    if (result)
-      // At least some edges were generated. Remember the edge array.
-      m_edges.emplace_back(std::move(edges));
+    if (! result)
+      // No edge was generated, forget the edge array.
+      FreeLastEdges();
     return result;
   }
 
@@ -359,6 +405,10 @@ public:
   bool PreserveCollinear() const {return m_PreserveCollinear;};
   void PreserveCollinear(bool value) {m_PreserveCollinear = value;};
 protected:
+  // Allocate an array of edges, from the arena or from m_edges.
+  TEdge* AllocateEdges(size_t num_edges);
+  // Release the edges returned by the last call to AllocateEdges().
+  void FreeLastEdges() { if (! m_arena) m_edges.pop_back(); }
   bool AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
   TEdge* AddBoundsToLML(TEdge *e, bool IsClosed);
   void Reset();
@@ -377,8 +427,9 @@ protected:
   bool              m_UseFullRange;
 #endif // CLIPPERLIB_INT32
 
-  // A vector of edges per each input path.
+  // A vector of edges per each input path, if not allocated from m_arena.
   std::vector<std::vector<TEdge>> m_edges;
+  MemoryArena     *m_arena;
   // Don't remove intermediate vertices of a collinear sequence of points.
   bool             m_PreserveCollinear;
   // Is any of the paths inserted by AddPath() or AddPaths() open?
@@ -389,7 +440,8 @@ protected:
 class Clipper : public ClipperBase
 {
 public:
-  Clipper(int initOptions = 0);
+  // If arena is set, the edges and the output records & points are allocated from the arena.
+  Clipper(int initOptions = 0, MemoryArena *arena = nullptr);
   ~Clipper() { Clear(); }
   void Clear() { ClipperBase::Clear(); DisposeAllOutRecs(); }
   bool Execute(ClipType clipType,
@@ -508,9 +560,12 @@ private:
 class ClipperOffset 
 {
 public:
-  ClipperOffset(double miterLimit = 2.0, double roundPrecision = 0.25, double shortestEdgeLength = 0.) :
-    MiterLimit(miterLimit), ArcTolerance(roundPrecision), ShortestEdgeLength(shortestEdgeLength), m_lowest(-1, 0) {}
-  ~ClipperOffset() { Clear(); }
+  // If arena is set, the contours and the working structures of the final union are allocated from the arena.
+  ClipperOffset(double miterLimit = 2.0, double roundPrecision = 0.25, double shortestEdgeLength = 0., MemoryArena *arena = nullptr) :
+    MiterLimit(miterLimit), ArcTolerance(roundPrecision), ShortestEdgeLength(shortestEdgeLength), m_lowest(-1, 0), m_arena(arena)
+    { if (m_arena) m_arena->Acquire(); }
+  explicit ClipperOffset(MemoryArena *arena) : ClipperOffset(2.0, 0.25, 0., arena) {}
+  ~ClipperOffset() { Clear(); if (m_arena) m_arena->Release(); }
   void AddPath(const Path& path, JoinType joinType, EndType endType);
   template<typename PathsProvider>
   void AddPaths(PathsProvider &&paths, JoinType joinType, EndType endType) {
@@ -535,6 +590,7 @@ private:
   // y: index of the lowest point in the lowest contour
   IntPoint m_lowest;
   PolyNode m_polyNodes;
+  MemoryArena *m_arena;
 
   void FixOrientations();
   void DoOffset(double delta);
@@ -4,10 +4,16 @@
 #include <cassert>
 
 // For parallel for
+#include <algorithm>
 #include <functional>
 #include <iterator>
 #include <future>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
 
 #ifndef NDEBUG
 #include <iostream>
@@ -25,6 +31,148 @@
 namespace libnest2d {
 namespace placers {
 
+/**
+ * @brief A cache of the no-fit polygons of pairs of items, to be shared by the
+ * placers of subsequent nestings (e.g. arranging the same objects again).
+ *
+ * The no-fit polygon of two items only depends on their shapes, inflations
+ * and rotations, it follows the translation of the stationary item. The
+ * cache is keyed by hashes of these and stores the no-fit polygons of the
+ * stationary items at zero translation, with a copy of the contours,
+ * inflations and rotations of both items: a hit is only returned if they are
+ * the same, so that two pairs of items with the same hashes can't get the
+ * no-fit polygon of each other. It is thread safe, so it can be filled by the
+ * parallel computation of the no-fit polygons.
+ */
+template<class RawShape>
+class NfpCache {
+    using Vertex = TPoint<RawShape>;
+    using Coord = TCoord<Vertex>;
+public:
+    /// The hashes of the stationary and the orbiting items.
+    using Key = std::pair<std::size_t, std::size_t>;
+
+    /// What the no-fit polygon depends on: the contour, inflation and
+    /// rotation of an item.
+    class Shape {
+    public:
+        explicit Shape(const _Item<RawShape>& item):
+            contour_(item.cbegin(), item.cend()),
+            inflation_(item.inflation()),
+            rotation_(double(item.rotation())) {}
+
+        bool operator==(const Shape& other) const
+        {
+            return inflation_ == other.inflation_ &&
+                   rotation_ == other.rotation_ &&
+                   std::equal(contour_.begin(), contour_.end(),
+                              other.contour_.begin(), other.contour_.end(),
+                              [](const Vertex& v1, const Vertex& v2) {
+                                  return getX(v1) == getX(v2) &&
+                                         getY(v1) == getY(v2);
+                              });
+        }
+
+        std::size_t size() const { return contour_.size(); }
+
+    private:
+        std::vector<Vertex> contour_;
+        Coord inflation_;
+        double rotation_;
+    };
+
+    /// The cache is cleared when its polygons reach max_points vertices,
+    /// the contours of the items included.
+    explicit NfpCache(std::size_t max_points = 1000000):
+        max_points_(max_points) {}
+
+    /// Hash of the contour, inflation and rotation of an item.
+    static std::size_t hash(const _Item<RawShape>& item)
+    {
+        std::size_t seed = 0;
+        auto combine = [&seed](std::size_t h) {
+            seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+        for(auto it = item.cbegin(); it != item.cend(); ++it) {
+            combine(std::hash<Coord>()(getX(*it)));
+            combine(std::hash<Coord>()(getY(*it)));
+        }
+        combine(std::hash<Coord>()(item.inflation()));
+        combine(std::hash<double>()(double(item.rotation())));
+        return seed;
+    }
+
+    /// Copy the no-fit polygon of the stationary and orbiting shapes into
+    /// nfp, returns false if missing.
+    bool find(const Key& key, const Shape& stationary, const Shape& orbiter,
+              RawShape& nfp) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = nfps_.find(key);
+        if(it == nfps_.end() || !(it->second.stationary == stationary) ||
+           !(it->second.orbiter == orbiter))
+            return false;
+        nfp = it->second.nfp;
+        return true;
+    }
+
+    void insert(const Key& key, const Shape& stationary, const Shape& orbiter,
+                RawShape&& nfp)
+    {
+        std::size_t points = stationary.size() + orbiter.size() +
+                             shapelike::contourVertexCount(nfp);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if(points_ + points > max_points_) clear_locked();
+        // Replaces the polygon of another pair of items with the same hashes.
+        auto it = nfps_.find(key);
+        if(it != nfps_.end()) {
+            points_ -= it->second.points;
+            nfps_.erase(it);
+        }
+        nfps_.emplace(key, Entry{stationary, orbiter, std::move(nfp), points});
+        points_ += points;
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        clear_locked();
+    }
+
+    std::size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return nfps_.size();
+    }
+
+private:
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const
+        {
+            return key.first ^ (key.second + 0x9e3779b9 + (key.first << 6) +
+                                (key.first >> 2));
+        }
+    };
+
+    struct Entry {
+        Shape stationary;
+        Shape orbiter;
+        RawShape nfp;
+        std::size_t points;
+    };
+
+    void clear_locked()
+    {
+        nfps_.clear();
+        points_ = 0;
+    }
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<Key, Entry, KeyHash> nfps_;
+    std::size_t points_ = 0;
+    std::size_t max_points_;
+};
+
 template<class RawShape>
 struct NfpPConfig {
 
@@ -89,6 +237,13 @@ struct NfpPConfig {
      */
     bool parallel = true;
 
+    /**
+     * @brief If set, the no-fit polygons are looked up into this cache and
+     * stored into it, so that they are reused by the next packings of the
+     * same items, also by the next nestings sharing the cache.
+     */
+    std::shared_ptr<NfpCache<RawShape>> nfp_cache;
+
     /**
      * @brief before_packing Callback that is called just before a search for
      * a new item's position is started. You can use this to create various
@@ -562,14 +717,52 @@ private:
         }
         // /////////////////////////////////////////////////////////////////////
 
+        // The hashes of the items, keys of the no-fit polygons in the cache,
+        // and the shapes to check them against
+        using Cache = NfpCache<RawShape>;
+        Cache* cache = config_.nfp_cache.get();
+        std::size_t orbiter_hash = 0;
+        std::vector<std::size_t> hashes;
+        std::vector<typename Cache::Shape> shapes;
+        std::unique_ptr<typename Cache::Shape> orbiter;
+        if(cache) {
+            orbiter_hash = Cache::hash(trsh);
+            orbiter = std::make_unique<typename Cache::Shape>(trsh);
+            hashes.reserve(items_.size());
+            shapes.reserve(items_.size());
+            for(Item& itm : items_) {
+                hashes.emplace_back(Cache::hash(itm));
+                shapes.emplace_back(itm);
+            }
+        }
+
         __parallel::enumerate(items_.begin(), items_.end(),
-                              [&nfps, &trsh](const Item& sh, size_t n)
+                              [&nfps, &trsh, cache, &hashes, &shapes, &orbiter,
+                               orbiter_hash]
+                              (const Item& sh, size_t n)
         {
+            typename Cache::Key key;
+            if(cache) {
+                key = {hashes[n], orbiter_hash};
+                if(cache->find(key, shapes[n], *orbiter, nfps[n])) {
+                    shapelike::translate(nfps[n], sh.translation());
+                    return;
+                }
+            }
+
             auto& fixedp = sh.transformedShape();
             auto& orbp = trsh.transformedShape();
             auto subnfp_r = noFitPolygon<NfpLevel::CONVEX_ONLY>(fixedp, orbp);
             correctNfpPosition(subnfp_r, sh, trsh);
             nfps[n] = subnfp_r.first;
+
+            if(cache) {
+                // The no-fit polygon follows the translation of the
+                // stationary item
+                auto tr = sh.translation();
+                shapelike::translate(subnfp_r.first, Vertex(-getX(tr), -getY(tr)));
+                cache->insert(key, shapes[n], *orbiter, std::move(subnfp_r.first));
+            }
         });
 
         return nfp::merge(nfps);
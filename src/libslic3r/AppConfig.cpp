@@ -346,6 +346,9 @@ void AppConfig::set_defaults()
         if (get("export_sources_full_pathnames").empty())
             set("export_sources_full_pathnames", "0");
 
+        if (get("3mf_compression_level").empty())
+            set("3mf_compression_level", "6");
+
 #ifdef _WIN32
         if (get("associate_3mf").empty())
             set("associate_3mf", "0");
@@ -459,6 +462,10 @@ void AppConfig::set_defaults()
     if (get("seq_top_layer_only").empty())
         set("seq_top_layer_only", "1");
 
+    // Size of the G-code toolpaths kept on the gpu, in MB, 0 to use half of the video memory.
+    if (get("gcode_viewer_gpu_budget").empty())
+        set("gcode_viewer_gpu_budget", "0");
+
     if (get("use_perspective_camera").empty())
         set("use_perspective_camera", "1");
 
@@ -79,6 +79,20 @@ using ItemGroup = std::vector<std::reference_wrapper<Item>>;
 // A coefficient used in separating bigger items and smaller items.
 const double BIG_ITEM_TRESHOLD = 0.02;
 
+// Minimum count of identical items to arrange them on a lattice, see arrange_on_lattice().
+const size_t LATTICE_MIN_ITEMS = 10;
+
+// Vertices of the no-fit polygons (and of the contours of their items) kept in the cache, about 16MB.
+const size_t NFP_CACHE_MAX_POINTS = 1000000;
+
+// The no-fit polygons of the arranged objects are kept between the arrange() calls:
+// arranging the same objects again (or their copies) reuses them. The cache is emptied when it is full.
+static std::shared_ptr<placers::NfpCache<ExPolygon>> nfp_cache()
+{
+    static auto cache = std::make_shared<placers::NfpCache<ExPolygon>>(NFP_CACHE_MAX_POINTS);
+    return cache;
+}
+
 // Fill in the placer algorithm configuration with values carefully chosen for
 // Slic3r.
 template<class PConf>
@@ -103,6 +117,8 @@ void fill_config(PConf& pcfg, const ArrangeParams &params) {
     
     // Allow parallel execution.
     pcfg.parallel = params.parallel;
+
+    pcfg.nfp_cache = nfp_cache();
 }
 
 // Apply penalty to object function result. This is used only when alignment
@@ -478,6 +494,163 @@ Radians fit_into_box_rotation(const S &sh, const _Box<TPoint<S>> &box)
     return fitIntoBoxRotation<S, TCompute<S>, boost::rational<LargeInt>>(sh, box);
 }
 
+// Whether the items have the same shape, inflation and rotation.
+static bool are_identical(const std::vector<Item> &items)
+{
+    if (items.empty())
+        return false;
+    const Item &front = items.front();
+    return std::all_of(items.begin() + 1, items.end(), [&front](const Item &itm) {
+        return itm.inflation() == front.inflation() && double(itm.rotation()) == double(front.rotation()) &&
+            itm.rawShape().contour.points == front.rawShape().contour.points;
+    });
+}
+
+// Horizontal chord [left, right] of a convex polygon at the height y.
+static std::pair<double, double> convex_chord(const std::vector<Vec2d> &poly, double y)
+{
+    double left  = std::numeric_limits<double>::max();
+    double right = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < poly.size(); ++ i) {
+        const Vec2d &p1 = poly[i];
+        const Vec2d &p2 = poly[(i + 1) % poly.size()];
+        if ((p1.y() < y && p2.y() < y) || (p1.y() > y && p2.y() > y))
+            continue;
+        if (p1.y() == p2.y()) {
+            left  = std::min(left, std::min(p1.x(), p2.x()));
+            right = std::max(right, std::max(p1.x(), p2.x()));
+        } else {
+            double x = p1.x() + (y - p1.y()) * (p2.x() - p1.x()) / (p2.y() - p1.y());
+            left  = std::min(left, x);
+            right = std::max(right, x);
+        }
+    }
+    return { left, right };
+}
+
+// Rows of copies of an item along the X axis, from the no-fit polygon of the item with itself centered at the origin:
+// two copies don't overlap as long as their distance is out of its interior, which is convex and centrally symmetric.
+// The copies of a row touch each other (step), the next row is shifted (shift) to touch the previous one as low
+// as possible (height). Returns (step, shift, height).
+static Vec3d lattice_rows(const std::vector<Vec2d> &nfp)
+{
+    double top = 0.;
+    for (const Vec2d &pt : nfp)
+        top = std::max(top, pt.y());
+    const double step = convex_chord(nfp, 0.).second;
+    // The copies of the next row fit between the ones of the previous row when the chord of the nfp is shorter than
+    // the step: the chord shrinks from the center to the top of the nfp, find the lowest height by bisection.
+    double low = 0., high = top;
+    for (int i = 0; i < 64 && high - low > 1.; ++ i) {
+        double mid = 0.5 * (low + high);
+        auto [left, right] = convex_chord(nfp, mid);
+        if (right - left <= step)
+            high = mid;
+        else
+            low = mid;
+    }
+    return { std::ceil(step) + 1., std::ceil(convex_chord(nfp, std::ceil(high)).second), std::ceil(high) };
+}
+
+// Arrange identical items on the densest lattice of lattice_rows() along the X or the Y axis, instead of placing
+// them one by one with the nester, which is slow for many items. The beds are filled from their center,
+// the pile of each bed is centered. Returns false if the items can't be arranged this way.
+static bool arrange_on_lattice(std::vector<Item> &              items,
+                               const Box &                      bin,
+                               std::function<void(unsigned)>    progressfn,
+                               const ArrangeParams             &params)
+{
+    const Item &front = items.front();
+    const ExPolygon hull = sl::convexHull(front.transformedShape());
+    const auto nfp = nfp::noFitPolygon<nfp::NfpLevel::CONVEX_ONLY>(hull, hull).first;
+    if (nfp.contour.points.size() < 3)
+        return false;
+
+    // Centered nfp, its bounding box is centered on its center of symmetry.
+    BoundingBoxf nfp_bb;
+    for (const Point &pt : nfp.contour.points)
+        nfp_bb.merge(pt.cast<double>());
+    const Vec2d nfp_center = nfp_bb.center();
+    std::vector<Vec2d> nfp_x, nfp_y;
+    for (const Point &pt : nfp.contour.points) {
+        Vec2d v = pt.cast<double>() - nfp_center;
+        nfp_x.emplace_back(v);
+        nfp_y.emplace_back(v.y(), v.x());
+    }
+    if (Polygon::area(nfp.contour.points) < 0) {
+        // Swapping the axes reverses the orientation.
+        std::reverse(nfp_x.begin(), nfp_x.end());
+    } else
+        std::reverse(nfp_y.begin(), nfp_y.end());
+
+    // The lattice with the smallest cell.
+    const Vec3d rows_x = lattice_rows(nfp_x);
+    const Vec3d rows_y = lattice_rows(nfp_y);
+    const bool  along_x = rows_x.x() * rows_x.z() <= rows_y.x() * rows_y.z();
+    const Vec3d rows    = along_x ? rows_x : rows_y;
+    if (rows.x() <= 0. || rows.z() <= 0.)
+        return false;
+
+    // Translations of the copies from the item centered into the bin, which keep them inside the bin.
+    const Box   ibb         = front.boundingBox();
+    const Vec2d half_free   = 0.5 * Vec2d(double(bin.width()) - double(ibb.width()), double(bin.height()) - double(ibb.height()));
+    if (half_free.x() < 0. || half_free.y() < 0.)
+        return false;
+    const Vec2d half_rows   = along_x ? half_free : Vec2d(half_free.y(), half_free.x());
+    // Only the lattice points around the center are needed, the bin may be infinite.
+    const size_t n          = items.size();
+    double       half_size  = std::sqrt(double(n) * rows.x() * rows.z()) + rows.x() + rows.z();
+    std::vector<Vec2d> pts;
+    for (;;) {
+        const Vec2d window(std::min(half_rows.x(), half_size), std::min(half_rows.y(), half_size));
+        pts.clear();
+        for (double j = std::ceil(- window.y() / rows.z()); j * rows.z() <= window.y(); j += 1.) {
+            const double shift = std::fmod(j * rows.y(), rows.x());
+            for (double i = std::ceil((- window.x() - shift) / rows.x()); i * rows.x() + shift <= window.x(); i += 1.)
+                pts.emplace_back(along_x ? Vec2d(i * rows.x() + shift, j * rows.z()) : Vec2d(j * rows.z(), i * rows.x() + shift));
+        }
+        if (pts.size() >= n || (window.x() == half_rows.x() && window.y() == half_rows.y()))
+            break;
+        half_size *= 2.;
+    }
+    if (pts.empty())
+        return false;
+    // Fill the beds from their center.
+    std::sort(pts.begin(), pts.end(), [](const Vec2d &p1, const Vec2d &p2) {
+        double d1 = p1.squaredNorm(), d2 = p2.squaredNorm();
+        return d1 < d2 || (d1 == d2 && (p1.y() < p2.y() || (p1.y() == p2.y() && p1.x() < p2.x())));
+    });
+
+    if (params.stopcondition && params.stopcondition())
+        return true;
+
+    const size_t capacity = pts.size();
+    const Point  center   = front.translation() + bin.center() - ibb.center();
+    for (size_t first = 0; first < n; first += capacity) {
+        const size_t count = std::min(capacity, n - first);
+        // Center the pile of this bed.
+        BoundingBoxf pile_bb;
+        for (size_t k = 0; k < count; ++ k)
+            pile_bb.merge(pts[k]);
+        const Vec2d offset = - pile_bb.center();
+        for (size_t k = 0; k < count; ++ k) {
+            Item &itm = items[first + k];
+            const Vec2d d = pts[k] + offset;
+            itm.translation(center + Point(coord_t(std::round(d.x())), coord_t(std::round(d.y()))));
+            itm.binId(int(first / capacity));
+            if (progressfn)
+                progressfn(unsigned(n - first - k - 1));
+            if (params.on_packed) {
+                ArrangePolygon ap;
+                ap.bed_idx  = itm.binId();
+                ap.priority = itm.priority();
+                params.on_packed(ap);
+            }
+        }
+    }
+    return true;
+}
+
 template<class BinT> // Arrange for arbitrary bin type
 void _arrange(
         std::vector<Item> &           shapes,
@@ -528,7 +701,14 @@ void _arrange(
         }
     }
 
-    arranger(inp.begin(), inp.end());
+    // Many copies of the same object: on a lattice.
+    bool arranged = false;
+    if constexpr (std::is_same_v<BinT, Box>)
+        arranged = excludes.empty() && shapes.size() >= LATTICE_MIN_ITEMS && are_identical(shapes) &&
+            arrange_on_lattice(shapes, corrected_bin, progressfn, params);
+
+    if (!arranged)
+        arranger(inp.begin(), inp.end());
     for (Item &itm : inp) itm.inflate(-infl);
 }
 
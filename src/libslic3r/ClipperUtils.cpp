@@ -156,22 +156,27 @@ bool has_duplicate_points(const ClipperLib::PolyTree &polytree)
 }
 #endif
 
+// The working structures of the Clipper operations are allocated from an arena of the calling thread,
+// rewound after each operation: the slicing steps call Clipper millions of times from many threads,
+// and these small allocations contend on the global heap.
+static inline ClipperLib::MemoryArena* clipper_arena() { return &ClipperLib::MemoryArena::ThreadArena(); }
+
 // Offset CCW contours outside, CW contours (holes) inside.
 // Don't calculate union of the output paths.
 template<typename PathsProvider, ClipperLib::EndType endType = ClipperLib::etClosedPolygon>
 static ClipperLib::Paths raw_offset(PathsProvider &&paths, double offset, ClipperLib::JoinType joinType, double miterLimit)
 {
-    ClipperLib::ClipperOffset co;
     ClipperLib::Paths out;
     out.reserve(paths.size());
     ClipperLib::Paths out_this;
-    if (joinType == jtRound)
-        co.ArcTolerance = miterLimit;
-    else
-        co.MiterLimit = miterLimit;
-    co.ShortestEdgeLength = double(std::abs(offset * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
     for (const ClipperLib::Path &path : paths) {
-        co.Clear();
+        // A new ClipperOffset for each path, so that the arena is rewound after each path.
+        ClipperLib::ClipperOffset co(clipper_arena());
+        if (joinType == jtRound)
+            co.ArcTolerance = miterLimit;
+        else
+            co.MiterLimit = miterLimit;
+        co.ShortestEdgeLength = double(std::abs(offset * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
         // Execute reorients the contours so that the outer most contour has a positive area. Thus the output
         // contours will be CCW oriented even though the input paths are CW oriented.
         // Offset is applied after contour reorientation, thus the signum of the offset value is reversed.
@@ -202,7 +207,7 @@ TResult clipper_do(
     TClip &&                       clip,
     const ClipperLib::PolyFillType fillType)
 {
-    ClipperLib::Clipper clipper;
+    ClipperLib::Clipper clipper(0, clipper_arena());
     clipper.AddPaths(std::forward<TSubj>(subject), ClipperLib::ptSubject, true);
     clipper.AddPaths(std::forward<TClip>(clip),    ClipperLib::ptClip,    true);
     TResult retval;
@@ -231,7 +236,7 @@ TResult clipper_union(
     // fillType pftNonZero and pftPositive "should" produce the same result for "normalized with implicit union" set of polygons
     const ClipperLib::PolyFillType fillType = ClipperLib::pftNonZero)
 {
-    ClipperLib::Clipper clipper;
+    ClipperLib::Clipper clipper(0, clipper_arena());
     clipper.AddPaths(std::forward<TSubj>(subject), ClipperLib::ptSubject, true);
     TResult retval;
     clipper.Execute(ClipperLib::ctUnion, retval, fillType, fillType);
@@ -272,7 +277,7 @@ static TResult shrink_paths(PathsProvider &&paths, double offset, ClipperLib::Jo
     assert(offset > 0);
     TResult out;
     if (auto raw = raw_offset(std::forward<PathsProvider>(paths), - offset, joinType, miterLimit); ! raw.empty()) {
-        ClipperLib::Clipper clipper;
+        ClipperLib::Clipper clipper(0, clipper_arena());
         clipper.AddPaths(raw, ClipperLib::ptSubject, true);
         ClipperLib::IntRect r = clipper.GetBounds();
         clipper.AddPath({ { r.left - 10, r.bottom + 10 }, { r.right + 10, r.bottom + 10 }, { r.right + 10, r.top - 10 }, { r.left - 10, r.top - 10 } }, ClipperLib::ptSubject, true);
@@ -311,7 +316,7 @@ static int offset_expolygon_inner(const Slic3r::ExPolygon &expoly, const double
     // 1) Offset the outer contour.
     ClipperLib::Paths contours;
     {
-        ClipperLib::ClipperOffset co;
+        ClipperLib::ClipperOffset co(clipper_arena());
         if (joinType == jtRound)
             co.ArcTolerance = miterLimit;
         else
@@ -332,7 +337,7 @@ static int offset_expolygon_inner(const Slic3r::ExPolygon &expoly, const double
         ClipperLib::Paths holes;
         {
             for (const Polygon &hole : expoly.holes) {
-                ClipperLib::ClipperOffset co;
+                ClipperLib::ClipperOffset co(clipper_arena());
                 if (joinType == jtRound)
                     co.ArcTolerance = miterLimit;
                 else
@@ -765,7 +770,7 @@ Polylines _clipper_pl_open(ClipperLib::ClipType clipType, PathsProvider1 &&subje
         }
 
     // init Clipper
-    ClipperLib::Clipper clipper;
+    ClipperLib::Clipper clipper(0, clipper_arena());
     clipper.Clear();
 
     // add polygons
@@ -976,7 +981,7 @@ Polygons simplify_polygons(const Polygons &subject, bool preserve_collinear)
 {
     ClipperLib::Paths output;
     if (preserve_collinear) {
-        ClipperLib::Clipper c;
+        ClipperLib::Clipper c(0, clipper_arena());
         c.PreserveCollinear(true);
         c.StrictlySimple(true);
         c.AddPaths(ClipperUtils::PolygonsProvider(subject), ClipperLib::ptSubject, true);
@@ -995,7 +1000,7 @@ ExPolygons simplify_polygons_ex(const Polygons &subject, bool preserve_collinear
         return union_ex(simplify_polygons(subject, false));
 
     ClipperLib::PolyTree polytree;    
-    ClipperLib::Clipper c;
+    ClipperLib::Clipper c(0, clipper_arena());
     c.PreserveCollinear(true);
     c.StrictlySimple(true);
     c.AddPaths(ClipperUtils::PolygonsProvider(subject), ClipperLib::ptSubject, true);
@@ -1008,7 +1013,7 @@ ExPolygons simplify_polygons_ex(const Polygons &subject, bool preserve_collinear
 Polygons top_level_islands(const Slic3r::Polygons &polygons)
 {
     // init Clipper
-    ClipperLib::Clipper clipper;
+    ClipperLib::Clipper clipper(0, clipper_arena());
     clipper.Clear();
     // perform union
     clipper.AddPaths(ClipperUtils::PolygonsProvider(polygons), ClipperLib::ptSubject, true);
@@ -1032,7 +1037,7 @@ ClipperLib::Paths fix_after_outer_offset(
 {
   	ClipperLib::Paths solution;
   	if (! input.empty()) {
-		ClipperLib::Clipper clipper;
+		ClipperLib::Clipper clipper(0, clipper_arena());
 	  	clipper.AddPath(input, ClipperLib::ptSubject, true);
 		clipper.ReverseSolution(reverse_result);
 		clipper.Execute(ClipperLib::ctUnion, solution, filltype, filltype);
@@ -1050,7 +1055,7 @@ ClipperLib::Paths fix_after_inner_offset(
 {
   	ClipperLib::Paths solution;
   	if (! input.empty()) {
-		ClipperLib::Clipper clipper;
+		ClipperLib::Clipper clipper(0, clipper_arena());
 		clipper.AddPath(input, ClipperLib::ptSubject, true);
 		ClipperLib::IntRect r = clipper.GetBounds();
 		r.left -= 10; r.top -= 10; r.right += 10; r.bottom += 10;
@@ -1238,7 +1243,7 @@ Polygons variable_offset_inner(const ExPolygon &expoly, const std::vector<std::v
 	if (holes.empty())
 		output = std::move(contours);
 	else {
-		ClipperLib::Clipper clipper;
+		ClipperLib::Clipper clipper(0, clipper_arena());
 		clipper.Clear();
 		clipper.AddPaths(contours, ClipperLib::ptSubject, true);
 		clipper.AddPaths(holes, ClipperLib::ptClip, true);
@@ -1280,7 +1285,7 @@ for (const std::vector<float>& ds : deltas)
 	if (holes.empty())
 		output = std::move(contours);
 	else {
-		ClipperLib::Clipper clipper;
+		ClipperLib::Clipper clipper(0, clipper_arena());
 		clipper.Clear();
 		clipper.AddPaths(contours, ClipperLib::ptSubject, true);
 		clipper.AddPaths(holes, ClipperLib::ptClip, true);
@@ -1324,7 +1329,7 @@ for (const std::vector<float>& ds : deltas)
 		for (ClipperLib::Path &path : contours) 
 			output.emplace_back(std::move(path));
 	} else {
-		ClipperLib::Clipper clipper;
+		ClipperLib::Clipper clipper(0, clipper_arena());
 		clipper.AddPaths(contours, ClipperLib::ptSubject, true);
 		clipper.AddPaths(holes, ClipperLib::ptClip, true);
 	    ClipperLib::PolyTree polytree;
@@ -1376,7 +1381,7 @@ ExPolygons variable_offset_inner_ex(const ExPolygon &expoly, const std::vector<s
 		for (ClipperLib::Path &path : contours) 
 			output.emplace_back(std::move(path));
 	} else {
-		ClipperLib::Clipper clipper;
+		ClipperLib::Clipper clipper(0, clipper_arena());
 		clipper.AddPaths(contours, ClipperLib::ptSubject, true);
 		clipper.AddPaths(holes, ClipperLib::ptClip, true);
 	    ClipperLib::PolyTree polytree;
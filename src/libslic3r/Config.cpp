@@ -3,6 +3,7 @@
 #include "format.hpp"
 #include "Utils.hpp"
 #include "LocalesUtils.hpp"
+#include "GCode/BinaryGCode.hpp"
 
 #include <assert.h>
 #include <fstream>
@@ -1085,6 +1086,25 @@ private:
 // Load the config keys from the tail of a G-code file.
 ConfigSubstitutions ConfigBase::load_from_gcode_file(const std::string &file, ForwardCompatibilitySubstitutionRule compatibility_rule)
 {
+    if (BinaryGCode::is_binary_gcode_file(file)) {
+        // The config of a binary G-code is stored in its slicer metadata block.
+        std::vector<std::pair<std::string, std::string>> key_values;
+        if (! BinaryGCode::read_slicer_metadata(file, key_values))
+            throw Slic3r::RuntimeError(format("Configuration block not found when reading %1%", file));
+        ConfigSubstitutionContext substitutions_ctxt(compatibility_rule);
+        size_t                    key_value_pairs = 0;
+        for (const auto &[key, value] : key_values)
+            try {
+                this->set_deserialize(key, value, substitutions_ctxt);
+                ++ key_value_pairs;
+            } catch (UnknownOptionException & /* e */) {
+                // ignore
+            }
+        if (key_value_pairs < 80)
+            throw Slic3r::RuntimeError(format("Suspiciously low number of configuration values extracted from %1%: %2%", file, key_value_pairs));
+        return std::move(substitutions_ctxt.substitutions);
+    }
+
     // Read a 64k block from the end of the G-code.
     boost::nowide::ifstream ifs(file, std::ifstream::binary);
     // Look for Slic3r-like header.
@@ -0,0 +1,273 @@
+#include "ExtrusionEntityPacked.hpp"
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace Slic3r {
+
+// Append the entities of a collection to a PackedExtrusionEntities, depth first.
+class PackExtrusionEntities : public ExtrusionVisitorConst {
+public:
+    PackExtrusionEntities(PackedExtrusionEntities &packed) : m_packed(packed) {}
+
+    void use(const ExtrusionPath &path) override {
+        this->add_node(PackedExtrusionEntities::NodeType::Path);
+        this->add_path(path, PackedExtrusionEntities::no_index);
+        m_packed.m_nodes.back().end = uint32_t(m_packed.m_paths.size());
+    }
+    void use(const ExtrusionPath3D &path3D) override {
+        this->add_node(PackedExtrusionEntities::NodeType::Path3D);
+        this->add_path3D(path3D);
+        m_packed.m_nodes.back().end = uint32_t(m_packed.m_paths.size());
+    }
+    void use(const ExtrusionMultiPath &multipath) override {
+        this->add_node(PackedExtrusionEntities::NodeType::MultiPath);
+        for (const ExtrusionPath &path : multipath.paths)
+            this->add_path(path, PackedExtrusionEntities::no_index);
+        m_packed.m_nodes.back().end = uint32_t(m_packed.m_paths.size());
+    }
+    void use(const ExtrusionMultiPath3D &multipath3D) override {
+        this->add_node(PackedExtrusionEntities::NodeType::MultiPath3D);
+        for (const ExtrusionPath3D &path : multipath3D.paths)
+            this->add_path3D(path);
+        m_packed.m_nodes.back().end = uint32_t(m_packed.m_paths.size());
+    }
+    void use(const ExtrusionLoop &loop) override {
+        this->add_node(PackedExtrusionEntities::NodeType::Loop);
+        m_packed.m_nodes.back().loop_role = uint16_t(loop.loop_role());
+        for (const ExtrusionPath &path : loop.paths)
+            this->add_path(path, PackedExtrusionEntities::no_index);
+        m_packed.m_nodes.back().end = uint32_t(m_packed.m_paths.size());
+    }
+    void use(const ExtrusionEntityCollection &collection) override {
+        size_t idx = m_packed.m_nodes.size();
+        this->add_node(PackedExtrusionEntities::NodeType::Collection);
+        m_packed.m_nodes.back().can_sort    = collection.can_sort();
+        m_packed.m_nodes.back().can_reverse = collection.can_reverse();
+        for (const ExtrusionEntity *entity : collection.entities())
+            entity->visit(*this);
+        // Don't keep a reference to the node, the vector was reallocated by the children.
+        m_packed.m_nodes[idx].end = uint32_t(m_packed.m_nodes.size());
+    }
+
+private:
+    void add_node(PackedExtrusionEntities::NodeType type) {
+        PackedExtrusionEntities::Node node;
+        node.type  = type;
+        node.begin = uint32_t(m_packed.m_paths.size());
+        m_packed.m_nodes.push_back(node);
+    }
+    void add_path(const ExtrusionPath &path, uint32_t z_offsets) {
+        PackedExtrusionEntities::Path packed;
+        packed.mm3_per_mm  = path.mm3_per_mm;
+        packed.width       = path.width;
+        packed.height      = path.height;
+        packed.first_point = uint32_t(m_packed.m_points.size());
+        packed.num_points  = uint32_t(path.polyline.points.size());
+        packed.z_offsets   = z_offsets;
+        packed.role        = uint16_t(path.role());
+        m_packed.m_paths.push_back(packed);
+        append(m_packed.m_points, path.polyline.points);
+    }
+    void add_path3D(const ExtrusionPath3D &path) {
+        m_packed.m_z_offsets.push_back(path.z_offsets);
+        this->add_path(path, uint32_t(m_packed.m_z_offsets.size() - 1));
+    }
+
+    PackedExtrusionEntities &m_packed;
+};
+
+void PackedExtrusionEntities::pack(const ExtrusionEntityCollection &collection)
+{
+    this->clear();
+    PackExtrusionEntities visitor(*this);
+    collection.visit(visitor);
+    // The buffers won't grow anymore.
+    m_nodes.shrink_to_fit();
+    m_paths.shrink_to_fit();
+    m_points.shrink_to_fit();
+    m_z_offsets.shrink_to_fit();
+    assert(m_points.size() < size_t(no_index));
+}
+
+void PackedExtrusionEntities::clear()
+{
+    m_nodes.clear();
+    m_paths.clear();
+    m_points.clear();
+    m_z_offsets.clear();
+}
+
+template<typename PATH>
+PATH PackedExtrusionEntities::unpack_path(const Path &path) const
+{
+    PATH out(path.extrusion_role(), path.mm3_per_mm, path.width, path.height);
+    out.polyline.points.assign(m_points.begin() + path.first_point, m_points.begin() + path.first_point + path.num_points);
+    return out;
+}
+
+ExtrusionEntity* PackedExtrusionEntities::unpack_node(uint32_t idx, uint32_t &next) const
+{
+    const Node &node = m_nodes[idx];
+    next = idx + 1;
+    switch (node.type) {
+    case NodeType::Collection:
+    {
+        ExtrusionEntitiesPtr entities;
+        for (uint32_t child = idx + 1; child < node.end;)
+            entities.emplace_back(this->unpack_node(child, child));
+        ExtrusionEntityCollection *collection = new ExtrusionEntityCollection();
+        collection->set_can_sort_reverse(node.can_sort, node.can_reverse);
+        collection->append(std::move(entities));
+        next = node.end;
+        return collection;
+    }
+    case NodeType::Path:
+        return new ExtrusionPath(this->unpack_path<ExtrusionPath>(m_paths[node.begin]));
+    case NodeType::Path3D:
+    {
+        const Path      &path = m_paths[node.begin];
+        ExtrusionPath3D *out  = new ExtrusionPath3D(this->unpack_path<ExtrusionPath3D>(path));
+        out->z_offsets = m_z_offsets[path.z_offsets];
+        return out;
+    }
+    case NodeType::MultiPath:
+    {
+        ExtrusionMultiPath *out = new ExtrusionMultiPath();
+        out->paths.reserve(node.end - node.begin);
+        for (uint32_t i = node.begin; i < node.end; ++ i)
+            out->paths.emplace_back(this->unpack_path<ExtrusionPath>(m_paths[i]));
+        return out;
+    }
+    case NodeType::MultiPath3D:
+    {
+        ExtrusionMultiPath3D *out = new ExtrusionMultiPath3D();
+        out->paths.reserve(node.end - node.begin);
+        for (uint32_t i = node.begin; i < node.end; ++ i) {
+            out->paths.emplace_back(this->unpack_path<ExtrusionPath3D>(m_paths[i]));
+            out->paths.back().z_offsets = m_z_offsets[m_paths[i].z_offsets];
+        }
+        return out;
+    }
+    case NodeType::Loop:
+    {
+        ExtrusionLoop *out = new ExtrusionLoop(ExtrusionLoopRole(node.loop_role));
+        out->paths.reserve(node.end - node.begin);
+        for (uint32_t i = node.begin; i < node.end; ++ i)
+            out->paths.emplace_back(this->unpack_path<ExtrusionPath>(m_paths[i]));
+        return out;
+    }
+    }
+    assert(false);
+    return nullptr;
+}
+
+ExtrusionEntityCollection PackedExtrusionEntities::unpack() const
+{
+    ExtrusionEntityCollection out;
+    if (! m_nodes.empty()) {
+        uint32_t next;
+        std::unique_ptr<ExtrusionEntity> root(this->unpack_node(0, next));
+        out = std::move(*static_cast<ExtrusionEntityCollection*>(root.get()));
+    }
+    return out;
+}
+
+ExtrusionRole PackedExtrusionEntities::node_role(uint32_t idx, uint32_t &next) const
+{
+    const Node &node = m_nodes[idx];
+    if (node.type != NodeType::Collection) {
+        next = idx + 1;
+        // The role of the first path, as ExtrusionLoop::role() and ExtrusionMultiPath::role().
+        return node.begin == node.end ? erNone : m_paths[node.begin].extrusion_role();
+    }
+    ExtrusionRole out = erNone;
+    for (uint32_t child = idx + 1; child < node.end;) {
+        ExtrusionRole er = this->node_role(child, child);
+        out = (out == erNone || out == er) ? er : erMixed;
+    }
+    next = node.end;
+    return out;
+}
+
+ExtrusionRole PackedExtrusionEntities::role() const
+{
+    uint32_t next;
+    return m_nodes.empty() ? erNone : this->node_role(0, next);
+}
+
+size_t PackedExtrusionEntities::items_count() const
+{
+    size_t count = 0;
+    for (const Node &node : m_nodes)
+        if (node.type != NodeType::Collection)
+            ++ count;
+    return count;
+}
+
+size_t PackedExtrusionEntities::memory_used() const
+{
+    size_t bytes = sizeof(*this) + m_nodes.capacity() * sizeof(Node) + m_paths.capacity() * sizeof(Path) +
+        m_points.capacity() * sizeof(Point) + m_z_offsets.capacity() * sizeof(std::vector<coord_t>);
+    for (const std::vector<coord_t> &z : m_z_offsets)
+        bytes += z.capacity() * sizeof(coord_t);
+    return bytes;
+}
+
+template<typename T>
+static void append_vector(std::string &out, const std::vector<T> &data)
+{
+    // Point is an Eigen vector of two coord_t, not trivially copyable only because of its user defined constructors.
+    static_assert(std::is_trivially_copyable<T>::value || std::is_same<T, Point>::value, "The vector is written as raw bytes");
+    uint64_t size = data.size();
+    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.append(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+}
+
+template<typename T>
+static bool read_vector(const char *&begin, const char *end, std::vector<T> &data)
+{
+    uint64_t size;
+    if (size_t(end - begin) < sizeof(size))
+        return false;
+    memcpy(&size, begin, sizeof(size));
+    begin += sizeof(size);
+    if (size > uint64_t(end - begin) / sizeof(T))
+        return false;
+    data.resize(size_t(size));
+    memcpy(reinterpret_cast<char*>(data.data()), begin, data.size() * sizeof(T));
+    begin += data.size() * sizeof(T);
+    return true;
+}
+
+void PackedExtrusionEntities::append_to(std::string &out) const
+{
+    append_vector(out, m_nodes);
+    append_vector(out, m_paths);
+    append_vector(out, m_points);
+    uint64_t num_z_offsets = m_z_offsets.size();
+    out.append(reinterpret_cast<const char*>(&num_z_offsets), sizeof(num_z_offsets));
+    for (const std::vector<coord_t> &z : m_z_offsets)
+        append_vector(out, z);
+}
+
+bool PackedExtrusionEntities::read_from(const char *&begin, const char *end)
+{
+    this->clear();
+    uint64_t num_z_offsets;
+    if (! read_vector(begin, end, m_nodes) || ! read_vector(begin, end, m_paths) || ! read_vector(begin, end, m_points) ||
+        size_t(end - begin) < sizeof(num_z_offsets))
+        return false;
+    memcpy(&num_z_offsets, begin, sizeof(num_z_offsets));
+    begin += sizeof(num_z_offsets);
+    if (num_z_offsets > uint64_t(end - begin))
+        return false;
+    m_z_offsets.assign(size_t(num_z_offsets), {});
+    for (std::vector<coord_t> &z : m_z_offsets)
+        if (! read_vector(begin, end, z))
+            return false;
+    return true;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,120 @@
+#ifndef slic3r_ExtrusionEntityPacked_hpp_
+#define slic3r_ExtrusionEntityPacked_hpp_
+
+#include "libslic3r.h"
+#include "ExtrusionEntityCollection.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+// Compact, read-only copy of an ExtrusionEntityCollection.
+// An ExtrusionEntityCollection is a tree of heap allocated entities, each ExtrusionPath owning its own vector of points.
+// Here all the points are stored in a single buffer, the paths are small headers (role, mm3_per_mm, width, height,
+// range of points) and the tree is a vector of nodes in depth first order, so that a whole layer lives in a few
+// contiguous blocks of memory, to hold the extrusions of the layers that are done with a lower memory footprint.
+// The entities are created back by unpack(), the code only reading the paths (roles, flows, extents) walks the raw
+// buffers with for_each_path() instead, without creating any entity.
+// It isn't the working storage of LayerRegion::perimeters / fills: only the layers held by LayerSpill (memory budget set)
+// are packed. The G-code export doesn't traverse it, GCode::process_layer() and the extrude_*() functions keep working on
+// entities (the islands point to them, the chaining and the seam placement reorder and reverse them), the layers are
+// unpacked one at a time for them by a LayerSpill::Loader.
+class PackedExtrusionEntities
+{
+public:
+    static constexpr const uint32_t no_index = uint32_t(-1);
+
+    // Header of a packed ExtrusionPath or ExtrusionPath3D.
+    struct Path {
+        double      mm3_per_mm;
+        float       width;
+        float       height;
+        // Range of the points of the polyline in points().
+        uint32_t    first_point;
+        uint32_t    num_points;
+        // Index of the z offsets of an ExtrusionPath3D in z_offsets(), no_index for an ExtrusionPath.
+        uint32_t    z_offsets;
+        // ExtrusionRole
+        uint16_t    role;
+
+        ExtrusionRole extrusion_role() const { return ExtrusionRole(role); }
+        bool          is_3d() const { return z_offsets != no_index; }
+    };
+
+    enum class NodeType : uint8_t {
+        Collection,
+        Path,
+        Path3D,
+        MultiPath,
+        MultiPath3D,
+        Loop,
+    };
+
+    struct Node {
+        NodeType    type;
+        // Collection only.
+        bool        can_sort    { true };
+        bool        can_reverse { true };
+        // Loop only (ExtrusionLoopRole).
+        uint16_t    loop_role   { 0 };
+        // Collection: the children are the nodes from this one + 1 up to end, excluded.
+        // Others: range of their paths in paths().
+        uint32_t    begin       { 0 };
+        uint32_t    end         { 0 };
+    };
+
+    PackedExtrusionEntities() = default;
+    explicit PackedExtrusionEntities(const ExtrusionEntityCollection &collection) { this->pack(collection); }
+
+    // Replace the content with a copy of collection.
+    void                        pack(const ExtrusionEntityCollection &collection);
+    // Create back the collection given to pack().
+    ExtrusionEntityCollection   unpack() const;
+    void                        clear();
+    bool                        empty() const { return m_nodes.size() <= 1; }
+
+    // Call fn(const Path &path, const Point *begin, const Point *end) for each path, in the order of the collection.
+    template<typename Fn>
+    void                        for_each_path(Fn &&fn) const {
+        for (const Path &path : m_paths)
+            fn(path, m_points.data() + path.first_point, m_points.data() + path.first_point + path.num_points);
+    }
+    // Same as ExtrusionEntityCollection::role() of the collection given to pack().
+    ExtrusionRole               role() const;
+    // Number of extrusions, the collections excluded, same as ExtrusionEntityCollection::items_count().
+    size_t                      items_count() const;
+    // Bytes allocated by this object.
+    size_t                      memory_used() const;
+
+    // Append a raw binary copy of the buffers to out, to be written into a file (see LayerSpill).
+    void                        append_to(std::string &out) const;
+    // Read back the buffers appended by append_to(), begin is moved past them. Returns false if the data is truncated.
+    bool                        read_from(const char *&begin, const char *end);
+
+    const std::vector<Node>&                  nodes()     const { return m_nodes; }
+    const std::vector<Path>&                  paths()     const { return m_paths; }
+    const Points&                             points()    const { return m_points; }
+    const std::vector<std::vector<coord_t>>&  z_offsets() const { return m_z_offsets; }
+
+private:
+    friend class PackExtrusionEntities;
+
+    // Create the entity of a node, the index of the next node is returned in next.
+    ExtrusionEntity*            unpack_node(uint32_t idx, uint32_t &next) const;
+    template<typename PATH>
+    PATH                        unpack_path(const Path &path) const;
+    // Role of the entity of a node, the index of the next node is returned in next.
+    ExtrusionRole               node_role(uint32_t idx, uint32_t &next) const;
+
+    // The root collection is m_nodes.front().
+    std::vector<Node>                   m_nodes;
+    std::vector<Path>                   m_paths;
+    Points                              m_points;
+    std::vector<std::vector<coord_t>>   m_z_offsets;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ExtrusionEntityPacked_hpp_
@@ -14,7 +14,10 @@
 
 #include "3mf.hpp"
 
+#include <atomic>
+#include <deque>
 #include <limits>
+#include <mutex>
 #include <stdexcept>
 
 #include <boost/algorithm/string/classification.hpp>
@@ -29,6 +32,10 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/foreach.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
 namespace pt = boost::property_tree;
 
 #include <expat.h>
@@ -283,9 +290,11 @@ namespace Slic3r {
     class _3MF_Base
     {
         std::vector<std::string> m_errors;
+        // The objects are exported in parallel.
+        std::mutex               m_errors_mutex;
 
     protected:
-        void add_error(const std::string& error) { m_errors.push_back(error); }
+        void add_error(const std::string& error) { std::lock_guard<std::mutex> lock(m_errors_mutex); m_errors.push_back(error); }
         void clear_errors() { m_errors.clear(); }
 
     public:
@@ -553,7 +562,27 @@ namespace Slic3r {
         bool _handle_start_config_metadata(const char** attributes, unsigned int num_attributes);
         bool _handle_end_config_metadata();
 
-        bool _generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions, DynamicPrintConfig& config_not_used_remove_plz);
+        // Volumes of a ModelObject to be created from the geometry of a 3MF object.
+        struct ObjectVolumes
+        {
+            ModelObject* object;
+            const Geometry* geometry;
+            // Volumes read from the model config, nullptr if the whole geometry is a single volume.
+            const ObjectMetadata::VolumeMetadataList* metadata;
+            ObjectMetadata::VolumeMetadataList whole_geometry;
+
+            ObjectVolumes(ModelObject* object, const Geometry* geometry, const ObjectMetadata::VolumeMetadataList* metadata)
+                : object(object), geometry(geometry), metadata(metadata)
+            {
+                if (metadata == nullptr)
+                    whole_geometry.emplace_back(0, (unsigned int)geometry->triangles.size() - 1);
+            }
+            const ObjectMetadata::VolumeMetadataList& volumes() const { return metadata ? *metadata : whole_geometry; }
+        };
+
+        // Creates the volumes of all the objects. The meshes and the painted facets are built in parallel,
+        // the ModelVolumes are created (and their config deserialized) on the calling thread.
+        bool _generate_volumes(const std::vector<ObjectVolumes>& objects, ConfigSubstitutionContext& config_substitutions, DynamicPrintConfig& config_not_used_remove_plz);
 
         // callbacks to parse the .model file
         static void XMLCALL _handle_start_model_xml_element(void* userData, const char* name, const char** attributes);
@@ -781,6 +810,9 @@ namespace Slic3r {
 
         close_zip_reader(&archive);
 
+        // Volumes to generate, all the objects at once to build their meshes in parallel.
+        std::vector<ObjectVolumes> objects_volumes;
+
         if (m_version == 0) {
             // if the 3mf was not produced by PrusaSlicer and there is more than one instance,
             // split the object in as many objects as instances
@@ -808,9 +840,6 @@ namespace Slic3r {
                         return false;
                     }
 
-                    // use the geometry to create the volumes in the new model objects
-                    ObjectMetadata::VolumeMetadataList volumes(1, { 0, (unsigned int)geometry->triangles.size() - 1 });
-
                     // for each instance after the 1st, create a new model object containing only that instance
                     // and copy into it the geometry
                     while (model_object->instances.size() > 1) {
@@ -818,8 +847,7 @@ namespace Slic3r {
                         new_model_object->clear_instances();
                         new_model_object->add_instance(*model_object->instances.back());
                         model_object->delete_last_instance();
-                        if (!_generate_volumes(*new_model_object, *geometry, volumes, config_substitutions, config))
-                            return false;
+                        objects_volumes.emplace_back(new_model_object, geometry, nullptr);
                     }
                 }
                 ++i;
@@ -860,8 +888,7 @@ namespace Slic3r {
                 model_object->sla_drain_holes = std::move(obj_drain_holes->second);
             }
 
-            ObjectMetadata::VolumeMetadataList volumes;
-            ObjectMetadata::VolumeMetadataList* volumes_ptr = nullptr;
+            const ObjectMetadata::VolumeMetadataList* volumes_ptr = nullptr;
 
             IdToMetadataMap::iterator obj_metadata = m_objects_metadata.find(object.first);
             if (obj_metadata != m_objects_metadata.end()) {
@@ -878,27 +905,24 @@ namespace Slic3r {
                 // select object's detected volumes
                 volumes_ptr = &obj_metadata->second.volumes;
             }
-            else {
-                // config data not found, this model was not saved using slic3r pe
+            // else config data not found, this model was not saved using slic3r pe:
+            // the entire geometry is generated as a single volume.
 
-                // add the entire geometry as the single volume to generate
-                volumes.emplace_back(0, (int)obj_geometry->second.triangles.size() - 1);
-
-                // select as volumes
-                volumes_ptr = &volumes;
-            }
+            objects_volumes.emplace_back(model_object, &obj_geometry->second, volumes_ptr);
+        }
 
-            if (!_generate_volumes(*model_object, obj_geometry->second, *volumes_ptr, config_substitutions, config))
-                return false;
+        if (!_generate_volumes(objects_volumes, config_substitutions, config))
+            return false;
 
-            if (use_prusa_config) {
+        if (use_prusa_config) {
+            for (const IdToModelObjectMap::value_type& object : m_objects) {
+                ModelObject* model_object = m_model->objects[object.second];
                 model_object->config.convert_from_prusa(config);
                 for (ModelVolume* volume : model_object->volumes)
                     volume->config.convert_from_prusa(config);
                 for (auto entry : model_object->layer_config_ranges)
                     entry.second.convert_from_prusa(config);
             }
-
         }
 
         int object_idx = 0;
@@ -2028,21 +2052,107 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Importer::_generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions, DynamicPrintConfig& config_not_used_remove_plz)
+    bool _3MF_Importer::_generate_volumes(const std::vector<ObjectVolumes>& objects, ConfigSubstitutionContext& config_substitutions, DynamicPrintConfig& config_not_used_remove_plz)
     {
-        if (!object.volumes.empty()) {
-            add_error("Found invalid volumes count");
-            return false;
+        // A volume to create, the mesh is built on a worker thread.
+        struct VolumeToGenerate
+        {
+            const ObjectVolumes* object;
+            const ObjectMetadata::VolumeMetadata* data;
+            // The transformation of the single instance is baked into the mesh of the 1st volume.
+            bool bake_instance_transformation;
+            TriangleMesh mesh;
+            ModelVolume* volume { nullptr };
+            std::string error;
+        };
+
+        std::vector<VolumeToGenerate> volumes_to_generate;
+        for (const ObjectVolumes& object : objects) {
+            if (!object.object->volumes.empty()) {
+                add_error("Found invalid volumes count");
+                return false;
+            }
+            bool first = true;
+            for (const ObjectMetadata::VolumeMetadata& volume_data : object.volumes()) {
+                // if the 3mf was not produced by PrusaSlicer and there is only one instance,
+                // bake the transformation into the geometry to allow the reload from disk command
+                // to work properly
+                //FIXME do the mesh fixing?
+                volumes_to_generate.push_back({ &object, &volume_data, first && m_version == 0 && object.object->instances.size() == 1 });
+                first = false;
+            }
         }
 
-        unsigned int geo_tri_count = (unsigned int)geometry.triangles.size();
-        unsigned int renamed_volumes_count = 0;
+        // Build the meshes.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, volumes_to_generate.size()), [this, &volumes_to_generate](const tbb::blocked_range<size_t>& range) {
+            for (size_t idx = range.begin(); idx < range.end(); ++ idx) {
+                VolumeToGenerate& to_generate = volumes_to_generate[idx];
+                const Geometry& geometry = *to_generate.object->geometry;
+                const ObjectMetadata::VolumeMetadata& volume_data = *to_generate.data;
 
-        for (const ObjectMetadata::VolumeMetadata& volume_data : volumes) {
-            if (geo_tri_count <= volume_data.first_triangle_id || geo_tri_count <= volume_data.last_triangle_id || volume_data.last_triangle_id < volume_data.first_triangle_id) {
-                add_error("Found invalid triangle id");
+                unsigned int geo_tri_count = (unsigned int)geometry.triangles.size();
+                if (geo_tri_count <= volume_data.first_triangle_id || geo_tri_count <= volume_data.last_triangle_id || volume_data.last_triangle_id < volume_data.first_triangle_id) {
+                    to_generate.error = "Found invalid triangle id";
+                    continue;
+                }
+
+                // splits volume out of imported geometry
+                indexed_triangle_set its;
+                its.indices.assign(geometry.triangles.begin() + volume_data.first_triangle_id, geometry.triangles.begin() + volume_data.last_triangle_id + 1);
+                if (its.indices.empty()) {
+                    to_generate.error = "An empty triangle mesh found";
+                    continue;
+                }
+
+                {
+                    int min_id = its.indices.front()[0];
+                    int max_id = min_id;
+                    for (const Vec3i32& face : its.indices) {
+                        for (const int tri_id : face) {
+                            if (tri_id < 0 || tri_id >= int(geometry.vertices.size())) {
+                                to_generate.error = "Found invalid vertex id";
+                                break;
+                            }
+                            min_id = std::min(min_id, tri_id);
+                            max_id = std::max(max_id, tri_id);
+                        }
+                    }
+                    if (!to_generate.error.empty())
+                        continue;
+                    its.vertices.assign(geometry.vertices.begin() + min_id, geometry.vertices.begin() + max_id + 1);
+
+                    // rebase indices to the current vertices list
+                    for (Vec3i32& face : its.indices)
+                        for (int& tri_id : face)
+                            tri_id -= min_id;
+                }
+
+                if (m_prusaslicer_generator_version && 
+                    *m_prusaslicer_generator_version >= *Semver::parse("2.4.0-alpha1") &&
+                    *m_prusaslicer_generator_version < *Semver::parse("2.4.0-alpha3"))
+                    // PrusaSlicer 2.4.0-alpha2 contained a bug, where all vertices of a single object were saved for each volume the object contained.
+                    // Remove the vertices, that are not referenced by any face.
+                    its_compactify_vertices(its, true);
+
+                to_generate.mesh = TriangleMesh(std::move(its), volume_data.mesh_stats);
+                if (to_generate.bake_instance_transformation)
+                    to_generate.mesh.transform(to_generate.object->object->instances.front()->get_transformation().get_matrix(), false);
+                if (to_generate.mesh.volume() < 0)
+                    to_generate.mesh.flip_triangles();
+            }
+        });
+
+        // Create the volumes, in the order of the objects.
+        unsigned int renamed_volumes_count = 0;
+        for (VolumeToGenerate& to_generate : volumes_to_generate) {
+            if (!to_generate.error.empty()) {
+                add_error(to_generate.error);
                 return false;
             }
+            ModelObject& object = *to_generate.object->object;
+            const ObjectMetadata::VolumeMetadata& volume_data = *to_generate.data;
+            if (object.volumes.empty())
+                renamed_volumes_count = 0;
 
             Transform3d volume_matrix_to_object = Transform3d::Identity();
             bool        has_transform 		    = false;
@@ -2055,83 +2165,15 @@ namespace Slic3r {
                 }
             }
 
-            // splits volume out of imported geometry
-            indexed_triangle_set its;
-            its.indices.assign(geometry.triangles.begin() + volume_data.first_triangle_id, geometry.triangles.begin() + volume_data.last_triangle_id + 1);
-            const size_t triangles_count = its.indices.size();
-            if (triangles_count == 0) {
-                add_error("An empty triangle mesh found");
-                return false;
-            }
-
-            {
-                int min_id = its.indices.front()[0];
-                int max_id = min_id;
-                for (const Vec3i32& face : its.indices) {
-                    for (const int tri_id : face) {
-                        if (tri_id < 0 || tri_id >= int(geometry.vertices.size())) {
-                            add_error("Found invalid vertex id");
-                            return false;
-                        }
-                        min_id = std::min(min_id, tri_id);
-                        max_id = std::max(max_id, tri_id);
-                    }
-                }
-                its.vertices.assign(geometry.vertices.begin() + min_id, geometry.vertices.begin() + max_id + 1);
-
-                // rebase indices to the current vertices list
-                for (Vec3i32& face : its.indices)
-                    for (int& tri_id : face)
-                        tri_id -= min_id;
-            }
-
-            if (m_prusaslicer_generator_version && 
-                *m_prusaslicer_generator_version >= *Semver::parse("2.4.0-alpha1") &&
-                *m_prusaslicer_generator_version < *Semver::parse("2.4.0-alpha3"))
-                // PrusaSlicer 2.4.0-alpha2 contained a bug, where all vertices of a single object were saved for each volume the object contained.
-                // Remove the vertices, that are not referenced by any face.
-                its_compactify_vertices(its, true);
-
-            TriangleMesh triangle_mesh(std::move(its), volume_data.mesh_stats);
-
-            if (m_version == 0) {
-                // if the 3mf was not produced by PrusaSlicer and there is only one instance,
-                // bake the transformation into the geometry to allow the reload from disk command
-                // to work properly
-                if (object.instances.size() == 1) {
-                    triangle_mesh.transform(object.instances.front()->get_transformation().get_matrix(), false);
-                    object.instances.front()->set_transformation(Slic3r::Geometry::Transformation());
-                    //FIXME do the mesh fixing?
-                }
-            }
-            if (triangle_mesh.volume() < 0)
-                triangle_mesh.flip_triangles();
+            if (to_generate.bake_instance_transformation)
+                object.instances.front()->set_transformation(Slic3r::Geometry::Transformation());
 
-			ModelVolume* volume = object.add_volume(std::move(triangle_mesh));
+			ModelVolume* volume = object.add_volume(std::move(to_generate.mesh));
+            to_generate.volume = volume;
             // stores the volume matrix taken from the metadata, if present
             if (has_transform)
                 volume->source.transform = Slic3r::Geometry::Transformation(volume_matrix_to_object);
 
-            // recreate custom supports, seam and mmu segmentation from previously loaded attribute
-            volume->supported_facets.reserve(triangles_count);
-            volume->seam_facets.reserve(triangles_count);
-            volume->mmu_segmentation_facets.reserve(triangles_count);
-            for (size_t i=0; i<triangles_count; ++i) {
-                size_t index = volume_data.first_triangle_id + i;
-                assert(index < geometry.custom_supports.size());
-                assert(index < geometry.custom_seam.size());
-                assert(index < geometry.mmu_segmentation.size());
-                if (! geometry.custom_supports[index].empty())
-                    volume->supported_facets.set_triangle_from_string(i, geometry.custom_supports[index]);
-                if (! geometry.custom_seam[index].empty())
-                    volume->seam_facets.set_triangle_from_string(i, geometry.custom_seam[index]);
-                if (! geometry.mmu_segmentation[index].empty())
-                    volume->mmu_segmentation_facets.set_triangle_from_string(i, geometry.mmu_segmentation[index]);
-            }
-            volume->supported_facets.shrink_to_fit();
-            volume->seam_facets.shrink_to_fit();
-            volume->mmu_segmentation_facets.shrink_to_fit();
-
             // apply the remaining volume's metadata
             for (const Metadata& metadata : volume_data.metadata) {
                 if (metadata.key == NAME_KEY)
@@ -2177,6 +2219,34 @@ namespace Slic3r {
             }
         }
 
+        // recreate custom supports, seam and mmu segmentation from previously loaded attribute
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, volumes_to_generate.size()), [&volumes_to_generate](const tbb::blocked_range<size_t>& range) {
+            for (size_t idx = range.begin(); idx < range.end(); ++ idx) {
+                const VolumeToGenerate& to_generate = volumes_to_generate[idx];
+                const Geometry& geometry = *to_generate.object->geometry;
+                ModelVolume* volume = to_generate.volume;
+                const size_t triangles_count = to_generate.data->last_triangle_id - to_generate.data->first_triangle_id + 1;
+                volume->supported_facets.reserve(triangles_count);
+                volume->seam_facets.reserve(triangles_count);
+                volume->mmu_segmentation_facets.reserve(triangles_count);
+                for (size_t i=0; i<triangles_count; ++i) {
+                    size_t index = to_generate.data->first_triangle_id + i;
+                    assert(index < geometry.custom_supports.size());
+                    assert(index < geometry.custom_seam.size());
+                    assert(index < geometry.mmu_segmentation.size());
+                    if (! geometry.custom_supports[index].empty())
+                        volume->supported_facets.set_triangle_from_string(i, geometry.custom_supports[index]);
+                    if (! geometry.custom_seam[index].empty())
+                        volume->seam_facets.set_triangle_from_string(i, geometry.custom_seam[index]);
+                    if (! geometry.mmu_segmentation[index].empty())
+                        volume->mmu_segmentation_facets.set_triangle_from_string(i, geometry.mmu_segmentation[index]);
+                }
+                volume->supported_facets.shrink_to_fit();
+                volume->seam_facets.shrink_to_fit();
+                volume->mmu_segmentation_facets.shrink_to_fit();
+            }
+        });
+
         return true;
     }
 
@@ -2261,7 +2331,52 @@ namespace Slic3r {
         typedef std::vector<BuildItem> BuildItemsList;
         typedef std::map<int, ObjectData> IdToObjectDataMap;
 
+        // Text of a part of the model file, compressed by pieces on the worker threads while it is being generated.
+        class DeflatedStream
+        {
+        public:
+            explicit DeflatedStream(int level) : m_level(level) {}
+            ~DeflatedStream() { m_tasks.wait(); }
+
+            // Text to be compressed, to be flushed regularly.
+            std::string buffer;
+            // Compress the buffer if it is big enough, or if forced.
+            void flush(bool force = false);
+            // Wait for the compression and append the compressed pieces to the staged file.
+            bool write(mz_zip_writer_staged_context& context);
+
+        private:
+            struct Piece
+            {
+                std::string text;
+                DeflatedChunk deflated;
+                bool ok{ false };
+            };
+            // Above this number of pieces waiting for compression, the pieces are compressed by the thread generating the text,
+            // so that the uncompressed text doesn't pile up in memory.
+            static constexpr const size_t max_pending_pieces = 16;
+
+            int m_level;
+            // Deque to keep the references to the pieces valid while they are compressed.
+            std::deque<Piece> m_pieces;
+            std::atomic<size_t> m_pending{ 0 };
+            tbb::task_group m_tasks;
+        };
+
+        // A small file compressed on a worker thread, to be written into the archive by _add_pending_files_to_archive().
+        struct PendingFile
+        {
+            std::string name;
+            std::string content;
+            DeflatedChunk deflated;
+            bool ok{ false };
+        };
+
         OptionStore3mf m_options{};
+        // Deflate level of the files of the archive, see OptionStore3mf::compression_level.
+        int m_compression_level{ MZ_DEFAULT_LEVEL };
+        std::deque<PendingFile> m_pending_files;
+        tbb::task_group m_compression_tasks;
 
     public:
         bool save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, const OptionStore3mf& options);
@@ -2271,9 +2386,13 @@ namespace Slic3r {
         bool _add_content_types_file_to_archive(mz_zip_archive& archive);
         bool _add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data);
         bool _add_relationships_file_to_archive(mz_zip_archive& archive);
+        // Compress the file on a worker thread, the file is written into the archive by _add_pending_files_to_archive().
+        bool _add_file_to_archive(mz_zip_archive& archive, const std::string& name, std::string&& content);
+        // Write the files compressed on the worker threads into the archive, in the order they were added.
+        bool _add_pending_files_to_archive(mz_zip_archive& archive);
         bool _add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, IdToObjectDataMap& objects_data);
-        bool _add_object_to_model_stream(mz_zip_writer_staged_context &context, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets);
-        bool _add_mesh_to_object_stream(mz_zip_writer_staged_context &context, ModelObject& object, VolumeToOffsetsMap& volumes_offsets);
+        bool _add_object_to_model_stream(DeflatedStream& stream, unsigned int object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets);
+        bool _add_mesh_to_object_stream(DeflatedStream& stream, ModelObject& object, VolumeToOffsetsMap& volumes_offsets);
         bool _add_build_to_model_stream(std::stringstream& stream, const BuildItemsList& build_items);
         bool _add_layer_height_profile_file_to_archive(mz_zip_archive& archive, Model& model);
         bool _add_layer_config_ranges_file_to_archive(mz_zip_archive& archive, Model& model, const DynamicPrintConfig& global_config);
@@ -2288,7 +2407,12 @@ namespace Slic3r {
     {
         clear_errors();
         m_options = options;
-        return _save_model_to_file(filename, model, config);
+        m_compression_level = options.compression_level < 0 ? MZ_DEFAULT_LEVEL : std::min(options.compression_level, int(MZ_UBER_COMPRESSION));
+        bool res = _save_model_to_file(filename, model, config);
+        // The compression of the pending files is still running if the export failed.
+        m_compression_tasks.wait();
+        m_pending_files.clear();
+        return res;
     }
 
     bool _3MF_Exporter::_save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config)
@@ -2328,6 +2452,13 @@ namespace Slic3r {
             return false;
         }
 
+        // The files above are written before the model file, to keep the order of the files in the archive.
+        if (!_add_pending_files_to_archive(archive)) {
+            close_zip_writer(&archive);
+            boost::filesystem::remove(filename);
+            return false;
+        }
+
         // Adds model file ("3D/3dmodel.model").
         // This is the one and only file that contains all the geometry (vertices and triangles) of all ModelVolumes.
         IdToObjectDataMap objects_data;
@@ -2419,6 +2550,12 @@ namespace Slic3r {
             return false;
         }
 
+        if (!_add_pending_files_to_archive(archive)) {
+            close_zip_writer(&archive);
+            boost::filesystem::remove(filename);
+            return false;
+        }
+
         if (!mz_zip_writer_finalize_archive(&archive)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
@@ -2431,6 +2568,65 @@ namespace Slic3r {
         return true;
     }
 
+    void _3MF_Exporter::DeflatedStream::flush(bool force)
+    {
+        if ((force && ! buffer.empty()) || buffer.size() >= 65536 * 16) {
+            m_pieces.emplace_back();
+            Piece &piece = m_pieces.back();
+            piece.text.swap(buffer);
+            buffer.reserve(piece.text.capacity());
+            auto compress = [&piece, level = m_level]() {
+                piece.ok = deflate_chunk(piece.text.data(), piece.text.size(), level, false, piece.deflated);
+                // Release the text as soon as it is compressed.
+                piece.text = std::string();
+            };
+            if (m_pending.load() < max_pending_pieces) {
+                ++ m_pending;
+                m_tasks.run([this, compress]() { compress(); -- m_pending; });
+            } else
+                compress();
+        }
+    }
+
+    bool _3MF_Exporter::DeflatedStream::write(mz_zip_writer_staged_context& context)
+    {
+        m_tasks.wait();
+        for (const Piece &piece : m_pieces)
+            if (! piece.ok || ! mz_zip_writer_add_staged_compressed_data(&context, piece.deflated.data.data(), piece.deflated.data.size(), piece.deflated.uncompressed_size, piece.deflated.crc32))
+                return false;
+        m_pieces.clear();
+        return true;
+    }
+
+    bool _3MF_Exporter::_add_file_to_archive(mz_zip_archive& archive, const std::string& name, std::string&& content)
+    {
+        if (m_compression_level == 0)
+            // Nothing to compress, store the file right away.
+            return _add_pending_files_to_archive(archive) &&
+                mz_zip_writer_add_mem(&archive, name.c_str(), (const void*)content.data(), content.length(), 0);
+
+        m_pending_files.push_back({ name, std::move(content) });
+        PendingFile &file = m_pending_files.back();
+        m_compression_tasks.run([&file, level = m_compression_level]() {
+            file.ok = deflate_chunk(file.content.data(), file.content.size(), level, true, file.deflated);
+            file.content = std::string();
+        });
+        return true;
+    }
+
+    bool _3MF_Exporter::_add_pending_files_to_archive(mz_zip_archive& archive)
+    {
+        m_compression_tasks.wait();
+        for (const PendingFile &file : m_pending_files)
+            if (! file.ok || ! add_deflated_file(&archive, file.name, file.deflated)) {
+                add_error("Unable to add " + file.name + " to archive");
+                m_pending_files.clear();
+                return false;
+            }
+        m_pending_files.clear();
+        return true;
+    }
+
     bool _3MF_Exporter::_add_content_types_file_to_archive(mz_zip_archive& archive)
     {
         std::stringstream stream;
@@ -2443,7 +2639,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!_add_file_to_archive(archive, CONTENT_TYPES_FILE, std::move(out))) {
             add_error("Unable to add content types file to archive");
             return false;
         }
@@ -2458,7 +2654,7 @@ namespace Slic3r {
         size_t png_size = 0;
         void* png_data = tdefl_write_image_to_png_file_in_memory_ex((const void*)thumbnail_data.pixels.data(), thumbnail_data.width, thumbnail_data.height, 4, &png_size, MZ_DEFAULT_LEVEL, 1);
         if (png_data != nullptr) {
-            res = mz_zip_writer_add_mem(&archive, THUMBNAIL_FILE.c_str(), (const void*)png_data, png_size, MZ_DEFAULT_COMPRESSION);
+            res = _add_file_to_archive(archive, THUMBNAIL_FILE, std::string(static_cast<const char*>(png_data), png_size));
             mz_free(png_data);
         }
 
@@ -2479,7 +2675,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, RELATIONSHIPS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!_add_file_to_archive(archive, RELATIONSHIPS_FILE, std::move(out))) {
             add_error("Unable to add relationships file to archive");
             return false;
         }
@@ -2509,7 +2705,8 @@ namespace Slic3r {
                 // Maximum expected 3MF file size is 4GB-1. This is a workaround for interoperability with Windows 10 3D model fixing API, see
                 // GH issue #6193.
                 (uint64_t(1) << 32) - 1,
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0)) {
+            // The staged compressor only compresses the header and the footer, the objects are compressed by DeflatedStream.
+            nullptr, nullptr, 0, std::max(m_compression_level, 1), nullptr, 0, nullptr, 0)) {
             add_error("Unable to add model file to archive");
             return false;
         }
@@ -2560,22 +2757,51 @@ namespace Slic3r {
         // The object_id here is a one based identifier of the first instance of a ModelObject in the 3MF file, where
         // all the object instances of all ModelObjects are stored and indexed in a 1 based linear fashion.
         // Therefore the list of object_ids here may not be continuous.
+        struct ObjectToExport
+        {
+            unsigned int id;
+            ModelObject* object;
+            ObjectData* data;
+            BuildItemsList build_items;
+        };
+        std::vector<ObjectToExport> objects;
         unsigned int object_id = 1;
         for (ModelObject* obj : model.objects) {
             if (obj == nullptr)
                 continue;
 
             // Index of an object in the 3MF file corresponding to the 1st instance of a ModelObject.
-            unsigned int curr_id = object_id;
-            IdToObjectDataMap::iterator object_it = objects_data.insert({ curr_id, ObjectData(obj) }).first;
-            // Store geometry of all ModelVolumes contained in a single ModelObject into a single 3MF indexed triangle set object.
-            // object_it->second.volumes_offsets will contain the offsets of the ModelVolumes in that single indexed triangle set.
+            IdToObjectDataMap::iterator object_it = objects_data.insert({ object_id, ObjectData(obj) }).first;
+            objects.push_back({ object_id, obj, &object_it->second });
             // object_id will be increased to point to the 1st instance of the next ModelObject.
-            if (!_add_object_to_model_stream(context, object_id, *obj, build_items, object_it->second.volumes_offsets)) {
-                add_error("Unable to add object to archive");
-                mz_zip_writer_add_staged_finish(&context);
-                return false;
-            }
+            object_id += (unsigned int)std::count_if(obj->instances.begin(), obj->instances.end(), [](const ModelInstance* instance) { return instance != nullptr; });
+        }
+
+        // The XML of the objects is generated and compressed in parallel, then appended to the model file in the order of the objects.
+        std::deque<DeflatedStream> streams;
+        for (size_t i = 0; i < objects.size(); ++ i)
+            streams.emplace_back(m_compression_level);
+        std::atomic<bool> objects_ok{ true };
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, objects.size()), [this, &objects, &streams, &objects_ok](const tbb::blocked_range<size_t>& range) {
+            // The locale is set per thread.
+            CNumericLocalesSetter locales_setter;
+            for (size_t idx = range.begin(); idx < range.end() && objects_ok; ++ idx) {
+                ObjectToExport& object = objects[idx];
+                // Store geometry of all ModelVolumes contained in a single ModelObject into a single 3MF indexed triangle set object.
+                // object.data->volumes_offsets will contain the offsets of the ModelVolumes in that single indexed triangle set.
+                if (!_add_object_to_model_stream(streams[idx], object.id, *object.object, object.build_items, object.data->volumes_offsets))
+                    objects_ok = false;
+            }
+        });
+        for (size_t idx = 0; idx < objects.size() && objects_ok; ++ idx) {
+            if (!streams[idx].write(context))
+                objects_ok = false;
+            append(build_items, std::move(objects[idx].build_items));
+        }
+        if (!objects_ok) {
+            add_error("Unable to add object to archive");
+            mz_zip_writer_add_staged_finish(&context);
+            return false;
         }
 
         {
@@ -2604,10 +2830,9 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_object_to_model_stream(mz_zip_writer_staged_context &context, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets)
+    bool _3MF_Exporter::_add_object_to_model_stream(DeflatedStream& stream, unsigned int object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets)
     {
-        std::stringstream stream;
-        reset_stream(stream);
+        std::string& buf = stream.buffer;
         unsigned int id = 0;
         for (const ModelInstance* instance : object.instances) {
 			assert(instance != nullptr);
@@ -2615,36 +2840,32 @@ namespace Slic3r {
                 continue;
 
             unsigned int instance_id = object_id + id;
-            stream << "  <" << OBJECT_TAG << " id=\"" << instance_id << "\" type=\"model\">\n";
+            buf += "  <" + std::string(OBJECT_TAG) + " id=\"" + std::to_string(instance_id) + "\" type=\"model\">\n";
 
             if (id == 0) {
-                std::string buf = stream.str();
-                reset_stream(stream);
-                if ((! buf.empty() && ! mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) ||
-                    ! _add_mesh_to_object_stream(context, object, volumes_offsets)) {
+                if (! _add_mesh_to_object_stream(stream, object, volumes_offsets)) {
                     add_error("Unable to add mesh to archive");
                     return false;
                 }
             }
             else {
-                stream << "   <" << COMPONENTS_TAG << ">\n";
-                stream << "    <" << COMPONENT_TAG << " objectid=\"" << object_id << "\"/>\n";
-                stream << "   </" << COMPONENTS_TAG << ">\n";
+                buf += "   <" + std::string(COMPONENTS_TAG) + ">\n";
+                buf += "    <" + std::string(COMPONENT_TAG) + " objectid=\"" + std::to_string(object_id) + "\"/>\n";
+                buf += "   </" + std::string(COMPONENTS_TAG) + ">\n";
             }
 
             Transform3d t = instance->get_matrix();
-            // instance_id is just a 1 indexed index in build_items.
-            assert(instance_id == build_items.size() + 1);
+            // instance_id is just a 1 indexed index in the build items of all the objects.
+            assert(instance_id == object_id + build_items.size());
             build_items.emplace_back(instance_id, t, instance->printable);
 
-            stream << "  </" << OBJECT_TAG << ">\n";
+            buf += "  </" + std::string(OBJECT_TAG) + ">\n";
 
             ++id;
         }
 
-        object_id += id;
-        std::string buf = stream.str();
-        return buf.empty() || mz_zip_writer_add_staged_data(&context, buf.data(), buf.size());
+        stream.flush(true);
+        return true;
     }
 
 #if EXPORT_3MF_USE_SPIRIT_KARMA_FP
@@ -2667,23 +2888,18 @@ namespace Slic3r {
     using coordinate_type_scientific = boost::spirit::karma::real_generator<float, coordinate_policy_scientific<float>>;
 #endif // EXPORT_3MF_USE_SPIRIT_KARMA_FP
 
-    bool _3MF_Exporter::_add_mesh_to_object_stream(mz_zip_writer_staged_context &context, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
+    bool _3MF_Exporter::_add_mesh_to_object_stream(DeflatedStream& stream, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
     {
-        std::string output_buffer;
+        std::string& output_buffer = stream.buffer;
         output_buffer += "   <";
         output_buffer += MESH_TAG;
         output_buffer += ">\n    <";
         output_buffer += VERTICES_TAG;
         output_buffer += ">\n";
 
-        auto flush = [this, &output_buffer, &context](bool force = false) {
-            if ((force && ! output_buffer.empty()) || output_buffer.size() >= 65536 * 16) {
-                if (! mz_zip_writer_add_staged_data(&context, output_buffer.data(), output_buffer.size())) {
-                    add_error("Error during writing or compression");
-                    return false;
-                }
-                output_buffer.clear();
-            }
+        // The text is compressed by pieces on the worker threads, errors are reported by DeflatedStream::write().
+        auto flush = [&stream]() {
+            stream.flush();
             return true;
         };
 
@@ -2829,8 +3045,7 @@ namespace Slic3r {
         output_buffer += MESH_TAG;
         output_buffer += ">\n";
 
-        // Force flush.
-        return flush(true);
+        return flush();
     }
 
     bool _3MF_Exporter::_add_build_to_model_stream(std::stringstream& stream, const BuildItemsList& build_items)
@@ -2885,7 +3100,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!_add_file_to_archive(archive, LAYER_HEIGHTS_PROFILE_FILE, std::move(out))) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
@@ -2988,16 +3203,16 @@ namespace Slic3r {
         }
 
         if (!default_out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, SLIC3R_LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)default_out.data(), default_out.length(), MZ_DEFAULT_COMPRESSION))
+            if (!_add_file_to_archive(archive, SLIC3R_LAYER_CONFIG_RANGES_FILE, std::string(default_out)))
             {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
-            if (!mz_zip_writer_add_mem(&archive, SUPER_LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)default_out.data(), default_out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!_add_file_to_archive(archive, SUPER_LAYER_CONFIG_RANGES_FILE, std::move(default_out))) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
-            if (!prusa_out.empty() && !mz_zip_writer_add_mem(&archive, PRUSA_LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)prusa_out.data(), prusa_out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!prusa_out.empty() && !_add_file_to_archive(archive, PRUSA_LAYER_CONFIG_RANGES_FILE, std::move(prusa_out))) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
@@ -3033,7 +3248,7 @@ namespace Slic3r {
             // Adds version header at the beginning:
             out = std::string("support_points_format_version=") + std::to_string(support_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!_add_file_to_archive(archive, SLA_SUPPORT_POINTS_FILE, std::move(out))) {
                 add_error("Unable to add sla support points file to archive");
                 return false;
             }
@@ -3084,7 +3299,7 @@ namespace Slic3r {
             // Adds version header at the beginning:
             out = std::string("drain_holes_format_version=") + std::to_string(drain_holes_format_version) + std::string("\n") + out;
             
-            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(MZ_DEFAULT_COMPRESSION))) {
+            if (!_add_file_to_archive(archive, SLA_DRAIN_HOLES_FILE, std::move(out))) {
                 add_error("Unable to add sla support points file to archive");
                 return false;
             }
@@ -3113,7 +3328,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, config_name.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!_add_file_to_archive(archive, config_name, std::move(out))) {
                 add_error("Unable to add print config file to archive");
                 return false;
             }
@@ -3285,7 +3500,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, file_path.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!_add_file_to_archive(archive, file_path, std::move(out))) {
             add_error("Unable to add model config file to archive");
             return false;
         }
@@ -3337,7 +3552,7 @@ bool _3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive( mz_zip_archiv
     } 
 
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!_add_file_to_archive(archive, CUSTOM_GCODE_PER_PRINT_Z_FILE, std::move(out))) {
             add_error("Unable to add custom Gcodes per print_z file to archive");
             return false;
         }
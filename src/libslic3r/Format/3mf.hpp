@@ -40,12 +40,16 @@ namespace Slic3r {
         bool zip64 = true;
         bool export_config = true;
         bool export_modifiers = true;
+        // Deflate level of the files of the archive: 0 stores them without compression, 1 is the fastest compression,
+        // up to 10 for the smallest files. -1 for the default level (6).
+        int compression_level = -1;
         const ThumbnailData* thumbnail_data = nullptr;
         OptionStore3mf& set_fullpath_sources(bool use_fullpath_sources) { fullpath_sources = use_fullpath_sources; return *this; }
         OptionStore3mf& set_zip64(bool use_zip64) { zip64 = use_zip64; return *this; }
         OptionStore3mf& set_export_config(bool use_export_config) { export_config = use_export_config; return *this; }
         OptionStore3mf& set_export_modifiers(bool use_export_modifiers) { export_modifiers = use_export_modifiers; return *this; }
         OptionStore3mf& set_thumbnail_data(const ThumbnailData* thumbnail) { thumbnail_data = thumbnail; return *this; }
+        OptionStore3mf& set_compression_level(int level) { compression_level = level; return *this; }
     };
 
     // Save the given model and the config data contained in the given Print into a 3mf file.
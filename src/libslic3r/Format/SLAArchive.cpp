@@ -1,4 +1,22 @@
 #include "Format/SLAArchive.hpp"
+#include "libslic3r/miniz_extension.hpp"
+
+#include <algorithm>
+
+#include <tbb/task_arena.h>
+
+// See GCode.cpp for the TBB 2017 / oneTBB compatibility.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 using ConfMap = std::map<std::string, std::string>;
@@ -57,4 +75,73 @@ sla::RasterEncoder SLAAbstractArchive::get_encoder() const
     return sla::PNGRasterEncoder{};
 }
 
+// Memory budget of the layers in flight when they were all rasterized by the slicing:
+// only their compressed copy is in flight then.
+static constexpr const size_t compressed_layers_memory_budget = 256 << 20;
+
+void SLAAbstractArchive::export_layers(Zipper &zipper, const SLAPrint &print, const std::string &project) const
+{
+    const bool   streaming = this->streaming();
+    const size_t nlayers   = streaming ? print.print_layers().size() : m_layers.size();
+    if (nlayers == 0)
+        return;
+
+    // Estimate of the memory taken by a layer in flight, to bound the number of layers in flight.
+    size_t layer_memory = 0;
+    if (streaming) {
+        // The raster, and its encoded and compressed copies, which are much smaller (the layers are mostly empty).
+        size_t pixels = size_t(this->config().display_pixels_x.getInt()) * size_t(this->config().display_pixels_y.getInt());
+        layer_memory  = pixels + pixels / 4;
+    } else {
+        for (const sla::EncodedRaster &rst : m_layers)
+            layer_memory += rst.size();
+        layer_memory /= nlayers;
+    }
+    const size_t budget      = streaming ? m_streaming_memory_budget : compressed_layers_memory_budget;
+    const size_t max_layers  = std::clamp<size_t>(budget / std::max<size_t>(layer_memory, 1), 1,
+                                                  4 * size_t(tbb::this_task_arena::max_concurrency()));
+
+    struct LayerToWrite {
+        size_t        idx = 0;
+        std::string   extension;
+        DeflatedChunk deflated;
+    };
+
+    size_t next_layer = 0;
+    const auto generator = tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order,
+        [nlayers, &next_layer](tbb::flow_control &fc) -> size_t {
+            if (next_layer == nlayers)
+                fc.stop();
+            return next_layer ++;
+        });
+    const auto compress = tbb::make_filter<size_t, LayerToWrite>(slic3r_tbb_filtermode::parallel,
+        [this, streaming, &print, &zipper](size_t idx) -> LayerToWrite {
+            print.throw_if_canceled();
+            LayerToWrite out;
+            out.idx = idx;
+            if (streaming) {
+                sla::EncodedRaster encoded;
+                {
+                    std::unique_ptr<sla::RasterBase> raster = this->create_raster();
+                    for (const ExPolygon &poly : print.print_layers()[idx].transformed_slices())
+                        raster->draw(poly);
+                    encoded = raster->encode(this->get_encoder());
+                }
+                out.extension = encoded.extension();
+                out.deflated  = zipper.deflate_entry(encoded.data(), encoded.size());
+            } else {
+                const sla::EncodedRaster &rst = m_layers[idx];
+                out.extension = rst.extension();
+                out.deflated  = zipper.deflate_entry(rst.data(), rst.size());
+            }
+            return out;
+        });
+    const auto write = tbb::make_filter<LayerToWrite, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&zipper, &project](const LayerToWrite &layer) {
+            zipper.add_entry(project + string_printf("%.5d", int(layer.idx)) + "." + layer.extension, layer.deflated);
+        });
+
+    tbb::parallel_pipeline(max_layers, generator & compress & write);
+}
+
 } // namespace Slic3r
@@ -17,6 +17,11 @@ protected:
     
     std::unique_ptr<sla::RasterBase> create_raster() const override;
     sla::RasterEncoder get_encoder() const override;
+
+    /// Write the layers into the zipper, as project00000.png, project00001.png...
+    /// The layers are compressed (and in the streaming mode rasterized and encoded) in parallel,
+    /// and written in order.
+    void export_layers(Zipper &zipper, const SLAPrint &print, const std::string &project) const;
 public: 
     SLAAbstractArchive() = default;
    
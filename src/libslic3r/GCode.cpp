@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <chrono>
+#include <deque>
 #include <map>
 #include <math.h>
 #include <unordered_set>
@@ -866,9 +867,13 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 
     std::string path_tmp(path);
     path_tmp += ".tmp";
+    // G-code as generated, before the GCodeProcessor inserts the time estimates into path_tmp.
+    std::string path_gcode = path_tmp;
+    if (print->gcode_spool())
+        path_gcode = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slic3r_gcode_%%%%-%%%%-%%%%.gcode")).string();
 
-    m_processor.initialize(path_tmp);
-    GCodeOutputStream file(boost::nowide::fopen(path_tmp.c_str(), "wb"), m_processor, *this);
+    m_processor.initialize(path_gcode);
+    GCodeOutputStream file(boost::nowide::fopen(path_gcode.c_str(), "wb"), m_processor, *this);
     if (! file.is_open())
         throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n");
 
@@ -879,14 +884,14 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         file.flush();
         if (file.is_error()) {
             file.close();
-            boost::nowide::remove(path_tmp.c_str());
+            boost::nowide::remove(path_gcode.c_str());
             throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed\nIs the disk full?\n");
         }
     } catch (std::exception & /* ex */) {
         // Rethrow on any exception. std::runtime_exception and CanceledException are expected to be thrown.
         // Close and remove the file.
         file.close();
-        boost::nowide::remove(path_tmp.c_str());
+        boost::nowide::remove(path_gcode.c_str());
         throw;
     }
     file.close();
@@ -898,7 +903,7 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         for (const auto &name_and_error : m_placeholder_parser_failed_templates)
             msg += name_and_error.first + "\n" + name_and_error.second + "\n";
         msg += "\nPlease inspect the file ";
-        msg += path_tmp + " for error messages enclosed between\n";
+        msg += path_gcode + " for error messages enclosed between\n";
         msg += "        !!!!! Failed to process the custom G-code template ...\n";
         msg += "and\n";
         msg += "        !!!!! End of an error report for the custom G-code template ...\n";
@@ -908,7 +913,19 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 
     BOOST_LOG_TRIVIAL(debug) << "Start processing gcode, " << log_memory_info();
     // Post-process the G-code to update time stamps.
-    m_processor.finalize(true);
+    if (path_gcode == path_tmp)
+        m_processor.finalize(true);
+    else {
+        // Spooled: path_tmp is written only once, by the post processing.
+        try {
+            m_processor.finalize(true, path_tmp);
+        } catch (std::exception & /* ex */) {
+            boost::nowide::remove(path_gcode.c_str());
+            boost::nowide::remove(path_tmp.c_str());
+            throw;
+        }
+        boost::nowide::remove(path_gcode.c_str());
+    }
 //    DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     DoExport::update_print_estimated_stats(m_processor, m_writer.extruders(), print->config() ,print->m_print_statistics);
     if (result != nullptr) {
@@ -1000,7 +1017,15 @@ namespace DoExport {
             for (const ExtrusionEntity* entity : collection.entities())
                 entity->visit(*this);
         }
-        double reset_use_get(const ExtrusionEntityCollection entity) { reset(); use(entity); return get(); }
+        // The paths of a spilled layer, read from the packed buffers.
+        void use(const PackedExtrusionEntities &packed) {
+            packed.for_each_path([this](const PackedExtrusionEntities::Path &path, const Point*, const Point*) {
+                if (excluded.find(path.extrusion_role()) == excluded.end())
+                    min = std::min(min, path.mm3_per_mm);
+            });
+        }
+        double reset_use_get(const ExtrusionEntityCollection &entity) { reset(); use(entity); return get(); }
+        double reset_use_get(const PackedExtrusionEntities &packed) { reset(); use(packed); return get(); }
         double get() { return min; }
         void reset() { min = std::numeric_limits<double>::max(); }
         //test if at least a ExtrusionRole from tests is used for min computation
@@ -1027,19 +1052,26 @@ namespace DoExport {
 	    // get the minimum cross-section used in the print
 	    std::vector<double> mm3_per_mm;
 	    for (auto object : print.objects()) {
-	        for (size_t region_id = 0; region_id < object->num_printing_regions(); ++ region_id) {
-	            const PrintRegion &region = object->printing_region(region_id);
-	            for (auto layer : object->layers()) {
-	                const LayerRegion* layerm = layer->regions()[region_id];
+	        for (auto layer : object->layers()) {
+                LayerSpill::PackedLoader loader(layer);
+	            for (const LayerRegion *layerm : layer->regions()) {
                     if (compute_min_mm3_per_mm.is_compatible({ erPerimeter, erExternalPerimeter, erOverhangPerimeter }))
-                        mm3_per_mm.push_back(compute_min_mm3_per_mm.reset_use_get(layerm->perimeters));
+                        mm3_per_mm.push_back(loader.packed() ?
+                            compute_min_mm3_per_mm.reset_use_get(layerm->packed_perimeters()) :
+                            compute_min_mm3_per_mm.reset_use_get(layerm->perimeters));
                     if (compute_min_mm3_per_mm.is_compatible({ erInternalInfill, erSolidInfill, erTopSolidInfill,erBridgeInfill,erInternalBridgeInfill }))
-                        mm3_per_mm.push_back(compute_min_mm3_per_mm.reset_use_get(layerm->fills));
+                        mm3_per_mm.push_back(loader.packed() ?
+                            compute_min_mm3_per_mm.reset_use_get(layerm->packed_fills()) :
+                            compute_min_mm3_per_mm.reset_use_get(layerm->fills));
 	            }
 	        }
             if (compute_min_mm3_per_mm.is_compatible({ erSupportMaterial, erSupportMaterialInterface }))
-	            for (auto layer : object->support_layers())
-                    mm3_per_mm.push_back(compute_min_mm3_per_mm.reset_use_get(layer->support_fills));
+	            for (auto layer : object->support_layers()) {
+                    LayerSpill::PackedLoader loader(layer);
+                    mm3_per_mm.push_back(loader.packed() ?
+                        compute_min_mm3_per_mm.reset_use_get(layer->packed_support_fills()) :
+                        compute_min_mm3_per_mm.reset_use_get(layer->support_fills));
+                }
 	    }
         if (compute_min_mm3_per_mm.is_compatible({ erSkirt })) {
             mm3_per_mm.push_back(compute_min_mm3_per_mm.reset_use_get(print.skirt()));
@@ -1289,6 +1321,9 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
     m_last_mm3_per_mm = 0.;
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
     m_fan_mover.release();
+    m_arc_fitter.reset();
+    if (print.config().arc_fitting.value)
+        m_arc_fitter = make_unique<ArcFitter>(print.config(), print.config().arc_fitting_tolerance.value);
 
     print.m_print_statistics.color_extruderid_to_used_filament.clear();
     print.m_print_statistics.color_extruderid_to_used_weight.clear();
@@ -1396,14 +1431,16 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
         this->m_ordered_objects.push_back(print_object);
         uint32_t copy_id = 0;
         for (const PrintInstance &print_instance : print_object->instances()) {
-            std::string object_name = print_object->model_object()->name;
+            // The instances of a PrintObject may come from several identical ModelObjects, see Print::set_merge_identical_objects().
+            const ModelObject &model_object = *print_instance.model_instance->get_object();
+            std::string object_name = model_object.name;
             size_t pos_dot = object_name.find(".", 0);
             if (pos_dot != std::string::npos && pos_dot > 0)
                 object_name = object_name.substr(0, pos_dot);
             //get bounding box for the instance
             //BoundingBoxf3 raw_bbox = print_object->model_object()->raw_mesh_bounding_box();
             //BoundingBoxf3 bounding_box;// = print_instance.model_instance->transform_bounding_box(raw_bbox);
-            BoundingBoxf3 bounding_box = print_object->model_object()->instance_bounding_box(*print_instance.model_instance, false);
+            BoundingBoxf3 bounding_box = model_object.instance_bounding_box(*print_instance.model_instance, false);
             if (global_bounding_box.size().norm() == 0) {
                 global_bounding_box = bounding_box;
             } else {
@@ -1411,7 +1448,7 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
             }
             if (this->config().gcode_label_objects) {
                 file.write_format("; object:{\"name\":\"%s\",\"id\":\"%s id:%d copy %d\",\"object_center\":[%f,%f,%f],\"boundingbox_center\":[%f,%f,%f],\"boundingbox_size\":[%f,%f,%f]}\n",
-                    object_name.c_str(), print_object->model_object()->name.c_str(), this->m_ordered_objects.size() - 1, copy_id,
+                    object_name.c_str(), model_object.name.c_str(), this->m_ordered_objects.size() - 1, copy_id,
                     bounding_box.center().x(), bounding_box.center().y(), 0.,
                     bounding_box.center().x(), bounding_box.center().y(), bounding_box.center().z(),
                     bounding_box.size().x(), bounding_box.size().y(), bounding_box.size().z()
@@ -1701,8 +1738,13 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
     DoExport::init_ooze_prevention(print, m_ooze_prevention);
     print.throw_if_canceled();
 
-    // Collect custom seam data from all objects.
-    m_seam_placer.init(print);
+    // Collect custom seam data from all objects. In sequential mode, only from the object being printed, see below.
+    if (! print.config().complete_objects.value) {
+        m_seam_placer.init(print);
+        // Not with a layer memory budget: the candidates of all the layers would be in memory.
+        if (! print.layer_spill().enabled())
+            m_seam_placer.precompute_candidates(print);
+    }
 
     //activate first extruder is multi-extruder and not in start-gcode
     if ((initial_extruder_id != (uint16_t)-1)) {
@@ -1808,7 +1850,9 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
                     set_extra_lift(0, 0, print.config(), m_writer, initial_extruder_id);
                 }
                 //reinit the seam placer on the new object
-                m_seam_placer.init(print);
+                m_seam_placer.init(print, &object);
+                if (! print.layer_spill().enabled())
+                    m_seam_placer.precompute_candidates(print);
                 // Reset the cooling buffer internal state (the current position, feed rate, accelerations).
                 m_cooling_buffer->reset(this->writer().get_position());
                 m_cooling_buffer->set_current_extruder(initial_extruder_id);
@@ -1994,34 +2038,58 @@ void GCode::process_layers(
 {
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &print_stat, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> GCode::LayerResult {
-            CNumericLocalesSetter locales_setter;
+    const auto layers = tbb::make_filter<void, GCode::LayerToProcess>(slic3r_tbb_filtermode::serial_in_order,
+        [&tool_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> GCode::LayerToProcess {
             if (layer_to_print_idx == layers_to_print.size()) {
                 fc.stop();
                 return {};
             } else {
                 const std::pair<coordf_t, std::vector<LayerToPrint>>& layer = layers_to_print[layer_to_print_idx++];
-                const LayerTools& layer_tools = tool_ordering.tools_for_layer(layer.first);
-                if (m_wipe_tower && layer_tools.has_wipe_tower)
-                    m_wipe_tower->next_layer();
-                print.throw_if_canceled();
-                return this->process_layer(print, print_stat, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+                return { layer.second, &tool_ordering.tools_for_layer(layer.first), &layer == &layers_to_print.back() };
+            }
+        });
+    const auto generator = tbb::make_filter<GCode::LayerToProcess, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &print_stat, &print_object_instances_ordering](GCode::LayerToProcess in) -> GCode::LayerResult {
+            CNumericLocalesSetter locales_setter;
+            if (m_wipe_tower && in.layer_tools->has_wipe_tower)
+                m_wipe_tower->next_layer();
+            print.throw_if_canceled();
+            return this->process_layer(print, print_stat, in.layers, *in.layer_tools, in.by_extruder, in.last_layer, &print_object_instances_ordering, size_t(-1));
+        });
+    // The extrusions of the layers are grouped by extruder, object, island and region ahead of the generator, in parallel
+    // as it doesn't depend on the previous layers: the generator only emits the G-code, keeping the machine state in order.
+    const auto group = tbb::make_filter<GCode::LayerToProcess, GCode::LayerToProcess>(slic3r_tbb_filtermode::parallel,
+        [&print](GCode::LayerToProcess in) -> GCode::LayerToProcess {
+            // Page in the layers spilled to the scratch file, until they are generated.
+            in.loaders = std::make_shared<std::deque<LayerSpill::Loader>>();
+            for (const LayerToPrint &layer_to_print : in.layers) {
+                in.loaders->emplace_back(layer_to_print.object_layer);
+                in.loaders->emplace_back(layer_to_print.support_layer);
             }
+            if (! in.layer_tools->extruders.empty())
+                in.by_extruder = GCode::group_extrusions_by_extruder(print, in.layers, *in.layer_tools);
+            return in;
         });
-    const auto spiral_vase = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [&spiral_vase = *this->m_spiral_vase.get()](GCode::LayerResult in) -> GCode::LayerResult {
+    // The G-code of the layers is tokenized once for all the filters, in parallel: the only state carried over from the previous layers,
+    // the active extruder, is given by the generator.
+    const auto tokenize = tbb::make_filter<GCode::LayerResult, GCode::LayerMoves>(slic3r_tbb_filtermode::parallel,
+        [syntax = MoveBuffer::Syntax(m_config, m_writer.toolchange_prefix())](GCode::LayerResult in) -> GCode::LayerMoves {
+            return { MoveBuffer(std::move(in.gcode), syntax, in.extruder), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
+        });
+    const auto spiral_vase = tbb::make_filter<GCode::LayerMoves, GCode::LayerMoves>(slic3r_tbb_filtermode::serial_in_order,
+        [&spiral_vase = *this->m_spiral_vase.get()](GCode::LayerMoves in) -> GCode::LayerMoves {
             CNumericLocalesSetter locales_setter;
             spiral_vase.enable(in.spiral_vase_enable);
             return { spiral_vase.process_layer(std::move(in.gcode)), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
         });
-    const auto cooling = tbb::make_filter<GCode::LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&cooling_buffer = *this->m_cooling_buffer.get()](GCode::LayerResult in) -> std::string {
+    const auto cooling = tbb::make_filter<GCode::LayerMoves, MoveBuffer>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get()](GCode::LayerMoves in) -> MoveBuffer {
             CNumericLocalesSetter locales_setter;
             return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
         });
-    const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&self = *this->m_find_replace.get()](std::string s) -> std::string {
+    // The find & replace doesn't keep any state between layers, the layers can be processed in parallel.
+    const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::parallel,
+        [&self = std::as_const(*this->m_find_replace.get())](std::string s) -> std::string {
             CNumericLocalesSetter locales_setter;
             return self.process_layer(std::move(s));
         });
@@ -2032,8 +2100,8 @@ void GCode::process_layers(
         }
     );
 
-    const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in)->std::string {
+    const auto fan_mover = tbb::make_filter<MoveBuffer, MoveBuffer>(slic3r_tbb_filtermode::serial_in_order,
+            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](MoveBuffer in)->MoveBuffer {
         CNumericLocalesSetter locales_setter;
 
         if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
@@ -2046,21 +2114,28 @@ void GCode::process_layers(
                     config.fan_speedup_overhangs.value,
                     (float)config.fan_kickstart.value));
             //flush as it's a whole layer
-            return fan_mover->process_gcode(in, true);
+            return fan_mover->process_gcode(std::move(in), true);
         }
         return in;
     });
 
+    // Last filter working on the tokenized G-code, it gives its text to the find & replace and the output.
+    const auto arc_fitter = tbb::make_filter<MoveBuffer, std::string>(slic3r_tbb_filtermode::serial_in_order,
+        [&arc_fitter = this->m_arc_fitter](MoveBuffer in)->std::string {
+            CNumericLocalesSetter locales_setter;
+            return arc_fitter ? arc_fitter->process_layer(std::move(in)).release_text() : in.release_text();
+        });
+
     // The pipeline elements are joined using const references, thus no copying is performed.
     output_stream.find_replace_supress();
     if (m_spiral_vase && m_find_replace)
-        tbb::parallel_pipeline(12, generator & spiral_vase & cooling & fan_mover & find_replace & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & spiral_vase & cooling & fan_mover & arc_fitter & find_replace & output);
     else if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator &  spiral_vase & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & spiral_vase & cooling & fan_mover & arc_fitter & output);
     else if (m_find_replace)
-        tbb::parallel_pipeline(12, generator & cooling & fan_mover & find_replace & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & cooling & fan_mover & arc_fitter & find_replace & output);
     else
-        tbb::parallel_pipeline(12, generator & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & cooling & fan_mover & arc_fitter & output);
     output_stream.find_replace_enable();
 }
 
@@ -2077,38 +2152,69 @@ void GCode::process_layers(
 {
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &print_stat, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx](tbb::flow_control& fc) -> GCode::LayerResult {
+    const auto layers = tbb::make_filter<void, GCode::LayerToProcess>(slic3r_tbb_filtermode::serial_in_order,
+        [&tool_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> GCode::LayerToProcess {
             if (layer_to_print_idx == layers_to_print.size()) {
                 fc.stop();
                 return {};
             } else {
-                LayerToPrint &layer = layers_to_print[layer_to_print_idx ++];
-                print.throw_if_canceled();
-                return this->process_layer(print, print_stat, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, single_object_idx);
+                const LayerToPrint &layer = layers_to_print[layer_to_print_idx ++];
+                return { { layer }, &tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back() };
+            }
+        });
+    const auto generator = tbb::make_filter<GCode::LayerToProcess, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &print_stat, single_object_idx](GCode::LayerToProcess in) -> GCode::LayerResult {
+            CNumericLocalesSetter locales_setter;
+            print.throw_if_canceled();
+            return this->process_layer(print, print_stat, in.layers, *in.layer_tools, in.by_extruder, in.last_layer, nullptr, single_object_idx);
+        });
+    // The extrusions of the layers are grouped by extruder, object, island and region ahead of the generator, in parallel
+    // as it doesn't depend on the previous layers: the generator only emits the G-code, keeping the machine state in order.
+    const auto group = tbb::make_filter<GCode::LayerToProcess, GCode::LayerToProcess>(slic3r_tbb_filtermode::parallel,
+        [&print](GCode::LayerToProcess in) -> GCode::LayerToProcess {
+            // Page in the layers spilled to the scratch file, until they are generated.
+            in.loaders = std::make_shared<std::deque<LayerSpill::Loader>>();
+            for (const LayerToPrint &layer_to_print : in.layers) {
+                in.loaders->emplace_back(layer_to_print.object_layer);
+                in.loaders->emplace_back(layer_to_print.support_layer);
             }
+            if (! in.layer_tools->extruders.empty())
+                in.by_extruder = GCode::group_extrusions_by_extruder(print, in.layers, *in.layer_tools);
+            return in;
         });
-    const auto spiral_vase = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [&spiral_vase = *this->m_spiral_vase.get()](GCode::LayerResult in)->GCode::LayerResult {
+    // The G-code of the layers is tokenized once for all the filters, in parallel: the only state carried over from the previous layers,
+    // the active extruder, is given by the generator.
+    const auto tokenize = tbb::make_filter<GCode::LayerResult, GCode::LayerMoves>(slic3r_tbb_filtermode::parallel,
+        [syntax = MoveBuffer::Syntax(m_config, m_writer.toolchange_prefix())](GCode::LayerResult in)->GCode::LayerMoves {
+            return { MoveBuffer(std::move(in.gcode), syntax, in.extruder), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
+        });
+    const auto spiral_vase = tbb::make_filter<GCode::LayerMoves, GCode::LayerMoves>(slic3r_tbb_filtermode::serial_in_order,
+        [&spiral_vase = *this->m_spiral_vase.get()](GCode::LayerMoves in)->GCode::LayerMoves {
+            CNumericLocalesSetter locales_setter;
             spiral_vase.enable(in.spiral_vase_enable);
             return { spiral_vase.process_layer(std::move(in.gcode)), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
         });
-    const auto cooling = tbb::make_filter<GCode::LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&cooling_buffer = *this->m_cooling_buffer.get()](GCode::LayerResult in)->std::string {
+    const auto cooling = tbb::make_filter<GCode::LayerMoves, MoveBuffer>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get()](GCode::LayerMoves in)->MoveBuffer {
+            CNumericLocalesSetter locales_setter;
             return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
         });
-    const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&self = *this->m_find_replace.get()](std::string s) -> std::string {
+    // The find & replace doesn't keep any state between layers, the layers can be processed in parallel.
+    const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::parallel,
+        [&self = std::as_const(*this->m_find_replace.get())](std::string s) -> std::string {
+            CNumericLocalesSetter locales_setter;
             return self.process_layer(std::move(s));
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { 
-            output_stream.write(s); 
+        [&output_stream](std::string s) {
+            CNumericLocalesSetter locales_setter;
+            output_stream.write(s);
         }
     );
 
-    const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in)->std::string {
+    const auto fan_mover = tbb::make_filter<MoveBuffer, MoveBuffer>(slic3r_tbb_filtermode::serial_in_order,
+        [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](MoveBuffer in)->MoveBuffer {
+        CNumericLocalesSetter locales_setter;
 
         if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
             if (fan_mover.get() == nullptr)
@@ -2120,21 +2226,31 @@ void GCode::process_layers(
                     config.fan_speedup_overhangs.value,
                     (float)config.fan_kickstart.value));
             //flush as it's a whole layer
-            return fan_mover->process_gcode(in, true);
+            return fan_mover->process_gcode(std::move(in), true);
         }
         return in;
     });
 
+    // Last filter working on the tokenized G-code, it gives its text to the find & replace and the output.
+    const auto arc_fitter = tbb::make_filter<MoveBuffer, std::string>(slic3r_tbb_filtermode::serial_in_order,
+        [&arc_fitter = this->m_arc_fitter](MoveBuffer in)->std::string {
+            CNumericLocalesSetter locales_setter;
+            return arc_fitter ? arc_fitter->process_layer(std::move(in)).release_text() : in.release_text();
+        });
+
+    // The between-objects G-code isn't seen by the arc fitter, don't trust its position.
+    if (m_arc_fitter)
+        m_arc_fitter->reset_position();
     // The pipeline elements are joined using const references, thus no copying is performed.
     output_stream.find_replace_supress();
     if (m_spiral_vase && m_find_replace)
-        tbb::parallel_pipeline(12, generator & spiral_vase & cooling & fan_mover & find_replace & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & spiral_vase & cooling & fan_mover & arc_fitter & find_replace & output);
     else if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_vase & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & spiral_vase & cooling & fan_mover & arc_fitter & output);
     else if (m_find_replace)
-        tbb::parallel_pipeline(12, generator & cooling & fan_mover & find_replace & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & cooling & fan_mover & arc_fitter & find_replace & output);
     else
-        tbb::parallel_pipeline(12, generator & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, layers & group & generator & tokenize & cooling & fan_mover & arc_fitter & output);
     output_stream.find_replace_enable();
 }
 
@@ -2632,12 +2748,185 @@ boost::regex regex_g92e0_gcode{ "^[ \\t]*[gG]92[ \\t]*[eE](0(\\.0*)?|\\.0+)[ \\t
 // In non-sequential mode, process_layer is called per each print_z height with all object and support layers accumulated.
 // For multi-material prints, this routine minimizes extruder switches by gathering extruder specific extrusion paths
 // and performing the extruder specific extrusions together.
+// Group the extrusions of the layers by an extruder, then by an object, an island and a region.
+GCode::ExtrusionsByExtruder GCode::group_extrusions_by_extruder(
+    const Print                             &print,
+    // Set of object & print layers of the same PrintObject and with the same print_z.
+    const std::vector<LayerToPrint>         &layers,
+    const LayerTools                        &layer_tools)
+{
+    assert(! layer_tools.extruders.empty());
+    ExtrusionsByExtruder by_extruder;
+    uint16_t first_extruder_id = layer_tools.extruders.front();
+    bool is_anything_overridden = const_cast<LayerTools&>(layer_tools).wiping_extrusions().is_anything_overridden();
+    for (const LayerToPrint &layer_to_print : layers) {
+        if (layer_to_print.support_layer != nullptr) {
+            const SupportLayer &support_layer = *layer_to_print.support_layer;
+            const PrintObject  &object = *support_layer.object();
+            if (! support_layer.support_fills.entities().empty()) {
+                ExtrusionRole   role               = support_layer.support_fills.role();
+                bool            has_support        = role == erMixed || role == erSupportMaterial;
+                bool            has_interface      = role == erMixed || role == erSupportMaterialInterface;
+                // Extruder ID of the support base. -1 if "don't care".
+                uint16_t    support_extruder   = object.config().support_material_extruder.value - 1;
+                // Shall the support be printed with the active extruder, preferably with non-soluble, to avoid tool changes?
+                bool            support_dontcare   = object.config().support_material_extruder.value == 0;
+                // Extruder ID of the support interface. -1 if "don't care".
+                uint16_t    interface_extruder = object.config().support_material_interface_extruder.value - 1;
+                // Shall the support interface be printed with the active extruder, preferably with non-soluble, to avoid tool changes?
+                bool            interface_dontcare = object.config().support_material_interface_extruder.value == 0;
+                if (support_dontcare || interface_dontcare) {
+                    // Some support will be printed with "don't care" material, preferably non-soluble.
+                    // Is the current extruder assigned a soluble filament?
+                    uint16_t dontcare_extruder = first_extruder_id;
+                    if (print.config().filament_soluble.get_at(dontcare_extruder)) {
+                        // The last extruder printed on the previous layer extrudes soluble filament.
+                        // Try to find a non-soluble extruder on the same layer.
+                        for (uint16_t extruder_id : layer_tools.extruders)
+                            if (! print.config().filament_soluble.get_at(extruder_id)) {
+                                dontcare_extruder = extruder_id;
+                                break;
+                            }
+                    }
+                    if (support_dontcare)
+                        support_extruder = dontcare_extruder;
+                    if (interface_dontcare)
+                        interface_extruder = dontcare_extruder;
+                }
+                // Both the support and the support interface are printed with the same extruder, therefore
+                // the interface may be interleaved with the support base.
+                bool single_extruder = ! has_support || support_extruder == interface_extruder;
+                // Assign an extruder to the base.
+                ObjectByExtruder &obj = object_by_extruder(by_extruder, has_support ? support_extruder : interface_extruder, &layer_to_print - layers.data(), layers.size());
+                obj.support = &support_layer.support_fills;
+                obj.support_extrusion_role = single_extruder ? erMixed : erSupportMaterial;
+                if (! single_extruder && has_interface) {
+                    ObjectByExtruder &obj_interface = object_by_extruder(by_extruder, interface_extruder, &layer_to_print - layers.data(), layers.size());
+                    obj_interface.support = &support_layer.support_fills;
+                    obj_interface.support_extrusion_role = erSupportMaterialInterface;
+                }
+            }
+        }
+        if (layer_to_print.object_layer != nullptr) {
+            const Layer &layer = *layer_to_print.object_layer;
+            // We now define a strategy for building perimeters and fills. The separation
+            // between regions doesn't matter in terms of printing order, as we follow
+            // another logic instead:
+            // - we group all extrusions by extruder so that we minimize toolchanges
+            // - we start from the last used extruder
+            // - for each extruder, we group extrusions by island
+            // - for each island, we extrude perimeters first, unless user set the infill_first
+            //   option
+            // (Still, we have to keep track of regions because we need to apply their config)
+            size_t n_slices = layer.lslices.size();
+            const std::vector<BoundingBox> &layer_surface_bboxes = layer.lslices_bboxes;
+            // Traverse the slices in an increasing order of bounding box size, so that the islands inside another islands are tested first,
+            // so we can just test a point inside ExPolygon::contour and we may skip testing the holes.
+            std::vector<size_t> slices_test_order;
+            slices_test_order.reserve(n_slices);
+            for (size_t i = 0; i < n_slices; ++ i)
+                slices_test_order.emplace_back(i);
+            std::sort(slices_test_order.begin(), slices_test_order.end(), [&layer_surface_bboxes](size_t i, size_t j) {
+                const Vec2d s1 = layer_surface_bboxes[i].size().cast<double>();
+                const Vec2d s2 = layer_surface_bboxes[j].size().cast<double>();
+                return s1.x() * s1.y() < s2.x() * s2.y();
+            });
+            auto point_inside_surface = [&layer, &layer_surface_bboxes](const size_t i, const Point &point) {
+                const BoundingBox &bbox = layer_surface_bboxes[i];
+                return point(0) >= bbox.min(0) && point(0) < bbox.max(0) &&
+                       point(1) >= bbox.min(1) && point(1) < bbox.max(1) &&
+                       layer.lslices[i].contour.contains(point);
+            };
+
+            for (size_t region_id = 0; region_id < layer.regions().size(); ++ region_id) {
+                const LayerRegion *layerm = layer.regions()[region_id];
+                if (layerm == nullptr)
+                    continue;
+                // PrintObjects own the PrintRegions, thus the pointer to PrintRegion would be unique to a PrintObject, they would not
+                // identify the content of PrintRegion accross the whole print uniquely. Translate to a Print specific PrintRegion.
+                const PrintRegion &region = print.get_print_region(layerm->region().print_region_id());
+
+                // Now we must process perimeters and infills and create islands of extrusions in by_region std::map.
+                // It is also necessary to save which extrusions are part of MM wiping and which are not.
+                // The process is almost the same for perimeters and infills - we will do it in a cycle that repeats twice:
+                std::vector<uint16_t> printing_extruders;
+                auto process_entities = [&](ObjectByExtruder::Island::Region::Type entity_type, const ExtrusionEntitiesPtr& entities) {
+                    for (const ExtrusionEntity* ee : entities) {
+                        // extrusions represents infill or perimeter extrusions of a single island.
+                        assert(dynamic_cast<const ExtrusionEntityCollection*>(ee) != nullptr);
+                        const auto* extrusions = static_cast<const ExtrusionEntityCollection*>(ee);
+                        if (extrusions->entities().empty()) // This shouldn't happen but first_point() would fail.
+                            continue;
+
+                        // This extrusion is part of certain Region, which tells us which extruder should be used for it:
+                        int correct_extruder_id = layer_tools.extruder(*extrusions, region);
+
+                        // Let's recover vector of extruder overrides:
+                        const WipingExtrusions::ExtruderPerCopy* entity_overrides = nullptr;
+                        if (!layer_tools.has_extruder(correct_extruder_id)) {
+                            // this entity is not overridden, but its extruder is not in layer_tools - we'll print it
+                            // by last extruder on this layer (could happen e.g. when a wiping object is taller than others - dontcare extruders are eradicated from layer_tools)
+                            correct_extruder_id = layer_tools.extruders.back();
+                        }
+                        printing_extruders.clear();
+                        if (is_anything_overridden) {
+                            entity_overrides = const_cast<LayerTools&>(layer_tools).wiping_extrusions().get_extruder_overrides(extrusions, correct_extruder_id, layer_to_print.object()->instances().size());
+                            if (entity_overrides == nullptr) {
+                                printing_extruders.emplace_back(correct_extruder_id);
+                            } else {
+                                printing_extruders.reserve(entity_overrides->size());
+                                for (int extruder : *entity_overrides)
+                                    printing_extruders.emplace_back(extruder >= 0 ?
+                                        // at least one copy is overridden to use this extruder
+                                        extruder :
+                                        // at least one copy would normally be printed with this extruder (see get_extruder_overrides function for explanation)
+                                        static_cast<uint16_t>(-extruder - 1));
+                                Slic3r::sort_remove_duplicates(printing_extruders);
+                            }
+                        } else
+                            printing_extruders.emplace_back(correct_extruder_id);
+
+                        // Now we must add this extrusion into the by_extruder map, once for each extruder that will print it:
+                        for (uint16_t extruder : printing_extruders)
+                        {
+                            std::vector<ObjectByExtruder::Island>& islands = object_islands_by_extruder(
+                                by_extruder,
+                                extruder,
+                                &layer_to_print - layers.data(),
+                                layers.size(), n_slices + 1);
+                            for (size_t i = 0; i <= n_slices; ++i) {
+                                bool   last = i == n_slices;
+                                size_t island_idx = last ? n_slices : slices_test_order[i];
+                                if (// extrusions->first_point does not fit inside any slice
+                                    last ||
+                                    // extrusions->first_point fits inside ith slice
+                                    point_inside_surface(island_idx, extrusions->first_point())) {
+                                    if (islands[island_idx].by_region.empty())
+                                        islands[island_idx].by_region.assign(print.num_print_regions(), ObjectByExtruder::Island::Region());
+                                    islands[island_idx].by_region[region.print_region_id()].append(entity_type, extrusions, entity_overrides);
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                };
+                process_entities(ObjectByExtruder::Island::Region::INFILL, layerm->fills.entities());
+                process_entities(ObjectByExtruder::Island::Region::PERIMETERS, layerm->perimeters.entities());
+                process_entities(ObjectByExtruder::Island::Region::IRONING, layerm->ironings.entities());
+            } // for regions
+        }
+    } // for objects
+    return by_extruder;
+}
+
 GCode::LayerResult GCode::process_layer(
     const Print                             &print,
     PrintStatistics                         &print_stat,
     // Set of object & print layers of the same PrintObject and with the same print_z.
     const std::vector<LayerToPrint>         &layers,
     const LayerTools                        &layer_tools,
+    // Extrusions of the layers, see group_extrusions_by_extruder().
+    ExtrusionsByExtruder                    &by_extruder,
     const bool                               last_layer,
     // Pairs of PrintObject index and its instance index.
     const std::vector<const PrintInstance*> *ordering,
@@ -2666,7 +2955,8 @@ GCode::LayerResult GCode::process_layer(
         }
     }
     const Layer         &layer         = (object_layer != nullptr) ? *object_layer : *support_layer;
-    GCode::LayerResult   result { {}, layer.id(), false, last_layer };
+    GCode::LayerResult   result { {}, layer.id(), false, last_layer, m_writer.tool() ? m_writer.tool()->id() : uint16_t(0) };
+    m_lower_layer_edge_grids.clear();
     if (layer_tools.extruders.empty())
         // Nothing to extrude.
         return result;
@@ -2801,169 +3091,8 @@ GCode::LayerResult GCode::process_layer(
         Skirt::make_skirt_loops_per_extruder_1st_layer(print, layer_tools, m_skirt_done) :
         Skirt::make_skirt_loops_per_extruder_other_layers(print, layer_tools, m_skirt_done);
 
-    // Group extrusions by an extruder, then by an object, an island and a region.
-    std::map<uint16_t, std::vector<ObjectByExtruder>> by_extruder;
     bool is_anything_overridden = const_cast<LayerTools&>(layer_tools).wiping_extrusions().is_anything_overridden();
-    for (const LayerToPrint &layer_to_print : layers) {
-        if (layer_to_print.support_layer != nullptr) {
-            const SupportLayer &support_layer = *layer_to_print.support_layer;
-            const PrintObject  &object = *support_layer.object();
-            if (! support_layer.support_fills.entities().empty()) {
-                ExtrusionRole   role               = support_layer.support_fills.role();
-                bool            has_support        = role == erMixed || role == erSupportMaterial;
-                bool            has_interface      = role == erMixed || role == erSupportMaterialInterface;
-                // Extruder ID of the support base. -1 if "don't care".
-                uint16_t    support_extruder   = object.config().support_material_extruder.value - 1;
-                // Shall the support be printed with the active extruder, preferably with non-soluble, to avoid tool changes?
-                bool            support_dontcare   = object.config().support_material_extruder.value == 0;
-                // Extruder ID of the support interface. -1 if "don't care".
-                uint16_t    interface_extruder = object.config().support_material_interface_extruder.value - 1;
-                // Shall the support interface be printed with the active extruder, preferably with non-soluble, to avoid tool changes?
-                bool            interface_dontcare = object.config().support_material_interface_extruder.value == 0;
-                if (support_dontcare || interface_dontcare) {
-                    // Some support will be printed with "don't care" material, preferably non-soluble.
-                    // Is the current extruder assigned a soluble filament?
-                    uint16_t dontcare_extruder = first_extruder_id;
-                    if (print.config().filament_soluble.get_at(dontcare_extruder)) {
-                        // The last extruder printed on the previous layer extrudes soluble filament.
-                        // Try to find a non-soluble extruder on the same layer.
-                        for (uint16_t extruder_id : layer_tools.extruders)
-                            if (! print.config().filament_soluble.get_at(extruder_id)) {
-                                dontcare_extruder = extruder_id;
-                                break;
-                            }
-                    }
-                    if (support_dontcare)
-                        support_extruder = dontcare_extruder;
-                    if (interface_dontcare)
-                        interface_extruder = dontcare_extruder;
-                }
-                // Both the support and the support interface are printed with the same extruder, therefore
-                // the interface may be interleaved with the support base.
-                bool single_extruder = ! has_support || support_extruder == interface_extruder;
-                // Assign an extruder to the base.
-                ObjectByExtruder &obj = object_by_extruder(by_extruder, has_support ? support_extruder : interface_extruder, &layer_to_print - layers.data(), layers.size());
-                obj.support = &support_layer.support_fills;
-                obj.support_extrusion_role = single_extruder ? erMixed : erSupportMaterial;
-                if (! single_extruder && has_interface) {
-                    ObjectByExtruder &obj_interface = object_by_extruder(by_extruder, interface_extruder, &layer_to_print - layers.data(), layers.size());
-                    obj_interface.support = &support_layer.support_fills;
-                    obj_interface.support_extrusion_role = erSupportMaterialInterface;
-                }
-            }
-        }
-        if (layer_to_print.object_layer != nullptr) {
-            const Layer &layer = *layer_to_print.object_layer;
-            // We now define a strategy for building perimeters and fills. The separation
-            // between regions doesn't matter in terms of printing order, as we follow
-            // another logic instead:
-            // - we group all extrusions by extruder so that we minimize toolchanges
-            // - we start from the last used extruder
-            // - for each extruder, we group extrusions by island
-            // - for each island, we extrude perimeters first, unless user set the infill_first
-            //   option
-            // (Still, we have to keep track of regions because we need to apply their config)
-            size_t n_slices = layer.lslices.size();
-            const std::vector<BoundingBox> &layer_surface_bboxes = layer.lslices_bboxes;
-            // Traverse the slices in an increasing order of bounding box size, so that the islands inside another islands are tested first,
-            // so we can just test a point inside ExPolygon::contour and we may skip testing the holes.
-            std::vector<size_t> slices_test_order;
-            slices_test_order.reserve(n_slices);
-            for (size_t i = 0; i < n_slices; ++ i)
-                slices_test_order.emplace_back(i);
-            std::sort(slices_test_order.begin(), slices_test_order.end(), [&layer_surface_bboxes](size_t i, size_t j) {
-                const Vec2d s1 = layer_surface_bboxes[i].size().cast<double>();
-                const Vec2d s2 = layer_surface_bboxes[j].size().cast<double>();
-                return s1.x() * s1.y() < s2.x() * s2.y();
-            });
-            auto point_inside_surface = [&layer, &layer_surface_bboxes](const size_t i, const Point &point) {
-                const BoundingBox &bbox = layer_surface_bboxes[i];
-                return point(0) >= bbox.min(0) && point(0) < bbox.max(0) &&
-                       point(1) >= bbox.min(1) && point(1) < bbox.max(1) &&
-                       layer.lslices[i].contour.contains(point);
-            };
-
-            for (size_t region_id = 0; region_id < layer.regions().size(); ++ region_id) {
-                const LayerRegion *layerm = layer.regions()[region_id];
-                if (layerm == nullptr)
-                    continue;
-                // PrintObjects own the PrintRegions, thus the pointer to PrintRegion would be unique to a PrintObject, they would not
-                // identify the content of PrintRegion accross the whole print uniquely. Translate to a Print specific PrintRegion.
-                const PrintRegion &region = print.get_print_region(layerm->region().print_region_id());
-
-                // Now we must process perimeters and infills and create islands of extrusions in by_region std::map.
-                // It is also necessary to save which extrusions are part of MM wiping and which are not.
-                // The process is almost the same for perimeters and infills - we will do it in a cycle that repeats twice:
-                std::vector<uint16_t> printing_extruders;
-                auto process_entities = [&](ObjectByExtruder::Island::Region::Type entity_type, const ExtrusionEntitiesPtr& entities) {
-                    for (const ExtrusionEntity* ee : entities) {
-                        // extrusions represents infill or perimeter extrusions of a single island.
-                        assert(dynamic_cast<const ExtrusionEntityCollection*>(ee) != nullptr);
-                        const auto* extrusions = static_cast<const ExtrusionEntityCollection*>(ee);
-                        if (extrusions->entities().empty()) // This shouldn't happen but first_point() would fail.
-                            continue;
-
-                        // This extrusion is part of certain Region, which tells us which extruder should be used for it:
-                        int correct_extruder_id = layer_tools.extruder(*extrusions, region);
-
-                        // Let's recover vector of extruder overrides:
-                        const WipingExtrusions::ExtruderPerCopy* entity_overrides = nullptr;
-                        if (!layer_tools.has_extruder(correct_extruder_id)) {
-                            // this entity is not overridden, but its extruder is not in layer_tools - we'll print it
-                            // by last extruder on this layer (could happen e.g. when a wiping object is taller than others - dontcare extruders are eradicated from layer_tools)
-                            correct_extruder_id = layer_tools.extruders.back();
-                        }
-                        printing_extruders.clear();
-                        if (is_anything_overridden) {
-                            entity_overrides = const_cast<LayerTools&>(layer_tools).wiping_extrusions().get_extruder_overrides(extrusions, correct_extruder_id, layer_to_print.object()->instances().size());
-                            if (entity_overrides == nullptr) {
-                                printing_extruders.emplace_back(correct_extruder_id);
-                            } else {
-                                printing_extruders.reserve(entity_overrides->size());
-                                for (int extruder : *entity_overrides)
-                                    printing_extruders.emplace_back(extruder >= 0 ?
-                                        // at least one copy is overridden to use this extruder
-                                        extruder :
-                                        // at least one copy would normally be printed with this extruder (see get_extruder_overrides function for explanation)
-                                        static_cast<uint16_t>(-extruder - 1));
-                                Slic3r::sort_remove_duplicates(printing_extruders);
-                            }
-                        } else
-                            printing_extruders.emplace_back(correct_extruder_id);
-
-                        // Now we must add this extrusion into the by_extruder map, once for each extruder that will print it:
-                        for (uint16_t extruder : printing_extruders)
-                        {
-                            std::vector<ObjectByExtruder::Island>& islands = object_islands_by_extruder(
-                                by_extruder,
-                                extruder,
-                                &layer_to_print - layers.data(),
-                                layers.size(), n_slices + 1);
-                            for (size_t i = 0; i <= n_slices; ++i) {
-                                bool   last = i == n_slices;
-                                size_t island_idx = last ? n_slices : slices_test_order[i];
-                                if (// extrusions->first_point does not fit inside any slice
-                                    last ||
-                                    // extrusions->first_point fits inside ith slice
-                                    point_inside_surface(island_idx, extrusions->first_point())) {
-                                    if (islands[island_idx].by_region.empty())
-                                        islands[island_idx].by_region.assign(print.num_print_regions(), ObjectByExtruder::Island::Region());
-                                    islands[island_idx].by_region[region.print_region_id()].append(entity_type, extrusions, entity_overrides);
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                };
-                process_entities(ObjectByExtruder::Island::Region::INFILL, layerm->fills.entities());
-                process_entities(ObjectByExtruder::Island::Region::PERIMETERS, layerm->perimeters.entities());
-                process_entities(ObjectByExtruder::Island::Region::IRONING, layerm->ironings.entities());
-            } // for regions
-        }
-    } // for objects
-
     // Extrude the skirt, brim, support, perimeters, infill ordered by the extruders.
-    std::vector<std::unique_ptr<EdgeGrid::Grid>> lower_layer_edge_grids(layers.size());
     for (uint16_t extruder_id : layer_tools.extruders)
     {
         gcode += (layer_tools.has_wipe_tower && m_wipe_tower) ?
@@ -3079,7 +3208,7 @@ GCode::LayerResult GCode::process_layer(
                     m_avoid_crossing_perimeters.init_layer(*m_layer);
                 //print object label to help the printer firmware know where it is (for removing the objects)
                 if (this->config().gcode_label_objects) {
-                    m_gcode_label_objects_start = std::string("; printing object ") + instance_to_print.print_object.model_object()->name
+                    m_gcode_label_objects_start = std::string("; printing object ") + instance_to_print.print_object.instances()[instance_to_print.instance_id].model_instance->get_object()->name
                         + " id:" + std::to_string(std::find(this->m_ordered_objects.begin(), this->m_ordered_objects.end(), &instance_to_print.print_object) - this->m_ordered_objects.begin())
                         + " copy " + std::to_string(instance_to_print.instance_id) + "\n";
                     if (print.config().gcode_flavor.value == gcfMarlinLegacy || print.config().gcode_flavor.value == gcfMarlinFirmware || print.config().gcode_flavor.value == gcfRepRap) {
@@ -3132,7 +3261,7 @@ GCode::LayerResult GCode::process_layer(
                             print_wipe_extrusions != 0) : 
                         island.by_region;
                     gcode += this->extrude_infill(print, by_region_specific, true);
-                    gcode += this->extrude_perimeters(print, by_region_specific, lower_layer_edge_grids[instance_to_print.layer_id]);
+                    gcode += this->extrude_perimeters(print, by_region_specific);
                     gcode += this->extrude_infill(print, by_region_specific, false);
                     gcode += this->extrude_ironing(print, by_region_specific);
                 }
@@ -3140,7 +3269,7 @@ GCode::LayerResult GCode::process_layer(
                 if (m_gcode_label_objects_start != "") {
                     m_gcode_label_objects_start = "";
                 }else if (this->config().gcode_label_objects) {
-                    m_gcode_label_objects_end = std::string("; stop printing object ") + instance_to_print.print_object.model_object()->name
+                    m_gcode_label_objects_end = std::string("; stop printing object ") + instance_to_print.print_object.instances()[instance_to_print.instance_id].model_instance->get_object()->name
                         + " id:" + std::to_string((std::find(this->m_ordered_objects.begin(), this->m_ordered_objects.end(), &instance_to_print.print_object) - this->m_ordered_objects.begin()))
                         + " copy " + std::to_string(instance_to_print.instance_id) + "\n";
                     if (print.config().gcode_flavor.value == gcfMarlinLegacy || print.config().gcode_flavor.value == gcfMarlinFirmware || print.config().gcode_flavor.value == gcfRepRap) {
@@ -3368,31 +3497,8 @@ std::string GCode::change_layer(coordf_t print_z)
 }
 
 
-static std::unique_ptr<EdgeGrid::Grid> calculate_layer_edge_grid(const Layer& layer)
-{
-    auto out = make_unique<EdgeGrid::Grid>();
-
-    // Create the distance field for a layer below.
-    const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
-    out->create(layer.lslices, distance_field_resolution);
-    out->calculate_sdf();
-#if 0
-        {
-            static int iRun = 0;
-            BoundingBox bbox = (*lower_layer_edge_grid)->bbox();
-            bbox.min(0) -= scale_(5.f);
-            bbox.min(1) -= scale_(5.f);
-            bbox.max(0) += scale_(5.f);
-            bbox.max(1) += scale_(5.f);
-            EdgeGrid::save_png(*(*lower_layer_edge_grid), bbox, scale_(0.1f), debug_out_path("GCode_extrude_loop_edge_grid-%d.png", iRun++));
-        }
-#endif
-    return out;
-}
-
-
 //like extrude_loop but with varying z and two full round
-std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const std::string &description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const std::string &description, double speed, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
     //don't keep the speed
     speed = -1;
@@ -3400,9 +3506,6 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
     // next copies (if any) would not detect the correct orientation
     ExtrusionLoop loop_to_seam = original_loop;
 
-    if (m_layer->lower_layer && lower_layer_edge_grid != nullptr && ! *lower_layer_edge_grid)
-        *lower_layer_edge_grid = calculate_layer_edge_grid(*m_layer->lower_layer);
-
     // extrude all loops ccw
     //no! this was decided in perimeter_generator
     bool is_hole_loop = (loop_to_seam.loop_role() & ExtrusionLoopRole::elrHole) != 0;// loop.make_counter_clockwise();
@@ -3529,7 +3632,7 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
             if (path == paths.begin() && step == Step::INCR){
                 if (paths.back().role() == erExternalPerimeter && m_layer != NULL && m_config.perimeters.value > 1 && paths.front().size() >= 2 && paths.back().polyline.points.size() >= 3) {
                     paths[0].polyline.points.erase(paths[0].polyline.points.begin());
-                    gcode += m_writer.extrude_to_xy(this->point_to_gcode(paths[0].polyline.points.front()), 0);
+                    m_writer.extrude_to_xy(gcode, this->point_to_gcode(paths[0].polyline.points.front()), 0);
                 }
             }
 
@@ -3554,11 +3657,11 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
                     coordf_t current_height_internal = current_height + height_increment / 2;
                     //ensure you go to the good xyz
                     if( (last_point - previous).norm() > EPSILON)
-                        gcode += m_writer.extrude_to_xyz(last_point, 0, description);
+                        m_writer.extrude_to_xyz(gcode, last_point, 0, description);
                     //extrusions
                     for (int i = 0; i < nb_sections - 1; i++) {
                         Vec3d new_point = last_point + pos_increment;
-                        gcode += m_writer.extrude_to_xyz(new_point,
+                        m_writer.extrude_to_xyz(gcode, new_point,
                             e_per_mm_per_height * (line_length / nb_sections) * current_height_internal,
                             description);
                         current_height_internal += height_increment;
@@ -3568,7 +3671,7 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
                     last_point.x() = this->point_to_gcode(line.b).x();
                     last_point.y() = this->point_to_gcode(line.b).y();
                     last_point.z() = current_z + z_per_length * line_length;
-                    gcode += m_writer.extrude_to_xyz(
+                    m_writer.extrude_to_xyz(gcode,
                         last_point,
                         e_per_mm_per_height * (line_length / nb_sections) * current_height_internal,
                         comment);
@@ -3644,13 +3747,13 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
         inward_point.rotate(angle, paths.front().polyline.points.front());
         
         // generate the travel move
-        gcode += m_writer.travel_to_xy(this->point_to_gcode(inward_point), 0.0, "move inwards before travel");
+        m_writer.travel_to_xy(gcode, this->point_to_gcode(inward_point), 0.0, "move inwards before travel");
     }
 
     return gcode;
 }
 
-void GCode::split_at_seam_pos(ExtrusionLoop& loop, std::unique_ptr<EdgeGrid::Grid>* lower_layer_edge_grid, bool was_clockwise)
+void GCode::split_at_seam_pos(ExtrusionLoop& loop, const EdgeGrid::Grid* lower_layer_edge_grid, bool was_clockwise)
 {
     if (loop.paths.empty())
         return;
@@ -3666,9 +3769,7 @@ void GCode::split_at_seam_pos(ExtrusionLoop& loop, std::unique_ptr<EdgeGrid::Gri
     if (m_config.spiral_vase && !m_spiral_vase->is_transition_layer()) {
             loop.split_at(last_pos, false);
     /*} else {
-        const EdgeGrid::Grid* edge_grid_ptr = (lower_layer_edge_grid && *lower_layer_edge_grid)
-            ? lower_layer_edge_grid->get()
-            : nullptr;
+        const EdgeGrid::Grid* edge_grid_ptr = lower_layer_edge_grid;
         Point seam = m_seam_placer.get_seam(*m_layer, seam_position, loop,
             last_pos, EXTRUDER_CONFIG_WITH_DEFAULT(nozzle_diameter, 0),
             (m_layer == NULL ? nullptr : m_layer->object()),
@@ -3684,7 +3785,7 @@ void GCode::split_at_seam_pos(ExtrusionLoop& loop, std::unique_ptr<EdgeGrid::Gri
             this->last_pos(), m_config.external_perimeters_first,
             EXTRUDER_CONFIG_WITH_DEFAULT(nozzle_diameter, 0.4),
             m_print_object_instance_id,
-            lower_layer_edge_grid ? lower_layer_edge_grid->get() : nullptr);
+            lower_layer_edge_grid);
 }
 
 namespace check_wipe {
@@ -3741,7 +3842,7 @@ namespace check_wipe {
     }
 }
 
-std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::string &description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::string &description, double speed, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
 #if DEBUG_EXTRUSION_OUTPUT
     std::cout << "extrude loop_" << (original_loop.polygon().is_counter_clockwise() ? "ccw" : "clw") << ": ";
@@ -3769,27 +3870,6 @@ std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::s
     // next copies (if any) would not detect the correct orientation
     ExtrusionLoop loop_to_seam = original_loop;
 
-    if (m_layer->lower_layer != nullptr && lower_layer_edge_grid != nullptr) {
-        if (! *lower_layer_edge_grid) {
-            // Create the distance field for a layer below.
-            const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
-            *lower_layer_edge_grid = make_unique<EdgeGrid::Grid>();
-            (*lower_layer_edge_grid)->create(m_layer->lower_layer->lslices, distance_field_resolution);
-            (*lower_layer_edge_grid)->calculate_sdf();
-            #if 0
-            {
-                static int iRun = 0;
-                BoundingBox bbox = (*lower_layer_edge_grid)->bbox();
-                bbox.min(0) -= scale_(5.f);
-                bbox.min(1) -= scale_(5.f);
-                bbox.max(0) += scale_(5.f);
-                bbox.max(1) += scale_(5.f);
-                EdgeGrid::save_png(*(*lower_layer_edge_grid), bbox, scale_(0.1f), debug_out_path("GCode_extrude_loop_edge_grid-%d.png", iRun++));
-            }
-            #endif
-        }
-    }
-
     // extrude all loops ccw
     //no! this was decided in perimeter_generator
     //but we need to know where is "inside", so we will use is_hole_loop. if is_hole_loop, then we need toconsider that the right direction is clockwise, else counter clockwise. 
@@ -3976,7 +4056,7 @@ std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::s
                 for (Point& pt : path.polyline.points) {
                     prev_point = current_point;
                     current_point = pt;
-                    gcode += m_writer.travel_to_xy(this->point_to_gcode(pt), 0.0, config().gcode_comments ? "; extra wipe" : "");
+                    m_writer.travel_to_xy(gcode, this->point_to_gcode(pt), 0.0, config().gcode_comments ? "; extra wipe" : "");
                     this->set_last_pos(pt);
                 }
             }
@@ -4021,7 +4101,7 @@ std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::s
         pt_inside.rotate(angle, current_point);
         // generate the travel move
         if (EXTRUDER_CONFIG_WITH_DEFAULT(wipe_inside_end, true)) {
-            gcode += m_writer.travel_to_xy(this->point_to_gcode(pt_inside), 0.0, "move inwards before travel");
+            m_writer.travel_to_xy(gcode, this->point_to_gcode(pt_inside), 0.0, "move inwards before travel");
             this->set_last_pos(pt_inside);
         }
 
@@ -4124,7 +4204,7 @@ std::string GCode::extrude_multi_path3D(const ExtrusionMultiPath3D &multipath3D,
                 Line line(path.polyline.points[i], path.polyline.points[i + 1]);
                 const double line_length = line.length() * SCALING_FACTOR;
                 path_length += line_length;
-                gcode += m_writer.extrude_to_xyz(
+                m_writer.extrude_to_xyz(gcode,
                     this->point_to_gcode(line.b, path.z_offsets.size()>i+1 ? path.z_offsets[i+1] : 0),
                     e_per_mm * line_length,
                     comment);
@@ -4141,7 +4221,7 @@ std::string GCode::extrude_multi_path3D(const ExtrusionMultiPath3D &multipath3D,
     return gcode;
 }
 
-std::string GCode::extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
     this->visitor_gcode.clear();
     this->visitor_comment = description;
@@ -4233,7 +4313,7 @@ std::string GCode::extrude_path_3D(const ExtrusionPath3D &path, const std::strin
             Line line(path.polyline.points[i], path.polyline.points[i + 1]);
             const double line_length = line.length() * SCALING_FACTOR;
             path_length += line_length;
-            gcode += m_writer.extrude_to_xyz(
+            m_writer.extrude_to_xyz(gcode,
                 this->point_to_gcode(line.b, path.z_offsets.size()>i ? path.z_offsets[i] : 0),
                 e_per_mm * line_length,
                 comment);
@@ -4251,22 +4331,19 @@ std::string GCode::extrude_path_3D(const ExtrusionPath3D &path, const std::strin
 }
 
 // Extrude perimeters: Decide where to put seams (hide or align seams).
-std::string GCode::extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, std::unique_ptr<EdgeGrid::Grid> &lower_layer_edge_grid)
+std::string GCode::extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region)
 {
     std::string gcode;
+    const EdgeGrid::Grid *lower_layer_edge_grid = this->lower_layer_edge_grid();
     for (const ObjectByExtruder::Island::Region &region : by_region)
         if (! region.perimeters.empty()) {
             m_region = &print.get_print_region(&region - &by_region.front());
 
-            // plan_perimeters tries to place seams, it needs to have the lower_layer_edge_grid calculated already.
-            if (m_layer->lower_layer && ! lower_layer_edge_grid)
-                lower_layer_edge_grid = calculate_layer_edge_grid(*m_layer->lower_layer);
-
             m_seam_placer.plan_perimeters(std::vector<const ExtrusionEntity*>(region.perimeters.begin(), region.perimeters.end()),
                 *m_layer, m_config.seam_position,
                 this->last_pos(), EXTRUDER_CONFIG_WITH_DEFAULT(nozzle_diameter, 0.4), (m_layer == NULL ? nullptr : m_layer->object()),
                 m_print_object_instance_id,
-                (lower_layer_edge_grid ? lower_layer_edge_grid.get() : nullptr));
+                lower_layer_edge_grid);
             m_config.apply(m_region->config());
             m_writer.apply_print_region_config(m_region->config());
             if (m_config.print_temperature > 0)
@@ -4276,12 +4353,27 @@ std::string GCode::extrude_perimeters(const Print &print, const std::vector<Obje
             else if (m_config.temperature.get_at(m_writer.tool()->id()) > 0) // don't set it if disabled
                 gcode += m_writer.set_temperature(m_config.temperature.get_at(m_writer.tool()->id()), false, m_writer.tool()->id());
             for (const ExtrusionEntity *ee : region.perimeters)
-                gcode += this->extrude_entity(*ee, "", -1., &lower_layer_edge_grid);
+                gcode += this->extrude_entity(*ee, "", -1., lower_layer_edge_grid);
             m_region = nullptr;
         }
     return gcode;
 }
 
+// Distance field of the layer below, calculated by PrintObject::make_perimeters(). With a layer memory budget
+// the layers have none, it is calculated here for the layers being printed and released with them.
+const EdgeGrid::Grid* GCode::lower_layer_edge_grid()
+{
+    const Layer *lower_layer = m_layer->lower_layer;
+    if (lower_layer == nullptr)
+        return nullptr;
+    if (const EdgeGrid::Grid *grid = lower_layer->lslices_grid(); grid != nullptr)
+        return grid;
+    std::unique_ptr<EdgeGrid::Grid> &grid = m_lower_layer_edge_grids[lower_layer];
+    if (! grid)
+        grid = lower_layer->create_lslices_grid();
+    return grid.get();
+}
+
 // Chain the paths hierarchically by a greedy algorithm to minimize a travel distance.
 std::string GCode::extrude_infill(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region, bool is_infill_first)
 {
@@ -4470,15 +4562,18 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string &descri
         * this->config().print_extrusion_multiplier.get_abs_value(1);
     if (m_layer->bottom_z() < EPSILON) e_per_mm *= this->config().first_layer_flow_ratio.get_abs_value(1);
     if (m_writer.extrusion_axis().empty()) e_per_mm = 0;
-    if (path.polyline.lines().size() > 0) {
+    if (path.polyline.points.size() > 1) {
         //get last direction //TODO: save it
         {
             std::string comment = m_config.gcode_comments ? descr : "";
             if (path.role() != erExternalPerimeter || config().external_perimeter_cut_corners.value == 0) {
                 // normal & legacy pathcode
-                for (const Line& line : path.polyline.lines()) {
+                // about 32 bytes per G1 line, appended to gcode by the writer
+                gcode.reserve(gcode.size() + 32 * path.polyline.points.size());
+                for (size_t i = 1; i < path.polyline.points.size(); ++ i) {
+                    const Line line(path.polyline.points[i - 1], path.polyline.points[i]);
                     if (line.a == line.b) continue; //todo: investigate if it happens (it happens in perimeters)
-                    gcode += m_writer.extrude_to_xy(
+                    m_writer.extrude_to_xy(gcode,
                         this->point_to_gcode(line.b),
                         e_per_mm * unscaled(line.length()),
                         comment);
@@ -4520,7 +4615,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string &descri
                             //Create a point
                             Point inter_point1 = line.point_at(scale_d(length1));
                             //extrude very reduced
-                            gcode += m_writer.extrude_to_xy(
+                            m_writer.extrude_to_xy(gcode,
                                 this->point_to_gcode(inter_point1),
                                 e_per_mm * (length1) * mult1,
                                 comment);
@@ -4529,21 +4624,21 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string &descri
                             if (line_length - length1 > length2) {
                                 Point inter_point2 = line.point_at(scale_d(length1 + length2));
                                 //extrude reduced
-                                gcode += m_writer.extrude_to_xy(
+                                m_writer.extrude_to_xy(gcode,
                                     this->point_to_gcode(inter_point2),
                                     e_per_mm * (length2) * mult2,
                                     comment);
                                 sum += e_per_mm * (length2) * mult2;
 
                                 //extrude normal
-                                gcode += m_writer.extrude_to_xy(
+                                m_writer.extrude_to_xy(gcode,
                                     this->point_to_gcode(line.b),
                                     e_per_mm * (line_length - (length1 + length2)),
                                     comment);
                                 sum += e_per_mm * (line_length - (length1 + length2));
                             } else {
                                 mult2 = 1 - coeff * (length2 / (line_length - length1));
-                                gcode += m_writer.extrude_to_xy(
+                                m_writer.extrude_to_xy(gcode,
                                     this->point_to_gcode(line.b),
                                     e_per_mm * (line_length - length1) * mult2,
                                     comment);
@@ -4551,14 +4646,14 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string &descri
                             }
                         } else {
                             double mult = std::max(0.1, 1 - coeff * (scale_(path.width) / line_length));
-                            gcode += m_writer.extrude_to_xy(
+                            m_writer.extrude_to_xy(gcode,
                                 this->point_to_gcode(line.b),
                                 e_per_mm * line_length * mult,
                                 comment);
                         }
                     } else {
                         // nothing special, angle is too shallow to have any impact.
-                        gcode += m_writer.extrude_to_xy(
+                        m_writer.extrude_to_xy(gcode,
                             this->point_to_gcode(line.b),
                             e_per_mm * unscaled(line.length()),
                             comment);
@@ -5074,7 +5169,7 @@ std::string GCode::_before_extrude(const ExtrusionPath &path, const std::string
     }
     // F     is mm per minute.
     // speed is mm per second
-    gcode += m_writer.set_speed(speed, "", comment);
+    m_writer.set_speed(gcode, speed, "", comment);
 
     return gcode;
 }
@@ -5228,7 +5323,7 @@ void GCode::write_travel_to(std::string &gcode, const Polyline& travel, std::str
             } else if (current_speed < max_speed) {
                 current_speed = max_speed;
             }
-            gcode += m_writer.travel_to_xy(
+            m_writer.travel_to_xy(gcode,
                 this->point_to_gcode(travel.points[idx_print]),
                 current_speed>2 ? double(uint32_t(current_speed)) : current_speed,
                 comment);
@@ -5258,14 +5353,14 @@ void GCode::write_travel_to(std::string &gcode, const Polyline& travel, std::str
 
         //finish writing moves at current speed
         for (; idx_print < travel.size(); ++idx_print)
-            gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[idx_print]),
+            m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[idx_print]),
                 current_speed > 2 ? double(uint32_t(current_speed)) : current_speed,
                 comment);
         this->set_last_pos(travel.points.back());
     } else if (travel.size() >= 2) {
         for (size_t i = 1; i < travel.size(); ++i)
             // use G1 because we rely on paths being straight (G0 may make round paths)
-            gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[i]), 0.0, comment);
+            m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[i]), 0.0, comment);
         this->set_last_pos(travel.points.back());
     }
 }
@@ -10,10 +10,12 @@
 #include "Print.hpp"
 #include "PlaceholderParser.hpp"
 #include "PrintConfig.hpp"
+#include "GCode/ArcFitter.hpp"
 #include "GCode/AvoidCrossingPerimeters.hpp"
 #include "GCode/CoolingBuffer.hpp"
 #include "GCode/FanMover.hpp"
 #include "GCode/FindReplace.hpp"
+#include "GCode/MoveBuffer.hpp"
 #include "GCode/SpiralVase.hpp"
 #include "GCode/ToolOrdering.hpp"
 #include "GCode/WipeTower.hpp"
@@ -21,6 +23,7 @@
 #include "GCode/GCodeProcessor.hpp"
 #include "GCode/ThumbnailData.hpp"
 
+#include <deque>
 #include <memory>
 #include <map>
 #include <string>
@@ -244,13 +247,30 @@ private:
         bool        spiral_vase_enable { false };
         // Should the cooling buffer content be flushed at the end of this layer?
         bool        cooling_buffer_flush { false };
+        // Extruder active before the G-code of this layer, the tool changes are then tracked by the tokenizer.
+        uint16_t    extruder { 0 };
     };
+    // LayerResult with its G-code tokenized, as passed to the filters of process_layers().
+    struct LayerMoves {
+        MoveBuffer  gcode;
+        size_t      layer_id;
+        bool        spiral_vase_enable { false };
+        bool        cooling_buffer_flush { false };
+    };
+    struct ObjectByExtruder;
+    // Extrusions of a set of layers with the same print_z, by an extruder, then by an object, an island and a region.
+    using ExtrusionsByExtruder = std::map<uint16_t, std::vector<ObjectByExtruder>>;
+    // Only reads the layers and their tool ordering, not the state of the G-code generator: process_layers() runs it
+    // in parallel for the next layers while process_layer() emits the G-code of the current one.
+    static ExtrusionsByExtruder group_extrusions_by_extruder(const Print &print, const std::vector<LayerToPrint> &layers, const LayerTools &layer_tools);
     LayerResult process_layer(
         const Print                     &print,
         PrintStatistics                 &print_stat,
         // Set of object & print layers of the same PrintObject and with the same print_z.
         const std::vector<LayerToPrint> &layers,
         const LayerTools  				&layer_tools,
+        // Extrusions of the layers, see group_extrusions_by_extruder().
+        ExtrusionsByExtruder            &by_extruder,
         const bool                       last_layer,
 		// Pairs of PrintObject index and its instance index.
 		const std::vector<const PrintInstance*> *ordering,
@@ -287,21 +307,21 @@ private:
     std::string     visitor_gcode;
     std::string     visitor_comment;
     double          visitor_speed;
-    std::unique_ptr<EdgeGrid::Grid> *visitor_lower_layer_edge_grid;
+    const EdgeGrid::Grid *visitor_lower_layer_edge_grid;
     virtual void use(const ExtrusionPath &path) override { visitor_gcode += extrude_path(path, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionPath3D &path3D) override { visitor_gcode += extrude_path_3D(path3D, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionMultiPath &multipath) override { visitor_gcode += extrude_multi_path(multipath, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionMultiPath3D &multipath) override { visitor_gcode += extrude_multi_path3D(multipath, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionLoop &loop) override { visitor_gcode += extrude_loop(loop, visitor_comment, visitor_speed, visitor_lower_layer_edge_grid); };
     virtual void use(const ExtrusionEntityCollection &collection) override;
-    std::string     extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
-    std::string     extrude_loop(const ExtrusionLoop &loop, const std::string &description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
-    std::string     extrude_loop_vase(const ExtrusionLoop &loop, const std::string &description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
+    std::string     extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed = -1., const EdgeGrid::Grid *lower_layer_edge_grid = nullptr);
+    std::string     extrude_loop(const ExtrusionLoop &loop, const std::string &description, double speed = -1., const EdgeGrid::Grid *lower_layer_edge_grid = nullptr);
+    std::string     extrude_loop_vase(const ExtrusionLoop &loop, const std::string &description, double speed = -1., const EdgeGrid::Grid *lower_layer_edge_grid = nullptr);
     std::string     extrude_multi_path(const ExtrusionMultiPath &multipath, const std::string &description, double speed = -1.);
     std::string     extrude_multi_path3D(const ExtrusionMultiPath3D &multipath, const std::string &description, double speed = -1.);
     std::string     extrude_path(const ExtrusionPath &path, const std::string &description, double speed = -1.);
     std::string     extrude_path_3D(const ExtrusionPath3D &path, const std::string &description, double speed = -1.);
-    void            split_at_seam_pos(ExtrusionLoop &loop, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid, bool was_clockwise);
+    void            split_at_seam_pos(ExtrusionLoop &loop, const EdgeGrid::Grid *lower_layer_edge_grid, bool was_clockwise);
 
     // Extruding multiple objects with soluble / non-soluble / combined supports
     // on a multi-material printer, trying to minimize tool switches.
@@ -361,6 +381,17 @@ private:
 		const size_t			 instance_id;
 	};
 
+    // A layer of process_layers(), from the grouping of its extrusions to process_layer().
+    struct LayerToProcess {
+        // Set of object & print layers of the same PrintObject and with the same print_z.
+        std::vector<LayerToPrint>                        layers;
+        const LayerTools                                *layer_tools { nullptr };
+        bool                                             last_layer { false };
+        // Keeps the spilled layers paged in until their G-code is generated.
+        std::shared_ptr<std::deque<LayerSpill::Loader>>  loaders;
+        ExtrusionsByExtruder                             by_extruder;
+    };
+
 	std::vector<InstanceToPrint> sort_print_object_instances(
 		std::vector<ObjectByExtruder> 					&objects_by_extruder,
 		// Object and Support layers for the current print_z, collected for a single object, or for possibly multiple objects with multiple instances.
@@ -370,7 +401,9 @@ private:
 		// For sequential print, the instance of the object to be printing has to be defined.
 		const size_t                     				 single_object_instance_idx);
 
-    std::string     extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, std::unique_ptr<EdgeGrid::Grid> &lower_layer_edge_grid);
+    std::string     extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region);
+    // Distance field of the layer below m_layer to place the seams.
+    const EdgeGrid::Grid* lower_layer_edge_grid();
     std::string     extrude_infill(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region, bool is_infill_first);
     std::string     extrude_ironing(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region);
     std::string     extrude_support(const ExtrusionEntityCollection &support_fills);
@@ -386,6 +419,8 @@ private:
 
     // Cache for custom seam enforcers/blockers for each layer.
     SeamPlacer                          m_seam_placer;
+    // Grids of the lower layers of the layers being printed, if their objects have none (layer memory budget).
+    std::map<const Layer*, std::unique_ptr<EdgeGrid::Grid>> m_lower_layer_edge_grids;
 
     /* Origin of print coordinates expressed in unscaled G-code coordinates.
        This affects the input arguments supplied to the extrude*() and travel_to()
@@ -489,6 +524,7 @@ private:
 
     //some post-processing on the file, with their data class
     std::unique_ptr<FanMover> m_fan_mover;
+    std::unique_ptr<ArcFitter> m_arc_fitter;
 
     std::string _extrude(const ExtrusionPath &path, const std::string &description, double speed = -1);
     std::string _before_extrude(const ExtrusionPath &path, const std::string &description, double speed = -1);
@@ -0,0 +1,231 @@
+#include "ArcFitter.hpp"
+
+#include "../LocalesUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Slic3r {
+
+ArcFitter::ArcFitter(const GCodeConfig &config, const double tolerance)
+    : m_tolerance(std::max(tolerance, EPSILON))
+    , m_precision_xyz(config.gcode_precision_xyz.value)
+    , m_precision_e(config.gcode_precision_e.value)
+    , m_extrusion_axis(get_extrusion_axis(config).empty() ? 0 : get_extrusion_axis(config)[0])
+    , m_relative_e(config.use_relative_e_distances.value)
+{}
+
+MoveBuffer ArcFitter::process_layer(MoveBuffer &&gcode)
+{
+    MoveBuffer out(gcode.syntax(), gcode.start_extruder());
+    for (const MoveBuffer::Line &line : gcode.lines())
+        this->_process_line(gcode, line, out);
+    // arcs don't span over layers: the layer change always ends with a z move.
+    this->_flush(gcode, out);
+    return out;
+}
+
+std::string ArcFitter::process_layer(const std::string &gcode)
+{
+    // The tool changes are not read by this filter.
+    MoveBuffer::Syntax syntax;
+    syntax.extrusion_axis = m_extrusion_axis;
+    return this->process_layer(MoveBuffer(std::string(gcode), syntax)).release_text();
+}
+
+void ArcFitter::_process_line(const MoveBuffer &in, const MoveBuffer::Line &line, MoveBuffer &out)
+{
+    const bool is_move = line.letter == 'G' && line.code >= 0 && line.code <= 3;
+    const bool has_x   = line.has(X);
+    const bool has_y   = line.has(Y);
+    const bool has_e   = line.has(E);
+
+    // Is it an extrusion that can be merged into an arc?
+    if (line.is_G(1) && m_pos_known && !m_relative_xyz && m_extrusion_axis != 0
+        && (has_x || has_y) && has_e && !line.has(Z) && !line.has(UNKNOWN_AXIS)) {
+        const double de = m_relative_e ? line.value(E) : line.value(E) - m_e;
+        if (de > 0) {
+            // a new feedrate starts a new run
+            if (line.has(F))
+                this->_flush(in, out);
+            if (m_moves.empty())
+                m_run_start = m_pos;
+            Move move;
+            move.line    = &line;
+            move.pos     = Vec2d(has_x ? line.value(X) : m_pos.x(), has_y ? line.value(Y) : m_pos.y());
+            move.de      = de;
+            move.e       = in.value_text(line, E);
+            move.f       = in.value_text(line, F);
+            move.comment = in.comment(line);
+            m_pos = move.pos;
+            if (!m_relative_e)
+                m_e = line.value(E);
+            m_moves.push_back(move);
+            return;
+        }
+    }
+
+    this->_flush(in, out);
+    out.append(in, line);
+
+    // update the machine state
+    if (is_move) {
+        if (m_relative_xyz) {
+            m_pos += Vec2d(has_x ? line.value(X) : 0., has_y ? line.value(Y) : 0.);
+        } else {
+            if (has_x) m_pos.x() = line.value(X);
+            if (has_y) m_pos.y() = line.value(Y);
+            // can't know the position before a move on both axes.
+            m_pos_known = m_pos_known || (has_x && has_y);
+        }
+        if (has_e && !m_relative_e)
+            m_e = line.value(E);
+    } else if (line.is_G(92)) {
+        if (has_x) m_pos.x() = line.value(X);
+        if (has_y) m_pos.y() = line.value(Y);
+        if (has_e) m_e = line.value(E);
+    } else if (line.is_G(28)) {
+        m_pos_known = false;
+    } else if (line.is_G(90) || line.is_G(91)) {
+        m_relative_xyz = line.code == 91;
+    } else if (line.is_M(82) || line.is_M(83)) {
+        m_relative_e = line.code == 83;
+    }
+}
+
+void ArcFitter::_flush(const MoveBuffer &in, MoveBuffer &out)
+{
+    const size_t nb_moves = m_moves.size();
+    size_t idx = 0;
+    while (idx < nb_moves) {
+        Arc    arc;
+        size_t last = idx + min_segments;
+        if (last <= nb_moves && this->_fit(idx, last, arc)) {
+            // Extend the arc as much as possible. Each fit checks all the moves of the arc, so the end isn't searched
+            // one move at a time (quadratic on the long runs of the round parts) but by doubling the step, then by bisection.
+            Arc    next_arc;
+            size_t step = 1;
+            size_t bad  = nb_moves + 1;
+            while (last < nb_moves) {
+                const size_t next = std::min(last + step, nb_moves);
+                if (! this->_fit(idx, next, next_arc)) {
+                    bad = next;
+                    break;
+                }
+                last = next;
+                arc  = next_arc;
+                step *= 2;
+            }
+            while (bad <= nb_moves && bad - last > 1) {
+                const size_t next = (last + bad) / 2;
+                if (this->_fit(idx, next, next_arc)) {
+                    last = next;
+                    arc  = next_arc;
+                } else
+                    bad = next;
+            }
+            this->_emit_arc(idx, last, arc, out);
+            idx = last;
+        } else {
+            out.append(in, *m_moves[idx].line);
+            ++idx;
+        }
+    }
+    m_moves.clear();
+}
+
+bool ArcFitter::_fit(size_t first, size_t last, Arc &arc) const
+{
+    assert(last > first + 1 && last <= m_moves.size());
+    // circle from the first, middle & last points
+    const Vec2d  p0 = this->_point(first);
+    const Vec2d  a  = this->_point((first + last) / 2) - p0;
+    const Vec2d  b  = this->_point(last) - p0;
+    const double d  = 2. * (a.x() * b.y() - a.y() * b.x());
+    if (std::abs(d) < EPSILON)
+        return false;
+    const Vec2d center_rel((b.y() * a.squaredNorm() - a.y() * b.squaredNorm()) / d,
+                           (a.x() * b.squaredNorm() - b.x() * a.squaredNorm()) / d);
+    arc.center = p0 + center_rel;
+    arc.radius = center_rel.norm();
+    arc.ccw    = d > 0;
+    if (arc.radius > max_radius || arc.radius < m_tolerance)
+        return false;
+
+    double total_angle = 0;
+    double total_length = 0;
+    double total_e = 0;
+    for (size_t idx = first; idx < last; ++idx) {
+        const Vec2d  pa = this->_point(idx) - arc.center;
+        const Vec2d  pb = this->_point(idx + 1) - arc.center;
+        if (std::abs(pb.norm() - arc.radius) > m_tolerance)
+            return false;
+        // the middle of the segment also has to be near the arc
+        const double length = (pb - pa).norm();
+        if (length < EPSILON || length >= 2 * arc.radius)
+            return false;
+        if (arc.radius - std::sqrt(arc.radius * arc.radius - length * length / 4) > m_tolerance)
+            return false;
+        // always in the same direction
+        const double angle = std::atan2(pa.x() * pb.y() - pa.y() * pb.x(), pa.dot(pb));
+        if (arc.ccw ? angle <= 0 : angle >= 0)
+            return false;
+        total_angle += std::abs(angle);
+        total_length += length;
+        total_e += m_moves[idx].de;
+    }
+    // no full circle: the end would be ambiguous
+    if (total_angle > 2 * PI - 0.01)
+        return false;
+    // the extrusion rate has to be (almost) constant, as the firmware will spread it evenly over the arc.
+    const double e_per_mm = total_e / total_length;
+    for (size_t idx = first; idx < last; ++idx) {
+        const double length = (this->_point(idx + 1) - this->_point(idx)).norm();
+        if (std::abs(m_moves[idx].de / length - e_per_mm) > 0.05 * e_per_mm)
+            return false;
+    }
+    return true;
+}
+
+// to_string_nozero, without the '-0' for the values rounded to zero.
+static std::string to_string_nozero_signless(double value, int32_t max_precision)
+{
+    return to_string_nozero(std::abs(value) < 0.5 * std::pow(10., -max_precision) ? 0. : value, max_precision);
+}
+
+void ArcFitter::_emit_arc(size_t first, size_t last, const Arc &arc, MoveBuffer &out_buffer) const
+{
+    std::string out;
+    const Vec2d start = this->_point(first);
+    const Vec2d end   = this->_point(last);
+    out += arc.ccw ? "G3" : "G2";
+    out += " X";
+    out += to_string_nozero_signless(end.x(), m_precision_xyz);
+    out += " Y";
+    out += to_string_nozero_signless(end.y(), m_precision_xyz);
+    out += " I";
+    out += to_string_nozero_signless(arc.center.x() - start.x(), m_precision_xyz);
+    out += " J";
+    out += to_string_nozero_signless(arc.center.y() - start.y(), m_precision_xyz);
+    out += ' ';
+    out += m_extrusion_axis;
+    if (m_relative_e) {
+        double de = 0;
+        for (size_t idx = first; idx < last; ++idx)
+            de += m_moves[idx].de;
+        out += to_string_nozero(de, m_precision_e);
+    } else {
+        out += m_moves[last - 1].e;
+    }
+    if (!m_moves[first].f.empty()) {
+        out += " F";
+        out += m_moves[first].f;
+    }
+    if (!m_moves[first].comment.empty()) {
+        out += ' ';
+        out += m_moves[first].comment;
+    }
+    out_buffer.append_gcode(out);
+}
+
+} // namespace Slic3r
@@ -0,0 +1,82 @@
+#ifndef slic3r_GCode_ArcFitter_hpp_
+#define slic3r_GCode_ArcFitter_hpp_
+
+#include "../libslic3r.h"
+#include "../PrintConfig.hpp"
+#include "../Point.hpp"
+#include "MoveBuffer.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Slic3r {
+
+// Post-processing filter of the G-code export pipeline:
+// collapses runs of short G1 extrusions lying on a circle (curved perimeters, holes, ...) into G2/G3 arcs.
+// It has to be called after the CoolingBuffer and the FanMover, as they don't understand G2/G3.
+// It's stateful (current position & extruder state), so it has to be fed the layers in order.
+class ArcFitter
+{
+public:
+    ArcFitter(const GCodeConfig &config, const double tolerance);
+
+    // Process a layer of G-code, returns it with the arcs fitted.
+    MoveBuffer  process_layer(MoveBuffer &&gcode);
+    std::string process_layer(const std::string &gcode);
+    // Forget the current position, to be called when some G-code is written without being processed by this filter.
+    void        reset_position() { m_pos_known = false; }
+
+    // Minimum number of G1 segments to replace by an arc.
+    static constexpr const size_t min_segments = 3;
+    // Don't emit arcs with a radius bigger than this (mm): firmwares can't do them accurately, and they are straight lines anyway.
+    static constexpr const double max_radius = 2000.;
+
+private:
+    // A G1 extrusion move that can be part of an arc, the views are into the text of the layer being processed.
+    struct Move {
+        const MoveBuffer::Line *line;
+        Vec2d                   pos;
+        // Extrusion length of this move (always relative).
+        double                  de;
+        // E & F values as written in the line, to write them back without any rounding.
+        std::string_view        e;
+        // Feedrate, only allowed on the first move of a run.
+        std::string_view        f;
+        // Trailing comment (with its ';')
+        std::string_view        comment;
+    };
+    struct Arc {
+        Vec2d  center;
+        double radius;
+        bool   ccw;
+    };
+
+    void _process_line(const MoveBuffer &in, const MoveBuffer::Line &line, MoveBuffer &out);
+    // Fit arcs on the buffered moves and write the result into out.
+    void _flush(const MoveBuffer &in, MoveBuffer &out);
+    // Check that the points from m_start/m_moves [first, last] lie on a circle within m_tolerance.
+    bool _fit(size_t first, size_t last, Arc &arc) const;
+    Vec2d _point(size_t idx) const { return idx == 0 ? m_run_start : m_moves[idx - 1].pos; }
+    void _emit_arc(size_t first, size_t last, const Arc &arc, MoveBuffer &out) const;
+
+    const double m_tolerance;
+    const int    m_precision_xyz;
+    const int    m_precision_e;
+    const char   m_extrusion_axis;
+
+    // Machine state, after the last line read.
+    Vec2d  m_pos = Vec2d::Zero();
+    bool   m_pos_known = false;
+    double m_e = 0;
+    bool   m_relative_e;
+    bool   m_relative_xyz = false;
+
+    // Current run of candidate moves.
+    Vec2d             m_run_start;
+    std::vector<Move> m_moves;
+};
+
+} // namespace Slic3r
+
+#endif /* slic3r_GCode_ArcFitter_hpp_ */
@@ -1347,12 +1347,13 @@ void AvoidCrossingPerimeters::init_layer(const Layer &layer)
     m_internal.clear();
     m_external.clear();
 
-    BoundingBox bbox_slice(get_extents(layer.lslices));
-    bbox_slice.offset(SCALED_EPSILON);
-
-    m_grid_lslice.set_bbox(bbox_slice);
-    //FIXME 1mm grid?
-    m_grid_lslice.create(layer.lslices, coord_t(scale_(1.)));
+    // Built in parallel by PrintObject::make_lslices_grids(), not for the support layers nor with a layer memory budget.
+    m_grid_lslice = layer.lslices_travel_grid();
+    if (m_grid_lslice == nullptr) {
+        m_grid_lslice_data = layer.create_lslices_travel_grid();
+        m_grid_lslice = m_grid_lslice_data.get();
+    } else
+        m_grid_lslice_data.reset();
     m_init = true;
 }
 
@@ -1600,7 +1601,7 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
         result_pl.translate(-scaled_origin);
         *could_be_wipe_disabled = false;
     } else
-        *could_be_wipe_disabled = !need_wipe(gcodegen, m_grid_lslice, travel, result_pl, travel_intersection_count);
+        *could_be_wipe_disabled = !need_wipe(gcodegen, *m_grid_lslice, travel, result_pl, travel_intersection_count);
 
     return result_pl;
 }
@@ -65,7 +65,9 @@ private:
     bool m_init{ false };
 
     // Used for detection of line or polyline is inside of any polygon.
-    EdgeGrid::Grid m_grid_lslice;
+    // Grid of the layer (Layer::lslices_travel_grid()), or m_grid_lslice_data if the layer has none.
+    const EdgeGrid::Grid           *m_grid_lslice { nullptr };
+    std::unique_ptr<EdgeGrid::Grid> m_grid_lslice_data;
     // Store all needed data for travels inside object
     Boundary m_internal;
     // Store all needed data for travels outside object
@@ -0,0 +1,420 @@
+#include "BinaryGCode.hpp"
+
+#include "../libslic3r.h"
+#include "../miniz_extension.hpp"
+#include "libslic3r_version.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/beast/core/detail/base64.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include <tbb/task_arena.h>
+
+namespace Slic3r {
+namespace BinaryGCode {
+
+static constexpr const uint16_t checksum_crc32 = 1;
+// Metadata and G-code blocks encoding parameter: plain text.
+static constexpr const uint16_t encoding_text = 0;
+// A corrupted block size shouldn't make us allocate gigabytes.
+static constexpr const uint32_t max_block_size = 1 << 30;
+
+static void put_u16(std::vector<char> &out, uint16_t value)
+{
+    out.push_back(char(value & 0xff));
+    out.push_back(char(value >> 8));
+}
+
+static void put_u32(std::vector<char> &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++ i)
+        out.push_back(char((value >> (8 * i)) & 0xff));
+}
+
+static uint16_t get_u16(const unsigned char *data) { return uint16_t(data[0] | (data[1] << 8)); }
+static uint32_t get_u32(const unsigned char *data) { return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24); }
+
+// Block with its header, parameters, (compressed) data and checksum, as written into the file.
+static std::vector<char> make_block(BlockType type, const std::vector<char> &params, const char *data, size_t size, int compression_level)
+{
+    std::vector<char> compressed;
+    Compression       compression = Compression::None;
+    if (compression_level > 0 && size > 0) {
+        mz_ulong compressed_size = mz_compressBound(mz_ulong(size));
+        compressed.assign(compressed_size, 0);
+        if (mz_compress2(reinterpret_cast<unsigned char*>(compressed.data()), &compressed_size, reinterpret_cast<const unsigned char*>(data), mz_ulong(size), compression_level) == MZ_OK &&
+            compressed_size < size) {
+            compressed.resize(compressed_size);
+            compression = Compression::Deflate;
+        }
+    }
+    std::vector<char> out;
+    out.reserve(16 + params.size() + (compression == Compression::None ? size : compressed.size()));
+    put_u16(out, uint16_t(type));
+    put_u16(out, uint16_t(compression));
+    put_u32(out, uint32_t(size));
+    if (compression != Compression::None)
+        put_u32(out, uint32_t(compressed.size()));
+    out.insert(out.end(), params.begin(), params.end());
+    if (compression == Compression::None)
+        out.insert(out.end(), data, data + size);
+    else
+        out.insert(out.end(), compressed.begin(), compressed.end());
+    put_u32(out, uint32_t(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(out.data()), out.size())));
+    return out;
+}
+
+static std::vector<char> text_params()
+{
+    std::vector<char> params;
+    put_u16(params, encoding_text);
+    return params;
+}
+
+bool is_binary_gcode_file(const std::string &filename)
+{
+    FILE *file = boost::nowide::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    char header[sizeof(magic)];
+    const bool binary = fread(header, 1, sizeof(header), file) == sizeof(header) && memcmp(header, magic, sizeof(magic)) == 0;
+    fclose(file);
+    return binary;
+}
+
+Encoder::Encoder(FILE *file, const std::string &producer, int compression_level) :
+    m_file(file), m_compression_level(std::clamp(compression_level, 0, 10))
+{
+    std::vector<char> header(magic, magic + sizeof(magic));
+    put_u32(header, version);
+    put_u16(header, checksum_crc32);
+    this->write(header.data(), header.size());
+    const std::string metadata = "Producer = " + producer + "\n";
+    this->write_block(BlockType::FileMetadata, text_params(), metadata.data(), metadata.size());
+}
+
+Encoder::~Encoder()
+{
+    m_tasks.wait();
+}
+
+void Encoder::append(const char *begin, const char *end)
+{
+    while (begin != end) {
+        const char *eol = std::find(begin, end, '\n');
+        if (eol == end) {
+            m_line.append(begin, end);
+            break;
+        }
+        if (m_line.empty())
+            this->process_line(begin, eol);
+        else {
+            m_line.append(begin, eol);
+            this->process_line(m_line.data(), m_line.data() + m_line.size());
+            m_line.clear();
+        }
+        begin = eol + 1;
+    }
+}
+
+bool Encoder::finish()
+{
+    if (! m_line.empty()) {
+        this->process_line(m_line.data(), m_line.data() + m_line.size());
+        m_line.clear();
+    }
+    if (m_section != Section::GCode) {
+        // Unterminated thumbnail or config: keep it as it is.
+        m_section = Section::GCode;
+        m_gcode.insert(m_gcode.end(), m_section_lines.begin(), m_section_lines.end());
+    }
+    this->flush_gcode();
+    m_tasks.wait();
+    this->write_pending();
+    return ! m_error;
+}
+
+static bool starts_with(const char *begin, const char *end, const char *prefix)
+{
+    const size_t len = strlen(prefix);
+    return size_t(end - begin) >= len && memcmp(begin, prefix, len) == 0;
+}
+
+void Encoder::process_line(const char *begin, const char *end)
+{
+    if (m_section != Section::GCode) {
+        if (size_t(end - begin) == m_section_end.size() && memcmp(begin, m_section_end.data(), m_section_end.size()) == 0) {
+            const Section section = m_section;
+            m_section = Section::GCode;
+            if (section == Section::Thumbnail) {
+                std::vector<char> image(boost::beast::detail::base64::decoded_size(m_section_data.size()), 0);
+                auto [written, read] = boost::beast::detail::base64::decode(image.data(), m_section_data.data(), m_section_data.size());
+                if (read == m_section_data.size() && written > 0) {
+                    std::vector<char> params;
+                    put_u16(params, uint16_t(m_thumbnail_format));
+                    put_u16(params, m_thumbnail_width);
+                    put_u16(params, m_thumbnail_height);
+                    this->write_block(BlockType::Thumbnail, params, image.data(), written);
+                } else {
+                    // Not a valid thumbnail, keep it as text.
+                    m_gcode.insert(m_gcode.end(), m_section_lines.begin(), m_section_lines.end());
+                    m_gcode.insert(m_gcode.end(), begin, end);
+                    m_gcode.push_back('\n');
+                }
+            } else
+                this->write_block(BlockType::SlicerMetadata, text_params(), m_section_data.data(), m_section_data.size());
+            return;
+        }
+        if (starts_with(begin, end, "; ")) {
+            m_section_lines.append(begin, end);
+            m_section_lines += '\n';
+            m_section_data.append(begin + 2, end);
+            if (m_section == Section::Config)
+                m_section_data += '\n';
+            return;
+        }
+        // Something else than a comment inside the section: it isn't a section we know, keep it as text.
+        m_section = Section::GCode;
+        m_gcode.insert(m_gcode.end(), m_section_lines.begin(), m_section_lines.end());
+    }
+
+    if (starts_with(begin, end, "; thumbnail")) {
+        // "; thumbnail begin 300x300 12345", "; thumbnail_JPG begin ..." or "; thumbnail_QOI begin ..."
+        static constexpr const std::pair<const char*, ThumbnailFormat> tags[] = {
+            { "; thumbnail begin ",     ThumbnailFormat::PNG },
+            { "; thumbnail_JPG begin ", ThumbnailFormat::JPG },
+            { "; thumbnail_QOI begin ", ThumbnailFormat::QOI },
+        };
+        for (const auto &[tag, format] : tags)
+            if (starts_with(begin, end, tag)) {
+                unsigned int width = 0, height = 0;
+                if (sscanf(std::string(begin + strlen(tag), end).c_str(), "%ux%u", &width, &height) == 2 && width <= 0xffff && height <= 0xffff) {
+                    m_section          = Section::Thumbnail;
+                    m_thumbnail_format = format;
+                    m_thumbnail_width  = uint16_t(width);
+                    m_thumbnail_height = uint16_t(height);
+                    m_section_end      = std::string(tag, strlen(tag) - strlen("begin ")) + "end";
+                    m_section_lines.assign(begin, end);
+                    m_section_lines += '\n';
+                    m_section_data.clear();
+                    return;
+                }
+            }
+    } else if (size_t(end - begin) == strlen("; " SLIC3R_APP_NAME "_config = begin") && starts_with(begin, end, "; " SLIC3R_APP_NAME "_config = begin")) {
+        m_section     = Section::Config;
+        m_section_end = "; " SLIC3R_APP_NAME "_config = end";
+        m_section_lines.assign(begin, end);
+        m_section_lines += '\n';
+        m_section_data.clear();
+        return;
+    }
+
+    if (! m_gcode.empty() && m_gcode.size() + size_t(end - begin) + 1 > max_gcode_block_size)
+        this->flush_gcode();
+    m_gcode.insert(m_gcode.end(), begin, end);
+    m_gcode.push_back('\n');
+}
+
+void Encoder::flush_gcode()
+{
+    if (m_gcode.empty())
+        return;
+    // Above this number of blocks being compressed, wait for them to be compressed and written,
+    // so that the G-code doesn't pile up in memory if the disk is slower than the compression.
+    const size_t max_pending = 4 * size_t(tbb::this_task_arena::max_concurrency());
+    if (m_pending.size() >= max_pending) {
+        m_tasks.wait();
+        this->write_pending();
+    }
+    PendingBlock &block = m_pending.emplace_back();
+    block.text = std::move(m_gcode);
+    m_gcode = {};
+    m_gcode.reserve(max_gcode_block_size);
+    m_tasks.run([&block, level = m_compression_level]() {
+        block.compressed = make_block(BlockType::GCode, text_params(), block.text.data(), block.text.size(), level);
+        block.text = {};
+    });
+}
+
+void Encoder::write_pending()
+{
+    for (const PendingBlock &block : m_pending)
+        this->write(block.compressed.data(), block.compressed.size());
+    m_pending.clear();
+}
+
+void Encoder::write_block(BlockType type, const std::vector<char> &params, const char *data, size_t size)
+{
+    // After the G-code before it.
+    this->flush_gcode();
+    m_tasks.wait();
+    this->write_pending();
+    // The images are already compressed.
+    const std::vector<char> block = make_block(type, params, data, size, type == BlockType::Thumbnail ? 0 : m_compression_level);
+    this->write(block.data(), block.size());
+}
+
+void Encoder::write(const void *data, size_t size)
+{
+    if (! m_error && fwrite(data, 1, size, m_file) != size)
+        m_error = true;
+}
+
+Reader::Reader(const std::string &filename)
+{
+    m_file = boost::nowide::fopen(filename.c_str(), "rb");
+    if (m_file == nullptr) {
+        m_error = "Cannot open " + filename;
+        return;
+    }
+    unsigned char header[10];
+    if (! this->read(header, sizeof(header)) || memcmp(header, magic, sizeof(magic)) != 0)
+        m_error = "Not a binary G-code file";
+    else if (get_u32(header + 4) > version)
+        m_error = "Unsupported binary G-code version";
+    else if (get_u16(header + 8) != checksum_crc32)
+        m_error = "Unsupported binary G-code checksum";
+}
+
+Reader::~Reader()
+{
+    if (m_file != nullptr)
+        fclose(m_file);
+}
+
+bool Reader::read(void *data, size_t size)
+{
+    if (fread(data, 1, size, m_file) == size)
+        return true;
+    m_error = ferror(m_file) ? "Error while reading the binary G-code" : "Truncated binary G-code";
+    return false;
+}
+
+bool Reader::next_block(Block &block)
+{
+    if (! m_error.empty() || m_eof)
+        return false;
+    std::vector<unsigned char> raw(8, 0);
+    // End of file before a block header.
+    const size_t first_read = fread(raw.data(), 1, raw.size(), m_file);
+    if (first_read == 0 && feof(m_file)) {
+        m_eof = true;
+        return false;
+    }
+    if (first_read != raw.size()) {
+        m_error = "Truncated binary G-code";
+        return false;
+    }
+    const auto     type        = BlockType(get_u16(raw.data()));
+    const auto     compression = Compression(get_u16(raw.data() + 2));
+    const uint32_t size        = get_u32(raw.data() + 4);
+    uint32_t       stored_size = size;
+    if (compression != Compression::None) {
+        if (compression != Compression::Deflate) {
+            m_error = "Unknown binary G-code compression";
+            return false;
+        }
+        raw.resize(12);
+        if (! this->read(raw.data() + 8, 4))
+            return false;
+        stored_size = get_u32(raw.data() + 8);
+    }
+    size_t params_size;
+    switch (type) {
+    case BlockType::FileMetadata:
+    case BlockType::GCode:
+    case BlockType::SlicerMetadata: params_size = 2; break;
+    case BlockType::Thumbnail:      params_size = 6; break;
+    default:
+        m_error = "Unknown binary G-code block";
+        return false;
+    }
+    if (size > max_block_size || stored_size > max_block_size) {
+        m_error = "Invalid binary G-code block size";
+        return false;
+    }
+    const size_t header_size = raw.size();
+    raw.resize(header_size + params_size + stored_size + 4);
+    if (! this->read(raw.data() + header_size, raw.size() - header_size))
+        return false;
+    if (uint32_t(mz_crc32(MZ_CRC32_INIT, raw.data(), raw.size() - 4)) != get_u32(raw.data() + raw.size() - 4)) {
+        m_error = "Binary G-code checksum mismatch";
+        return false;
+    }
+
+    const unsigned char *params = raw.data() + header_size;
+    const unsigned char *data   = params + params_size;
+    block.type = type;
+    if (type == BlockType::Thumbnail) {
+        block.thumbnail_format = ThumbnailFormat(get_u16(params));
+        block.thumbnail_width  = get_u16(params + 2);
+        block.thumbnail_height = get_u16(params + 4);
+    }
+    if (compression == Compression::None)
+        block.data.assign(data, data + size);
+    else {
+        block.data.assign(size, 0);
+        mz_ulong uncompressed_size = size;
+        if (mz_uncompress(reinterpret_cast<unsigned char*>(block.data.data()), &uncompressed_size, data, stored_size) != MZ_OK || uncompressed_size != size) {
+            m_error = "Invalid compressed binary G-code block";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decode_gcode(const std::string &filename, std::function<bool(const char *begin, const char *end)> text_callback, std::string &error)
+{
+    Reader reader(filename);
+    Block  block;
+    while (reader.next_block(block))
+        if (block.type == BlockType::GCode) {
+            if (! text_callback(block.data.data(), block.data.data() + block.data.size()))
+                return true;
+        } else if (block.type == BlockType::SlicerMetadata) {
+            // Back to the config section of the text G-code.
+            std::string text = "; " SLIC3R_APP_NAME "_config = begin\n";
+            for (auto it = block.data.begin(); it != block.data.end();) {
+                auto eol = std::find(it, block.data.end(), '\n');
+                text += "; ";
+                text.append(it, eol);
+                text += '\n';
+                it = eol == block.data.end() ? eol : eol + 1;
+            }
+            text += "; " SLIC3R_APP_NAME "_config = end\n";
+            if (! text_callback(text.data(), text.data() + text.size()))
+                return true;
+        }
+    error = reader.error();
+    return reader.is_valid();
+}
+
+bool read_slicer_metadata(const std::string &filename, std::vector<std::pair<std::string, std::string>> &key_values)
+{
+    Reader reader(filename);
+    Block  block;
+    while (reader.next_block(block))
+        if (block.type == BlockType::SlicerMetadata) {
+            key_values.clear();
+            for (auto it = block.data.begin(); it != block.data.end();) {
+                auto eol = std::find(it, block.data.end(), '\n');
+                auto eq  = std::find(it, eol, '=');
+                if (eq != eol) {
+                    std::string key(it, eq);
+                    std::string value(eq + 1, eol);
+                    boost::trim(key);
+                    boost::trim(value);
+                    key_values.emplace_back(std::move(key), std::move(value));
+                }
+                it = eol == block.data.end() ? eol : eol + 1;
+            }
+            return true;
+        }
+    return false;
+}
+
+} // namespace BinaryGCode
+} // namespace Slic3r
@@ -0,0 +1,153 @@
+#ifndef slic3r_GCode_BinaryGCode_hpp_
+#define slic3r_GCode_BinaryGCode_hpp_
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tbb/task_group.h>
+
+namespace Slic3r {
+
+// Binary G-code container, written instead of the text G-code if binary_gcode is enabled.
+// Experimental format of our own, read back only by the slicer: it isn't the libbgcode format, no firmware or print host reads it.
+// The format is documented in doc/Binary G-code format.md, keep it in sync.
+//
+// The file is a header followed by a sequence of blocks, each of them compressed on its own:
+//   file header:  char[4] magic "SSBG", uint32 version, uint16 checksum type (1: CRC32)
+//   block header: uint16 type, uint16 compression, uint32 uncompressed size, uint32 compressed size (only if compressed)
+//   block parameters (depends on the type), block data, uint32 CRC32 of the block header, parameters and data.
+// All the values are little endian.
+//
+// The G-code text is split into G-code blocks of whole lines, up to 64kB. The thumbnails are stored as images
+// in thumbnail blocks instead of base64 comments, and the configuration section "; xxx_config = begin" ... "end"
+// is stored as a slicer metadata block of "key = value" lines.
+// The blocks are written in the order of the text they replace, so that the text can be encoded in a single pass:
+// decoding the G-code and slicer metadata blocks gives back the text G-code, without its thumbnails.
+namespace BinaryGCode {
+
+enum class BlockType : uint16_t {
+    FileMetadata   = 0,
+    GCode          = 1,
+    SlicerMetadata = 2,
+    Thumbnail      = 5,
+};
+
+enum class Compression : uint16_t {
+    None    = 0,
+    // zlib stream
+    Deflate = 1,
+};
+
+enum class ThumbnailFormat : uint16_t {
+    PNG = 0,
+    JPG = 1,
+    QOI = 2,
+};
+
+static constexpr const char     magic[4] = { 'S', 'S', 'B', 'G' };
+static constexpr const uint32_t version  = 1;
+// Maximum size of the text of a G-code block, unless a single line is longer.
+static constexpr const size_t   max_gcode_block_size = 65536;
+
+struct Block {
+    BlockType            type;
+    // Thumbnail blocks only.
+    ThumbnailFormat      thumbnail_format { ThumbnailFormat::PNG };
+    uint16_t             thumbnail_width  { 0 };
+    uint16_t             thumbnail_height { 0 };
+    // Uncompressed data.
+    std::vector<char>    data;
+};
+
+// Does the file start with the binary G-code magic?
+bool is_binary_gcode_file(const std::string &filename);
+
+// Streaming encoder of the G-code text into a binary G-code file.
+// The text is fed by append() in pieces of whole lines, the G-code blocks are compressed on the worker threads.
+class Encoder
+{
+public:
+    // Writes the file header. The file stays owned by the caller, it has to be kept open until finish() returns.
+    Encoder(FILE *file, const std::string &producer, int compression_level = 6);
+    ~Encoder();
+
+    // Append some lines of G-code, ended by a newline.
+    void append(const char *begin, const char *end);
+    void append(const std::string &text) { this->append(text.data(), text.data() + text.size()); }
+    // Write the last blocks. Returns false if writing into the file failed.
+    bool finish();
+    bool is_error() const { return m_error; }
+
+private:
+    struct PendingBlock {
+        std::vector<char> text;
+        // The whole block, as written into the file.
+        std::vector<char> compressed;
+    };
+
+    void process_line(const char *begin, const char *end);
+    // Queue the G-code buffer to be compressed into a G-code block.
+    void flush_gcode();
+    // Write the compressed G-code blocks, after they are compressed.
+    void write_pending();
+    // Compress and write a block (after the pending G-code blocks).
+    void write_block(BlockType type, const std::vector<char> &params, const char *data, size_t size);
+    void write(const void *data, size_t size);
+
+    FILE               *m_file;
+    int                 m_compression_level;
+    bool                m_error { false };
+    // Incomplete line from the last append().
+    std::string         m_line;
+    std::vector<char>   m_gcode;
+    // Thumbnail or config section being read.
+    enum class Section { GCode, Thumbnail, Config };
+    Section             m_section { Section::GCode };
+    ThumbnailFormat     m_thumbnail_format { ThumbnailFormat::PNG };
+    uint16_t            m_thumbnail_width { 0 };
+    uint16_t            m_thumbnail_height { 0 };
+    std::string         m_section_end;
+    std::string         m_section_data;
+    // Skipped lines of the current section, written back as G-code if the section isn't valid.
+    std::string         m_section_lines;
+    // G-code blocks being compressed, written in order by write_pending().
+    std::deque<PendingBlock> m_pending;
+    tbb::task_group     m_tasks;
+};
+
+// Reads the blocks of a binary G-code file one by one, checking their checksum.
+class Reader
+{
+public:
+    explicit Reader(const std::string &filename);
+    ~Reader();
+
+    // Returns false at the end of the file or on error.
+    bool next_block(Block &block);
+    // Was the file read up to its end without errors?
+    bool is_valid() const { return m_error.empty() && m_eof; }
+    const std::string& error() const { return m_error; }
+
+private:
+    bool read(void *data, size_t size);
+
+    FILE        *m_file { nullptr };
+    bool         m_eof  { false };
+    std::string  m_error;
+};
+
+// Decode the G-code text of a binary G-code file: calls text_callback with pieces of whole lines, in order,
+// until it returns false. Returns false and sets error if the file can't be read or is corrupted.
+bool decode_gcode(const std::string &filename, std::function<bool(const char *begin, const char *end)> text_callback, std::string &error);
+// Read the key / value pairs of the slicer metadata block. Returns false if the file has no valid slicer metadata.
+bool read_slicer_metadata(const std::string &filename, std::vector<std::pair<std::string, std::string>> &key_values);
+
+} // namespace BinaryGCode
+} // namespace Slic3r
+
+#endif // slic3r_GCode_BinaryGCode_hpp_
@@ -1,6 +1,5 @@
 #include "../GCode.hpp"
 #include "CoolingBuffer.hpp"
-#include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/log/trivial.hpp>
 #include <iostream>
@@ -17,7 +16,7 @@
 
 namespace Slic3r {
 
-CoolingBuffer::CoolingBuffer(GCode &gcodegen) : m_config(gcodegen.config()), m_toolchange_prefix(gcodegen.writer().toolchange_prefix()), m_current_extruder(0)
+CoolingBuffer::CoolingBuffer(GCode &gcodegen) : m_config(gcodegen.config()), m_current_extruder(0)
 {
     this->reset(gcodegen.writer().get_position());
 
@@ -65,8 +64,8 @@ struct CoolingLine
         TYPE_RESTORE_AFTER_WT   = 1 << 19,
     };
 
-    CoolingLine(unsigned int type, size_t  line_start, size_t  line_end) :
-        type(type), line_start(line_start), line_end(line_end),
+    CoolingLine(unsigned int type, size_t line_idx) :
+        type(type), line_idx(line_idx),
         length(0.f), feedrate(0.f), time(0.f), time_max(0.f), slowdown(false) {}
 
     bool adjustable(bool slowdown_external_perimeters) const {
@@ -80,10 +79,8 @@ struct CoolingLine
     }
 
     size_t  type;
-    // Start of this line at the G-code snippet.
-    size_t  line_start;
-    // End of this line at the G-code snippet.
-    size_t  line_end;
+    // Index of this line in the MoveBuffer of the G-code snippet.
+    size_t  line_idx;
     // XY Euclidian length of this segment.
     float   length;
     // Current feedrate, possibly adjusted.
@@ -304,15 +301,12 @@ finished:
 	return new_feedrate;
 }
 
-std::string CoolingBuffer::process_layer(std::string &&gcode_in, size_t layer_id, bool flush, bool is_support_only)
+MoveBuffer CoolingBuffer::process_layer(MoveBuffer &&gcode_in, size_t layer_id, bool flush, bool is_support_only)
 {
     // Cache the input G-code.
-    if (m_gcode.empty())
-        m_gcode = std::move(gcode_in);
-    else
-        m_gcode += gcode_in;
+    m_gcode.append(std::move(gcode_in));
 
-    std::string out;
+    MoveBuffer out(m_gcode.syntax(), m_gcode.start_extruder());
     if (flush) {
 	    auto& previous_layer_time = is_support_only ? saved_layer_time_object : saved_layer_time_support;
 	    auto my_previous_layer_time = is_support_only ? saved_layer_time_support : saved_layer_time_object;
@@ -359,7 +353,7 @@ std::string CoolingBuffer::process_layer(std::string &&gcode_in, size_t layer_id
 
 // Parse the layer G-code for the moves, which could be adjusted.
 // Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const MoveBuffer &gcode, std::vector<float> &current_pos) const
 {
     std::vector<PerExtruderAdjustments> per_extruder_adjustments(m_extruder_ids.size());
     std::vector<size_t>                 map_extruder_to_per_extruder_adjustment(m_num_extruders, 0);
@@ -376,64 +370,39 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
 
     uint16_t        current_extruder  = m_current_extruder;
     PerExtruderAdjustments *adjustment  = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
-    const char       *line_start = gcode.c_str();
-    const char       *line_end   = line_start;
-    const char        extrusion_axis = get_extrusion_axis(m_config)[0];
     // Index of an existing CoolingLine of the current adjustment, which holds the feedrate setting command
     // for a sequence of extrusion moves.
     size_t            active_speed_modifier = size_t(-1);
 
-    for (; *line_start != 0; line_start = line_end) 
-    {
-        while (*line_end != '\n' && *line_end != 0)
-            ++ line_end;
-        // sline will not contain the trailing '\n'.
-        std::string sline(line_start, line_end);
-        // CoolingLine will contain the trailing '\n'.
-        if (*line_end == '\n')
-            ++ line_end;
-        CoolingLine line(0, line_start - gcode.c_str(), line_end - gcode.c_str());
-        if (boost::starts_with(sline, "G0 "))
+    for (const MoveBuffer::Line &gline : gcode.lines()) {
+        // The lines were tokenized by the MoveBuffer.
+        CoolingLine line(0, &gline - gcode.lines().data());
+        if (gline.is_G(0))
             line.type = CoolingLine::TYPE_G0;
-        else if (boost::starts_with(sline, "G1 "))
+        else if (gline.is_G(1))
             line.type = CoolingLine::TYPE_G1;
-        else if (boost::starts_with(sline, "G92 "))
+        else if (gline.is_G(92))
             line.type = CoolingLine::TYPE_G92;
         if (line.type) {
             // G0, G1 or G92
-            // Parse the G-code line.
             std::vector<float> new_pos(current_pos);
-            const char *c = sline.data() + 3;
-            for (;;) {
-                // Skip whitespaces.
-                for (; *c == ' ' || *c == '\t'; ++ c);
-                if (*c == 0 || *c == ';')
-                    break;
-
-                assert(is_decimal_separator_point()); // for atof
-                // Parse the axis.
-                size_t axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
-                              (*c == extrusion_axis) ? 3 : (*c == 'F') ? 4 : size_t(-1);
-                if (axis != size_t(-1)) {
-                    new_pos[axis] = float(atof(++c));
-                    if (axis == 4) {
-                        // Convert mm/min to mm/sec.
-                        new_pos[4] /= 60.f;
-                        if ((line.type & CoolingLine::TYPE_G92) == 0)
-                            // This is G0 or G1 line and it sets the feedrate. This mark is used for reducing the duplicate F calls.
-                            line.type |= CoolingLine::TYPE_HAS_F;
-                    }
-                }
-                // Skip this word.
-                for (; *c != ' ' && *c != '\t' && *c != 0; ++ c);
+            for (size_t axis = 0; axis < 5; ++ axis)
+                if (gline.has(Axis(axis)))
+                    new_pos[axis] = float(gline.value(Axis(axis)));
+            if (gline.has(F)) {
+                // Convert mm/min to mm/sec.
+                new_pos[4] /= 60.f;
+                if ((line.type & CoolingLine::TYPE_G92) == 0)
+                    // This is G0 or G1 line and it sets the feedrate. This mark is used for reducing the duplicate F calls.
+                    line.type |= CoolingLine::TYPE_HAS_F;
             }
-            bool external_perimeter = boost::contains(sline, ";_EXTERNAL_PERIMETER");
-            bool wipe               = boost::contains(sline, ";_WIPE");
+            bool external_perimeter = gline.has_marker(MoveBuffer::mkExternalPerimeter);
+            bool wipe               = gline.has_marker(MoveBuffer::mkWipe);
             if (external_perimeter)
                 line.type |= CoolingLine::TYPE_EXTERNAL_PERIMETER;
             if (wipe)
                 line.type |= CoolingLine::TYPE_WIPE;
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED") && ! wipe) {
+            if (gline.has_marker(MoveBuffer::mkExtrudeSetSpeed) && ! wipe) {
                 line.type |= CoolingLine::TYPE_ADJUSTABLE;
                 active_speed_modifier = adjustment->lines.size();
             }
@@ -482,13 +451,13 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                 }
             }
             current_pos = std::move(new_pos);
-        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
+        } else if (gline.has_marker(MoveBuffer::mkExtrudeEnd)) {
             line.type = CoolingLine::TYPE_EXTRUDE_END;
             active_speed_modifier = size_t(-1);
-        } else if (boost::starts_with(sline, m_toolchange_prefix)) {
-            uint16_t new_extruder = (uint16_t)atoi(sline.c_str() + m_toolchange_prefix.size());
+        } else if (gline.letter == 'T') {
+            uint16_t new_extruder = gline.extruder;
             // Only change extruder in case the number is meaningful. User could provide an out-of-range index through custom gcodes - those shall be ignored.
-            if (new_extruder < map_extruder_to_per_extruder_adjustment.size()) {
+            if (gline.code >= 0 && new_extruder < map_extruder_to_per_extruder_adjustment.size()) {
                 if (new_extruder != current_extruder) {
                     // Switch the tool.
                     line.type = CoolingLine::TYPE_SET_TOOL;
@@ -499,37 +468,38 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
             else {
                 // Only log the error in case of MM printer. Single extruder printers likely ignore any T anyway.
                 if (map_extruder_to_per_extruder_adjustment.size() > 1)
-                    BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << sline;
+                    BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << gcode.text(gline);
             }
 
-        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_START")) {
+        } else if (gline.has_marker(MoveBuffer::mkBridgeFanStart)) {
             line.type = CoolingLine::TYPE_BRIDGE_FAN_START;
-        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_END")) {
+        } else if (gline.has_marker(MoveBuffer::mkBridgeFanEnd)) {
             line.type = CoolingLine::TYPE_BRIDGE_FAN_END;
-        } else if (boost::starts_with(sline, ";_BRIDGE_INTERNAL_FAN_START")) {
+        } else if (gline.has_marker(MoveBuffer::mkBridgeInternalFanStart)) {
             line.type = CoolingLine::TYPE_BRIDGE_INTERNAL_FAN_START;
-        } else if (boost::starts_with(sline, ";_BRIDGE_INTERNAL_FAN_END")) {
+        } else if (gline.has_marker(MoveBuffer::mkBridgeInternalFanEnd)) {
             line.type = CoolingLine::TYPE_BRIDGE_INTERNAL_FAN_END;
-        } else if (boost::starts_with(sline, ";_TOP_FAN_START")) {
+        } else if (gline.has_marker(MoveBuffer::mkTopFanStart)) {
             line.type = CoolingLine::TYPE_TOP_FAN_START;
-        } else if (boost::starts_with(sline, ";_TOP_FAN_END")) {
+        } else if (gline.has_marker(MoveBuffer::mkTopFanEnd)) {
             line.type = CoolingLine::TYPE_TOP_FAN_END;
-        } else if (boost::starts_with(sline, ";_SUPP_INTER_FAN_START")) {
+        } else if (gline.has_marker(MoveBuffer::mkSuppInterFanStart)) {
             line.type = CoolingLine::TYPE_SUPP_INTER_FAN_START;
-        } else if (boost::starts_with(sline, ";_SUPP_INTER_FAN_END")) {
+        } else if (gline.has_marker(MoveBuffer::mkSuppInterFanEnd)) {
             line.type = CoolingLine::TYPE_SUPP_INTER_FAN_END;
-        } else if (boost::starts_with(sline, "G4 ")) {
+        } else if (gline.is_G(4)) {
             // Parse the wait time.
             line.type = CoolingLine::TYPE_G4;
+            std::string sline(gcode.text(gline));
             size_t pos_S = sline.find('S', 3);
             size_t pos_P = sline.find('P', 3);
             assert(is_decimal_separator_point()); // for atof
             line.time = line.time_max = float(
                 (pos_S > 0) ? atof(sline.c_str() + pos_S + 1) :
                 (pos_P > 0) ? atof(sline.c_str() + pos_P + 1) * 0.001 : 0.);
-        } else if (boost::starts_with(sline, ";_STORE_FAN_SPEED_WT")) {
+        } else if (gline.has_marker(MoveBuffer::mkStoreFanSpeedWT)) {
             line.type = CoolingLine::TYPE_STORE_FOR_WT;
-        } else if (boost::starts_with(sline, ";_RESTORE_FAN_SPEED_WT")) {
+        } else if (gline.has_marker(MoveBuffer::mkRestoreFanSpeedWT)) {
             line.type = CoolingLine::TYPE_RESTORE_AFTER_WT;
         }
         if (line.type != 0)
@@ -739,9 +709,9 @@ float CoolingBuffer::calculate_layer_slowdown(std::vector<PerExtruderAdjustments
 
 // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
 // Returns the adjusted G-code.
-std::string CoolingBuffer::apply_layer_cooldown(
+MoveBuffer CoolingBuffer::apply_layer_cooldown(
     // Source G-code for the current layer.
-    const std::string                      &gcode,
+    const MoveBuffer                       &gcode,
     // ID of the current layer, used to disable fan for the first n layers.
     size_t                                  layer_id, 
     // Total time of this layer after slow down, used to control the fan.
@@ -759,11 +729,10 @@ std::string CoolingBuffer::apply_layer_cooldown(
         for (const PerExtruderAdjustments &adj : per_extruder_adjustments)
             for (const CoolingLine &line : adj.lines)
                 lines.emplace_back(&line);
-        std::sort(lines.begin(), lines.end(), [](const CoolingLine *ln1, const CoolingLine *ln2) { return ln1->line_start < ln2->line_start; } );
+        std::sort(lines.begin(), lines.end(), [](const CoolingLine *ln1, const CoolingLine *ln2) { return ln1->line_idx < ln2->line_idx; } );
     }
     // Second generate the adjusted G-code.
-    std::string new_gcode;
-    new_gcode.reserve(gcode.size() * 2);
+    MoveBuffer new_gcode(gcode.syntax(), gcode.start_extruder());
     bool bridge_fan_control = false;
     int  bridge_fan_speed = 0;
     bool bridge_internal_fan_control = false;
@@ -877,32 +846,37 @@ std::string CoolingBuffer::apply_layer_cooldown(
         }
         if (fan_speed_new != m_fan_speed) {
             m_fan_speed = fan_speed_new;
-            new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, m_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+            new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, m_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
         }
     };
     //set to know all fan modifiers that can be applied ( TYPE_BRIDGE_FAN_END, TYPE_TOP_FAN_START, TYPE_SUPP_INTER_FAN_START, TYPE_EXTERNAL_PERIMETER).
     std::unordered_set<CoolingLine::Type> current_fan_sections;
-    const char         *pos               = gcode.c_str();
+    // Index of the first source line not yet copied into new_gcode.
+    size_t              pos               = 0;
+    // Text of the modified G-code line.
+    std::string         line_gcode;
     int                 current_feedrate  = 0;
     int                 stored_fan_speed = m_fan_speed;
     change_extruder_set_fan();
     for (const CoolingLine *line : lines) {
-        const char *line_start  = gcode.c_str() + line->line_start;
-        const char *line_end    = gcode.c_str() + line->line_end;
+        const MoveBuffer::Line &gline = gcode.lines()[line->line_idx];
+        // The source line, with its '\n'.
+        const char *line_start  = gcode.text().data() + gline.begin;
+        const char *line_end    = gcode.text().data() + gline.end + 1;
         bool fan_need_set = false;
-        if (line_start > pos)
-            new_gcode.append(pos, line_start - pos);
+        if (line->line_idx > pos)
+            new_gcode.append(gcode, pos, line->line_idx);
         if (line->type & CoolingLine::TYPE_SET_TOOL) {
-            unsigned int new_extruder = (unsigned int)atoi(line_start + m_toolchange_prefix.size());
+            unsigned int new_extruder = gline.extruder;
             if (new_extruder != m_current_extruder) {
                 m_current_extruder = new_extruder;
                 change_extruder_set_fan();
             }
-            new_gcode.append(line_start, line_end - line_start);
+            new_gcode.append(gcode, gline);
         } else if (line->type & CoolingLine::TYPE_STORE_FOR_WT) {
             stored_fan_speed = m_fan_speed;
         } else if (line->type & CoolingLine::TYPE_RESTORE_AFTER_WT) {
-            new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, stored_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+            new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, stored_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
         } else if (line->type & CoolingLine::TYPE_BRIDGE_FAN_START) {
             if (bridge_fan_control && current_fan_sections.find(CoolingLine::TYPE_BRIDGE_FAN_START) == current_fan_sections.end()) {
                 fan_need_set = true;
@@ -955,6 +929,7 @@ std::string CoolingBuffer::apply_layer_cooldown(
                 current_fan_sections.insert(CoolingLine::TYPE_EXTERNAL_PERIMETER);
             }
 
+            line_gcode.clear();
             // Find the start of a comment, or roll to the end of line.
             const char *end = line_start;
             for (; end < line_end && *end != ';'; ++ end);
@@ -981,17 +956,17 @@ std::string CoolingBuffer::apply_layer_cooldown(
             } else {
                 // The F value is different from current_feedrate, but not slowed down, thus the G-code line will not be modified.
                 // Emit the line without the comment.
-                new_gcode.append(line_start, end - line_start);
+                line_gcode.append(line_start, end - line_start);
                 current_feedrate = new_feedrate;
             }
             if (modify || remove) {
                 if (modify) {
                     // Replace the feedrate.
-                    new_gcode.append(line_start, fpos - line_start);
+                    line_gcode.append(line_start, fpos - line_start);
                     current_feedrate = new_feedrate;
                     char buf[64];
                     sprintf(buf, "%d", int(current_feedrate));
-                    new_gcode += buf;
+                    line_gcode += buf;
                 } else {
                     // Remove the feedrate word.
                     const char *f = fpos;
@@ -1000,18 +975,18 @@ std::string CoolingBuffer::apply_layer_cooldown(
                     // Append up to the F word, without the trailing whitespace.
                     //but only if there are something else than a simple "G1" (F is always put at the end of a G1 command)
                     if(f - line_start > 2)
-                        new_gcode.append(line_start, f - line_start + 1);
+                        line_gcode.append(line_start, f - line_start + 1);
                 }
                 // Skip the non-whitespaces of the F parameter up the comment or end of line.
                 for (; fpos != end && *fpos != ' ' && *fpos != ';' && *fpos != '\n'; ++ fpos);
                 // Append the rest of the line without the comment.
-                if (remove && (fpos == end || *fpos == '\n') && (new_gcode == "G1" || boost::ends_with(new_gcode, "\nG1"))) {
+                if (remove && (fpos == end || *fpos == '\n') && line_gcode == "G1") {
                     // The G-code line only contained the F word, now it is empty. Remove it completely including the comments.
-                    new_gcode.resize(new_gcode.size() - 2);
+                    line_gcode.clear();
                     end = line_end;
                 } else {
                     // The G-code line may not be empty yet. Emit the rest of it.
-                    new_gcode.append(fpos, end - fpos);
+                    line_gcode.append(fpos, end - fpos);
                 }
             }
             // Process the rest of the line.
@@ -1024,40 +999,39 @@ std::string CoolingBuffer::apply_layer_cooldown(
                         boost::replace_all(comment, ";_EXTERNAL_PERIMETER", "");
                     if (line->type & CoolingLine::TYPE_WIPE)
                         boost::replace_all(comment, ";_WIPE", "");
-                    new_gcode += comment;
+                    line_gcode += comment;
                 } else {
                     // Just attach the rest of the source line.
-                    new_gcode.append(end, line_end - end);
+                    line_gcode.append(end, line_end - end);
                 }
             }
+            new_gcode.append_gcode(line_gcode);
         } else {
-            new_gcode.append(line_start, line_end - line_start);
+            new_gcode.append(gcode, gline);
         }
         if (fan_need_set) {
             //choose the speed with highest priority
             if (current_fan_sections.find(CoolingLine::TYPE_BRIDGE_FAN_START) != current_fan_sections.end())
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, bridge_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+                new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, bridge_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
             else if (current_fan_sections.find(CoolingLine::TYPE_BRIDGE_INTERNAL_FAN_START) != current_fan_sections.end())
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, bridge_internal_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+                new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, bridge_internal_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
             else if (current_fan_sections.find(CoolingLine::TYPE_TOP_FAN_START) != current_fan_sections.end())
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, top_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+                new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, top_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
             else if (current_fan_sections.find(CoolingLine::TYPE_SUPP_INTER_FAN_START) != current_fan_sections.end())
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, supp_inter_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+                new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, supp_inter_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
             else if (current_fan_sections.find(CoolingLine::TYPE_EXTERNAL_PERIMETER) != current_fan_sections.end())
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, ext_peri_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+                new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, ext_peri_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
             else
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, m_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage);
+                new_gcode.append_gcode(GCodeWriter::set_fan(m_config.gcode_flavor, m_config.gcode_comments, m_fan_speed, EXTRUDER_CONFIG(extruder_fan_offset), m_config.fan_percentage));
             fan_need_set = false;
         }
-        pos = line_end;
+        pos = line->line_idx + 1;
     }
 #undef EXTRUDER_CONFIG
-    const char *gcode_end = gcode.c_str() + gcode.size();
-    if (pos < gcode_end)
-        new_gcode.append(pos, gcode_end - pos);
+    new_gcode.append(gcode, pos, gcode.size());
 
     // There should be no empty G1 lines emitted.
-    assert(new_gcode.find("G1\n") == std::string::npos);
+    assert(new_gcode.text().find("G1\n") == std::string::npos);
     return new_gcode;
 }
 
@@ -2,6 +2,7 @@
 #define slic3r_CoolingBuffer_hpp_
 
 #include "../libslic3r.h"
+#include "MoveBuffer.hpp"
 #include <map>
 #include <string>
 
@@ -27,18 +28,18 @@ public:
     void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
     /// process the layer: check the time and apply fan / speed change
     /// append_time_only: if the layer is only support, then you can put this at true to not process the layer but just append its time to the next one.
-    std::string process_layer(std::string &&gcode, size_t layer_id, bool flush, bool append_time_only = false);
+    MoveBuffer  process_layer(MoveBuffer &&gcode, size_t layer_id, bool flush, bool append_time_only = false);
 
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const MoveBuffer &gcode, std::vector<float> &current_pos) const;
     float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
     // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
     // Returns the adjusted G-code.
-    std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    MoveBuffer  apply_layer_cooldown(const MoveBuffer &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
 
     // G-code snippet cached for the support layers preceding an object layer.
-    std::string                 m_gcode;
+    MoveBuffer                  m_gcode;
     // Internal data.
     // X,Y,Z,E,F
     std::vector<char>           m_axis;
@@ -50,7 +51,6 @@ private:
     std::vector<unsigned int>   m_extruder_ids;
     // Highest of m_extruder_ids plus 1.
     uint16_t                    m_num_extruders { 0 };
-    const std::string           m_toolchange_prefix;
     // Referencs GCode::m_config, which is FullPrintConfig. While the PrintObjectConfig slice of FullPrintConfig is being modified,
     // the PrintConfig slice of FullPrintConfig is constant, thus no thread synchronization is required.
     const PrintConfig          &m_config;
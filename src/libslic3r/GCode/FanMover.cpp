@@ -1,7 +1,5 @@
 #include "FanMover.hpp"
 
-#include "GCodeReader.hpp"
-
 #include <iomanip>
 /*
 #include <memory.h>
@@ -19,26 +17,37 @@
 
 namespace Slic3r {
 
-const std::string& FanMover::process_gcode(const std::string& gcode, bool flush)
+MoveBuffer FanMover::process_gcode(MoveBuffer &&gcode, bool flush)
 {
-    m_process_output = "";
+    m_process_output = MoveBuffer(m_syntax, gcode.start_extruder());
+    m_input = &gcode;
+    m_currrent_extruder = gcode.start_extruder();
 
     // recompute buffer time to recover from rounding
     m_buffer_time_size = 0;
     for (auto& data : m_buffer) m_buffer_time_size += data.time;
 
-    if(!gcode.empty())
-        m_parser.parse_buffer(gcode,
-            [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { /*m_process_output += line.raw() + "\n";*/ this->_process_gcode_line(reader, line); });
+    for (const MoveBuffer::Line &line : gcode.lines())
+        this->_process_gcode_line(line);
 
     if (flush) {
         while (!m_buffer.empty()) {
-            m_process_output += m_buffer.front().raw + "\n";
+            _write(m_buffer.front());
             remove_from_buffer(m_buffer.begin());
         }
+    } else {
+        // The lines stay in the buffer after the G-code they come from is gone.
+        for (BufferData &data : m_buffer)
+            _raw(data);
     }
 
-    return m_process_output;
+    m_input = nullptr;
+    return std::move(m_process_output);
+}
+
+std::string FanMover::process_gcode(const std::string& gcode, bool flush)
+{
+    return this->process_gcode(MoveBuffer(std::string(gcode), m_syntax, m_currrent_extruder), flush).release_text();
 }
 
 bool is_end_of_word(char c) {
@@ -104,8 +113,8 @@ void FanMover::_put_in_middle_G1(std::list<BufferData>::iterator item_to_split,
         // doesn't really need to be split, print it before
         //will also print before if line_to_split.time == 0
         m_buffer.insert(item_to_split, line_to_write);
-    } else if (item_to_split->raw.size() > 2
-        && item_to_split->raw[0] == 'G' && item_to_split->raw[1] == '1' && item_to_split->raw[2] == ' ') {
+    } else if (_text(*item_to_split).size() > 2
+        && _text(*item_to_split)[0] == 'G' && _text(*item_to_split)[1] == '1' && _text(*item_to_split)[2] == ' ') {
         float percent = nb_sec_since_itemtosplit_start / item_to_split->time;
         BufferData before = *item_to_split;
         before.time *= percent;
@@ -114,31 +123,31 @@ void FanMover::_put_in_middle_G1(std::list<BufferData>::iterator item_to_split,
             before.dx = item_to_split->dx * percent;
             item_to_split->x += before.dx;
             item_to_split->dx = item_to_split->dx * (1-percent);
-            change_axis_value(before.raw, 'X', before.x + before.dx, 3);
+            change_axis_value(_raw(before), 'X', before.x + before.dx, 3);
         }
         if (item_to_split->dy != 0) {
             before.dy = item_to_split->dy * percent;
             item_to_split->y += before.dy;
             item_to_split->dy = item_to_split->dy * (1 - percent);
-            change_axis_value(before.raw, 'Y', before.y + before.dy, 3);
+            change_axis_value(_raw(before), 'Y', before.y + before.dy, 3);
         }
         if (item_to_split->dz != 0) {
             before.dz = item_to_split->dz * percent;
             item_to_split->z += before.dz;
             item_to_split->dz = item_to_split->dz * (1 - percent);
-            change_axis_value(before.raw, 'Z', before.z + before.dz, 3);
+            change_axis_value(_raw(before), 'Z', before.z + before.dz, 3);
         }
         if (item_to_split->de != 0) {
             if (relative_e) {
                 before.de = item_to_split->de * percent;
-                change_axis_value(before.raw, 'E', before.de, 5);
+                change_axis_value(_raw(before), 'E', before.de, 5);
                 item_to_split->de = item_to_split->de * (1 - percent);
-                change_axis_value(item_to_split->raw, 'E', item_to_split->de, 5);
+                change_axis_value(_raw(*item_to_split), 'E', item_to_split->de, 5);
             } else {
                 before.de = item_to_split->de * percent;
                 item_to_split->e += before.de;
                 item_to_split->de = item_to_split->de * (1 - percent);
-                change_axis_value(before.raw, 'E', before.e + before.de, 5);
+                change_axis_value(_raw(before), 'E', before.e + before.de, 5);
             }
         }
         //add before then line_to_write, then there is the modified data.
@@ -154,18 +163,17 @@ void FanMover::_put_in_middle_G1(std::list<BufferData>::iterator item_to_split,
 void FanMover::_print_in_middle_G1(BufferData& line_to_split, float nb_sec, const std::string &line_to_write) {
     if (nb_sec < line_to_split.time * 0.1) {
         // doesn't really need to be split, print it after
-        m_process_output += line_to_split.raw + "\n";
-        m_process_output += line_to_write + (line_to_write.back() == '\n'?"":"\n");
+        _write(line_to_split);
+        m_process_output.append_gcode(line_to_write);
     } else if (nb_sec > line_to_split.time * 0.9) {
         // doesn't really need to be split, print it before
         //will also print before if line_to_split.time == 0
-        m_process_output += line_to_write + (line_to_write.back() == '\n' ? "" : "\n");
-        m_process_output += line_to_split.raw + "\n";
-    }else if(line_to_split.raw.size() > 2
-        && line_to_split.raw[0] == 'G' && line_to_split.raw[1] == '1' && line_to_split.raw[2] == ' ') {
+        m_process_output.append_gcode(line_to_write);
+        _write(line_to_split);
+    }else if(_text(line_to_split).size() > 2
+        && _text(line_to_split)[0] == 'G' && _text(line_to_split)[1] == '1' && _text(line_to_split)[2] == ' ') {
         float percent = nb_sec / line_to_split.time;
-        std::string before = line_to_split.raw;
-        std::string& after = line_to_split.raw;
+        std::string before(_text(line_to_split));
         if (line_to_split.dx != 0) {
             change_axis_value(before, 'X', line_to_split.x + line_to_split.dx * percent, 3);
         }
@@ -178,19 +186,19 @@ void FanMover::_print_in_middle_G1(BufferData& line_to_split, float nb_sec, cons
         if (line_to_split.de != 0) {
             if (relative_e) {
                 change_axis_value(before, 'E', line_to_split.de * percent, 5);
-                change_axis_value(after, 'E', line_to_split.de * (1 - percent), 5);
+                change_axis_value(_raw(line_to_split), 'E', line_to_split.de * (1 - percent), 5);
             } else {
                 change_axis_value(before, 'E', line_to_split.e + line_to_split.de * percent, 5);
             }
         }
-        m_process_output += before + "\n";
-        m_process_output += line_to_write + (line_to_write.back() == '\n' ? "" : "\n");
-        m_process_output += line_to_split.raw + "\n";
+        m_process_output.append_gcode(before);
+        m_process_output.append_gcode(line_to_write);
+        _write(line_to_split);
 
     } else {
         //not a G1, print it before
-        m_process_output += line_to_write + (line_to_write.back() == '\n' ? "" : "\n");
-        m_process_output += line_to_split.raw + "\n";
+        m_process_output.append_gcode(line_to_write);
+        _write(line_to_split);
     }
 }
 
@@ -217,66 +225,24 @@ std::string FanMover::_set_fan(int16_t speed) {
 }
 
 
-bool parse_number(const std::string_view sv, int& out)
-{
-    {
-        // Legacy conversion, which is costly due to having to make a copy of the string before conversion.
-        try {
-            assert(sv.size() < 1024);
-            assert(sv.data() != nullptr);
-            std::string str{ sv };
-            size_t read = 0;
-            out = std::stoi(str, &read);
-            return str.size() == read;
-        }
-        catch (...) {
-            return false;
-        }
-    }
-}
-
-//FIXME: add other firmware
-// or just create that damn new gcode writer arch
-void FanMover::_process_T(const std::string_view command)
-{
-    if (command.length() > 1) {
-        int eid = 0;
-        if (!parse_number(command.substr(1), eid) || eid < 0 || eid > 255) {
-            GCodeFlavor flavor = m_writer.config.gcode_flavor;
-            // Specific to the MMU2 V2 (see https://www.help.prusa3d.com/en/article/prusa-specific-g-codes_112173):
-            if ((flavor == gcfMarlinLegacy || flavor == gcfMarlinFirmware) && (command == "Tx" || command == "Tc" || command == "T?"))
-                return;
-
-            // T-1 is a valid gcode line for RepRap Firmwares (used to deselects all tools) see https://github.com/prusa3d/PrusaSlicer/issues/5677
-            if ((flavor != gcfRepRap && flavor != gcfSprinter) || eid != -1)
-                m_currrent_extruder = static_cast<uint16_t>(0);
-        } else {
-            m_currrent_extruder = static_cast<uint16_t>(eid);
-        }
-    }
-}
-
-void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCodeLine& line)
+void FanMover::_process_gcode_line(const MoveBuffer::Line& line)
 {
     // processes 'normal' gcode lines
     bool need_flush = false;
-    std::string cmd(line.cmd());
+    std::string_view cmd = m_input->command(line);
     double time = 0;
     int16_t fan_speed = -1;
+    m_currrent_extruder = line.extruder;
     if (cmd.length() > 1) {
-        if (line.has_f())
-            m_current_speed = line.f() / 60.0f;
+        if (line.has(F))
+            m_current_speed = float(line.value(F)) / 60.0f;
         switch (::toupper(cmd[0])) {
-        case 'T':
-        case 't':
-            _process_T(cmd);
-                break;
         case 'G':
         {
-            if (::atoi(&cmd[1]) == 1 || ::atoi(&cmd[1]) == 0) {
-                double distx = line.dist_X(reader);
-                double disty = line.dist_Y(reader);
-                double distz = line.dist_Z(reader);
+            if (line.is_linear_move()) {
+                double distx = m_position.dist(line, X);
+                double disty = m_position.dist(line, Y);
+                double distz = m_position.dist(line, Z);
                 double dist = distx * distx + disty * disty + distz * distz;
                 if (dist > 0) {
                     dist = std::sqrt(dist);
@@ -287,7 +253,8 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
         }
         case 'M':
         {
-            fan_speed = get_fan_speed(line.raw(), m_writer.config.gcode_flavor);
+            const std::string raw(m_input->text(line));
+            fan_speed = get_fan_speed(raw, m_writer.config.gcode_flavor);
             if (fan_speed >= 0) {
                 const auto fan_baseline = (m_writer.config.fan_percentage.value ? 100.0 : 255.0);
                 fan_speed = 100 * fan_speed / fan_baseline;
@@ -317,7 +284,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                     _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, _set_fan(100));//m_writer.set_fan(100, true)); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
                                     remove_from_buffer(m_buffer.begin());
                                 } else {
-                                    m_process_output += _set_fan(100);//m_writer.set_fan(100, true)); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
+                                    m_process_output.append_gcode(_set_fan(100));//m_writer.set_fan(100, true)); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
                                 }
                                 //write it in the queue if possible
                                 const float kickstart_duration = kickstart * float(fan_speed - m_front_buffer_fan_speed) / 100.f;
@@ -327,7 +294,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                     time_count -= it->time;
                                     if (time_count< 0) {
                                         //found something that is lower than us
-                                        _put_in_middle_G1(it, it->time + time_count, BufferData(std::string(line.raw()), 0, fan_speed, true));
+                                        _put_in_middle_G1(it, it->time + time_count, BufferData(raw, 0, fan_speed, true));
                                         //found, stop
                                         break;
                                     }
@@ -337,7 +304,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                     //can't place it in the buffer, use m_current_kickstart
                                     m_current_kickstart.fan_speed = fan_speed;
                                     m_current_kickstart.time = time_count;
-                                    m_current_kickstart.raw = line.raw();
+                                    m_current_kickstart.raw = raw;
                                 }
                                 m_front_buffer_fan_speed = fan_speed;
                             } else {
@@ -345,10 +312,10 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                 _remove_slow_fan(fan_speed, m_buffer_time_size + 1);
                                 // then write the fan command
                                 if (!m_buffer.empty() && (m_buffer_time_size - m_buffer.front().time * 0.1) > nb_seconds_delay) {
-                                    _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, line.raw());
+                                    _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, raw);
                                     remove_from_buffer(m_buffer.begin());
                                 } else {
-                                    m_process_output += line.raw() + "\n";
+                                    m_process_output.append(*m_input, line);
                                 }
                                 m_front_buffer_fan_speed = fan_speed;
                             }
@@ -367,7 +334,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                     float kickstart_duration = kickstart * float(fan_speed - m_back_buffer_fan_speed) / 100.f;
                                     m_current_kickstart.fan_speed = fan_speed;
                                     m_current_kickstart.time += kickstart_duration;
-                                    m_current_kickstart.raw = line.raw();
+                                    m_current_kickstart.raw = raw;
                                     //i'm printed by the m_current_kickstart
                                     time = -1;
                                 }
@@ -385,7 +352,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                 //add the normal speed line for the future
                                 m_current_kickstart.fan_speed = fan_speed;
                                 m_current_kickstart.time = kickstart_duration;
-                                m_current_kickstart.raw = line.raw();
+                                m_current_kickstart.raw = raw;
                             }
                         }
                     }
@@ -400,43 +367,35 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
         }
         }
     } else {
-        if(!line.raw().empty() && line.raw().front() == ';')
-        {
-            if (line.raw().size() > 10 && line.raw().rfind(";TYPE:", 0) == 0) {
-                // get the type of the next extrusions
-                std::string extrusion_string = line.raw().substr(6, line.raw().size() - 6);
-                current_role = ExtrusionEntity::string_to_role(extrusion_string);
-            }
-            if (line.raw().size() > 16) {
-                if (line.raw().rfind("; custom gcode", 0) != std::string::npos)
-                    if (line.raw().rfind("; custom gcode end", 0) != std::string::npos)
-                        m_is_custom_gcode = false;
-                    else
-                        m_is_custom_gcode = true;
-            }
-        }
+        // get the type of the next extrusions
+        if (line.has_marker(MoveBuffer::mkRole))
+            current_role = line.role;
+        if (line.has_marker(MoveBuffer::mkCustomStart))
+            m_is_custom_gcode = true;
+        else if (line.has_marker(MoveBuffer::mkCustomEnd))
+            m_is_custom_gcode = false;
     }
 
     if (time >= 0) {
-        BufferData& new_data = put_in_buffer(BufferData(line.raw(), time, fan_speed));
+        BufferData& new_data = put_in_buffer(BufferData(&line, time, fan_speed));
         if (line.has(Axis::X)) {
-            new_data.x = reader.x();
-            new_data.dx = line.dist_X(reader);
+            new_data.x = m_position[X];
+            new_data.dx = m_position.dist(line, X);
         }
         if (line.has(Axis::Y)) {
-            new_data.y = reader.y();
-            new_data.dy = line.dist_Y(reader);
+            new_data.y = m_position[Y];
+            new_data.dy = m_position.dist(line, Y);
         }
         if (line.has(Axis::Z)) {
-            new_data.z = reader.z();
-            new_data.dz = line.dist_Z(reader);
+            new_data.z = m_position[Z];
+            new_data.dz = m_position.dist(line, Z);
         }
         if (line.has(Axis::E)) {
-            new_data.e = reader.e();
+            new_data.e = m_position[E];
             if (relative_e)
-                new_data.de = line.e();
+                new_data.de = float(line.value(E));
             else
-                new_data.de = line.dist_E(reader);
+                new_data.de = m_position.dist(line, E);
         }
 
         if (m_current_kickstart.time > 0 && time > 0) {
@@ -446,28 +405,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                 _put_in_middle_G1(prev(m_buffer.end()), time + m_current_kickstart.time, BufferData{ m_current_kickstart.raw, 0, m_current_kickstart.fan_speed, true });
             }
         }
-    }/* else {
-        BufferData& new_data = put_in_buffer(BufferData("; del? "+line.raw(), 0, fan_speed));
-        if (line.has(Axis::X)) {
-            new_data.x = reader.x();
-            new_data.dx = line.dist_X(reader);
-        }
-        if (line.has(Axis::Y)) {
-            new_data.y = reader.y();
-            new_data.dy = line.dist_Y(reader);
-        }
-        if (line.has(Axis::Z)) {
-            new_data.z = reader.z();
-            new_data.dz = line.dist_Z(reader);
-        }
-        if (line.has(Axis::E)) {
-            new_data.e = reader.e();
-            if (relative_e)
-                new_data.de = line.e();
-            else
-                new_data.de = line.dist_E(reader);
-        }
-    }*/
+    }
     // puts the line back into the gcode
     //if buffer too big, flush it.
     if (time >= 0) {
@@ -476,11 +414,11 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
             if (frontdata.fan_speed < 0 || frontdata.fan_speed != m_front_buffer_fan_speed || frontdata.is_kickstart) {
                 if (frontdata.is_kickstart && frontdata.fan_speed < m_front_buffer_fan_speed) {
                     //you have to slow down! not kickstart! rewrite the fan speed.
-                    m_process_output += _set_fan(frontdata.fan_speed);//m_writer.set_fan(frontdata.fan_speed,true); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
+                    m_process_output.append_gcode(_set_fan(frontdata.fan_speed));//m_writer.set_fan(frontdata.fan_speed,true); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
                         
                     m_front_buffer_fan_speed = frontdata.fan_speed;
                 } else {
-                    m_process_output += frontdata.raw + "\n";
+                    _write(frontdata);
                     if (frontdata.fan_speed >= 0) {
                         //note that this is the only place where the fan_speed is set and we print from the buffer, as if the fan_speed >= 0 => time == 0
                         //and as this flush all time == 0 lines from the back of the queue...
@@ -494,6 +432,8 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
     double sum = 0;
     for (auto& data : m_buffer) sum += data.time;
     assert( std::abs(m_buffer_time_size - sum) < 0.01);
+
+    m_position.update(line);
 }
 
 } // namespace Slic3r
@@ -7,44 +7,47 @@
 #include "../ExtrusionEntity.hpp"
 
 #include "../Point.hpp"
-#include "../GCodeReader.hpp"
 #include "../GCodeWriter.hpp"
-#include <regex>
+#include "MoveBuffer.hpp"
 
 namespace Slic3r {
 
 class BufferData {
 public:
+    // Line of the G-code being processed, copied as it is into the output. nullptr if the line is in raw.
+    const MoveBuffer::Line *line = nullptr;
+    // Line created or modified by the FanMover.
     std::string raw;
     float time;
     int16_t fan_speed;
     bool is_kickstart;
     float x = 0, y = 0, z = 0, e = 0;
     float dx = 0, dy = 0, dz = 0, de = 0;
-    BufferData(std::string line, float time = 0, int16_t fan_speed = 0, float is_kickstart = false) : raw(line), time(time), fan_speed(fan_speed), is_kickstart(is_kickstart){
-        //avoid double \n
-        if(!line.empty() && line.back() == '\n') line.pop_back();
-    }
+    BufferData(const MoveBuffer::Line *line, float time = 0, int16_t fan_speed = 0) : line(line), time(time), fan_speed(fan_speed), is_kickstart(false) {}
+    // A line ending with a '\n' (from _set_fan()) keeps it, it's written with an empty line after it.
+    BufferData(std::string line, float time = 0, int16_t fan_speed = 0, float is_kickstart = false) : raw(std::move(line)), time(time), fan_speed(fan_speed), is_kickstart(is_kickstart) {}
 };
 
 class FanMover
 {
 private:
-    const std::regex regex_fan_speed;
     const float nb_seconds_delay;
     const bool with_D_option;
     const bool relative_e;
     const bool only_overhangs;
     const float kickstart;
 
-    GCodeReader m_parser{};
     const GCodeWriter& m_writer;
+    const MoveBuffer::Syntax m_syntax;
+    // Position of the axes at the back of the buffer.
+    MoveBuffer::Position m_position;
 
     //current value (at the back of the buffer), when parsing a new line
     ExtrusionRole current_role = ExtrusionRole::erCustom;
     // in unit/second
     double m_current_speed = 1000 / 60.0;
     bool m_is_custom_gcode = false;
+    // Extruder of the line being processed, see MoveBuffer::Line::extruder.
     uint16_t m_currrent_extruder = 0;
 
     // variable for when you add a line (front of the buffer)
@@ -56,19 +59,22 @@ private:
     std::list<BufferData> m_buffer;
     double m_buffer_time_size = 0;
 
+    // The G-code being processed.
+    const MoveBuffer *m_input = nullptr;
     // The output of process_layer()
-    std::string m_process_output;
+    MoveBuffer m_process_output;
 
 public:
     FanMover(const GCodeWriter& writer, const float nb_seconds_delay, const bool with_D_option, const bool relative_e,
         const bool only_overhangs, const float kickstart)
-        : regex_fan_speed("S[0-9]+"), 
-        nb_seconds_delay(nb_seconds_delay>0 ? std::max(0.01f,nb_seconds_delay) : 0),
+        : nb_seconds_delay(nb_seconds_delay>0 ? std::max(0.01f,nb_seconds_delay) : 0),
         with_D_option(with_D_option)
-        , relative_e(relative_e), only_overhangs(only_overhangs), kickstart(kickstart), m_writer(writer){}
+        , relative_e(relative_e), only_overhangs(only_overhangs), kickstart(kickstart), m_writer(writer)
+        , m_syntax(writer.config, writer.toolchange_prefix()) {}
 
-    // Adds the gcode contained in the given string to the analysis and returns it after removing the workcodes
-    const std::string& process_gcode(const std::string& gcode, bool flush);
+    // Adds the gcode to the analysis and returns it after removing the workcodes
+    MoveBuffer process_gcode(MoveBuffer &&gcode, bool flush);
+    std::string process_gcode(const std::string& gcode, bool flush);
 
 private:
     BufferData& put_in_buffer(BufferData&& data) {
@@ -80,9 +86,24 @@ private:
         m_buffer_time_size -= data->time;
         return m_buffer.erase(data);
     }
+    // Text of a line of the buffer.
+    std::string_view _text(const BufferData &data) const { return data.line ? m_input->text(*data.line) : std::string_view(data.raw); }
+    // Text of a line of the buffer, to be modified.
+    std::string& _raw(BufferData &data) {
+        if (data.line) {
+            data.raw  = m_input->text(*data.line);
+            data.line = nullptr;
+        }
+        return data.raw;
+    }
+    void _write(const BufferData &data) {
+        if (data.line)
+            m_process_output.append(*m_input, *data.line);
+        else
+            m_process_output.append_gcode(data.raw + "\n");
+    }
     // Processes the given gcode line
-    void _process_gcode_line(GCodeReader& reader, const GCodeReader::GCodeLine& line);
-    void _process_T(const std::string_view command);
+    void _process_gcode_line(const MoveBuffer::Line& line);
     void _put_in_middle_G1(std::list<BufferData>::iterator item_to_split, float nb_sec, BufferData&& line_to_write);
     void _print_in_middle_G1(BufferData& line_to_split, float nb_sec, const std::string& line_to_write);
     void _remove_slow_fan(int16_t min_speed, float past_sec);
@@ -4,6 +4,8 @@
 #include "libslic3r/LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
 #include "GCodeProcessor.hpp"
+#include "BinaryGCode.hpp"
+#include "libslic3r_version.h"
 
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/log/trivial.hpp>
@@ -12,6 +14,8 @@
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include <float.h>
 #include <assert.h>
@@ -33,6 +37,8 @@ static const float DEFAULT_RETRACT_ACCELERATION = 1500.0f; // Prusa Firmware 1_7
 static const float DEFAULT_TRAVEL_ACCELERATION = 1250.0f;
 
 static const size_t MIN_EXTRUDERS_COUNT = 5;
+// Moves kept as MoveVertex while processing, the older ones are flushed into the columns of the result.
+static const size_t MOVES_FLUSH_BLOCK = 8192;
 static const float DEFAULT_FILAMENT_DIAMETER = 1.75f;
 static const float DEFAULT_FILAMENT_DENSITY = 1.245f;
 static const Slic3r::Vec3f DEFAULT_EXTRUDER_OFFSET = Slic3r::Vec3f::Zero();
@@ -335,6 +341,7 @@ void GCodeProcessor::TimeProcessor::reset()
 {
     extruder_unloaded = true;
     export_remaining_time_enabled = false;
+    binary_gcode = false;
     machine_envelope_processing_enabled = false;
     machine_limits = MachineEnvelopeConfig();
     filament_load_times = std::vector<float>();
@@ -345,14 +352,24 @@ void GCodeProcessor::TimeProcessor::reset()
     machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].enabled = true;
 }
 
-void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, std::vector<GCodeProcessorResult::MoveVertex>& moves, std::vector<size_t>& lines_ends)
+void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, const std::string& out_filename, std::vector<uint32_t>& gcode_ids, std::vector<size_t>& lines_ends)
 {
-    FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
-    if (in.f == nullptr)
-        throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for reading.\n"));
+    // Memory map the input file, the lines are then read in place and copied only if they have to be modified.
+    boost::iostreams::mapped_file_source in_mapped;
+    FilePtr in{ nullptr };
+    try {
+        const boost::filesystem::path path(filename);
+        if (boost::filesystem::file_size(path) > 0)
+            in_mapped.open(path);
+    } catch (const std::exception &) {
+        // Some file systems don't support memory mapping, fall back to the buffered reading.
+        in.f = boost::nowide::fopen(filename.c_str(), "rb");
+        if (in.f == nullptr)
+            throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for reading.\n"));
+    }
 
-    // temporary file to contain modified gcode
-    std::string out_path = filename + ".postprocess";
+    // temporary file to contain modified gcode, unless it's written directly where it's expected
+    std::string out_path = out_filename.empty() ? filename + ".postprocess" : out_filename;
     FilePtr out{ boost::nowide::fopen(out_path.c_str(), "wb") };
     if (out.f == nullptr) {
         throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for writing.\n"));
@@ -501,18 +518,21 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
 
     // check for temporary lines
     auto is_temporary_decoration = [](const std::string_view gcode_line) {
-        // remove trailing '\n'
-        assert(! gcode_line.empty());
-        assert(gcode_line.back() == '\n');
-
         // return true for decorations which are used in processing the gcode but that should not be exported into the final gcode
         // i.e.:
-        // bool ret = gcode_line.substr(0, gcode_line.length() - 1) == ";" + Layer_Change_Tag;
+        // bool ret = gcode_line == ";" + Layer_Change_Tag;
         // ...
         // return ret;
         return false;
     };
 
+    // Same as GCodeReader::GCodeLine::cmd_is(gcode_line, "G1"), on a line that isn't null terminated.
+    auto is_G1 = [](const char *begin, const char *end) {
+        for (; begin != end && (*begin == ' ' || *begin == '\t'); ++ begin) ;
+        return end - begin >= 2 && begin[0] == 'G' && begin[1] == '1' &&
+            (end - begin == 2 || begin[2] == ' ' || begin[2] == '\t' || begin[2] == ';');
+    };
+
     // Iterators for the normal and silent cached time estimate entry recently processed, used by process_line_G1.
     auto g1_times_cache_it = Slic3r::reserve_vector<std::vector<TimeMachine::G1LinesCacheItem>::const_iterator>(machines.size());
     for (const auto& machine : machines)
@@ -582,16 +602,31 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
     };
 
 
+    // the binary gcode is encoded while it's written, as the last stage of the export
+    std::unique_ptr<BinaryGCode::Encoder> binary_encoder;
+    if (binary_gcode)
+        binary_encoder = std::make_unique<BinaryGCode::Encoder>(out.f, SLIC3R_APP_NAME " " SLIC3R_VERSION);
+
     // helper function to write to disk
     size_t out_file_pos = 0;
     lines_ends.clear();
-    auto write_string = [&export_line, &out, &out_path, &out_file_pos, &lines_ends](const std::string& str) {
-        fwrite((const void*)export_line.c_str(), 1, export_line.length(), out.f);
-        if (ferror(out.f)) {
-            out.close();
-            boost::nowide::remove(out_path.c_str());
-            throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nIs the disk full?\n"));
+    auto write_error = [&out, &out_path, &binary_encoder]() {
+        binary_encoder.reset();
+        out.close();
+        boost::nowide::remove(out_path.c_str());
+        throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nIs the disk full?\n"));
+    };
+    auto write_string = [&export_line, &out, &out_file_pos, &lines_ends, &binary_encoder, &write_error](const std::string& str) {
+        if (binary_encoder) {
+            binary_encoder->append(export_line);
+            if (binary_encoder->is_error())
+                write_error();
+            export_line.clear();
+            return;
         }
+        fwrite((const void*)export_line.c_str(), 1, export_line.length(), out.f);
+        if (ferror(out.f))
+            write_error();
         for (size_t i = 0; i < export_line.size(); ++ i)
             if (export_line[i] == '\n')
                 lines_ends.emplace_back(out_file_pos + i + 1);
@@ -602,11 +637,52 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
     unsigned int line_id = 0;
     std::vector<std::pair<unsigned int, unsigned int>> offsets;
 
-    {
+    // Process a line (without its EOL) and append it to export_line.
+    auto process_line = [&](const char *begin, const char *end) {
+        ++line_id;
+        // Only a comment can be a placeholder: copy & process it, the other lines are exported as they are.
+        if (begin != end && *begin == ';') {
+            gcode_line.assign(begin, end);
+            gcode_line += "\n";
+            // replace placeholder lines
+            auto [processed, lines_added_count] = process_placeholders(gcode_line);
+            if (processed && lines_added_count > 0)
+                offsets.push_back({ line_id, lines_added_count });
+            export_line += gcode_line;
+        } else {
+            if (! is_temporary_decoration(std::string_view(begin, end - begin)) && is_G1(begin, end)) {
+                // remove temporary lines, add lines M73 where needed
+                unsigned int extra_lines_count = process_line_G1(g1_lines_counter ++);
+                if (extra_lines_count > 0)
+                    offsets.push_back({ line_id, extra_lines_count });
+            }
+            export_line.append(begin, end);
+            export_line += '\n';
+        }
+        if (export_line.length() > 65535)
+            write_string(export_line);
+    };
+
+    if (in_mapped.is_open()) {
+        const char *begin = in_mapped.data();
+        const char *end   = begin + in_mapped.size();
+        for (const char *it = begin; it != end;) {
+            // Find end of line.
+            const char *it_end = it;
+            for (; it_end != end && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+            process_line(it, it_end);
+            // Skip EOL.
+            it = it_end;
+            if (it != end && *it == '\r')
+                ++ it;
+            if (it != end && *it == '\n')
+                ++ it;
+        }
+    } else if (in.f != nullptr) {
         // Read the input stream 64kB at a time, extract lines and process them.
         std::vector<char> buffer(65536 * 10, 0);
         // Line buffer.
-        assert(gcode_line.empty());
+        std::string line_buffer;
         for (;;) {
             size_t cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f);
             if (::ferror(in.f))
@@ -614,33 +690,17 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
             bool eof       = cnt_read == 0;
             auto it        = buffer.begin();
             auto it_bufend = buffer.begin() + cnt_read;
-            while (it != it_bufend || (eof && ! gcode_line.empty())) {
+            while (it != it_bufend || (eof && ! line_buffer.empty())) {
                 // Find end of line.
                 bool eol    = false;
                 auto it_end = it;
                 for (; it_end != it_bufend && ! (eol = *it_end == '\r' || *it_end == '\n'); ++ it_end) ;
                 // End of line is indicated also if end of file was reached.
                 eol |= eof && it_end == it_bufend;
-                gcode_line.insert(gcode_line.end(), it, it_end);
+                line_buffer.insert(line_buffer.end(), it, it_end);
                 if (eol) {
-                    ++line_id;
-
-                    gcode_line += "\n";
-                    // replace placeholder lines
-                    auto [processed, lines_added_count] = process_placeholders(gcode_line);
-                    if (processed && lines_added_count > 0)
-                        offsets.push_back({ line_id, lines_added_count });
-                    if (! processed && ! is_temporary_decoration(gcode_line) && GCodeReader::GCodeLine::cmd_is(gcode_line, "G1")) {
-                        // remove temporary lines, add lines M73 where needed
-                        unsigned int extra_lines_count = process_line_G1(g1_lines_counter ++);
-                        if (extra_lines_count > 0)
-                            offsets.push_back({ line_id, extra_lines_count });
-                    }
-
-                    export_line += gcode_line;
-                    if (export_line.length() > 65535)
-                        write_string(export_line);
-                    gcode_line.clear();
+                    process_line(line_buffer.data(), line_buffer.data() + line_buffer.size());
+                    line_buffer.clear();
                 }
                 // Skip EOL.
                 it = it_end; 
@@ -656,21 +716,27 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
 
     if (!export_line.empty())
         write_string(export_line);
+    if (binary_encoder && ! binary_encoder->finish())
+        write_error();
+    binary_encoder.reset();
 
     out.close();
     in.close();
+    in_mapped.close();
 
     // updates moves' gcode ids which have been modified by the insertion of the M73 lines
     unsigned int curr_offset_id = 0;
     unsigned int total_offset = 0;
-    for (GCodeProcessorResult::MoveVertex& move : moves) {
-        while (curr_offset_id < static_cast<unsigned int>(offsets.size()) && offsets[curr_offset_id].first <= move.gcode_id) {
+    for (uint32_t& gcode_id : gcode_ids) {
+        while (curr_offset_id < static_cast<unsigned int>(offsets.size()) && offsets[curr_offset_id].first <= gcode_id) {
             total_offset += offsets[curr_offset_id].second;
             ++curr_offset_id;
         }
-        move.gcode_id += total_offset;
+        gcode_id += total_offset;
     }
 
+    if (! out_filename.empty())
+        return;
     std::error_code err_code;
     if (err_code = rename_file(out_path, filename)) {
         std::string err_msg = (std::string("Failed to rename the output G-code file from ") + out_path + " to " + filename + '\n' +
@@ -749,7 +815,7 @@ void GCodeProcessor::UsedFilaments::process_caches(GCodeProcessor* processor)
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
 void GCodeProcessorResult::reset() {
-    moves = std::vector<GCodeProcessorResult::MoveVertex>();
+    moves.clear();
     bed_shape = Pointfs();
     max_print_height = 0.0f;
     settings_ids.reset();
@@ -784,6 +850,129 @@ void GCodeProcessorResult::reset() {
 }
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
+void GCodeProcessorResult::MoveVertices::Builder::append(const MoveVertex& move)
+{
+    if (! m_columns)
+        m_columns = std::make_shared<Columns>();
+    Columns& c = *m_columns;
+    const uint32_t id = uint32_t(m_gcode_ids.size());
+    m_gcode_ids.push_back(move.gcode_id);
+    c.position.push_back(move.position);
+    c.delta_extruder.push_back(move.delta_extruder);
+    c.time.push_back(move.time);
+    c.type.push_back(id, move.type);
+    c.extrusion_role.push_back(id, move.extrusion_role);
+    c.extruder_id.push_back(id, move.extruder_id);
+    c.cp_color_id.push_back(id, move.cp_color_id);
+    c.feedrate.push_back(id, move.feedrate);
+    c.width.push_back(id, move.width);
+    c.height.push_back(id, move.height);
+    c.mm3_per_mm.push_back(id, move.mm3_per_mm);
+    c.fan_speed.push_back(id, move.fan_speed);
+    c.temperature.push_back(id, move.temperature);
+    c.layer_duration.push_back(id, move.layer_duration);
+}
+
+void GCodeProcessorResult::MoveVertices::Builder::set_layer_durations(const std::vector<float>& layers_times)
+{
+    if (! m_columns)
+        return;
+    // one value per run of moves of the same layer
+    for (float& value : m_columns->layer_duration.values) {
+        const size_t layer_id = size_t(value);
+        value = (layer_id > 0 && layers_times.size() > layer_id - 1) ? layers_times[layer_id - 1] : 0.f;
+    }
+}
+
+void GCodeProcessorResult::MoveVertices::Builder::build(MoveVertices& moves)
+{
+    // The previous columns may still be read through a copy, the new moves go into new ones.
+    moves.clear();
+    if (m_gcode_ids.empty()) {
+        this->clear();
+        return;
+    }
+    Columns& c = *m_columns;
+    // gcode ids: one base per block of moves, if they are close enough.
+    bool delta_encoded = true;
+    for (size_t id = 0; id < m_gcode_ids.size(); id += GCodeIdBlock) {
+        const auto [min_it, max_it] = std::minmax_element(m_gcode_ids.begin() + id, m_gcode_ids.begin() + std::min(id + GCodeIdBlock, m_gcode_ids.size()));
+        if (*max_it - *min_it > std::numeric_limits<uint16_t>::max()) {
+            // can't be delta encoded
+            delta_encoded = false;
+            c.gcode_id_base.clear();
+            break;
+        }
+        c.gcode_id_base.push_back(*min_it);
+    }
+    if (delta_encoded) {
+        c.gcode_id_delta.reserve(m_gcode_ids.size());
+        for (size_t id = 0; id < m_gcode_ids.size(); ++id)
+            c.gcode_id_delta.push_back(uint16_t(m_gcode_ids[id] - c.gcode_id_base[id / GCodeIdBlock]));
+        m_gcode_ids = std::vector<uint32_t>();
+    } else
+        c.gcode_id_full = std::move(m_gcode_ids);
+    // the columns were grown move by move
+    c.position.shrink_to_fit();
+    c.delta_extruder.shrink_to_fit();
+    c.time.shrink_to_fit();
+    moves.m_columns = std::move(m_columns);
+    this->clear();
+}
+
+void GCodeProcessorResult::MoveVertices::Builder::clear()
+{
+    m_columns.reset();
+    m_gcode_ids = std::vector<uint32_t>();
+}
+
+void GCodeProcessorResult::MoveVertices::assign(const std::vector<MoveVertex>& moves)
+{
+    Builder builder;
+    for (const MoveVertex& move : moves)
+        builder.append(move);
+    builder.build(*this);
+}
+
+void GCodeProcessorResult::MoveVertices::clear()
+{
+    m_columns.reset();
+}
+
+GCodeProcessorResult::MoveVertex GCodeProcessorResult::MoveVertices::get(size_t id, Cursor& cursor) const
+{
+    assert(id < this->size());
+    const Columns& c = *m_columns;
+    return MoveVertex(
+        this->gcode_id(id),
+        c.type.values[c.type.run(id, cursor.type)],
+        c.extrusion_role.values[c.extrusion_role.run(id, cursor.extrusion_role)],
+        c.extruder_id.values[c.extruder_id.run(id, cursor.extruder_id)],
+        c.cp_color_id.values[c.cp_color_id.run(id, cursor.cp_color_id)],
+        c.position[id],
+        c.delta_extruder[id],
+        c.feedrate.values[c.feedrate.run(id, cursor.feedrate)],
+        c.width.values[c.width.run(id, cursor.width)],
+        c.height.values[c.height.run(id, cursor.height)],
+        c.mm3_per_mm.values[c.mm3_per_mm.run(id, cursor.mm3_per_mm)],
+        c.fan_speed.values[c.fan_speed.run(id, cursor.fan_speed)],
+        c.temperature.values[c.temperature.run(id, cursor.temperature)],
+        c.time[id],
+        c.layer_duration.values[c.layer_duration.run(id, cursor.layer_duration)]);
+}
+
+size_t GCodeProcessorResult::MoveVertices::memory_size() const
+{
+    if (! m_columns)
+        return 0;
+    const Columns& c = *m_columns;
+    return SLIC3R_STDVEC_MEMSIZE(c.position, Vec3f) + SLIC3R_STDVEC_MEMSIZE(c.delta_extruder, float) + SLIC3R_STDVEC_MEMSIZE(c.time, float) +
+        SLIC3R_STDVEC_MEMSIZE(c.gcode_id_base, uint32_t) + SLIC3R_STDVEC_MEMSIZE(c.gcode_id_delta, uint16_t) + SLIC3R_STDVEC_MEMSIZE(c.gcode_id_full, uint32_t) +
+        c.type.memory_size() + c.extrusion_role.memory_size() + c.extruder_id.memory_size() + c.cp_color_id.memory_size() +
+        c.feedrate.memory_size() + c.width.memory_size() + c.height.memory_size() + c.mm3_per_mm.memory_size() +
+        c.fan_speed.memory_size() + c.temperature.memory_size() + c.layer_duration.memory_size();
+}
+
 const std::vector<std::pair<GCodeProcessor::EProducer, std::string>> GCodeProcessor::Producers = {
     { EProducer::PrusaSlicer, "generated by PrusaSlicer" },
     { EProducer::Slic3rPE,    "generated by Slic3r Prusa Edition" },
@@ -851,7 +1040,7 @@ bool GCodeProcessor::contains_reserved_tags(const std::string& gcode, unsigned i
 }
 
 GCodeProcessor::GCodeProcessor()
-: m_options_z_corrector(m_result)
+: m_options_z_corrector(m_moves, m_flushed_moves, m_result)
 {
     reset();
 }
@@ -928,6 +1117,7 @@ void GCodeProcessor::apply_config(const PrintConfig& config)
     }
 
     m_time_processor.export_remaining_time_enabled = config.remaining_times.value;
+    m_time_processor.binary_gcode = config.binary_gcode.value;
     m_use_volumetric_e = config.use_volumetric_e;
 
     const ConfigOptionFloatOrPercent* first_layer_height = config.option<ConfigOptionFloatOrPercent>("first_layer_height");
@@ -1314,10 +1504,12 @@ void GCodeProcessor::reset()
     m_used_filaments.reset();
 
     m_result.reset();
+    m_moves.clear();
+    m_flushed_moves.clear();
     m_result.id = ++s_result_id;
     // 1st move must be a dummy move
-    assert(m_result.moves.empty());
-    m_result.moves.emplace_back();
+    assert(m_moves.empty());
+    m_moves.emplace_back();
 
     m_use_volumetric_e = false;
     m_last_default_color_id = 0;
@@ -1407,7 +1599,7 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     m_result.filename = filename;
     m_result.id = ++s_result_id;
     // 1st move must be a dummy move (should be added by the reset())
-    assert(m_result.moves.size() == 1 && m_result.moves.front().type == EMoveType::Noop);
+    assert(m_moves.size() == 1 && m_moves.front().type == EMoveType::Noop);
     size_t parse_line_callback_cntr = 10000;
     m_parser.parse_file(filename, [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
         if (-- parse_line_callback_cntr == 0) {
@@ -1435,7 +1627,7 @@ void GCodeProcessor::initialize(const std::string& filename)
     m_result.filename = filename;
     m_result.id = ++s_result_id;
     // 1st move must be a dummy move (should be added by the reset())
-    assert(m_result.moves.size()==1 && m_result.moves.front().type == EMoveType::Noop);
+    assert(m_moves.size()==1 && m_moves.front().type == EMoveType::Noop);
 }
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
@@ -1446,15 +1638,11 @@ void GCodeProcessor::process_buffer(const std::string &buffer)
     });
 }
 
-void GCodeProcessor::finalize(bool post_process)
+void GCodeProcessor::finalize(bool post_process, const std::string& post_process_output)
 {
-    // update width/height of wipe moves
-    for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
-        if (move.type == EMoveType::Wipe) {
-            move.width = Wipe_Width;
-            move.height = Wipe_Height;
-        }
-    }
+    // the pending correction of the z of the last option is dropped with it
+    m_options_z_corrector.reset();
+    flush_moves(0);
 
     // process the time blocks
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
@@ -1470,23 +1658,21 @@ void GCodeProcessor::finalize(bool post_process)
     update_estimated_times_stats();
 
     //update times for results
-    for (size_t i = 0; i < m_result.moves.size(); i++) {
-        //field layer_duration contains the layer id for the move in which the layer_duration has to be set.
-        size_t layer_id = size_t(m_result.moves[i].layer_duration);
-        std::vector<float>& layer_times = m_result.print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].layers_times;
-        if (layer_times.size() > layer_id - 1 && layer_id > 0)
-            m_result.moves[i].layer_duration = layer_times[layer_id - 1];
-        else
-            m_result.moves[i].layer_duration = 0;
-    }
+    //field layer_duration contains the layer id for the move in which the layer_duration has to be set.
+    m_flushed_moves.set_layer_durations(m_result.print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].layers_times);
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
     m_mm3_per_mm_compare.output();
     m_height_compare.output();
     m_width_compare.output();
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
 
-    if (post_process)
-        m_time_processor.post_process(m_result.filename, m_result.moves, m_result.lines_ends);
+    if (post_process) {
+        m_time_processor.post_process(m_result.filename, post_process_output, m_flushed_moves.gcode_ids(), m_result.lines_ends);
+        if (! post_process_output.empty())
+            m_result.filename = post_process_output;
+    }
+    m_flushed_moves.build(m_result.moves);
+    m_moves = std::vector<GCodeProcessorResult::MoveVertex>();
 #if ENABLE_GCODE_VIEWER_STATISTICS
     m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_start_time).count();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
@@ -2108,10 +2294,10 @@ void GCodeProcessor::process_tags(const std::string_view comment, bool producers
         ++m_layer_id;
 #if ENABLE_SPIRAL_VASE_LAYERS
         if (m_spiral_vase_active) {
-            if (m_result.moves.empty())
+            if (moves_count() == 0)
                 m_result.spiral_vase_layers.push_back({ m_first_layer_height, { 0, 0 } });
             else {
-                const size_t move_id = m_result.moves.size() - 1;
+                const size_t move_id = moves_count() - 1;
                 if (!m_result.spiral_vase_layers.empty() && m_end_position[Z] == m_result.spiral_vase_layers.back().first)
                     m_result.spiral_vase_layers.back().second.second = move_id;
                 else
@@ -2915,7 +3101,7 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line)
     if (m_seams_detector.is_active()) {
         // check for seam starting vertex
         if (type == EMoveType::Extrude && m_extrusion_role == erExternalPerimeter && !m_seams_detector.has_first_vertex())
-            m_seams_detector.set_first_vertex(m_result.moves.back().position - m_extruder_offsets[m_extruder_id]);
+            m_seams_detector.set_first_vertex(m_moves.back().position - m_extruder_offsets[m_extruder_id]);
         // check for seam ending vertex and store the resulting move
         else if ((type != EMoveType::Extrude || (m_extrusion_role != erExternalPerimeter && m_extrusion_role != erOverhangPerimeter)) && m_seams_detector.has_first_vertex()) {
             auto set_end_position = [this](const Vec3f& pos) {
@@ -2923,7 +3109,7 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line)
             };
 
             const Vec3f curr_pos(m_end_position[X], m_end_position[Y], m_end_position[Z]);
-            const Vec3f new_pos = m_result.moves.back().position - m_extruder_offsets[m_extruder_id];
+            const Vec3f new_pos = m_moves.back().position - m_extruder_offsets[m_extruder_id];
             const std::optional<Vec3f> first_vertex = m_seams_detector.get_first_vertex();
             // the threshold value = 0.0625f == 0.25 * 0.25 is arbitrary, we may find some smarter condition later
 
@@ -2942,12 +3128,12 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line)
     }
     else if (type == EMoveType::Extrude && m_extrusion_role == erExternalPerimeter) {
         m_seams_detector.activate(true);
-        m_seams_detector.set_first_vertex(m_result.moves.back().position - m_extruder_offsets[m_extruder_id]);
+        m_seams_detector.set_first_vertex(m_moves.back().position - m_extruder_offsets[m_extruder_id]);
     }
 
 #if ENABLE_SPIRAL_VASE_LAYERS
-    if (m_spiral_vase_active && !m_result.spiral_vase_layers.empty() && !m_result.moves.empty())
-        m_result.spiral_vase_layers.back().second.second = m_result.moves.size() - 1;
+    if (m_spiral_vase_active && !m_result.spiral_vase_layers.empty() && moves_count() > 0)
+        m_result.spiral_vase_layers.back().second.second = moves_count() - 1;
 #endif // ENABLE_SPIRAL_VASE_LAYERS
 
     // store move
@@ -3564,7 +3750,7 @@ void GCodeProcessor::store_move_vertex(EMoveType type)
         m_line_id + 1 :
         ((type == EMoveType::Seam) ? m_last_line_id : m_line_id);
     assert(type != EMoveType::Noop);
-    m_result.moves.emplace_back(
+    m_moves.emplace_back(
         m_last_line_id,
         type,
         m_extrusion_role,
@@ -3596,6 +3782,26 @@ void GCodeProcessor::store_move_vertex(EMoveType type)
             machine.stop_times.push_back({ m_g1_line_id, 0.0f });
         }
     }
+
+    if (m_moves.size() >= 2 * MOVES_FLUSH_BLOCK)
+        flush_moves(MOVES_FLUSH_BLOCK);
+}
+
+void GCodeProcessor::flush_moves(size_t keep)
+{
+    size_t count = m_moves.size() - std::min(keep, m_moves.size());
+    if (const std::optional<size_t>& move_id = m_options_z_corrector.move_id(); move_id.has_value())
+        count = std::min(count, *move_id - m_flushed_moves.size());
+    for (size_t i = 0; i < count; ++i) {
+        GCodeProcessorResult::MoveVertex& move = m_moves[i];
+        // update width/height of wipe moves
+        if (move.type == EMoveType::Wipe) {
+            move.width = Wipe_Width;
+            move.height = Wipe_Height;
+        }
+        m_flushed_moves.append(move);
+    }
+    m_moves.erase(m_moves.begin(), m_moves.begin() + count);
 }
 
 void GCodeProcessor::set_extrusion_role(ExtrusionRole role)
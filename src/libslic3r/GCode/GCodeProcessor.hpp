@@ -9,7 +9,10 @@
 
 #include <cstdint>
 #include <ctime>
+#include <algorithm>
 #include <array>
+#include <iterator>
+#include <memory>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -123,9 +126,160 @@ namespace Slic3r {
             float volumetric_rate() const { return feedrate * mm3_per_mm; }
         };
 
+        // Read only, column oriented storage of the moves of a processed G-code.
+        // Most of the attributes (type, role, extruder, width, height, fan speed, temperature...) are constant over long runs
+        // of moves, they are run length encoded. The gcode ids are delta encoded, the positions, extrusions and times are stored as they are.
+        // The moves are rebuilt on access: use a Cursor (or the iterator) to read them in sequence in constant time.
+        // The columns are shared by the copies: a copy is O(1), it keeps the moves alive while the original is assigned again.
+        class MoveVertices
+        {
+            struct Columns;
+
+            // Run length encoded column: values[i] is the value of the moves from starts[i] to starts[i + 1] (excluded).
+            template<typename T>
+            struct RLEColumn
+            {
+                std::vector<T>        values;
+                std::vector<uint32_t> starts;
+
+                void push_back(uint32_t id, const T& value) {
+                    if (values.empty() || !(values.back() == value)) {
+                        values.push_back(value);
+                        starts.push_back(id);
+                    }
+                }
+                // Index of the run containing the move id.
+                size_t run(size_t id) const {
+                    return std::upper_bound(starts.begin(), starts.end(), uint32_t(id)) - starts.begin() - 1;
+                }
+                // Same, starting the search from the run hint, which is updated.
+                size_t run(size_t id, size_t& hint) const {
+                    if (hint >= starts.size() || starts[hint] > id)
+                        hint = run(id);
+                    else
+                        for (size_t i = 0; hint + 1 < starts.size() && starts[hint + 1] <= id; ++hint)
+                            if (++i == 8) {
+                                // far jump
+                                hint = run(id);
+                                break;
+                            }
+                    return hint;
+                }
+                size_t memory_size() const { return values.capacity() * sizeof(T) + starts.capacity() * sizeof(uint32_t); }
+            };
+
+        public:
+            // Hints of the runs of the last move read, to read the moves in sequence without searching for them.
+            struct Cursor
+            {
+                size_t type{ 0 }, extrusion_role{ 0 }, extruder_id{ 0 }, cp_color_id{ 0 }, feedrate{ 0 }, width{ 0 }, height{ 0 },
+                    mm3_per_mm{ 0 }, fan_speed{ 0 }, temperature{ 0 }, layer_duration{ 0 };
+            };
+
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = MoveVertex;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const MoveVertex*;
+                using reference         = const MoveVertex&;
+
+                const_iterator(const MoveVertices& moves, size_t id) : m_moves(&moves), m_id(id) { this->update(); }
+                reference operator*() const { return m_vertex; }
+                pointer operator->() const { return &m_vertex; }
+                const_iterator& operator++() { ++m_id; this->update(); return *this; }
+                bool operator==(const const_iterator& rhs) const { return m_id == rhs.m_id; }
+                bool operator!=(const const_iterator& rhs) const { return m_id != rhs.m_id; }
+                size_t id() const { return m_id; }
+
+            private:
+                void update() { if (m_id < m_moves->size()) m_vertex = m_moves->get(m_id, m_cursor); }
+
+                const MoveVertices* m_moves;
+                size_t              m_id;
+                Cursor              m_cursor;
+                MoveVertex          m_vertex;
+            };
+
+            // Fills the columns while the G-code is processed: the moves are appended in blocks and dropped by the caller.
+            // The gcode ids and the layer durations of the moves appended can still be updated until build().
+            class Builder
+            {
+            public:
+                void append(const MoveVertex& move);
+                // Number of moves appended.
+                size_t size() const { return m_gcode_ids.size(); }
+                // gcode ids of the moves appended, delta encoded by build().
+                std::vector<uint32_t>& gcode_ids() { return m_gcode_ids; }
+                // Replaces the 1-based layer ids stored as the layer_duration of the moves by the times of these layers.
+                void set_layer_durations(const std::vector<float>& layers_times);
+                // Moves the columns into moves, the builder is empty afterwards.
+                void build(MoveVertices& moves);
+                void clear();
+
+            private:
+                std::shared_ptr<Columns> m_columns;
+                std::vector<uint32_t>    m_gcode_ids;
+            };
+
+            void assign(const std::vector<MoveVertex>& moves);
+            void clear();
+
+            size_t size() const { return m_columns ? m_columns->position.size() : 0; }
+            bool empty() const { return this->size() == 0; }
+            // Random access, O(log(runs)).
+            MoveVertex operator[](size_t id) const { Cursor cursor; return this->get(id, cursor); }
+            // Access in sequence, O(1) if id is near the last move read with this cursor.
+            MoveVertex get(size_t id, Cursor& cursor) const;
+            MoveVertex front() const { return (*this)[0]; }
+            MoveVertex back() const { return (*this)[this->size() - 1]; }
+            const_iterator begin() const { return const_iterator(*this, 0); }
+            const_iterator end() const { return const_iterator(*this, this->size()); }
+
+            // Single attribute accessors, cheaper than building the whole MoveVertex.
+            const Vec3f& position(size_t id) const { return m_columns->position[id]; }
+            EMoveType type(size_t id) const { return m_columns->type.values[m_columns->type.run(id)]; }
+            uint32_t gcode_id(size_t id) const {
+                const Columns& c = *m_columns;
+                return c.gcode_id_full.empty() ? c.gcode_id_base[id / GCodeIdBlock] + c.gcode_id_delta[id] : c.gcode_id_full[id];
+            }
+
+            size_t memory_size() const;
+
+        private:
+            // Number of moves sharing a base gcode id.
+            static constexpr const size_t GCodeIdBlock = 256;
+
+            struct Columns
+            {
+                std::vector<Vec3f>            position;
+                std::vector<float>            delta_extruder;
+                std::vector<float>            time;
+                // gcode_id = gcode_id_base[id / GCodeIdBlock] + gcode_id_delta[id],
+                // or gcode_id_full[id] if the ids of a block are too far apart.
+                std::vector<uint32_t>         gcode_id_base;
+                std::vector<uint16_t>         gcode_id_delta;
+                std::vector<uint32_t>         gcode_id_full;
+                RLEColumn<EMoveType>          type;
+                RLEColumn<ExtrusionRole>      extrusion_role;
+                RLEColumn<uint8_t>            extruder_id;
+                RLEColumn<uint8_t>            cp_color_id;
+                RLEColumn<float>              feedrate;
+                RLEColumn<float>              width;
+                RLEColumn<float>              height;
+                RLEColumn<float>              mm3_per_mm;
+                RLEColumn<float>              fan_speed;
+                RLEColumn<float>              temperature;
+                RLEColumn<float>              layer_duration;
+            };
+            // Never modified once assigned, nullptr if there are no moves.
+            std::shared_ptr<const Columns> m_columns;
+        };
+
         std::string filename;
         unsigned int id;
-        std::vector<MoveVertex> moves;
+        MoveVertices moves;
         // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code.
         std::vector<size_t> lines_ends;
         Pointfs bed_shape;
@@ -348,6 +502,8 @@ namespace Slic3r {
             bool extruder_unloaded = false;
             // whether or not to export post-process the gcode to export lines M73 in it
             bool export_remaining_time_enabled = false;
+            // whether or not to encode the post-processed gcode into a binary gcode
+            bool binary_gcode = false;
             // allow to skip the lines M201/M203/M204/M205 generated by GCode::print_machine_envelope() for non-Normal time estimate mode
             bool machine_envelope_processing_enabled = false;
             MachineEnvelopeConfig machine_limits = MachineEnvelopeConfig{};
@@ -369,7 +525,10 @@ namespace Slic3r {
 
             // post process the file with the given filename to add remaining time lines M73
             // and updates moves' gcode ids accordingly
-            void post_process(const std::string& filename, std::vector<GCodeProcessorResult::MoveVertex>& moves, std::vector<size_t>& lines_ends);
+            // the lines ends are not collected for a binary gcode, as they can't be found in the file
+            // If out_filename is set, the result is written there and the input file is left as it is,
+            // otherwise the input file is replaced.
+            void post_process(const std::string& filename, const std::string& out_filename, std::vector<uint32_t>& gcode_ids, std::vector<size_t>& lines_ends);
         };
 
         struct UsedFilaments  // filaments per ColorChange
@@ -421,30 +580,39 @@ namespace Slic3r {
         // custom gcode markes
         class OptionsZCorrector
         {
-            GCodeProcessorResult& m_result;
+            std::vector<GCodeProcessorResult::MoveVertex>& m_moves;
+            // moves already flushed before m_moves
+            const GCodeProcessorResult::MoveVertices::Builder& m_flushed_moves;
+            std::vector<CustomGCode::Item>& m_custom_gcode_per_print_z;
             std::optional<size_t> m_move_id;
             std::optional<size_t> m_custom_gcode_per_print_z_id;
 
         public:
-            explicit OptionsZCorrector(GCodeProcessorResult& result) : m_result(result) {
+            OptionsZCorrector(std::vector<GCodeProcessorResult::MoveVertex>& moves, const GCodeProcessorResult::MoveVertices::Builder& flushed_moves, GCodeProcessorResult& result) :
+                m_moves(moves), m_flushed_moves(flushed_moves), m_custom_gcode_per_print_z(result.custom_gcode_per_print_z) {
             }
 
+            // Id of the move to be corrected, it must not be flushed.
+            const std::optional<size_t>& move_id() const { return m_move_id; }
+
             void set() {
-                m_move_id = m_result.moves.size() - 1;
-                m_custom_gcode_per_print_z_id = m_result.custom_gcode_per_print_z.size() - 1;
+                m_move_id = m_flushed_moves.size() + m_moves.size() - 1;
+                m_custom_gcode_per_print_z_id = m_custom_gcode_per_print_z.size() - 1;
             }
 
             void update(float height) {
                 if (!m_move_id.has_value() || !m_custom_gcode_per_print_z_id.has_value())
                     return;
 
-                const Vec3f position = m_result.moves.back().position;
+                const Vec3f position = m_moves.back().position;
+                assert(*m_move_id >= m_flushed_moves.size());
+                const size_t move_id = *m_move_id - m_flushed_moves.size();
 
-                GCodeProcessorResult::MoveVertex& move = m_result.moves.emplace_back(m_result.moves[*m_move_id]);
+                GCodeProcessorResult::MoveVertex& move = m_moves.emplace_back(m_moves[move_id]);
                 move.position = position;
                 move.height = height;
-                m_result.moves.erase(m_result.moves.begin() + *m_move_id);
-                m_result.custom_gcode_per_print_z[*m_custom_gcode_per_print_z_id].print_z = position.z();
+                m_moves.erase(m_moves.begin() + move_id);
+                m_custom_gcode_per_print_z[*m_custom_gcode_per_print_z_id].print_z = position.z();
                 reset();
             }
 
@@ -596,6 +764,9 @@ namespace Slic3r {
         UsedFilaments m_used_filaments;
 
         GCodeProcessorResult m_result;
+        // Last moves of m_result while processing, the older ones are flushed in blocks into m_flushed_moves.
+        std::vector<GCodeProcessorResult::MoveVertex> m_moves;
+        GCodeProcessorResult::MoveVertices::Builder m_flushed_moves;
         static unsigned int s_result_id;
 
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
@@ -626,7 +797,8 @@ namespace Slic3r {
         // Streaming interface, for processing G-codes just generated by PrusaSlicer in a pipelined fashion.
         void initialize(const std::string& filename);
         void process_buffer(const std::string& buffer);
-        void finalize(bool post_process);
+        // If post_process_output is set, the post processed G-code is written into this file instead of replacing the processed one.
+        void finalize(bool post_process, const std::string& post_process_output = std::string());
 
         float get_time(PrintEstimatedStatistics::ETimeMode mode) const;
         std::string get_time_dhm(PrintEstimatedStatistics::ETimeMode mode) const;
@@ -757,6 +929,10 @@ namespace Slic3r {
         void process_klipper_ACTIVATE_EXTRUDER(const GCodeReader::GCodeLine& line);
 
         void store_move_vertex(EMoveType type);
+        // Flushes the moves into m_flushed_moves, keeping the last ones and the ones the OptionsZCorrector may still modify.
+        void flush_moves(size_t keep);
+        // Number of moves stored, flushed or not.
+        size_t moves_count() const { return m_flushed_moves.size() + m_moves.size(); }
 
         void set_extrusion_role(ExtrusionRole role);
 
@@ -0,0 +1,246 @@
+#include "MoveBuffer.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include <fast_float/fast_float.h>
+
+namespace Slic3r {
+
+MoveBuffer::Syntax::Syntax(const GCodeConfig &config, const std::string &toolchange_prefix) :
+    extrusion_axis(get_extrusion_axis(config).empty() ? 0 : get_extrusion_axis(config).front()),
+    toolchange_prefix(toolchange_prefix)
+{}
+
+MoveBuffer::MoveBuffer(std::string &&gcode, const Syntax &syntax, uint16_t extruder) :
+    m_syntax(syntax), m_start_extruder(extruder), m_extruder(extruder), m_text(std::move(gcode))
+{
+    if (! m_text.empty() && m_text.back() != '\n')
+        m_text += '\n';
+    this->tokenize(0);
+}
+
+void MoveBuffer::append(const MoveBuffer &src, size_t first, size_t last)
+{
+    assert(first <= last && last <= src.m_lines.size());
+    if (first == last)
+        return;
+    // The lines of src are contiguous in its text.
+    const uint32_t src_begin = src.m_lines[first].begin;
+    const uint32_t src_end   = src.m_lines[last - 1].end + 1;
+    const int64_t  shift     = int64_t(m_text.size()) - int64_t(src_begin);
+    m_text.append(src.m_text.data() + src_begin, src_end - src_begin);
+    m_lines.reserve(m_lines.size() + last - first);
+    for (size_t i = first; i < last; ++ i) {
+        Line line = src.m_lines[i];
+        line.begin = uint32_t(int64_t(line.begin) + shift);
+        line.end   = uint32_t(int64_t(line.end) + shift);
+        m_lines.emplace_back(line);
+    }
+    m_extruder = m_lines.back().extruder;
+}
+
+void MoveBuffer::append(MoveBuffer &&src)
+{
+    if (m_lines.empty()) {
+        m_syntax         = src.m_syntax;
+        m_start_extruder = src.m_start_extruder;
+        m_extruder       = src.m_extruder;
+        m_lines          = std::move(src.m_lines);
+        m_text           = std::move(src.m_text);
+    } else
+        this->append(src, 0, src.m_lines.size());
+    src.clear();
+}
+
+void MoveBuffer::append_gcode(std::string_view gcode)
+{
+    if (gcode.empty())
+        return;
+    size_t start = m_text.size();
+    m_text.append(gcode.data(), gcode.size());
+    if (m_text.back() != '\n')
+        m_text += '\n';
+    this->tokenize(start);
+}
+
+void MoveBuffer::tokenize(size_t text_start)
+{
+    // Text sizes are stored as uint32_t.
+    assert(m_text.size() < size_t(std::numeric_limits<uint32_t>::max()));
+    assert(m_text.empty() || m_text.back() == '\n');
+    const char *c   = m_text.data() + text_start;
+    const char *end = m_text.data() + m_text.size();
+    while (c != end) {
+        const char *line_end = static_cast<const char*>(memchr(c, '\n', end - c));
+        m_lines.emplace_back(this->parse_line(c, line_end, m_extruder));
+        m_extruder = m_lines.back().extruder;
+        c = line_end + 1;
+    }
+}
+
+static inline bool is_whitespace(char c) { return c == ' ' || c == '\t'; }
+// The lines end with a '\n' in the text, it may be preceded by a '\r'.
+static inline bool is_end_of_word(char c) { return is_whitespace(c) || c == ';' || c == '\r' || c == '\n'; }
+static inline bool starts_with(const char *begin, const char *end, const std::string_view prefix)
+    { return size_t(end - begin) >= prefix.size() && memcmp(begin, prefix.data(), prefix.size()) == 0; }
+
+MoveBuffer::Line MoveBuffer::parse_line(const char *begin, const char *end, uint16_t extruder) const
+{
+    Line line {};
+    line.begin    = uint32_t(begin - m_text.data());
+    line.end      = uint32_t(end - m_text.data());
+    line.code     = -1;
+    line.extruder = extruder;
+    line.role    = erNone;
+    const char *comment = static_cast<const char*>(memchr(begin, ';', end - begin));
+    if (comment == nullptr)
+        comment = end;
+    line.comment = uint32_t(comment - begin);
+
+    // Command.
+    // Number ending a word, -1 if there is none or it's not the end of the word.
+    auto read_code = [](const char *c) -> int16_t {
+        if (*c < '0' || *c > '9')
+            return -1;
+        int code = 0;
+        for (; *c >= '0' && *c <= '9' && code < 10000; ++ c)
+            code = code * 10 + (*c - '0');
+        return is_end_of_word(*c) ? int16_t(code) : -1;
+    };
+    const char *c = begin;
+    if (! m_syntax.toolchange_prefix.empty() && starts_with(begin, comment, m_syntax.toolchange_prefix)) {
+        // A tool change that can't be read ("Tx", "T?" of the MMU, "T-1" of RepRap deselecting the tools) keeps the extruder.
+        line.letter = 'T';
+        line.code   = read_code(begin + m_syntax.toolchange_prefix.size());
+        if (line.code >= 0)
+            line.extruder = uint16_t(line.code);
+    } else {
+        for (; is_whitespace(*c); ++ c);
+        if (*c == 'G' || *c == 'M') {
+            line.code = read_code(c + 1);
+            if (line.code >= 0)
+                line.letter = *c;
+        }
+    }
+    // Words, after the first one.
+    for (; c < comment && ! is_end_of_word(*c); ++ c);
+    while (c < comment) {
+        for (; is_whitespace(*c); ++ c);
+        if (is_end_of_word(*c))
+            break;
+        int axis = UNKNOWN_AXIS;
+        switch (*c) {
+        case 'X': axis = X; break;
+        case 'Y': axis = Y; break;
+        case 'Z': axis = Z; break;
+        case 'F': axis = F; break;
+        default:
+            if (*c == m_syntax.extrusion_axis && m_syntax.extrusion_axis != 0)
+                axis = E;
+        }
+        if (axis != UNKNOWN_AXIS) {
+            for (++ c; is_whitespace(*c); ++ c);
+            double v;
+            auto [pend, ec] = fast_float::from_chars(c, comment, v);
+            if (pend != c && is_end_of_word(*pend) && size_t(c - begin) <= size_t(std::numeric_limits<uint16_t>::max())) {
+                line.values[axis]    = v;
+                line.value_pos[axis] = uint16_t(c - begin);
+                line.axes           |= 1 << axis;
+                c = pend;
+                continue;
+            }
+        }
+        // Another word, or a value that can't be read.
+        line.axes |= 1 << UNKNOWN_AXIS;
+        for (; c < comment && ! is_end_of_word(*c); ++ c);
+    }
+
+    // Markers.
+    if (comment != end) {
+        if (comment == begin) {
+            // Comment line.
+            static constexpr const std::pair<std::string_view, Marker> line_markers[] = {
+                { ";_EXTRUDE_END",                  mkExtrudeEnd },
+                { ";_BRIDGE_FAN_START",             mkBridgeFanStart },
+                { ";_BRIDGE_FAN_END",               mkBridgeFanEnd },
+                { ";_BRIDGE_INTERNAL_FAN_START",    mkBridgeInternalFanStart },
+                { ";_BRIDGE_INTERNAL_FAN_END",      mkBridgeInternalFanEnd },
+                { ";_TOP_FAN_START",                mkTopFanStart },
+                { ";_TOP_FAN_END",                  mkTopFanEnd },
+                { ";_SUPP_INTER_FAN_START",         mkSuppInterFanStart },
+                { ";_SUPP_INTER_FAN_END",           mkSuppInterFanEnd },
+                { ";_STORE_FAN_SPEED_WT",           mkStoreFanSpeedWT },
+                { ";_RESTORE_FAN_SPEED_WT",         mkRestoreFanSpeedWT },
+            };
+            if (begin[1] == '_') {
+                for (const auto &[prefix, marker] : line_markers)
+                    if (starts_with(begin, end, prefix)) {
+                        line.markers |= marker;
+                        break;
+                    }
+            } else if (starts_with(begin, end, ";TYPE:")) {
+                const char *role_end = end;
+                if (role_end > begin && role_end[-1] == '\r')
+                    -- role_end;
+                line.markers |= mkRole;
+                line.role     = ExtrusionEntity::string_to_role(std::string_view(begin + 6, role_end - begin - 6));
+            } else if (starts_with(begin, end, "; custom gcode"))
+                line.markers |= starts_with(begin, end, "; custom gcode end") ? mkCustomEnd : mkCustomStart;
+        }
+        // Markers appended to the G-code lines.
+        for (const char *m = comment; m != nullptr; m = static_cast<const char*>(memchr(m + 1, ';', end - m - 1))) {
+            if (m[1] != '_')
+                continue;
+            if (starts_with(m, end, ";_EXTRUDE_SET_SPEED"))
+                line.markers |= mkExtrudeSetSpeed;
+            else if (starts_with(m, end, ";_EXTERNAL_PERIMETER"))
+                line.markers |= mkExternalPerimeter;
+            else if (starts_with(m, end, ";_WIPE"))
+                line.markers |= mkWipe;
+        }
+    }
+    return line;
+}
+
+std::string_view MoveBuffer::command(const Line &line) const
+{
+    const char *begin = m_text.data() + line.begin;
+    const char *end   = m_text.data() + line.end;
+    for (; begin != end && is_whitespace(*begin); ++ begin);
+    const char *c = begin;
+    for (; c != end && ! is_end_of_word(*c); ++ c);
+    return std::string_view(begin, c - begin);
+}
+
+std::string_view MoveBuffer::value_text(const Line &line, Axis axis) const
+{
+    if (! line.has(axis))
+        return std::string_view();
+    const char *begin = m_text.data() + line.begin + line.value_pos[axis];
+    const char *c     = begin;
+    for (; ! is_end_of_word(*c); ++ c);
+    return std::string_view(begin, c - begin);
+}
+
+void MoveBuffer::set_value(std::string &line, char axis, bool has_axis, float value, int decimal_digits)
+{
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(decimal_digits) << value;
+    const char match[3] = { ' ', axis, 0 };
+    if (has_axis) {
+        size_t pos = line.find(match) + 2;
+        size_t end = line.find(' ', pos + 1);
+        line.replace(pos, end - pos, ss.str());
+    } else {
+        size_t pos = line.find(' ');
+        if (pos == std::string::npos)
+            line += std::string(match) + ss.str();
+        else
+            line.replace(pos, 0, std::string(match) + ss.str());
+    }
+}
+
+} // namespace Slic3r
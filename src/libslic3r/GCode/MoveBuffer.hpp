@@ -0,0 +1,166 @@
+#ifndef slic3r_GCode_MoveBuffer_hpp_
+#define slic3r_GCode_MoveBuffer_hpp_
+
+#include "../libslic3r.h"
+#include "../ExtrusionEntity.hpp"
+#include "../PrintConfig.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Slic3r {
+
+// A block of G-code (usually a layer) split into lines and tokenized once, to be passed between the filters of the
+// GCode::process_layers() pipeline (vase mode, cooling buffer, fan mover, arc fitter) without each of them parsing the text again.
+// The text is kept as it was generated: the filters build their output by copying the lines they don't modify (without
+// parsing them) and by appending the text of the lines they modify or insert (only these are tokenized).
+// The text of a MoveBuffer is always its lines, each one followed by a '\n', so that it's the serialized G-code
+// once the last filter is done (see release_text()).
+class MoveBuffer
+{
+public:
+    // What the tokenizer has to know about the G-code flavor.
+    struct Syntax {
+        Syntax() = default;
+        Syntax(const GCodeConfig &config, const std::string &toolchange_prefix);
+        // 0 for gcfNoExtrusion.
+        char        extrusion_axis { 'E' };
+        // Start of the lines selecting an extruder, see GCodeWriter::toolchange_prefix().
+        std::string toolchange_prefix { "T" };
+    };
+
+    // Comments written by GCode for the CoolingBuffer and the FanMover.
+    enum Marker : uint32_t {
+        // Anywhere in a comment of a G-code line.
+        mkExtrudeSetSpeed           = 1 << 0,
+        mkExternalPerimeter         = 1 << 1,
+        mkWipe                      = 1 << 2,
+        // At the start of a comment line.
+        mkExtrudeEnd                = 1 << 3,
+        mkBridgeFanStart            = 1 << 4,
+        mkBridgeFanEnd              = 1 << 5,
+        mkBridgeInternalFanStart    = 1 << 6,
+        mkBridgeInternalFanEnd      = 1 << 7,
+        mkTopFanStart               = 1 << 8,
+        mkTopFanEnd                 = 1 << 9,
+        mkSuppInterFanStart         = 1 << 10,
+        mkSuppInterFanEnd           = 1 << 11,
+        mkStoreFanSpeedWT           = 1 << 12,
+        mkRestoreFanSpeedWT         = 1 << 13,
+        // ";TYPE:", the role is in Line::role.
+        mkRole                      = 1 << 14,
+        // "; custom gcode" and "; custom gcode end" around the custom G-codes.
+        mkCustomStart               = 1 << 15,
+        mkCustomEnd                 = 1 << 16,
+    };
+
+    struct Line {
+        // Range of the line in text(), without its '\n'.
+        uint32_t        begin;
+        uint32_t        end;
+        // Offset of the ';' of the comment from begin, end - begin if there is none.
+        uint32_t        comment;
+        // Values of X, Y, Z, E and F (in mm/min) written in the line, see axes.
+        double          values[NUM_AXES];
+        // Offsets of the values in the line from begin, to write them back without rounding.
+        uint16_t        value_pos[NUM_AXES];
+        // Bits of Marker.
+        uint32_t        markers;
+        // Number of a G or M command, tool of a tool change (see Syntax::toolchange_prefix), -1 if it can't be read.
+        int16_t         code;
+        // Extruder active after this line: the one of the last tool change that could be read, up to this line included,
+        // or the extruder active at the start of the buffer. The filters read it instead of parsing the tool changes.
+        uint16_t        extruder;
+        // 'G', 'M', 'T' for a tool change, 0 for a comment, an empty line or another command.
+        char            letter;
+        // 1 << Axis for the axes in values, 1 << UNKNOWN_AXIS if there are other words or values that can't be read.
+        uint8_t         axes;
+        // Role set by a ";TYPE:" line.
+        ExtrusionRole   role;
+
+        bool    has(Axis axis) const { return (axes & (1 << int(axis))) != 0; }
+        double  value(Axis axis) const { return values[axis]; }
+        bool    is_G(int g) const { return letter == 'G' && code == g; }
+        bool    is_M(int m) const { return letter == 'M' && code == m; }
+        // G0 or G1.
+        bool    is_linear_move() const { return letter == 'G' && (code == 0 || code == 1); }
+        bool    has_marker(Marker marker) const { return (markers & marker) != 0; }
+    };
+
+    // Axes positions after the lines given to update(), following the same rules as the GCodeReader.
+    struct Position {
+        float   axes[NUM_AXES] { 0.f, 0.f, 0.f, 0.f, 0.f };
+
+        float   operator[](Axis axis) const { return axes[axis]; }
+        float&  operator[](Axis axis) { return axes[axis]; }
+        // To be called before the line is processed: with relative extruder distances, E is zero before each extrusion.
+        void    start(const Line &line, bool relative_e) { if (relative_e && line.has(E)) axes[E] = 0.f; }
+        // To be called after the line is processed.
+        void    update(const Line &line) {
+            if (line.is_linear_move() || line.is_G(92))
+                for (size_t i = 0; i < NUM_AXES; ++ i)
+                    if (line.has(Axis(i)))
+                        axes[i] = float(line.values[i]);
+        }
+        // Distance from the current position to the value of the line, zero if the line doesn't set this axis.
+        float   dist(const Line &line, Axis axis) const { return line.has(axis) ? float(line.value(axis)) - axes[axis] : 0.f; }
+    };
+
+    MoveBuffer() = default;
+    // Empty buffer, the extruder is the one active before the lines that will be appended.
+    explicit MoveBuffer(const Syntax &syntax, uint16_t extruder = 0) : m_syntax(syntax), m_start_extruder(extruder), m_extruder(extruder) {}
+    // Take the text of the G-code and tokenize it, a missing '\n' is added to its last line.
+    // The extruder is the one active before the G-code, as GCode knows it when generating the layer.
+    MoveBuffer(std::string &&gcode, const Syntax &syntax, uint16_t extruder = 0);
+
+    const Syntax&               syntax() const { return m_syntax; }
+    const std::vector<Line>&    lines()  const { return m_lines; }
+    const std::string&          text()   const { return m_text; }
+    bool                        empty()  const { return m_lines.empty(); }
+    size_t                      size()   const { return m_lines.size(); }
+    // Extruder active before the first line.
+    uint16_t                    start_extruder() const { return m_start_extruder; }
+    // Extruder active after the last line.
+    uint16_t                    extruder() const { return m_extruder; }
+    // The lines appended after a clear() start with the extruder active after the lines removed.
+    void                        clear() { m_lines.clear(); m_text.clear(); m_start_extruder = m_extruder; }
+    // Get the G-code text and clear this buffer.
+    std::string                 release_text() { m_lines.clear(); m_start_extruder = m_extruder; return std::move(m_text); }
+
+    // Text of a line without its '\n'.
+    std::string_view            text(const Line &line) const { return std::string_view(m_text.data() + line.begin, line.end - line.begin); }
+    // Comment of a line, with its ';'.
+    std::string_view            comment(const Line &line) const { return this->text(line).substr(line.comment); }
+    // First word of a line.
+    std::string_view            command(const Line &line) const;
+    // Text of the value of an axis of the line, as written.
+    std::string_view            value_text(const Line &line, Axis axis) const;
+
+    // Append a line of another buffer, without parsing it again.
+    void                        append(const MoveBuffer &src, const Line &line) { this->append(src, &line - src.m_lines.data(), &line - src.m_lines.data() + 1); }
+    // Append the lines [first, last) of another buffer, without parsing them again.
+    void                        append(const MoveBuffer &src, size_t first, size_t last);
+    // Move the lines of another buffer at the end of this one, an empty buffer takes the syntax of src.
+    void                        append(MoveBuffer &&src);
+    // Append some G-code text and tokenize it, a missing '\n' is added to its last line.
+    void                        append_gcode(std::string_view gcode);
+
+    // Replace the value of an axis in the text of a line, or add it after the command if it's not there.
+    // Same formatting as GCodeReader::GCodeLine::set().
+    static void                 set_value(std::string &line, char axis, bool has_axis, float value, int decimal_digits = 3);
+
+private:
+    void                        tokenize(size_t text_start);
+    Line                        parse_line(const char *begin, const char *end, uint16_t extruder) const;
+
+    Syntax                      m_syntax;
+    uint16_t                    m_start_extruder { 0 };
+    uint16_t                    m_extruder       { 0 };
+    std::vector<Line>           m_lines;
+    std::string                 m_text;
+};
+
+} // namespace Slic3r
+
+#endif /* slic3r_GCode_MoveBuffer_hpp_ */
@@ -6,6 +6,7 @@
 #include "../BoundingBox.hpp"
 #include "../ExtrusionEntity.hpp"
 #include "../ExtrusionEntityCollection.hpp"
+#include "../ExtrusionEntityPacked.hpp"
 #include "../Layer.hpp"
 #include "../Print.hpp"
 
@@ -14,20 +15,25 @@
 
 namespace Slic3r {
 
-static inline BoundingBox extrusion_polyline_extents(const Polyline &polyline, const coord_t radius)
+static inline BoundingBox extrusion_polyline_extents(const Point *begin, const Point *end, const coord_t radius)
 {
     BoundingBox bbox;
-    if (! polyline.points.empty())
-        bbox.merge(polyline.points.front());
-    for (const Point &pt : polyline.points) {
-        bbox.min(0) = std::min(bbox.min(0), pt(0) - radius);
-        bbox.min(1) = std::min(bbox.min(1), pt(1) - radius);
-        bbox.max(0) = std::max(bbox.max(0), pt(0) + radius);
-        bbox.max(1) = std::max(bbox.max(1), pt(1) + radius);
+    if (begin != end)
+        bbox.merge(*begin);
+    for (const Point *pt = begin; pt != end; ++ pt) {
+        bbox.min(0) = std::min(bbox.min(0), (*pt)(0) - radius);
+        bbox.min(1) = std::min(bbox.min(1), (*pt)(1) - radius);
+        bbox.max(0) = std::max(bbox.max(0), (*pt)(0) + radius);
+        bbox.max(1) = std::max(bbox.max(1), (*pt)(1) + radius);
     }
     return bbox;
 }
 
+static inline BoundingBox extrusion_polyline_extents(const Polyline &polyline, const coord_t radius)
+{
+    return extrusion_polyline_extents(polyline.points.data(), polyline.points.data() + polyline.points.size(), radius);
+}
+
 static inline BoundingBoxf extrusionentity_extents(const ExtrusionPath &extrusion_path)
 {
     BoundingBox bbox = extrusion_polyline_extents(extrusion_path.polyline, coord_t(scale_(0.5 * extrusion_path.width)));
@@ -98,6 +104,22 @@ static BoundingBoxf extrusionentity_extents(const ExtrusionEntity *extrusion_ent
     return BoundingBoxf();
 }
 
+// Extents of the extrusions of a spilled layer, read from the packed buffers without creating the entities.
+static BoundingBoxf extrusionentity_extents(const PackedExtrusionEntities &packed)
+{
+    BoundingBox bbox;
+    packed.for_each_path([&bbox](const PackedExtrusionEntities::Path &path, const Point *begin, const Point *end) {
+        bbox.merge(extrusion_polyline_extents(begin, end, coord_t(scale_(0.5 * path.width))));
+    });
+    BoundingBoxf bboxf;
+    if (! empty(bbox)) {
+        bboxf.min = unscale(bbox.min);
+        bboxf.max = unscale(bbox.max);
+        bboxf.defined = true;
+    }
+    return bboxf;
+}
+
 BoundingBoxf get_print_extrusions_extents(const Print &print)
 {
     BoundingBoxf bbox(extrusionentity_extents(print.brim()));
@@ -111,8 +133,14 @@ BoundingBoxf get_print_object_extrusions_extents(const PrintObject &print_object
     for (const Layer *layer : print_object.layers()) {
         if (layer->print_z > max_print_z)
             break;
+        LayerSpill::PackedLoader loader(layer);
         BoundingBoxf bbox_this;
         for (const LayerRegion *layerm : layer->regions()) {
+            if (loader.packed()) {
+                bbox_this.merge(extrusionentity_extents(layerm->packed_perimeters()));
+                bbox_this.merge(extrusionentity_extents(layerm->packed_fills()));
+                continue;
+            }
             bbox_this.merge(extrusionentity_extents(layerm->perimeters));
             for (const ExtrusionEntity *ee : layerm->fills.entities())
                 // fill represents infill extrusions of a single island.
@@ -9,6 +9,11 @@
 #include "libslic3r/SVG.hpp"
 #include "libslic3r/Layer.hpp"
 
+#include <boost/functional/hash.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
 // This penalty is added to all points inside custom blockers (subtracted from pts inside enforcers).
@@ -140,6 +145,16 @@ static Points::const_iterator project_point_to_polygon_and_insert(Polygon &polyg
 
 
 
+// Angle at p1 between the segments p0-p1 and p1-p2, positive if turning left.
+static float vertex_angle(const Point &p0, const Point &p1, const Point &p2)
+{
+    const Point  v1 = p1 - p0;
+    const Point  v2 = p2 - p1;
+    int64_t dot   = int64_t(v1(0))*int64_t(v2(0)) + int64_t(v1(1))*int64_t(v2(1));
+    int64_t cross = int64_t(v1(0))*int64_t(v2(1)) - int64_t(v1(1))*int64_t(v2(0));
+    return float(atan2(double(cross), double(dot)));
+}
+
 static std::vector<float> polygon_angles_at_vertices(const Polygon &polygon, const std::vector<float> &lengths, float min_arm_length)
 {
     assert(polygon.points.size() + 1 == lengths.size());
@@ -181,28 +196,47 @@ static std::vector<float> polygon_angles_at_vertices(const Polygon &polygon, con
         while (idx_next < idx_curr && lengths.back() - lengths[idx_curr] + lengths[idx_next] < min_arm_length)
             ++ idx_next;
         // Calculate angle between idx_prev, idx_curr, idx_next.
-        const Point &p0 = polygon.points[idx_prev];
-        const Point &p1 = polygon.points[idx_curr];
-        const Point &p2 = polygon.points[idx_next];
-        const Point  v1 = p1 - p0;
-        const Point  v2 = p2 - p1;
-        int64_t dot   = int64_t(v1(0))*int64_t(v2(0)) + int64_t(v1(1))*int64_t(v2(1));
-        int64_t cross = int64_t(v1(0))*int64_t(v2(1)) - int64_t(v1(1))*int64_t(v2(0));
-        float angle = float(atan2(double(cross), double(dot)));
-        angles[idx_curr] = angle;
+        angles[idx_curr] = vertex_angle(polygon.points[idx_prev], polygon.points[idx_curr], polygon.points[idx_next]);
     }
 
     return angles;
 }
 
+// Signed distance of a point of a perimeter to the lower layer, positive outside of it.
+static float overhang_distance(const EdgeGrid::Grid &lower_layer_edge_grid, const Point &pt, coordf_t nozzle_dmr)
+{
+    coord_t search_r = coord_t(std::floor(scale_(0.8 * nozzle_dmr) + 0.5));
+    coordf_t dist;
+    [[maybe_unused]] bool found = lower_layer_edge_grid.signed_distance(pt, search_r, dist);
+    // If the approximate Signed Distance Field was initialized over lower_layer_edge_grid,
+    // then the signed distnace shall always be known.
+    assert(found);
+    return float(dist);
+}
+
+static uint64_t polygon_hash(const Polygon &polygon)
+{
+    size_t seed = polygon.points.size();
+    for (const Point &pt : polygon.points) {
+        boost::hash_combine(seed, pt.x());
+        boost::hash_combine(seed, pt.y());
+    }
+    return uint64_t(seed);
+}
 
 
-void SeamPlacer::init(const Print& print)
+
+void SeamPlacer::init(const Print& print, const PrintObject* object)
 {
+    m_seam_history.clear();
+    if (object != nullptr && m_po_list.size() == 1 && m_po_list.front() == object)
+        // Another instance of the same object, its custom seams and candidates are still valid.
+        return;
+
     m_enforcers.clear();
     m_blockers.clear();
-    m_seam_history.clear();
     m_po_list.clear();
+    m_candidates.clear();
 
    const std::vector<double>& nozzle_dmrs = print.config().nozzle_diameter.values;
    float max_nozzle_dmr = *std::max_element(nozzle_dmrs.begin(), nozzle_dmrs.end());
@@ -213,6 +247,8 @@ void SeamPlacer::init(const Print& print)
     std::vector<Polygons>   temp_polygons;
 
     for (const PrintObject* po : print.objects()) {
+        if (object != nullptr && po != object)
+            continue;
 
         auto merge_and_offset = [po, &temp_polygons, max_nozzle_dmr](EnforcerBlockerType type, std::vector<ExPolygons>& out) {
             // Offset the triangles out slightly.
@@ -303,6 +339,80 @@ void SeamPlacer::init(const Print& print)
 
 
 
+void SeamPlacer::precompute_candidates(const Print& print)
+{
+    if (! m_candidates.empty())
+        return;
+    m_candidates.assign(m_po_list.size(), {});
+    for (size_t po_idx = 0; po_idx < m_po_list.size(); ++ po_idx) {
+        const PrintObject *po = m_po_list[po_idx];
+        m_candidates[po_idx].resize(po->layer_count());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, po->layer_count()),
+            [this, &print, po, po_idx](const tbb::blocked_range<size_t> &range) {
+            std::vector<const ExtrusionLoop*> loops;
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                print.throw_if_canceled();
+                const Layer          *layer = po->get_layer(int(layer_idx));
+                LayerSpill::Loader    loader(layer);
+                const EdgeGrid::Grid *lower_layer_edge_grid = layer->lower_layer ? layer->lower_layer->lslices_grid() : nullptr;
+                const bool            custom_seam_on_layer  = this->is_custom_seam_on_layer(layer_idx, po_idx);
+                std::unordered_map<uint64_t, LoopCandidates> &layer_candidates = m_candidates[po_idx][layer_idx];
+                for (const LayerRegion *layerm : layer->regions()) {
+                    // The perimeters are printed with the perimeter extruder, unless overriden.
+                    const coordf_t nozzle_dmr = print.config().nozzle_diameter.get_at(std::max(1, layerm->region().config().perimeter_extruder.value) - 1);
+                    const coord_t  nozzle_r   = coord_t(scale_(0.5 * nozzle_dmr) + 0.5);
+                    loops.clear();
+                    std::function<void(const ExtrusionEntityCollection&)> collect_loops = [&loops, &collect_loops](const ExtrusionEntityCollection &collection) {
+                        for (const ExtrusionEntity *ee : collection.entities())
+                            if (const ExtrusionEntityCollection *coll = dynamic_cast<const ExtrusionEntityCollection*>(ee))
+                                collect_loops(*coll);
+                            else if (const ExtrusionLoop *loop = dynamic_cast<const ExtrusionLoop*>(ee))
+                                loops.push_back(loop);
+                    };
+                    collect_loops(layerm->perimeters);
+                    for (const ExtrusionLoop *loop : loops) {
+                        // Same polygon as in calculate_seam().
+                        Polygon polygon = loop->polygon();
+                        polygon.make_counter_clockwise();
+                        if (loop->role() == erExternalPerimeter && custom_seam_on_layer)
+                            polygon.densify(MINIMAL_POLYGON_SIDE);
+                        if (polygon.size() < 2)
+                            continue;
+                        LoopCandidates candidates;
+                        candidates.points                = polygon.points;
+                        candidates.nozzle_dmr            = nozzle_dmr;
+                        candidates.lower_layer_edge_grid = lower_layer_edge_grid;
+                        candidates.angles = polygon_angles_at_vertices(polygon, polygon.parameter_by_length(),
+                            custom_seam_on_layer ? std::min(MINIMAL_POLYGON_SIDE / 2.f, float(nozzle_r)) : float(nozzle_r));
+                        if (lower_layer_edge_grid) {
+                            candidates.overhangs.reserve(polygon.size());
+                            for (const Point &pt : polygon.points)
+                                candidates.overhangs.push_back(overhang_distance(*lower_layer_edge_grid, pt, nozzle_dmr));
+                        }
+                        // On a hash collision between two loops of this layer, the second one is computed by calculate_seam().
+                        layer_candidates.emplace(polygon_hash(polygon), std::move(candidates));
+                    }
+                }
+            }
+        });
+    }
+}
+
+
+
+const SeamPlacer::LoopCandidates* SeamPlacer::find_candidates(size_t po_idx, size_t layer_idx, const Polygon& polygon, coordf_t nozzle_dmr) const
+{
+    if (po_idx >= m_candidates.size() || layer_idx >= m_candidates[po_idx].size())
+        return nullptr;
+    const std::unordered_map<uint64_t, LoopCandidates> &layer_candidates = m_candidates[po_idx][layer_idx];
+    auto it = layer_candidates.find(polygon_hash(polygon));
+    if (it == layer_candidates.end() || it->second.nozzle_dmr != nozzle_dmr || it->second.points != polygon.points)
+        return nullptr;
+    return &it->second;
+}
+
+
+
 void SeamPlacer::plan_perimeters(const std::vector<const ExtrusionEntity*> perimeters,
                             const Layer& layer, SeamPosition seam_position,
                             Point last_pos, coordf_t nozzle_dmr, const PrintObject* po,
@@ -633,11 +743,19 @@ Point SeamPlacer::calculate_seam(const Layer& layer, SeamPosition seam_position,
 
 
 
+        // Angles and overhangs of the polygon, if they were precomputed.
+        const LoopCandidates *candidates = this->find_candidates(po_idx, layer_idx, polygon, nozzle_dmr);
+
         // Insert a projection of last_pos into the polygon.
         size_t last_pos_proj_idx;
+        // Index of the projection if it's a new point, not in the candidates.
+        size_t inserted_idx = size_t(-1);
         {
+            const size_t num_points = polygon.points.size();
             Points::const_iterator it = project_point_to_polygon_and_insert(polygon, last_pos, 0.1 * nozzle_r );
             last_pos_proj_idx = it - polygon.points.begin();
+            if (polygon.points.size() > num_points)
+                inserted_idx = last_pos_proj_idx;
         }
         Point last_pos_proj = polygon.points[last_pos_proj_idx];
 
@@ -656,8 +774,12 @@ Point SeamPlacer::calculate_seam(const Layer& layer, SeamPosition seam_position,
 
         // For each polygon point, store a penalty.
         // First calculate the angles, store them as penalties. The angles are caluculated over a minimum arm length of nozzle_r.
-        std::vector<float> penalties = polygon_angles_at_vertices(polygon, lengths,
-            this->is_custom_seam_on_layer(layer_idx, po_idx) ? std::min(MINIMAL_POLYGON_SIDE / 2.f, float(nozzle_r)) : float(nozzle_r));
+        // The arms of the vertices next to the projection of last_pos may end on it: the precomputed angles are only the ones
+        // of this polygon if the projection is one of the vertices of the loop.
+        std::vector<float> penalties = candidates != nullptr && inserted_idx == size_t(-1) ?
+            candidates->angles :
+            polygon_angles_at_vertices(polygon, lengths,
+                this->is_custom_seam_on_layer(layer_idx, po_idx) ? std::min(MINIMAL_POLYGON_SIDE / 2.f, float(nozzle_r)) : float(nozzle_r));
         // No penalty for reflex points, slight penalty for convex points, high penalty for flat surfaces.
         const float penaltyConvexVertex = 1.f;
         const float penaltyFlatSurface = 3.f;
@@ -708,18 +830,15 @@ Point SeamPlacer::calculate_seam(const Layer& layer, SeamPosition seam_position,
         if (lower_layer_edge_grid) {
             // Use the edge grid distance field structure over the lower layer to calculate overhangs.
             coord_t nozzle_r = coord_t(std::floor(scale_(0.5 * nozzle_dmr) + 0.5));
-            coord_t search_r = coord_t(std::floor(scale_(0.8 * nozzle_dmr) + 0.5));
+            const bool precomputed = candidates != nullptr && candidates->lower_layer_edge_grid == lower_layer_edge_grid;
             for (size_t i = 0; i < polygon.points.size(); ++ i) {
-                const Point &p = polygon.points[i];
-                coordf_t dist;
                 // Signed distance is positive outside the object, negative inside the object.
                 // The point is considered at an overhang, if it is more than nozzle radius
                 // outside of the lower layer contour.
-                [[maybe_unused]] bool found = lower_layer_edge_grid->signed_distance(p, search_r, dist);
-                // If the approximate Signed Distance Field was initialized over lower_layer_edge_grid,
-                // then the signed distnace shall always be known.
-                assert(found);
-                penalties[i] += extrudate_overlap_penalty(float(nozzle_r), penaltyOverhangHalf, float(dist));
+                float dist = ! precomputed || i == inserted_idx ?
+                    overhang_distance(*lower_layer_edge_grid, polygon.points[i], nozzle_dmr) :
+                    candidates->overhangs[i < inserted_idx ? i : i - 1];
+                penalties[i] += extrudate_overlap_penalty(float(nozzle_r), penaltyOverhangHalf, dist);
             }
         }
         
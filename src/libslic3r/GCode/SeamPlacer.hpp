@@ -2,6 +2,7 @@
 #define libslic3r_SeamPlacer_hpp_
 
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 #include "libslic3r/ExtrusionEntity.hpp"
@@ -41,7 +42,12 @@ private:
 
 class SeamPlacer {
 public:
-    void init(const Print& print);
+    // Collect the custom seams of all the objects, or only of object (sequential printing, called before printing each
+    // of its instances: the seam history is reset, the rest is kept).
+    void init(const Print& print, const PrintObject* object = nullptr);
+    // Precompute the seam candidates of the objects passed to init(), in parallel. Optional, the seams are the same without,
+    // but then calculate_seam() computes them in the serial G-code generation. Does nothing if they are already computed.
+    void precompute_candidates(const Print& print);
 
     // When perimeters are printed, first call this function with the respective
     // external perimeter. SeamPlacer will find a location for its seam and remember it.
@@ -74,6 +80,26 @@ private:
         TreeType tree;
     };
 
+    // The part of calculate_seam() which doesn't depend on the nozzle position nor on the seams already placed,
+    // computed by precompute_candidates() for the perimeters of all the layers in parallel. The serial G-code generation then only picks the seam.
+    struct LoopCandidates {
+        // Counter clockwise polygon of the loop (densified if there are custom seams on its layer), to check a hit of its hash.
+        Points                points;
+        // Nozzle diameter and distance field of the lower layer they were computed with.
+        coordf_t              nozzle_dmr;
+        const EdgeGrid::Grid* lower_layer_edge_grid;
+        // Angle at each point of the polygon, used if the projection of the last position is one of its points. Otherwise the angles
+        // are calculated again with the projection inserted, as the arms of its neighbours may end on it.
+        std::vector<float>    angles;
+        // Signed distance of each point to the lower layer, empty if there is no lower layer.
+        std::vector<float>    overhangs;
+    };
+    // Per PrintObject and per layer, the candidates of its perimeter loops, by the hash of their polygon.
+    std::vector<std::vector<std::unordered_map<uint64_t, LoopCandidates>>> m_candidates;
+
+    // nullptr if this polygon wasn't precomputed with this nozzle diameter.
+    const LoopCandidates* find_candidates(size_t po_idx, size_t layer_idx, const Polygon& polygon, coordf_t nozzle_dmr) const;
+
     // Just a cache to save some lookups.
     const Layer* m_last_layer_po = nullptr;
     coordf_t m_last_print_z = -1.;
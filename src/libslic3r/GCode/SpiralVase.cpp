@@ -1,10 +1,10 @@
 #include "SpiralVase.hpp"
 #include "GCode.hpp"
-#include <sstream>
+#include <cmath>
 
 namespace Slic3r {
 
-std::string SpiralVase::process_layer(const std::string &gcode)
+MoveBuffer SpiralVase::process_layer(MoveBuffer &&gcode)
 {
     /*  This post-processor relies on several assumptions:
         - all layers are processed through it, including those that are not supposed
@@ -14,11 +14,15 @@ std::string SpiralVase::process_layer(const std::string &gcode)
         - each layer is composed by suitable geometry (i.e. a single complete loop)
         - loops were not clipped before calling this method  */
     
-    // If we're not going to modify G-code, just feed it to the reader
+    const bool relative_e = m_config.use_relative_e_distances.value;
+    // If we're not going to modify G-code, just go through it
     // in order to update positions.
     if (! m_enabled) {
-        m_reader.parse_buffer(gcode);
-        return gcode;
+        for (const MoveBuffer::Line &line : gcode.lines()) {
+            m_position.start(line, relative_e);
+            m_position.update(line);
+        }
+        return std::move(gcode);
     }
     
     // Get total XY length for this layer by summing all extrusion moves.
@@ -27,76 +31,83 @@ std::string SpiralVase::process_layer(const std::string &gcode)
     float z = 0.f;
     
     {
-        //FIXME Performance warning: This copies the GCodeConfig of the reader.
-        GCodeReader r = m_reader;  // clone
+        MoveBuffer::Position position = m_position;
         bool set_z = false;
-        r.parse_buffer(gcode, [&total_layer_length, &layer_height, &z, &set_z]
-            (GCodeReader &reader, const GCodeReader::GCodeLine &line) {
-            if (line.cmd_is("G1")) {
-                if (line.extruding(reader)) {
-                    total_layer_length += line.dist_XY(reader);
+        for (const MoveBuffer::Line &line : gcode.lines()) {
+            position.start(line, relative_e);
+            if (line.is_G(1)) {
+                if (position.dist(line, E) > 0) {
+                    float dist_x = position.dist(line, X);
+                    float dist_y = position.dist(line, Y);
+                    total_layer_length += sqrt(dist_x * dist_x + dist_y * dist_y);
                 } else if (line.has(Z)) {
-                    layer_height += line.dist_Z(reader);
+                    layer_height += position.dist(line, Z);
                     if (!set_z) {
-                        z = line.new_Z(reader);
+                        z = float(line.value(Z));
                         set_z = true;
                     }
                 }
             }
-        });
+            position.update(line);
+        }
     }
     
-    // Remove layer height from initial Z.
+    // Remove layer height from initial Z.
     z -= layer_height;
     
-    std::string new_gcode;
+    MoveBuffer new_gcode(gcode.syntax(), gcode.start_extruder());
     //FIXME Tapering of the transition layer only works reliably with relative extruder distances.
     // For absolute extruder distances it will be switched off.
     // Tapering the absolute extruder distances requires to process every extrusion value after the first transition
     // layer.
-    bool  transition = m_transition_layer && m_config.use_relative_e_distances.value;
+    bool  transition = m_transition_layer && relative_e;
     if (transition)
-        new_gcode += "; Began spiral\n";
+        new_gcode.append_gcode("; Began spiral\n");
     bool  keep_first_travel = m_transition_layer;
     float layer_height_factor = layer_height / total_layer_length;
     float len = 0.f;
-    m_reader.parse_buffer(gcode, [&keep_first_travel , &new_gcode, &z, total_layer_length, layer_height_factor, transition, &len]
-        (GCodeReader &reader, GCodeReader::GCodeLine line) {
-        if (line.cmd_is("G1")) {
-            if (line.has_z()) {
+    std::string raw;
+    for (const MoveBuffer::Line &line : gcode.lines()) {
+        m_position.start(line, relative_e);
+        if (line.is_G(1)) {
+            if (line.has(Z)) {
                 // If this is the initial Z move of the layer, replace it with a
                 // (redundant) move to the last Z of previous layer.
-                line.set(reader, Z, z);
-                new_gcode += line.raw() + '\n';
-                return;
+                raw = gcode.text(line);
+                MoveBuffer::set_value(raw, 'Z', true, z);
+                new_gcode.append_gcode(raw);
             } else {
-                float dist_XY = line.dist_XY(reader);
+                float dist_x  = m_position.dist(line, X);
+                float dist_y  = m_position.dist(line, Y);
+                float dist_XY = sqrt(dist_x * dist_x + dist_y * dist_y);
                 if (dist_XY > 0) {
                     // horizontal move
-                    if (line.extruding(reader)) {
+                    if (m_position.dist(line, E) > 0) {
                         keep_first_travel = false;
                         len += dist_XY;
-                        line.set(reader, Z, z + len * layer_height_factor);
+                        raw = gcode.text(line);
+                        MoveBuffer::set_value(raw, 'Z', false, z + len * layer_height_factor);
                         if (transition && line.has(E))
                             // Transition layer, modulate the amount of extrusion from zero to the final value.
-                            line.set(reader, E, line.value(E) * len / total_layer_length);
-                        new_gcode += line.raw() + '\n';
+                            MoveBuffer::set_value(raw, gcode.syntax().extrusion_axis, true, float(line.value(E)) * len / total_layer_length);
+                        new_gcode.append_gcode(raw);
                     } else if (keep_first_travel) {
                         //we can travel until the first spiral extrusion
-                        new_gcode += line.raw() + '\n';
+                        new_gcode.append(gcode, line);
                     }
-                    return;
                 
                     /*  Skip travel moves: the move to first perimeter point will
                         cause a visible seam when loops are not aligned in XY; by skipping
                         it we blend the first loop move in the XY plane (although the smoothness
                         of such blend depend on how long the first segment is; maybe we should
                         enforce some minimum length?).  */
-                }
+                } else
+                    new_gcode.append(gcode, line);
             }
-        }
-        new_gcode += line.raw() + '\n';
-    });
+        } else
+            new_gcode.append(gcode, line);
+        m_position.update(line);
+    }
     
     return new_gcode;
 }
@@ -2,7 +2,7 @@
 #define slic3r_SpiralVase_hpp_
 
 #include "../libslic3r.h"
-#include "../GCodeReader.hpp"
+#include "MoveBuffer.hpp"
 
 namespace Slic3r {
 
@@ -10,8 +10,7 @@ class SpiralVase {
 public:
     SpiralVase(const PrintConfig &config) : m_config(config)
     {
-        m_reader.z() = (float)m_config.z_offset;
-        m_reader.apply_config(m_config);
+        m_position[Z] = (float)m_config.z_offset;
     };
 
     void 		enable(bool en) {
@@ -19,13 +18,14 @@ public:
     	m_enabled 		   = en;
     }
 
-    std::string process_layer(const std::string& gcode);
+    MoveBuffer process_layer(MoveBuffer &&gcode);
 
     bool is_transition_layer() { return m_transition_layer; }
     
 private:
     const PrintConfig  &m_config;
-    GCodeReader 		m_reader;
+    // Position at the end of the last layer processed.
+    MoveBuffer::Position m_position;
 
     bool 				m_enabled = false;
     // First spiral vase layer. Layer height has to be ramped up from zero to the target layer height.
@@ -193,7 +193,11 @@ void ToolOrdering::collect_extruders(const PrintObject &object, const std::vecto
     // Collect the support extruders.
     for (auto support_layer : object.support_layers()) {
         LayerTools   &layer_tools = this->tools_for_layer(support_layer->print_z);
-        ExtrusionRole role = support_layer->support_fills.role();
+        ExtrusionRole role;
+        {
+            LayerSpill::PackedLoader loader(support_layer);
+            role = loader.packed() ? support_layer->packed_support_fills().role() : support_layer->support_fills.role();
+        }
         bool         has_support        = role == erMixed || role == erSupportMaterial;
         bool         has_interface      = role == erMixed || role == erSupportMaterialInterface;
         uint16_t extruder_support   = object.config().support_material_extruder.value;
@@ -213,6 +217,7 @@ void ToolOrdering::collect_extruders(const PrintObject &object, const std::vecto
 
     // Collect the object extruders.
     for (auto layer : object.layers()) {
+        LayerSpill::Loader loader(layer);
         LayerTools &layer_tools = this->tools_for_layer(layer->print_z);
 
         // Override extruder with the next 
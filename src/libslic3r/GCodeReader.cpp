@@ -1,8 +1,12 @@
 #include "GCodeReader.hpp"
+#include "GCode/BinaryGCode.hpp"
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/log/trivial.hpp>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -13,6 +17,23 @@
 #include <Shiny/Shiny.h>
 #include <fast_float/fast_float.h>
 
+#include <atomic>
+#include <memory>
+
+#include <tbb/task_arena.h>
+
+// See GCode.cpp for the TBB 2017 / oneTBB compatibility.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 static inline char get_extrusion_axis_char(const GCodeConfig &config)
@@ -36,6 +57,22 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
 }
 
 const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+{
+    const char *c = this->parse_line_axes(ptr, end, gline, command);
+    this->begin_line(gline);
+    return c;
+}
+
+void GCodeReader::begin_line(const GCodeLine &gline)
+{
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+}
+
+const char* GCodeReader::parse_line_axes(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command) const
 {
     PROFILE_FUNC();
 
@@ -90,9 +127,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
@@ -109,9 +143,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
 	if (*c == '\n')
 		++ c;
 
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
@@ -129,10 +160,69 @@ void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, co
     }
 }
 
+// Memory map a file, so that its lines are parsed in place, without being copied into a read buffer first.
+// Returns false if the file can't be mapped, the mapping isn't opened for an empty file.
+static bool map_file(const std::string &filename, boost::iostreams::mapped_file_source &file)
+{
+    try {
+        const boost::filesystem::path path(filename);
+        if (boost::filesystem::file_size(path) > 0)
+            file.open(path);
+    } catch (const std::exception &) {
+        // Some file systems don't support memory mapping (or the file is too big for a 32 bits address space).
+        return false;
+    }
+    return true;
+}
+
 template<typename ParseLineCallback, typename LineEndCallback>
 bool GCodeReader::parse_file_raw_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
+{
+    if (BinaryGCode::is_binary_gcode_file(filename))
+        return this->parse_file_raw_binary(filename, parse_line_callback);
+
+    boost::iostreams::mapped_file_source file;
+    if (! map_file(filename, file))
+        return this->parse_file_raw_buffered(filename, parse_line_callback, line_end_callback);
+    m_parsing = true;
+    if (! file.is_open())
+        // Empty file.
+        return true;
+
+    const char *begin = file.data();
+    const char *end   = begin + file.size();
+    // The last line, if not ended by a newline, is copied to be null terminated.
+    std::string last_line;
+    for (const char *it = begin; it != end;) {
+        // Find end of line.
+        const char *it_end = it;
+        for (; it_end != end && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+        if (it_end == end) {
+            last_line.assign(it, it_end);
+            parse_line_callback(last_line.c_str(), last_line.c_str() + last_line.size());
+        } else
+            parse_line_callback(it, it_end);
+        if (! m_parsing)
+            // The callback wishes to exit.
+            return true;
+        // Skip EOL.
+        it = it_end;
+        if (it != end && *it == '\r')
+            ++ it;
+        if (it != end && *it == '\n') {
+            ++ it;
+            line_end_callback(size_t(it - begin));
+        }
+    }
+    return true;
+}
+
+template<typename ParseLineCallback, typename LineEndCallback>
+bool GCodeReader::parse_file_raw_buffered(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
 {
     FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
+    if (in.f == nullptr)
+        return false;
 
     // Read the input stream 64kB at a time, extract lines and process them.
     std::vector<char> buffer(65536 * 10, 0);
@@ -185,9 +275,122 @@ bool GCodeReader::parse_file_raw_internal(const std::string &filename, ParseLine
     return true;
 }
 
+template<typename ParseLineCallback>
+bool GCodeReader::parse_file_raw_binary(const std::string &filename, ParseLineCallback parse_line_callback)
+{
+    m_parsing = true;
+    std::string error;
+    // The decoded pieces of G-code always end with a newline.
+    bool ok = BinaryGCode::decode_gcode(filename, [this, &parse_line_callback](const char *begin, const char *end) {
+        for (const char *it = begin; it != end && m_parsing;) {
+            const char *it_end = it;
+            for (; it_end != end && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+            parse_line_callback(it, it_end);
+            // Skip EOL.
+            it = it_end;
+            if (it != end && *it == '\r')
+                ++ it;
+            if (it != end && *it == '\n')
+                ++ it;
+        }
+        // The callback may wish to exit.
+        return m_parsing;
+    }, error);
+    if (! ok)
+        BOOST_LOG_TRIVIAL(error) << "Error while reading the binary G-code " << filename << ": " << error;
+    return ok;
+}
+
+template<typename ParseLineCallback, typename LineEndCallback>
+bool GCodeReader::parse_file_parallel(const char *begin, const char *end, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
+{
+    struct Chunk {
+        // Whole lines of the file.
+        const char                                          *begin { nullptr };
+        const char                                          *end   { nullptr };
+        std::vector<GCodeLine>                               lines;
+        std::vector<std::pair<const char*, const char*>>     commands;
+        // File position after the end of each line, 0 if the line isn't ended by a newline.
+        std::vector<size_t>                                  line_ends;
+        // The last line of the file, copied to be null terminated if it isn't ended by a newline.
+        std::string                                          last_line;
+    };
+    static constexpr const size_t chunk_size = 1 << 20;
+
+    m_parsing = true;
+    // Set once the callback asked to stop, to not cut the next chunks.
+    std::atomic<bool> stop { false };
+    const char       *next = begin;
+    const auto cut = tbb::make_filter<void, std::shared_ptr<Chunk>>(slic3r_tbb_filtermode::serial_in_order,
+        [end, &next, &stop](tbb::flow_control &fc) -> std::shared_ptr<Chunk> {
+            if (next == end || stop) {
+                fc.stop();
+                return {};
+            }
+            auto chunk = std::make_shared<Chunk>();
+            chunk->begin = next;
+            // Cut the chunk after a newline, thus a chunk is made of whole lines.
+            next = size_t(end - next) <= chunk_size ? end : next + chunk_size;
+            for (; next != end && *(next - 1) != '\n'; ++ next) ;
+            chunk->end = next;
+            return chunk;
+        });
+    const auto parse = tbb::make_filter<std::shared_ptr<Chunk>, std::shared_ptr<Chunk>>(slic3r_tbb_filtermode::parallel,
+        [this, begin, end](std::shared_ptr<Chunk> chunk) -> std::shared_ptr<Chunk> {
+            CNumericLocalesSetter locales_setter;
+            for (const char *it = chunk->begin; it != chunk->end;) {
+                // Find end of line.
+                const char *it_end = it;
+                for (; it_end != chunk->end && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+                chunk->lines.emplace_back();
+                chunk->commands.emplace_back();
+                if (it_end == end) {
+                    chunk->last_line.assign(it, it_end);
+                    this->parse_line_axes(chunk->last_line.c_str(), chunk->last_line.c_str() + chunk->last_line.size(), chunk->lines.back(), chunk->commands.back());
+                } else
+                    this->parse_line_axes(it, it_end, chunk->lines.back(), chunk->commands.back());
+                // Skip EOL.
+                it = it_end;
+                if (it != chunk->end && *it == '\r')
+                    ++ it;
+                size_t line_end = 0;
+                if (it != chunk->end && *it == '\n')
+                    line_end = size_t(++ it - begin);
+                chunk->line_ends.emplace_back(line_end);
+            }
+            return chunk;
+        });
+    const auto process = tbb::make_filter<std::shared_ptr<Chunk>, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &stop, &parse_line_callback, &line_end_callback](std::shared_ptr<Chunk> chunk) {
+            if (stop)
+                return;
+            for (size_t i = 0; i < chunk->lines.size(); ++ i) {
+                GCodeLine &gline = chunk->lines[i];
+                this->begin_line(gline);
+                parse_line_callback(*this, gline);
+                this->update_coordinates(gline, chunk->commands[i]);
+                if (! m_parsing) {
+                    // The callback wishes to exit.
+                    stop = true;
+                    return;
+                }
+                if (chunk->line_ends[i] != 0)
+                    line_end_callback(chunk->line_ends[i]);
+            }
+        });
+    tbb::parallel_pipeline(2 * size_t(tbb::this_task_arena::max_concurrency()), cut & parse & process);
+    return true;
+}
+
 template<typename ParseLineCallback, typename LineEndCallback>
 bool GCodeReader::parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
 {
+    if (! BinaryGCode::is_binary_gcode_file(filename)) {
+        boost::iostreams::mapped_file_source file;
+        if (map_file(filename, file) && file.is_open())
+            return this->parse_file_parallel(file.data(), file.data() + file.size(), parse_line_callback, line_end_callback);
+    }
+    // Binary, empty or not mapped G-code.
     GCodeLine gline;    
     return this->parse_file_raw_internal(filename, 
         [this, &gline, parse_line_callback](const char *begin, const char *end) {
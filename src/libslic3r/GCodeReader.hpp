@@ -150,10 +150,25 @@ public:
 private:
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_raw_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
+    // Fallback of parse_file_raw_internal() if the file can't be memory mapped: read it by big chunks.
+    template<typename ParseLineCallback, typename LineEndCallback>
+    bool        parse_file_raw_buffered(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
+    // parse_file_raw_internal() of a binary G-code: its G-code is decoded block by block.
+    // The line ends aren't reported, as the lines can't be found in the file.
+    template<typename ParseLineCallback>
+    bool        parse_file_raw_binary(const std::string &filename, ParseLineCallback parse_line_callback);
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
+    // parse_file_internal() of a memory mapped G-code: the lines are parsed by chunks in parallel, then given to the callback in order.
+    // Only a few chunks are parsed ahead of the callback, so that the parsed lines of a big file are never all in memory.
+    template<typename ParseLineCallback, typename LineEndCallback>
+    bool        parse_file_parallel(const char *begin, const char *end, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Parse the command and the axes of a line without touching the state of the reader, thus it may be called in parallel.
+    const char* parse_line_axes(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command) const;
+    // Update the state of the reader with a parsed line, before the line is given to the callback.
+    void        begin_line(const GCodeLine &gline);
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
@@ -6,13 +6,13 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <map>
 
-#ifdef __APPLE__
-    #include <boost/spirit/include/karma.hpp>
-#endif
 
 #define FLAVOR_IS(val) this->config.gcode_flavor.value == val
 #define FLAVOR_IS_NOT(val) this->config.gcode_flavor.value != val
@@ -392,22 +392,23 @@ std::string GCodeWriter::toolchange(uint16_t tool_id)
 }
 
 std::string GCodeWriter::set_speed(const double speed, const std::string &comment, const std::string &cooling_marker)
+{
+    std::string gcode;
+    this->set_speed(gcode, speed, comment, cooling_marker);
+    return gcode;
+}
+
+void GCodeWriter::set_speed(std::string &gcode, const double speed, const std::string &comment, const std::string &cooling_marker)
 {
     const double F = speed * 60;
     m_current_speed = speed;
     assert(F > 0.);
     assert(F < 100000.);
-//    GCodeG1Formatter w;
-//    w.emit_f(F);
-//    w.emit_comment(this->config.gcode_comments, comment);
-//    w.emit_string(cooling_marker);
-//    return w.string();
-    std::ostringstream gcode;
-    gcode << "G1 F" << F_NUM(F);
-    COMMENT(comment);
-    gcode << cooling_marker;
-    gcode << "\n";
-    return gcode.str();
+    GCodeG1Formatter w(gcode);
+    w.emit_f(F);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_string(cooling_marker);
+    w.end_line();
 }
 
 double GCodeWriter::get_speed() const
@@ -417,8 +418,14 @@ double GCodeWriter::get_speed() const
 
 std::string GCodeWriter::travel_to_xy(const Vec2d &point, const double speed, const std::string &comment)
 {
-    std::ostringstream gcode;
-    gcode << write_acceleration();
+    std::string gcode;
+    this->travel_to_xy(gcode, point, speed, comment);
+    return gcode;
+}
+
+void GCodeWriter::travel_to_xy(std::string &gcode, const Vec2d &point, const double speed, const std::string &comment)
+{
+    gcode += write_acceleration();
 
     double travel_speed = this->config.travel_speed.value;
     if ((speed > 0) & (speed < travel_speed))
@@ -426,18 +433,13 @@ std::string GCodeWriter::travel_to_xy(const Vec2d &point, const double speed, co
 
     m_pos.x() = point.x();
     m_pos.y() = point.y();
-    
-//    GCodeG1Formatter w;
-//    w.emit_xy(point);
-//    w.emit_f(this->config.travel_speed.value * 60.0);
-//    w.emit_comment(this->config.gcode_comments, comment);
-//    return w.string();
-    gcode << "G1 X" << XYZ_NUM(point.x())
-          <<   " Y" << XYZ_NUM(point.y())
-          <<   " F" << F_NUM(travel_speed * 60);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+
+    GCodeG1Formatter w(gcode);
+    w.emit_axis('X', point.x(), this->config.gcode_precision_xyz.value);
+    w.emit_axis('Y', point.y(), this->config.gcode_precision_xyz.value);
+    w.emit_f(travel_speed * 60);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.end_line();
 }
 
 std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const double speed, const std::string &comment)
@@ -535,24 +537,37 @@ bool GCodeWriter::will_move_z(double z) const
 }
 
 std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std::string &comment)
+{
+    std::string gcode;
+    this->extrude_to_xy(gcode, point, dE, comment);
+    return gcode;
+}
+
+void GCodeWriter::extrude_to_xy(std::string &gcode, const Vec2d &point, double dE, const std::string &comment)
 {
     assert(dE == dE);
     m_pos.x() = point.x();
     m_pos.y() = point.y();
     bool is_extrude = m_tool->extrude(dE) != 0;
 
-    std::ostringstream gcode;
-    gcode << write_acceleration();
-    gcode << "G1 X" << XYZ_NUM(point.x())
-        << " Y" << XYZ_NUM(point.y());
-    if(is_extrude)
-        gcode <<    " " << m_extrusion_axis << E_NUM(m_tool->E());
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    gcode += write_acceleration();
+    GCodeG1Formatter w(gcode);
+    w.emit_axis('X', point.x(), this->config.gcode_precision_xyz.value);
+    w.emit_axis('Y', point.y(), this->config.gcode_precision_xyz.value);
+    if (is_extrude)
+        w.emit_axis(m_extrusion_axis, m_tool->E(), this->config.gcode_precision_e.value);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.end_line();
 }
 
 std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment)
+{
+    std::string gcode;
+    this->extrude_to_xyz(gcode, point, dE, comment);
+    return gcode;
+}
+
+void GCodeWriter::extrude_to_xyz(std::string &gcode, const Vec3d &point, double dE, const std::string &comment)
 {
     assert(dE == dE);
     m_pos.x() = point.x();
@@ -560,21 +575,15 @@ std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std
     m_lifted = 0;
     bool is_extrude = m_tool->extrude(dE) != 0;
 
-//    GCodeG1Formatter w;
-//    w.emit_xyz(point);
-//    w.emit_e(m_extrusion_axis, m_extruder->E());
-//    w.emit_comment(this->config.gcode_comments, comment);
-//    return w.string();
-    std::ostringstream gcode;
-    gcode << write_acceleration();
-    gcode << "G1 X" << XYZ_NUM(point.x())
-        << " Y" << XYZ_NUM(point.y())
-        << " Z" << XYZ_NUM(point.z() + m_pos.z());
+    gcode += write_acceleration();
+    GCodeG1Formatter w(gcode);
+    w.emit_axis('X', point.x(), this->config.gcode_precision_xyz.value);
+    w.emit_axis('Y', point.y(), this->config.gcode_precision_xyz.value);
+    w.emit_axis('Z', point.z() + m_pos.z(), this->config.gcode_precision_xyz.value);
     if (is_extrude)
-            gcode <<    " " << m_extrusion_axis << E_NUM(m_tool->E());
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+        w.emit_axis(m_extrusion_axis, m_tool->E(), this->config.gcode_precision_e.value);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.end_line();
 }
 
 std::string GCodeWriter::retract(bool before_wipe)
@@ -820,65 +829,59 @@ std::string GCodeWriter::set_fan(const uint8_t speed, uint16_t default_tool)
     return GCodeWriter::set_fan(this->config.gcode_flavor.value, this->config.gcode_comments.value, speed, tool ? tool->fan_offset() : 0, this->config.fan_percentage.value);
 }
 
-#ifdef USE_GCODEFORMATTER
-void GCodeFormatter::emit_axis(const char axis, const double v, size_t digits) {
-    assert(digits <= 9);
-    static constexpr const std::array<int, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
-    *ptr_err.ptr++ = ' '; *ptr_err.ptr++ = axis;
-
-    char *base_ptr = this->ptr_err.ptr;
-    auto  v_int    = int64_t(std::round(v * pow_10[digits]));
-    // Older stdlib on macOS doesn't support std::from_chars at all, so it is used boost::spirit::karma::generate instead of it.
-    // That is a little bit slower than std::to_chars but not much.
-#ifdef __APPLE__
-    boost::spirit::karma::generate(this->ptr_err.ptr, boost::spirit::karma::int_generator<int64_t>(), v_int);
-#else
-    // this->buf_end minus 1 because we need space for adding the extra decimal point.
-    this->ptr_err = std::to_chars(this->ptr_err.ptr, this->buf_end - 1, v_int);
-#endif
-    size_t writen_digits = (this->ptr_err.ptr - base_ptr) - (v_int < 0 ? 1 : 0);
-    if (writen_digits < digits) {
-        // Number is smaller than 10^digits, so that we will pad it with zeros.
-        size_t remaining_digits = digits - writen_digits;
-        // Move all newly inserted chars by remaining_digits to allocate space for padding with zeros.
-        for (char *from_ptr = this->ptr_err.ptr - 1, *to_ptr = from_ptr + remaining_digits; from_ptr >= this->ptr_err.ptr - writen_digits; --to_ptr, --from_ptr)
-            *to_ptr = *from_ptr;
-
-        memset(this->ptr_err.ptr - writen_digits, '0', remaining_digits);
-        this->ptr_err.ptr += remaining_digits;
-    }
+void GCodeFormatter::emit_axis(const char axis, const double v, int precision)
+{
+    m_out += ' ';
+    m_out += axis;
+    this->emit_number(v, precision);
+}
 
-    // Move all newly inserted chars by one to allocate space for a decimal point.
-    for (char *to_ptr = this->ptr_err.ptr, *from_ptr = to_ptr - 1; from_ptr >= this->ptr_err.ptr - digits; --to_ptr, --from_ptr)
-        *to_ptr = *from_ptr;
+void GCodeFormatter::emit_axis(const std::string &axis, const double v, int precision)
+{
+    m_out += ' ';
+    m_out += axis;
+    this->emit_number(v, precision);
+}
 
-    *(this->ptr_err.ptr - digits) = '.';
-    for (size_t i = 0; i < digits; ++i) {
-        if (*this->ptr_err.ptr != '0')
-            break;
-        this->ptr_err.ptr--;
-    }
-    if (*this->ptr_err.ptr == '.')
-        this->ptr_err.ptr--;
-    if ((this->ptr_err.ptr + 1) == base_ptr || *this->ptr_err.ptr == '-')
-        *(++this->ptr_err.ptr) = '0';
-    this->ptr_err.ptr++;
+void GCodeFormatter::emit_f(const double speed)
+{
+    assert(is_decimal_separator_point()); // for the snprintf
+    // same as std::defaultfloat << std::setprecision(8)
+    char buf[64];
+    int  len = snprintf(buf, sizeof(buf), " F%.8g", speed);
+    assert(len > 0 && len < int(sizeof(buf)));
+    m_out.append(buf, len);
+}
 
-#if 0 // #ifndef NDEBUG
-    {
-        // Verify that the optimized formatter produces the same result as the standard sprintf().
-        double v1 = atof(std::string(base_ptr, this->ptr_err.ptr).c_str());
-        char buf[2048];
-        sprintf(buf, "%.*lf", int(digits), v);
-        double v2 = atof(buf);
-        // Numbers may differ when rounding at exactly or very close to 0.5 due to numerical issues when scaling the double to an integer.
-        // Thus the complex assert.
-//        assert(v1 == v2);
-        assert(std::abs(v1 - v) * pow_10[digits] < 0.50001);
-        assert(std::abs(v2 - v) * pow_10[digits] < 0.50001);
+// Same output as to_string_nozero(v, precision).
+void GCodeFormatter::emit_number(const double v, int precision)
+{
+    assert(is_decimal_separator_point()); // for the snprintf
+    char   buf[64];
+    int    len;
+    double intpart;
+    if (std::modf(v, &intpart) == 0.0) {
+        // same as boost::lexical_cast<std::string>(intpart)
+        len = snprintf(buf, sizeof(buf), "%.17g", intpart);
+    } else {
+        // there is only 15-16 decimal digit in a double
+        int long10 = 0;
+        if (intpart > 9)
+            long10 = int(std::floor(std::log10(std::abs(intpart))));
+        len = snprintf(buf, sizeof(buf), "%.*f", std::min(15 - long10, precision), v);
+        if (len > 0 && len < int(sizeof(buf)) && memchr(buf, '.', len) != nullptr) {
+            // remove the trailing zeros, then the '.' at the end of the int
+            while (len > 1 && buf[len - 1] == '0')
+                -- len;
+            if (len > 1 && buf[len - 1] == '.')
+                -- len;
+        }
     }
-#endif // NDEBUG
+    if (len > 0 && len < int(sizeof(buf)))
+        m_out.append(buf, len);
+    else
+        // Too big for a print bed.
+        m_out += to_string_nozero(v, precision);
 }
-#endif
 
 } // namespace Slic3r
@@ -64,14 +64,20 @@ public:
     std::string toolchange(uint16_t tool_id);
     // in mm/s
     std::string set_speed(const double speed, const std::string &comment = std::string(), const std::string &cooling_marker = std::string());
+    void        set_speed(std::string &gcode, const double speed, const std::string &comment = std::string(), const std::string &cooling_marker = std::string());
     // in mm/s
     double      get_speed() const;
     std::string travel_to_xy(const Vec2d &point, const double speed = 0.0, const std::string &comment = std::string());
+    void        travel_to_xy(std::string &gcode, const Vec2d &point, const double speed = 0.0, const std::string &comment = std::string());
     std::string travel_to_xyz(const Vec3d &point, const double speed = 0.0, const std::string &comment = std::string());
     std::string travel_to_z(double z, const std::string &comment = std::string());
     bool        will_move_z(double z) const;
     std::string extrude_to_xy(const Vec2d &point, double dE, const std::string &comment = std::string());
     std::string extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment = std::string());
+    // The set_speed(), travel_to_xy() and extrude_to_xy[z]() taking a gcode string append their G-code at its end
+    // instead of returning a new string, to be used in the hot loops of the G-code export.
+    void        extrude_to_xy(std::string &gcode, const Vec2d &point, double dE, const std::string &comment = std::string());
+    void        extrude_to_xyz(std::string &gcode, const Vec3d &point, double dE, const std::string &comment = std::string());
     std::string retract(bool before_wipe = false);
     std::string retract_for_toolchange(bool before_wipe = false);
     std::string unretract();
@@ -115,102 +121,46 @@ private:
     std::string _retract(double length, double restart_extra, double restart_extra_toolchange, const std::string &comment);
 
 };
-#if 0
-// removed as charconv isn't here in older system like ubuntu 16.04 (cpp 17)
-#include <charconv>
-#define USE_GCODEFORMATTER
+
+// Appends the G-code of a move at the end of a string, without any temporary string: the G1 lines are emitted
+// millions of times by the G-code export, they are appended into the G-code of the layer as they are formatted.
+// The numbers are formatted like to_string_nozero() (and F like an ostream with a precision of 8), but with snprintf
+// (no charconv in older systems like ubuntu 16.04), thus the C locale has to use a decimal point (see CNumericLocalesSetter).
 class GCodeFormatter {
 public:
-    GCodeFormatter() {
-        this->buf_end = buf + buflen;
-        this->ptr_err.ptr = this->buf;
-    }
+    GCodeFormatter(std::string &out) : m_out(out) {}
 
     GCodeFormatter(const GCodeFormatter&) = delete;
     GCodeFormatter& operator=(const GCodeFormatter&) = delete;
 
-    // At layer height 0.15mm, extrusion width 0.2mm and filament diameter 1.75mm,
-    // the crossection of extrusion is 0.4 * 0.15 = 0.06mm2
-    // and the filament crossection is 1.75^2 = 3.063mm2
-    // thus the filament moves 3.063 / 0.6 = 51x slower than the XY axes
-    // and we need roughly two decimal digits more on extruder than on XY.
-#if 1
-    static constexpr const int XYZF_EXPORT_DIGITS = 3;
-    static constexpr const int E_EXPORT_DIGITS    = 5;
-#else
-    // order of magnitude smaller extrusion rate erros
-    static constexpr const int XYZF_EXPORT_DIGITS = 4;
-    static constexpr const int E_EXPORT_DIGITS    = 6;
-    // excessive accuracy
-//    static constexpr const int XYZF_EXPORT_DIGITS = 6;
-//    static constexpr const int E_EXPORT_DIGITS    = 9;
-#endif
-
-    void emit_axis(const char axis, const double v, size_t digits);
-
-    void emit_xy(const Vec2d &point) {
-        this->emit_axis('X', point.x(), XYZF_EXPORT_DIGITS);
-        this->emit_axis('Y', point.y(), XYZF_EXPORT_DIGITS);
-    }
-
-    void emit_xyz(const Vec3d &point) {
-        this->emit_axis('X', point.x(), XYZF_EXPORT_DIGITS);
-        this->emit_axis('Y', point.y(), XYZF_EXPORT_DIGITS);
-        this->emit_z(point.z());
-    }
-
-    void emit_z(const double z) {
-        this->emit_axis('Z', z, XYZF_EXPORT_DIGITS);
-    }
-
-    void emit_e(const std::string &axis, double v) {
-        if (! axis.empty()) {
-            // not gcfNoExtrusion
-            this->emit_axis(axis[0], v, E_EXPORT_DIGITS);
-        }
-    }
-
-    void emit_f(double speed) {
-        this->emit_axis('F', speed, XYZF_EXPORT_DIGITS);
-    }
-
-    void emit_string(const std::string &s) {
-        strncpy(ptr_err.ptr, s.c_str(), s.size());
-        ptr_err.ptr += s.size();
-    }
-
+    // " X1.234", with at most precision decimals, without the trailing zeros.
+    void emit_axis(const char axis, const double v, int precision);
+    void emit_axis(const std::string &axis, const double v, int precision);
+    // " F1800"
+    void emit_f(const double speed);
+    void emit_string(const std::string &s) { m_out += s; }
+    void emit_string(const char *s) { m_out += s; }
     void emit_comment(bool allow_comments, const std::string &comment) {
         if (allow_comments && ! comment.empty()) {
-            *ptr_err.ptr ++ = ' '; *ptr_err.ptr ++ = ';'; *ptr_err.ptr ++ = ' ';
-            this->emit_string(comment);
+            m_out += " ; ";
+            m_out += comment;
         }
     }
+    void end_line() { m_out += '\n'; }
 
-    std::string string() {
-        *ptr_err.ptr ++ = '\n';
-        return std::string(this->buf, ptr_err.ptr - buf);
-    }
+private:
+    void emit_number(const double v, int precision);
 
-protected:
-    static constexpr const size_t   buflen = 256;
-    char                            buf[buflen];
-    char* buf_end;
-    std::to_chars_result            ptr_err;
+    std::string &m_out;
 };
 
 class GCodeG1Formatter : public GCodeFormatter {
 public:
-    GCodeG1Formatter() {
-        this->buf[0] = 'G';
-        this->buf[1] = '1';
-        this->buf_end = buf + buflen;
-        this->ptr_err.ptr = this->buf + 2;
-    }
+    GCodeG1Formatter(std::string &out) : GCodeFormatter(out) { this->emit_string("G1"); }
 
     GCodeG1Formatter(const GCodeG1Formatter&) = delete;
     GCodeG1Formatter& operator=(const GCodeG1Formatter&) = delete;
 };
-#endif
 
 } /* namespace Slic3r */
 
@@ -28,6 +28,32 @@ bool Layer::empty() const
     return true;
 }
 
+void Layer::make_lslices_grid()
+{
+    m_lslices_grid        = this->create_lslices_grid();
+    m_lslices_travel_grid = this->create_lslices_travel_grid();
+}
+
+std::unique_ptr<EdgeGrid::Grid> Layer::create_lslices_grid() const
+{
+    auto grid = std::make_unique<EdgeGrid::Grid>();
+    // 1mm grid, fine enough for the distance queries of the seam placement.
+    grid->create(this->lslices, coord_t(scale_(1.) + 0.5));
+    grid->calculate_sdf();
+    return grid;
+}
+
+std::unique_ptr<EdgeGrid::Grid> Layer::create_lslices_travel_grid() const
+{
+    auto grid = std::make_unique<EdgeGrid::Grid>();
+    BoundingBox bbox_slice(get_extents(this->lslices));
+    bbox_slice.offset(SCALED_EPSILON);
+    grid->set_bbox(bbox_slice);
+    //FIXME 1mm grid?
+    grid->create(this->lslices, coord_t(scale_(1.)));
+    return grid;
+}
+
 LayerRegion* Layer::add_region(const PrintRegion *print_region)
 {
     m_regions.emplace_back(new LayerRegion(this, print_region));
@@ -392,6 +418,27 @@ void Layer::export_region_fill_surfaces_to_svg_debug(const char *name) const
     this->export_region_fill_surfaces_to_svg(debug_out_path("Layer-fill_surfaces-%s-%d.svg", name, idx ++).c_str());
 }
 
+void SupportLayer::pack_extrusions()
+{
+    if (m_support_fills_packed)
+        return;
+    m_has_packed_support_fills = ! this->support_fills.empty();
+    m_packed_support_fills.pack(this->support_fills);
+    this->support_fills.clear();
+    this->support_fills.set_entities().shrink_to_fit();
+    m_support_fills_packed = true;
+}
+
+void SupportLayer::unpack_extrusions()
+{
+    if (! m_support_fills_packed)
+        return;
+    this->support_fills      = m_packed_support_fills.unpack();
+    m_packed_support_fills   = PackedExtrusionEntities();
+    m_support_fills_packed   = false;
+    m_has_packed_support_fills = false;
+}
+
 BoundingBox get_extents(const LayerRegion &layer_region)
 {
     BoundingBox bbox;
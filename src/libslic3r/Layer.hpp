@@ -2,9 +2,11 @@
 #define slic3r_Layer_hpp_
 
 #include "libslic3r.h"
+#include "EdgeGrid.hpp"
 #include "Flow.hpp"
 #include "SurfaceCollection.hpp"
 #include "ExtrusionEntityCollection.hpp"
+#include "ExtrusionEntityPacked.hpp"
 #include "ExPolygonCollection.hpp"
 
 namespace Slic3r {
@@ -92,18 +94,41 @@ public:
     void    export_region_fill_surfaces_to_svg_debug(const char *name) const;
 
     // Is there any valid extrusion assigned to this LayerRegion?
-    bool    has_extrusions() const { return !this->perimeters.entities().empty() || !this->fills.entities().empty() || !this->ironings.entities().empty() || !this->thin_fills.entities().empty(); }
+    bool    has_extrusions() const { return m_has_packed_extrusions || !this->perimeters.entities().empty() || !this->fills.entities().empty() || !this->ironings.entities().empty() || !this->thin_fills.entities().empty(); }
+
+    // Move perimeters, fills and thin_fills into a compact storage, to hold the extrusions of a finished layer with less memory.
+    // They are empty until unpack_extrusions() is called. Only called by LayerSpill: without a memory budget the layers stay unpacked.
+    // The ironings stay unpacked: they are made by the ironing step, after the layer is packed by LayerSpill as soon as
+    // it is infilled, and they are a few paths over the top surfaces only.
+    void    pack_extrusions();
+    void    unpack_extrusions();
+    bool    extrusions_packed() const { return m_extrusions_packed; }
+    const PackedExtrusionEntities& packed_perimeters() const { return m_packed_perimeters; }
+    const PackedExtrusionEntities& packed_fills() const { return m_packed_fills; }
+    const PackedExtrusionEntities& packed_thin_fills() const { return m_packed_thin_fills; }
 
 protected:
     friend class Layer;
+    friend class LayerSpill;
     friend class PrintObject;
 
     LayerRegion(Layer *layer, const PrintRegion *region) : m_layer(layer), m_region(region) {}
     ~LayerRegion() {}
 
+    // The packed buffers with the collections they are unpacked into, for LayerSpill.
+    void    packed_extrusions(std::vector<std::pair<PackedExtrusionEntities*, ExtrusionEntityCollection*>> &out)
+        { out.emplace_back(&m_packed_perimeters, &this->perimeters); out.emplace_back(&m_packed_fills, &this->fills); out.emplace_back(&m_packed_thin_fills, &this->thin_fills); }
+
 private:
     Layer             *m_layer;
     const PrintRegion *m_region;
+
+    PackedExtrusionEntities m_packed_perimeters;
+    PackedExtrusionEntities m_packed_fills;
+    PackedExtrusionEntities m_packed_thin_fills;
+    bool                    m_extrusions_packed { false };
+    // Were perimeters, fills or thin_fills not empty when they were packed? The packed buffers may be spilled to a file by LayerSpill.
+    bool                    m_has_packed_extrusions { false };
 };
 
 class Layer 
@@ -133,6 +158,18 @@ public:
     // that the 1st lslice is not compensated by the Elephant foot compensation algorithm.
     ExPolygons 				 lslices;
     std::vector<BoundingBox> lslices_bboxes;
+    // Edge grid of the lslices with their signed distance field, calculated in parallel for all the layers at the end of posPerimeters.
+    // Only read by the G-code generator, for the seam placement over the lower layer.
+    // Released after the G-code export and when posPerimeters is invalidated, nullptr then. Not built with a layer memory budget.
+    const EdgeGrid::Grid*    lslices_grid() const { return m_lslices_grid.get(); }
+    // Edge grid of the lslices for the avoid crossing perimeters travels, without distance field and with the bounding box
+    // inflated by SCALED_EPSILON, as their containment tests expect. Built and released with lslices_grid().
+    const EdgeGrid::Grid*    lslices_travel_grid() const { return m_lslices_travel_grid.get(); }
+    // Build both grids.
+    void                     make_lslices_grid();
+    std::unique_ptr<EdgeGrid::Grid> create_lslices_grid() const;
+    std::unique_ptr<EdgeGrid::Grid> create_lslices_travel_grid() const;
+    void                     clear_lslices_grid() { m_lslices_grid.reset(); m_lslices_travel_grid.reset(); }
 
     size_t                  region_count() const { return m_regions.size(); }
     const LayerRegion*      get_region(size_t idx) const { return m_regions[idx]; }
@@ -156,6 +193,9 @@ public:
     void                    make_fills() { this->make_fills(nullptr, nullptr); }
     void                    make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree);
     void                    make_ironing();
+    // Pack / unpack the perimeters and fills of all the regions, see LayerRegion::pack_extrusions().
+    virtual void            pack_extrusions()   { for (LayerRegion *layerm : m_regions) layerm->pack_extrusions(); }
+    virtual void            unpack_extrusions() { for (LayerRegion *layerm : m_regions) layerm->unpack_extrusions(); }
 
     void                    export_region_slices_to_svg(const char *path) const;
     void                    export_region_fill_surfaces_to_svg(const char *path) const;
@@ -168,9 +208,14 @@ public:
 
 protected:
     friend class PrintObject;
+    friend class LayerSpill;
     friend std::vector<Layer*> new_layers(PrintObject*, const std::vector<coordf_t>&);
     friend std::string fix_slicing_errors(LayerPtrs&, const std::function<void()>&);
 
+    // The packed buffers of pack_extrusions() with the collections they are unpacked into, for LayerSpill.
+    using PackedExtrusions = std::vector<std::pair<PackedExtrusionEntities*, ExtrusionEntityCollection*>>;
+    virtual void            packed_extrusions(PackedExtrusions &out) { for (LayerRegion *layerm : m_regions) layerm->packed_extrusions(out); }
+
     Layer(size_t id, PrintObject *object, coordf_t height, coordf_t print_z, coordf_t slice_z) :
         upper_layer(nullptr), lower_layer(nullptr), slicing_errors(false),
         slice_z(slice_z), print_z(print_z), height(height),
@@ -182,6 +227,8 @@ private:
     size_t              m_id;
     PrintObject        *m_object;
     LayerRegionPtrs     m_regions;
+    std::unique_ptr<EdgeGrid::Grid> m_lslices_grid;
+    std::unique_ptr<EdgeGrid::Grid> m_lslices_travel_grid;
 };
 
 class SupportLayer : public Layer 
@@ -195,7 +242,12 @@ public:
 
 
     // Is there any valid extrusion assigned to this LayerRegion?
-    virtual bool                has_extrusions() const { return ! support_fills.empty(); }
+    virtual bool                has_extrusions() const { return m_has_packed_support_fills || ! support_fills.empty(); }
+    // Pack / unpack the support_fills, same as the extrusions of the object layers.
+    void                        pack_extrusions() override;
+    void                        unpack_extrusions() override;
+    bool                        extrusions_packed() const { return m_support_fills_packed; }
+    const PackedExtrusionEntities& packed_support_fills() const { return m_packed_support_fills; }
 
     // Zero based index of an interface layer, used for alternating direction of interface / contact layers.
     size_t                      interface_id() const { return m_interface_id; }
@@ -209,7 +261,14 @@ protected:
         Layer(id, object, height, print_z, slice_z), m_interface_id(interface_id) {}
     virtual ~SupportLayer() = default;
 
+    void                        packed_extrusions(PackedExtrusions &out) override { out.emplace_back(&m_packed_support_fills, &this->support_fills); }
+
     size_t m_interface_id;
+
+    PackedExtrusionEntities     m_packed_support_fills;
+    bool                        m_support_fills_packed { false };
+    // Was support_fills not empty when it was packed?
+    bool                        m_has_packed_support_fills { false };
 };
 
 template<typename LayerContainer>
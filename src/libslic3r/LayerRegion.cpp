@@ -78,6 +78,38 @@ void LayerRegion::slices_to_fill_surfaces_clipped(coord_t opening_offset)
     }
 }
 
+void LayerRegion::pack_extrusions()
+{
+    if (m_extrusions_packed)
+        return;
+    m_has_packed_extrusions = ! this->perimeters.empty() || ! this->fills.empty() || ! this->thin_fills.empty();
+    m_packed_perimeters.pack(this->perimeters);
+    m_packed_fills.pack(this->fills);
+    // The thin fills are copied into the fills by make_fills(), they are only kept to make the fills again.
+    m_packed_thin_fills.pack(this->thin_fills);
+    this->perimeters.clear();
+    this->fills.clear();
+    this->thin_fills.clear();
+    this->perimeters.set_entities().shrink_to_fit();
+    this->fills.set_entities().shrink_to_fit();
+    this->thin_fills.set_entities().shrink_to_fit();
+    m_extrusions_packed = true;
+}
+
+void LayerRegion::unpack_extrusions()
+{
+    if (! m_extrusions_packed)
+        return;
+    this->perimeters = m_packed_perimeters.unpack();
+    this->fills      = m_packed_fills.unpack();
+    this->thin_fills = m_packed_thin_fills.unpack();
+    m_packed_perimeters = PackedExtrusionEntities();
+    m_packed_fills      = PackedExtrusionEntities();
+    m_packed_thin_fills = PackedExtrusionEntities();
+    m_extrusions_packed = false;
+    m_has_packed_extrusions = false;
+}
+
 void LayerRegion::make_perimeters(const SurfaceCollection &slices, SurfaceCollection* fill_surfaces)
 {
     this->perimeters.clear();
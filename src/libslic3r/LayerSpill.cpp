@@ -0,0 +1,313 @@
+#include "LayerSpill.hpp"
+#include "Exception.hpp"
+#include "Layer.hpp"
+#include "Print.hpp"
+#include "Utils.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace Slic3r {
+
+// Positional writes and reads: the threads share the scratch file without moving a shared file position.
+static bool write_at(FILE *file, const char *data, size_t size, uint64_t offset)
+{
+#ifdef _WIN32
+    HANDLE     handle = HANDLE(_get_osfhandle(_fileno(file)));
+    OVERLAPPED overlapped {};
+    overlapped.Offset     = DWORD(offset);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+    DWORD      written    = 0;
+    return WriteFile(handle, data, DWORD(size), &written, &overlapped) && written == DWORD(size);
+#else
+    while (size > 0) {
+        ssize_t written = pwrite(fileno(file), data, size, off_t(offset));
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data   += written;
+        size   -= size_t(written);
+        offset += uint64_t(written);
+    }
+    return true;
+#endif
+}
+
+static bool read_at(FILE *file, char *data, size_t size, uint64_t offset)
+{
+#ifdef _WIN32
+    HANDLE     handle = HANDLE(_get_osfhandle(_fileno(file)));
+    OVERLAPPED overlapped {};
+    overlapped.Offset     = DWORD(offset);
+    overlapped.OffsetHigh = DWORD(offset >> 32);
+    DWORD      num_read   = 0;
+    return ReadFile(handle, data, DWORD(size), &num_read, &overlapped) && num_read == DWORD(size);
+#else
+    while (size > 0) {
+        ssize_t num_read = pread(fileno(file), data, size, off_t(offset));
+        if (num_read < 0 && errno == EINTR)
+            continue;
+        if (num_read <= 0)
+            return false;
+        data   += num_read;
+        size   -= size_t(num_read);
+        offset += uint64_t(num_read);
+    }
+    return true;
+#endif
+}
+
+bool LayerSpill::can_spill(const Layer &layer)
+{
+    const PrintObject &object = *layer.object();
+    // The first layers are read by the skirt and brim generators.
+    if (dynamic_cast<const SupportLayer*>(&layer) != nullptr ?
+            &layer == object.support_layers().front() :
+            &layer == object.layers().front())
+        return false;
+    // The wiping into the infill or the object is planned by ToolOrdering on the extrusions of the layers, which have to stay
+    // in memory until the G-code is exported.
+    if (object.print()->has_wipe_tower()) {
+        bool wipe_into = object.config().wipe_into_objects.value;
+        for (size_t region_id = 0; region_id < object.num_printing_regions(); ++ region_id)
+            wipe_into |= object.printing_region(region_id).config().wipe_into_infill.value;
+        if (wipe_into)
+            return false;
+    }
+    return true;
+}
+
+void LayerSpill::spill(Layer &layer)
+{
+    if (! this->enabled() || ! can_spill(layer))
+        return;
+    Record *record;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [it, inserted] = m_records.try_emplace(&layer);
+        if (! inserted)
+            // Already spilled by a previous process().
+            return;
+        record = &it->second;
+    }
+    std::lock_guard<std::mutex> lock_record(record->mutex);
+    layer.pack_extrusions();
+    Layer::PackedExtrusions packed;
+    layer.packed_extrusions(packed);
+    size_t bytes = 0;
+    for (const auto &[extrusions, collection] : packed)
+        bytes += extrusions->memory_used();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_resident + bytes <= m_budget) {
+            m_resident += bytes;
+            return;
+        }
+    }
+    // Over the budget: into the scratch file.
+    std::string data;
+    for (const auto &[extrusions, collection] : packed)
+        extrusions->append_to(data);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file == nullptr) {
+            m_path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slic3r_layers_%%%%-%%%%-%%%%.bin")).string();
+            m_file = boost::nowide::fopen(m_path.c_str(), "w+b");
+            if (m_file == nullptr)
+                throw Slic3r::RuntimeError(std::string("Can't create the layers scratch file ") + m_path);
+            m_file_size = 0;
+        }
+        record->offset = m_file_size;
+        record->size   = data.size();
+        m_file_size   += data.size();
+    }
+    if (! write_at(m_file, data.data(), data.size(), record->offset))
+        throw Slic3r::RuntimeError(std::string("Can't write the layers into the scratch file ") + m_path);
+    for (auto &[extrusions, collection] : packed)
+        *extrusions = PackedExtrusionEntities();
+}
+
+void LayerSpill::spill(PrintObject &object)
+{
+    if (! this->enabled())
+        return;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, object.layers().size() + object.support_layers().size()),
+        [this, &object](const tbb::blocked_range<size_t> &range) {
+            for (size_t idx = range.begin(); idx < range.end(); ++ idx)
+                this->spill(idx < object.layers().size() ?
+                    *static_cast<Layer*>(object.get_layer(int(idx))) :
+                    *static_cast<Layer*>(object.get_support_layer(int(idx - object.layers().size()))));
+        });
+    std::lock_guard<std::mutex> lock(m_mutex);
+    BOOST_LOG_TRIVIAL(debug) << "Spilled the layers of " << object.model_object()->name << ", " <<
+        format_memsize_MB(m_resident) << " of packed layers in memory, " << format_memsize_MB(size_t(m_file_size)) << " in " << m_path << log_memory_info();
+}
+
+LayerSpill::Record* LayerSpill::find(const Layer &layer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_records.find(&layer);
+    return it == m_records.end() ? nullptr : &it->second;
+}
+
+void LayerSpill::read(Layer &layer, const Record &record)
+{
+    if (record.size == 0)
+        // Packed in memory.
+        return;
+    std::string data(size_t(record.size), 0);
+    if (! read_at(m_file, data.data(), data.size(), record.offset))
+        throw Slic3r::RuntimeError(std::string("Can't read the layers from the scratch file ") + m_path);
+    const char *begin = data.data();
+    const char *end   = begin + data.size();
+    Layer::PackedExtrusions packed;
+    layer.packed_extrusions(packed);
+    for (auto &[extrusions, collection] : packed)
+        if (! extrusions->read_from(begin, end))
+            throw Slic3r::RuntimeError(std::string("The layers scratch file is corrupted: ") + m_path);
+}
+
+bool LayerSpill::load(const Layer &layer)
+{
+    Record *record = this->find(layer);
+    if (record == nullptr)
+        return false;
+    std::lock_guard<std::mutex> lock(record->mutex);
+    if (record->loaded ++ == 0) {
+        // The layers are only modified by the LayerSpill once their extrusions are made, as a cache of the layer extrusions.
+        // The packed extrusions kept in memory stay there, the ones read from the scratch file are freed once unpacked.
+        // They may already be read by a PackedLoader.
+        Layer &layer_mutable = const_cast<Layer&>(layer);
+        if (record->loaded_packed == 0)
+            this->read(layer_mutable, *record);
+        Layer::PackedExtrusions packed;
+        layer_mutable.packed_extrusions(packed);
+        for (auto &[extrusions, collection] : packed) {
+            *collection = extrusions->unpack();
+            if (record->size > 0 && record->loaded_packed == 0)
+                *extrusions = PackedExtrusionEntities();
+        }
+    }
+    return true;
+}
+
+void LayerSpill::release(const Layer &layer)
+{
+    Record *record = this->find(layer);
+    assert(record != nullptr);
+    std::lock_guard<std::mutex> lock(record->mutex);
+    assert(record->loaded > 0);
+    if (-- record->loaded == 0) {
+        // The extrusions were only read, the packed copy in memory or in the scratch file is still valid.
+        Layer::PackedExtrusions packed;
+        const_cast<Layer&>(layer).packed_extrusions(packed);
+        for (auto &[extrusions, collection] : packed) {
+            collection->clear();
+            collection->set_entities().shrink_to_fit();
+        }
+    }
+}
+
+bool LayerSpill::load_packed(const Layer &layer)
+{
+    Record *record = this->find(layer);
+    if (record == nullptr)
+        return false;
+    std::lock_guard<std::mutex> lock(record->mutex);
+    if (record->loaded_packed ++ == 0)
+        this->read(const_cast<Layer&>(layer), *record);
+    return true;
+}
+
+void LayerSpill::release_packed(const Layer &layer)
+{
+    Record *record = this->find(layer);
+    assert(record != nullptr);
+    std::lock_guard<std::mutex> lock(record->mutex);
+    assert(record->loaded_packed > 0);
+    if (-- record->loaded_packed == 0 && record->size > 0) {
+        // Read from the scratch file, they are still there.
+        Layer::PackedExtrusions packed;
+        const_cast<Layer&>(layer).packed_extrusions(packed);
+        for (auto &[extrusions, collection] : packed)
+            *extrusions = PackedExtrusionEntities();
+    }
+}
+
+void LayerSpill::restore()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &[layer, record] : m_records) {
+        assert(record.loaded == 0 && record.loaded_packed == 0);
+        Layer &layer_mutable = const_cast<Layer&>(*layer);
+        this->read(layer_mutable, record);
+        layer_mutable.unpack_extrusions();
+    }
+    m_records.clear();
+    m_resident = 0;
+    this->close();
+}
+
+void LayerSpill::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records.clear();
+    m_resident = 0;
+    this->close();
+}
+
+void LayerSpill::close()
+{
+    if (m_file != nullptr) {
+        fclose(m_file);
+        m_file = nullptr;
+        boost::nowide::remove(m_path.c_str());
+        m_path.clear();
+        m_file_size = 0;
+    }
+}
+
+LayerSpill::Loader::Loader(const Layer *layer) : m_layer(layer)
+{
+    if (layer != nullptr) {
+        LayerSpill &spill = layer->object()->print()->layer_spill();
+        if (spill.enabled() && spill.load(*layer))
+            m_spill = &spill;
+    }
+}
+
+LayerSpill::Loader::~Loader()
+{
+    if (m_spill != nullptr)
+        m_spill->release(*m_layer);
+}
+
+LayerSpill::PackedLoader::PackedLoader(const Layer *layer) : m_layer(layer)
+{
+    if (layer != nullptr) {
+        LayerSpill &spill = layer->object()->print()->layer_spill();
+        if (spill.enabled() && spill.load_packed(*layer))
+            m_spill = &spill;
+    }
+}
+
+LayerSpill::PackedLoader::~PackedLoader()
+{
+    if (m_spill != nullptr)
+        m_spill->release_packed(*m_layer);
+}
+
+} // namespace Slic3r
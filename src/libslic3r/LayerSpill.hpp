@@ -0,0 +1,119 @@
+#ifndef slic3r_LayerSpill_hpp_
+#define slic3r_LayerSpill_hpp_
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+class Layer;
+class PrintObject;
+
+// Memory budgeted storage of the extrusions of the layers, for the prints too big to keep all their layers in memory.
+// The extrusions of an object layer are packed (see LayerRegion::pack_extrusions()) as soon as its infill is made,
+// the ones of the support layers once the support of the object is generated. The packed layers are kept in memory
+// up to the budget, the next ones are written into a scratch file.
+// The code reading the extrusions after that (support generation, skirt, tool ordering, seam placement, G-code export)
+// pages the layers in with a Loader, for as long as it needs them. The code only reading the paths (roles, flows, extents)
+// pages in the packed extrusions with a PackedLoader instead, without unpacking them.
+// Not spilled: the geometry of the layers (lslices, region slices and fill surfaces), which the support, the skirt,
+// the brim and the travels read across the whole object, and the first object and support layers, read by the brim.
+class LayerSpill
+{
+public:
+    LayerSpill() = default;
+    ~LayerSpill() { this->close(); }
+    LayerSpill(const LayerSpill&) = delete;
+    LayerSpill& operator=(const LayerSpill&) = delete;
+
+    // Bytes of packed extrusions to keep in memory, 0 (default) to keep all the layers unpacked in memory.
+    void        set_budget(size_t bytes) { m_budget = bytes; }
+    size_t      budget() const { return m_budget; }
+    bool        enabled() const { return m_budget > 0; }
+    // Path of the scratch file, empty if no layer was written into one.
+    const std::string& path() const { return m_path; }
+
+    // Pack a layer whose extrusions are all made and spill it over the budget.
+    // Thread safe, the layers are spilled by the parallel loops generating them.
+    void        spill(Layer &layer);
+    // Spill the layers of an object not spilled yet (its support layers, the layers not infilled again), once its steps are done.
+    void        spill(PrintObject &object);
+    // Unpack all the layers as if they were never spilled and remove the scratch file.
+    // To be called before the layers are modified.
+    void        restore();
+    // Forget the spilled layers without touching them, when they are deleted.
+    void        clear();
+
+    // Makes the extrusions of a layer available during its life time.
+    // Does nothing if the layer was not spilled.
+    class Loader {
+    public:
+        explicit Loader(const Layer *layer);
+        ~Loader();
+        Loader(const Loader&) = delete;
+        Loader& operator=(const Loader&) = delete;
+    private:
+        LayerSpill  *m_spill { nullptr };
+        const Layer *m_layer;
+    };
+
+    // Makes the packed extrusions of a layer available during its life time, to walk them with
+    // PackedExtrusionEntities::for_each_path(). If packed() is false, the layer was not spilled:
+    // the extrusions are to be read from the collections of the layer.
+    class PackedLoader {
+    public:
+        explicit PackedLoader(const Layer *layer);
+        ~PackedLoader();
+        PackedLoader(const PackedLoader&) = delete;
+        PackedLoader& operator=(const PackedLoader&) = delete;
+        bool         packed() const { return m_spill != nullptr; }
+    private:
+        LayerSpill  *m_spill { nullptr };
+        const Layer *m_layer;
+    };
+
+private:
+    struct Record {
+        // Serializes the paging in and out of this layer, the other layers are paged in parallel.
+        std::mutex  mutex;
+        // Position of the packed extrusions in the scratch file, size is zero if they are kept in memory.
+        uint64_t    offset { 0 };
+        uint64_t    size   { 0 };
+        // Number of the Loaders of the layer.
+        int         loaded { 0 };
+        // Number of the PackedLoaders of the layer. The packed extrusions read from the scratch file are kept while it isn't zero.
+        int         loaded_packed { 0 };
+    };
+
+    // The wiping into the infill or the object keeps the extrusions of its layers in memory, as well as the first layers.
+    static bool can_spill(const Layer &layer);
+    // nullptr if the layer was not spilled.
+    Record*     find(const Layer &layer);
+    // Returns false if the layer was not spilled.
+    bool        load(const Layer &layer);
+    void        release(const Layer &layer);
+    bool        load_packed(const Layer &layer);
+    void        release_packed(const Layer &layer);
+    // Read the packed extrusions of a layer from the scratch file.
+    void        read(Layer &layer, const Record &record);
+    void        close();
+
+    size_t                          m_budget    { 0 };
+    // Guards the map of the records, the budget accounting and the allocation of the scratch file.
+    // The records themselves are locked by their own mutex, the scratch file is only accessed with positional reads and writes.
+    std::mutex                      m_mutex;
+    // Bytes of packed extrusions kept in memory.
+    size_t                          m_resident  { 0 };
+    std::string                     m_path;
+    FILE                           *m_file      { nullptr };
+    uint64_t                        m_file_size { 0 };
+    std::map<const Layer*, Record>  m_records;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_LayerSpill_hpp_
@@ -83,4 +83,35 @@ void duplicate_objects(Model &model, size_t copies_num)
     }
 }
 
+std::vector<Model> split_to_plates(Model &model, const ArrangePolygons &arranged, ModelInstancePtrs &instances)
+{
+    int num_plates = 0;
+    for (size_t i = 0; i < arranged.size(); ++ i) {
+        if (arranged[i].bed_idx < 0)
+            throw Slic3r::RuntimeError("Objects could not fit on the bed");
+        instances[i]->apply_arrange_result(arranged[i].translation.cast<double>(), arranged[i].rotation);
+        num_plates = std::max(num_plates, arranged[i].bed_idx + 1);
+    }
+
+    std::vector<Model> plates;
+    plates.reserve(size_t(num_plates));
+    for (int plate_idx = 0; plate_idx < num_plates; ++ plate_idx) {
+        // The copies of the objects share the meshes of their volumes.
+        Model &plate = plates.emplace_back(model);
+        size_t first = 0;
+        for (ModelObject *o : plate.objects) {
+            size_t num_instances = o->instances.size();
+            assert(first + num_instances <= arranged.size());
+            for (size_t i = num_instances; i > 0; -- i)
+                if (arranged[first + i - 1].bed_idx != plate_idx)
+                    o->delete_instance(i - 1);
+            first += num_instances;
+        }
+        for (size_t i = plate.objects.size(); i > 0; -- i)
+            if (plate.objects[i - 1]->instances.empty())
+                plate.delete_object(i - 1);
+    }
+    return plates;
+}
+
 } // namespace Slic3r
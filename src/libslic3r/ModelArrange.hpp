@@ -30,6 +30,9 @@ bool apply_arrange_polys(ArrangePolygons &polys, ModelInstancePtrs &instances, V
 
 void duplicate(Model &model, ArrangePolygons &copies, VirtualBedFn);
 void duplicate_objects(Model &model, size_t copies_num);
+// Move the instances of a model on the beds they are arranged on (see ArrangePolygon::bed_idx) and split the model
+// into one model per bed. The plates share the meshes of the model. Throws if an instance is out of the beds.
+std::vector<Model> split_to_plates(Model &model, const ArrangePolygons &arranged, ModelInstancePtrs &instances);
 
 template<class TBed>
 bool arrange_objects(Model &              model,
@@ -44,6 +47,18 @@ bool arrange_objects(Model &              model,
     return apply_arrange_polys(input, instances, vfn);
 }
 
+// Arrange the instances of a model over as many beds as needed and split it into one model per bed.
+template<class TBed>
+std::vector<Model> arrange_plates(Model &              model,
+                                  const TBed &         bed,
+                                  const ArrangeParams &params)
+{
+    ModelInstancePtrs instances;
+    ArrangePolygons input = get_arrange_polys(model, instances);
+    arrangement::arrange(input, bed, params);
+    return split_to_plates(model, input, instances);
+}
+
 template<class TBed>
 void duplicate(Model &              model,
                size_t               copies_num,
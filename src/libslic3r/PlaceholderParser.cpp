@@ -2,11 +2,13 @@
 #include "Exception.hpp"
 #include "Flow.hpp"
 
+#include <atomic>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
 #include <map>
+#include <mutex>
 
 #ifdef _MSC_VER
     #include <stdlib.h>  // provides **_environ
@@ -68,7 +70,13 @@
 
 namespace Slic3r {
 
-PlaceholderParser::PlaceholderParser(const DynamicConfig *external_config) : m_external_config(external_config)
+struct PlaceholderParser::CheckedVars {
+    std::mutex                                                      mutex;
+    std::map<t_config_option_key, std::unique_ptr<ConfigOption>>   vars;
+};
+
+PlaceholderParser::PlaceholderParser(const DynamicConfig *external_config) :
+    m_external_config(external_config), m_checked_vars(std::make_shared<CheckedVars>())
 {
     this->set("version", std::string(SLIC3R_VERSION));
     this->apply_env_variables();
@@ -690,10 +698,11 @@ namespace client
         // If false, the macro_processor will evaluate a full macro.
         // If true, the macro processor will evaluate just a boolean condition using the full expressive power of the macro processor.
         bool                     just_boolean_expression = false;
-        inline static bool       ignore_legacy = false;
+        inline static std::atomic<bool> ignore_legacy { false };
         std::string              error_message;
 
-        static std::map<t_config_option_key, std::unique_ptr<ConfigOption>> checked_vars;
+        // Variables tested by exists() or given a default(), see PlaceholderParser::CheckedVars.
+        PlaceholderParser::CheckedVars *checked_vars    = nullptr;
 
         // Table to translate symbol tag to a human readable error message.
         static std::map<std::string, std::string> tag_to_error_message;
@@ -710,8 +719,9 @@ namespace client
             if (opt == nullptr && external_config != nullptr)
                 opt = external_config->option(opt_key);
             if (opt == nullptr) {
-                auto it = MyContext::checked_vars.find(opt_key);
-                if (it != MyContext::checked_vars.end())
+                std::lock_guard<std::mutex> lock(checked_vars->mutex);
+                auto it = checked_vars->vars.find(opt_key);
+                if (it != checked_vars->vars.end())
                     opt = it->second.get();
             }
             return opt;
@@ -907,14 +917,17 @@ namespace client
                 opt = ctx->config->option(key);
             if (opt == nullptr && ctx->external_config != nullptr)
                 opt = ctx->external_config->option(key);
-            if (opt == nullptr && (has_default_value || MyContext::checked_vars.find(key) == MyContext::checked_vars.end()) ) {
-                // set stub bool value only if a default() hasn't been called yet.
-                if (!has_default_value) {
-                    default_val.reset(new ConfigOptionBool(false));
+            if (opt == nullptr) {
+                std::lock_guard<std::mutex> lock(ctx->checked_vars->mutex);
+                if (has_default_value || ctx->checked_vars->vars.find(key) == ctx->checked_vars->vars.end()) {
+                    // set stub bool value only if a default() hasn't been called yet.
+                    if (!has_default_value) {
+                        default_val.reset(new ConfigOptionBool(false));
+                    }
+                    // set flag to say "it's a var that isn't here, please ignore it"
+                    default_val->flags |= ConfigOption::FCO_PLACEHOLDER_TEMP;
+                    ctx->checked_vars->vars[key] = std::move(default_val);
                 }
-                // set flag to say "it's a var that isn't here, please ignore it"
-                default_val->flags |= ConfigOption::FCO_PLACEHOLDER_TEMP;
-                MyContext::checked_vars[key] = std::move(default_val);
             }
             // return (wanted for exists() but not for default())
             if(!has_default_value)
@@ -1157,7 +1170,6 @@ namespace client
         { "variable_reference",         "Expecting a variable reference."},
         { "regular_expression",         "Expecting a regular expression."}
     };
-    std::map<t_config_option_key, std::unique_ptr<ConfigOption>> MyContext::checked_vars = {};
 
     // For debugging the boost::spirit parsers. Print out the string enclosed in it_range.
     template<typename Iterator>
@@ -1631,6 +1643,7 @@ std::string PlaceholderParser::process(const std::string &templ, unsigned int cu
     context.config_override     = config_override;
     context.current_extruder_id = current_extruder_id;
     context.context_data        = context_data;
+    context.checked_vars        = m_checked_vars.get();
     return process_macro(templ, context);
 }
 
@@ -1638,9 +1651,11 @@ std::string PlaceholderParser::process(const std::string &templ, unsigned int cu
 // Throws Slic3r::RuntimeError on syntax or runtime error.
 bool PlaceholderParser::evaluate_boolean_expression(const std::string &templ, const DynamicConfig &config, const DynamicConfig *config_override)
 {
+    CheckedVars       checked_vars;
     client::MyContext context;
     context.config              = &config;
     context.config_override     = config_override;
+    context.checked_vars        = &checked_vars;
     // Let the macro processor parse just a boolean expression, not the full macro language.
     context.just_boolean_expression = true;
     return process_macro(templ, context) == "true";
@@ -1773,7 +1788,8 @@ void PlaceholderParser::append_custom_variables(std::map<std::string, std::vecto
 
 void PlaceholderParser::reset()
 {
-    client::MyContext::checked_vars.clear();
+    // The copies of this parser keep the variables checked so far.
+    m_checked_vars = std::make_shared<CheckedVars>();
     m_config.clear();
 }
 
@@ -3,6 +3,7 @@
 
 #include "libslic3r.h"
 #include <map>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
@@ -21,6 +22,9 @@ public:
     struct ContextData {
         std::mt19937 rng;
     };
+    // Variables tested by exists() or given a default() by the templates, kept between the process() calls of a parser
+    // (and of its copies, until reset()).
+    struct CheckedVars;
 
     PlaceholderParser(const DynamicConfig *external_config = nullptr);
     
@@ -76,6 +80,7 @@ private:
 	// config has a higher priority than external_config when looking up a symbol.
     DynamicConfig 			 m_config;
     const DynamicConfig 	*m_external_config;
+    std::shared_ptr<CheckedVars> m_checked_vars;
 };
 
 }
@@ -765,6 +765,9 @@ static std::vector<std::string> s_Preset_machine_limits_options {
 static std::vector<std::string> s_Preset_printer_options {
     "printer_technology",
     "bed_shape", "bed_custom_texture", "bed_custom_model", "z_offset", "init_z_rotate",
+    "arc_fitting",
+    "arc_fitting_tolerance",
+    "binary_gcode",
     "fan_kickstart",
     "fan_speedup_overhangs",
     "fan_speedup_time",
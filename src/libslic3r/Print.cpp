@@ -21,12 +21,16 @@
 
 #include <algorithm>
 #include <limits>
+#include <mutex>
 #include <unordered_set>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/format.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/regex.hpp>
 
+#include <tbb/flow_graph.h>
+
 // Mark string for localization and translate.
 #define L(s) Slic3r::I18N::translate(s)
 
@@ -43,6 +47,7 @@ void Print::clear()
     std::scoped_lock<std::mutex> lock(this->state_mutex());
     // The following call should stop background processing if it is running.
     this->invalidate_all_steps();
+    m_layer_spill.clear();
 	for (PrintObject *object : m_objects)
 		delete object;
 	m_objects.clear();
@@ -60,6 +65,8 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver& /* ne
     // Cache the plenty of parameters, which influence the G-code generator only,
     // or they are only notes not influencing the generated G-code.
     static std::unordered_set<std::string> steps_gcode = {
+        "arc_fitting",
+        "arc_fitting_tolerance",
         "avoid_crossing_perimeters",
         "avoid_crossing_perimeters_max_detour",
         "avoid_crossing_not_first_layer",
@@ -68,6 +75,7 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver& /* ne
         "chamber_temperature",
         "before_layer_gcode",
         "between_objects_gcode",
+        "binary_gcode",
         "bridge_acceleration",
         "bridge_internal_acceleration",
         "bridge_fan_speed",
@@ -1034,17 +1042,43 @@ void Print::process()
     name_tbb_thread_pool_threads_set_locale();
     bool something_done = !is_step_done_unguarded(psSkirtBrim);
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
-    for (PrintObject *obj : m_objects)
-        obj->make_perimeters();
-    //note: as object seems to be sliced independantly, it's maybe possible to add a tbb parallel_loop with simple partitioner on infill,
-    //  as prepare_infill has some function not // 
-    for (PrintObject *obj : m_objects)
-        obj->infill();
-    for (PrintObject *obj : m_objects)
-        obj->ironing();
-	this->set_status(50, L("Generating support material"));
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_material();
+    {
+        // The steps of the objects are scheduled as a task graph, where a step only waits for the previous steps of its object:
+        // the support of an object is generated while the other objects are infilled, and the plates with many small objects
+        // (with too few layers to fill the thread pool from the parallel loops of a single object) keep all the cores busy.
+        //   make_perimeters -> infill -> ironing
+        //                             -> generate_support_material (it looks at the bridging infill)
+        // With a layer memory budget, the layers of an object are spilled (see LayerSpill) as soon as they are infilled, its support layers
+        // and the layers not infilled again once both its ironing and its support are done.
+        // An exception (cancelation, slicing error) stops the graph and is rethrown by wait_for_all().
+        using namespace tbb::flow;
+        graph                                                       object_steps;
+        std::vector<std::unique_ptr<continue_node<continue_msg>>>   nodes;
+        auto make_node = [&object_steps, &nodes](std::function<void()> step) {
+            nodes.emplace_back(std::make_unique<continue_node<continue_msg>>(object_steps, [step](const continue_msg&) { step(); return continue_msg(); }));
+            return nodes.back().get();
+        };
+        std::once_flag support_status;
+        for (PrintObject *obj : m_objects) {
+            continue_node<continue_msg> *perimeters = make_node([obj]() { obj->make_perimeters(); });
+            continue_node<continue_msg> *infill     = make_node([obj]() { obj->infill(); });
+            continue_node<continue_msg> *ironing    = make_node([obj]() { obj->ironing(); });
+            continue_node<continue_msg> *support    = make_node([this, obj, &support_status]() {
+                std::call_once(support_status, [this]() { this->set_status(50, L("Generating support material")); });
+                obj->generate_support_material();
+            });
+            make_edge(*perimeters, *infill);
+            make_edge(*infill, *ironing);
+            make_edge(*infill, *support);
+            if (m_layer_spill.enabled()) {
+                continue_node<continue_msg> *spill = make_node([this, obj]() { m_layer_spill.spill(*obj); });
+                make_edge(*ironing, *spill);
+                make_edge(*support, *spill);
+            }
+            perimeters->try_put(continue_msg());
+        }
+        object_steps.wait_for_all();
+    }
     if (this->set_started(psWipeTower)) {
         m_wipe_tower_data.clear();
         m_tool_ordering.clear();
@@ -1206,9 +1240,19 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
         message = L("Generating G-code");
     this->set_status(60, message);
 
-    // The following line may die for multiple reasons.
-    GCode gcode;
-    gcode.do_export(this, path.c_str(), result, thumbnail_cb);
+    // The grids of the lslices are released after each export, rebuild them if the G-code is exported again.
+    // With a layer memory budget, the G-code generation builds them layer by layer.
+    if (! m_layer_spill.enabled())
+        for (PrintObject *object : m_objects)
+            object->make_lslices_grids();
+    {
+        // The following line may die for multiple reasons.
+        GCode gcode;
+        gcode.do_export(this, path.c_str(), result, thumbnail_cb);
+    }
+    // Only the G-code export reads the grids of the lslices, free them until the next export.
+    for (PrintObject *object : m_objects)
+        object->clear_lslices_grids();
     return path.c_str();
 }
 
@@ -1247,6 +1291,7 @@ void Print::_make_skirt(const PrintObjectPtrs &objects, ExtrusionEntityCollectio
         for (const SupportLayer *layer : object->support_layers()) {
             if (layer->print_z > skirt_height_z)
                 break;
+            LayerSpill::Loader loader(layer);
             layer->support_fills.collect_points(object_points);
         }
         // if brim, it superseed object & support for first layer
@@ -1649,7 +1694,12 @@ std::string Print::output_filename(const std::string &filename_base) const
     // These values will be just propagated into the output file name.
     DynamicConfig config = this->finished() ? this->print_statistics().config() : this->print_statistics().placeholders();
     config.set_key_value("num_extruders", new ConfigOptionInt((int)m_config.nozzle_diameter.size()));
-    return this->PrintBase::output_filename(m_config.output_filename_format.value, ".gcode", filename_base, &config);
+    std::string filename = this->PrintBase::output_filename(m_config.output_filename_format.value, m_config.binary_gcode.value ? ".ssbg" : ".gcode", filename_base, &config);
+    // A binary G-code isn't readable by the tools expecting a text G-code, nor by the ones reading the .bgcode of other slicers:
+    // it gets its own extension.
+    if (m_config.binary_gcode.value && boost::iends_with(filename, ".gcode"))
+        filename.replace(filename.size() - 6, 6, ".ssbg");
+    return filename;
 }
 
 DynamicConfig PrintStatistics::config() const
@@ -14,6 +14,7 @@
 #include "GCode/WipeTower.hpp"
 #include "GCode/ThumbnailData.hpp"
 #include "GCode/GCodeProcessor.hpp"
+#include "LayerSpill.hpp"
 #include "MultiMaterialSegmentation.hpp"
 
 #include "libslic3r.h"
@@ -244,6 +245,15 @@ private:
     size_t                                      m_ref_cnt{ 0 };
 };
 
+// Index to slice a model volume, kept by its PrintObject to slice it again quickly if only the layer heights change.
+struct ModelVolumeSlicingIndex
+{
+    ObjectID                                volume_id;
+    // Mesh the index was built for, the transformation is stored by the index.
+    std::weak_ptr<const TriangleMesh>       mesh;
+    std::shared_ptr<const MeshSlicingIndex> index;
+};
+
 class PrintObject : public PrintObjectBaseWithState<Print, PrintObjectStep, posCount>
 {
 private: // Prevents erroneous use by other classes.
@@ -322,6 +332,11 @@ public:
     //FIXME returing all possible regions before slicing, thus some of the regions may not be slicing at the end.
     std::vector<std::reference_wrapper<const PrintRegion>> all_regions() const;
     const PrintObjectRegions*   shared_regions() const throw() { return m_shared_regions; }
+    // Index kept to slice a model volume again, null if the volume was not sliced yet.
+    std::shared_ptr<const MeshSlicingIndex> volume_slicing_index(const ObjectID volume_id) const {
+        auto it = std::find_if(m_volume_slicing_indices.begin(), m_volume_slicing_indices.end(), [volume_id](const ModelVolumeSlicingIndex &si) { return si.volume_id == volume_id; });
+        return it == m_volume_slicing_indices.end() ? nullptr : it->index;
+    }
 
     bool                        has_support()           const { return m_config.support_material || m_config.support_material_enforce_layers > 0; }
     bool                        has_raft()              const { return m_config.raft_layers > 0; }
@@ -365,8 +380,13 @@ protected:
     bool                    invalidate_all_steps();
     // Invalidate steps based on a set of parameters changed.
     // It may be called for both the PrintObjectConfig and PrintRegionConfig.
+    // If z_range is set, the parameters only apply to the layers with their slice_z inside it (a modifier or a layer range):
+    // if only the infill has to be redone, only these layers are filled again.
     bool                    invalidate_state_by_config_options(
-        const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
+        const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys,
+        const t_layer_height_range *z_range = nullptr);
+    // Invalidates posInfill, keeping the infill of the layers outside of z_range if it was computed.
+    bool                    invalidate_infill_in_range(const t_layer_height_range &z_range);
     // If ! m_slicing_params.valid, recalculate.
     void                    update_slicing_parameters();
 
@@ -376,8 +396,13 @@ private:
     void make_perimeters();
     void prepare_infill();
     void infill();
+    // Layers to process by infill() & ironing(): all of them, or only the ones inside m_infill_dirty_ranges.
+    LayerPtrs infill_dirty_layers() const;
     void ironing();
     void generate_support_material();
+    // Edge grids of the lslices of the layers (Layer::lslices_grid()), built in parallel for the layers missing one.
+    void make_lslices_grids();
+    void clear_lslices_grids();
 
     void slice_volumes();
     // Has any support (not counting the raft).
@@ -411,9 +436,14 @@ private:
     // Object split into layer ranges and regions with their associated configurations.
     // Shared among PrintObjects created for the same ModelObject.
     PrintObjectRegions                     *m_shared_regions { nullptr };
+    // Model volumes indexed for slicing by slice_volumes().
+    std::vector<ModelVolumeSlicingIndex>    m_volume_slicing_indices;
 
     SlicingParameters                       m_slicing_params;
     LayerPtrs                               m_layers;
+    // Z ranges (slice_z) where posInfill was invalidated by invalidate_infill_in_range(), the other layers keep their infill.
+    // Empty if the infill of all the layers has to be computed. Cleared once posIroning is done.
+    std::vector<t_layer_height_range>       m_infill_dirty_ranges;
     SupportLayerPtrs                        m_support_layers;
 
     // Ordered collections of extrusion paths to build skirt loops and brim.
@@ -570,6 +600,18 @@ public:
     std::vector<ObjectID> print_object_ids() const override;
 
     ApplyStatus         apply(const Model &model, DynamicPrintConfig config) override;
+    // Slice the ModelObjects with the same volumes and configs (the same part loaded from several files) only once:
+    // their instances are then all printed by the PrintObjects of the first of them.
+    // Only the PrintInstances refer to their own ModelObject then, thus it's not enabled by the GUI.
+    void                set_merge_identical_objects(bool merge) { m_merge_identical_objects = merge; }
+    // Keep at most this many bytes of the extrusions of the finished layers in memory, write the others into a scratch file
+    // until they are exported (see LayerSpill). 0 (default) keeps all the layers in memory. Not for the GUI: the preview reads the layers.
+    void                set_layer_memory_budget(size_t bytes) { m_layer_spill.set_budget(bytes); }
+    LayerSpill&         layer_spill() const { return m_layer_spill; }
+    // Generate the G-code into a scratch file in the temporary directory, so that the output file is written only once,
+    // when the time estimates are inserted (see GCodeProcessor::TimeProcessor::post_process()).
+    void                set_gcode_spool(bool spool) { m_gcode_spool = spool; }
+    bool                gcode_spool() const { return m_gcode_spool; }
 
     void                process() override;
     // Exports G-code into a file name based on the path_template, returns the file path of the generated G-code file.
@@ -678,6 +720,12 @@ private:
     PrintRegionConfig                       m_default_region_config;
     PrintObjectPtrs                         m_objects;
     PrintRegionPtrs                         m_print_regions;
+    // See set_merge_identical_objects().
+    bool                                    m_merge_identical_objects { false };
+    // See set_layer_memory_budget(). Mutable, as the layers are paged in while the G-code is exported from a const Print.
+    mutable LayerSpill                      m_layer_spill;
+    // See set_gcode_spool().
+    bool                                    m_gcode_spool { false };
 
     // Ordered collections of extrusion paths to build skirt loops and brim.
     std::optional<ExtrusionEntityCollection> m_skirt_first_layer;
@@ -3,6 +3,8 @@
 
 #include <cfloat>
 
+#include <boost/functional/hash.hpp>
+
 namespace Slic3r {
 
 // Add or remove support modifier ModelVolumes from model_object_dst to match the ModelVolumes of model_object_new
@@ -129,25 +131,77 @@ struct PrintObjectTrafoAndInstances
     bool operator<(const PrintObjectTrafoAndInstances &rhs) const { return transform3d_lower(this->trafo, rhs.trafo); }
 };
 
-// Generate a list of trafos and XY offsets for instances of a ModelObject
-static std::vector<PrintObjectTrafoAndInstances> print_objects_from_model_object(const ModelObject &model_object)
+// Generate a list of trafos and XY offsets for instances of a ModelObject,
+// and of the ModelObjects identical to it (see model_objects_print_identical()).
+static std::vector<PrintObjectTrafoAndInstances> print_objects_from_model_object(const ModelObject &model_object, const std::vector<const ModelObject*> &identical_model_objects = {})
 {
     std::set<PrintObjectTrafoAndInstances> trafos;
     PrintObjectTrafoAndInstances           trafo;
-    for (ModelInstance *model_instance : model_object.instances)
-        if (model_instance->is_printable()) {
-            trafo.trafo = model_instance->get_matrix();
-            auto shift = Point::new_scale(trafo.trafo.data()[12], trafo.trafo.data()[13]);
-            // Reset the XY axes of the transformation.
-            trafo.trafo.data()[12] = 0;
-            trafo.trafo.data()[13] = 0;
-            // Search or insert a trafo.
-            auto it = trafos.emplace(trafo).first;
-            const_cast<PrintObjectTrafoAndInstances&>(*it).instances.emplace_back(PrintInstance{ nullptr, model_instance, shift });
-        }
+    auto add_instances = [&trafos, &trafo](const ModelObject &model_object) {
+        for (ModelInstance *model_instance : model_object.instances)
+            if (model_instance->is_printable()) {
+                trafo.trafo = model_instance->get_matrix();
+                auto shift = Point::new_scale(trafo.trafo.data()[12], trafo.trafo.data()[13]);
+                // Reset the XY axes of the transformation.
+                trafo.trafo.data()[12] = 0;
+                trafo.trafo.data()[13] = 0;
+                // Search or insert a trafo.
+                auto it = trafos.emplace(trafo).first;
+                const_cast<PrintObjectTrafoAndInstances&>(*it).instances.emplace_back(PrintInstance{ nullptr, model_instance, shift });
+            }
+    };
+    add_instances(model_object);
+    for (const ModelObject *identical : identical_model_objects)
+        add_instances(*identical);
     return std::vector<PrintObjectTrafoAndInstances>(trafos.begin(), trafos.end());
 }
 
+// Cheap hash of what makes a ModelObject print, to find the candidates for model_objects_print_identical().
+static size_t model_object_print_hash(const ModelObject &model_object)
+{
+    size_t seed = model_object.volumes.size();
+    for (const ModelVolume *model_volume : model_object.volumes) {
+        const indexed_triangle_set &its = model_volume->mesh().its;
+        boost::hash_combine(seed, int(model_volume->type()));
+        boost::hash_combine(seed, its.vertices.size());
+        boost::hash_combine(seed, its.indices.size());
+        // A few vertices.
+        for (size_t i = 0; i < its.vertices.size(); i += std::max<size_t>(1, its.vertices.size() / 16))
+            for (int axis = 0; axis < 3; ++ axis)
+                boost::hash_combine(seed, its.vertices[i](axis));
+    }
+    return seed;
+}
+
+// Do the two ModelObjects produce the same PrintObjects for the same instance transformation?
+// They have to have the same volumes (meshes, transformations, configs and paintings), configs and layer heights.
+static bool model_objects_print_identical(const ModelObject &mo1, const ModelObject &mo2)
+{
+    if (mo1.volumes.size() != mo2.volumes.size() ||
+        ! (mo1.config.get() == mo2.config.get()) ||
+        mo1.layer_height_profile.get() != mo2.layer_height_profile.get() ||
+        mo1.layer_config_ranges.size() != mo2.layer_config_ranges.size())
+        return false;
+    for (auto it1 = mo1.layer_config_ranges.begin(), it2 = mo2.layer_config_ranges.begin(); it1 != mo1.layer_config_ranges.end(); ++ it1, ++ it2)
+        if (it1->first != it2->first || ! (it1->second.get() == it2->second.get()))
+            return false;
+    for (size_t i = 0; i < mo1.volumes.size(); ++ i) {
+        const ModelVolume &mv1 = *mo1.volumes[i];
+        const ModelVolume &mv2 = *mo2.volumes[i];
+        if (mv1.type() != mv2.type() ||
+            ! transform3d_equal(mv1.get_matrix(), mv2.get_matrix()) ||
+            ! (mv1.config.get() == mv2.config.get()) ||
+            mv1.supported_facets.get_data() != mv2.supported_facets.get_data() ||
+            mv1.seam_facets.get_data() != mv2.seam_facets.get_data() ||
+            mv1.mmu_segmentation_facets.get_data() != mv2.mmu_segmentation_facets.get_data())
+            return false;
+        if (mv1.get_mesh_shared_ptr() != mv2.get_mesh_shared_ptr() &&
+            (mv1.mesh().its.vertices != mv2.mesh().its.vertices || mv1.mesh().its.indices != mv2.mesh().its.indices))
+            return false;
+    }
+    return true;
+}
+
 // Compare just the layer ranges and their layer heights, not the associated configs.
 // Ignore the layer heights if check_layer_heights is false.
 static bool layer_height_ranges_equal(const t_layer_config_ranges &lr1, const t_layer_config_ranges &lr2, bool check_layer_height)
@@ -640,8 +694,40 @@ void print_region_ref_inc(PrintRegion &r) { ++ r.m_ref_cnt; }
 void print_region_ref_reset(PrintRegion &r) { r.m_ref_cnt = 0; }
 int  print_region_ref_cnt(const PrintRegion &r) { return r.m_ref_cnt; }
 
+// Z range (in the slice_z coordinates of the PrintObject) where a PrintRegion is used:
+// the layer ranges referencing it, clipped by the Z extents of the ModelVolumes producing it.
+// Returns an empty range (first > second) if the region isn't used.
+static t_layer_height_range print_region_z_extents(const PrintObjectRegions &print_object_regions, const PrintRegion &print_region)
+{
+    t_layer_height_range out { DBL_MAX, -DBL_MAX };
+    std::vector<std::pair<const ModelVolume*, BoundingBoxf3>> volume_bboxes;
+    auto extend = [&print_object_regions, &volume_bboxes, &out](const t_layer_height_range &layer_height_range, const ModelVolume &model_volume) {
+        auto it = std::find_if(volume_bboxes.begin(), volume_bboxes.end(), [&model_volume](const auto &l) { return l.first == &model_volume; });
+        if (it == volume_bboxes.end()) {
+            volume_bboxes.emplace_back(&model_volume, model_volume.mesh().transformed_bounding_box(print_object_regions.trafo_bboxes * model_volume.get_matrix(false)));
+            it = volume_bboxes.end() - 1;
+        }
+        const double lo = std::max(layer_height_range.first,  it->second.min.z());
+        const double hi = std::min(layer_height_range.second, it->second.max.z());
+        if (lo <= hi) {
+            out.first  = std::min(out.first, lo);
+            out.second = std::max(out.second, hi);
+        }
+    };
+    for (const PrintObjectRegions::LayerRangeRegions &layer_range : print_object_regions.layer_ranges) {
+        for (const PrintObjectRegions::VolumeRegion &region : layer_range.volume_regions)
+            if (region.region == &print_region)
+                extend(layer_range.layer_height_range, *region.model_volume);
+        for (const PrintObjectRegions::PaintedRegion &region : layer_range.painted_regions)
+            if (region.region == &print_region)
+                extend(layer_range.layer_height_range, *layer_range.volume_regions[region.parent].model_volume);
+    }
+    return out;
+}
+
 // Verify whether the PrintRegions of a PrintObject are still valid, possibly after updating the region configs.
-// Before region configs are updated, callback_invalidate() is called to possibly stop background processing.
+// Before region configs are updated, callback_invalidate() is called to possibly stop background processing,
+// with the Z range where the region is used.
 // Returns false if this object needs to be resliced because regions were merged or split.
 bool verify_update_print_object_regions(
     ModelVolumePtrs                     model_volumes,
@@ -649,7 +735,7 @@ bool verify_update_print_object_regions(
     size_t                              num_extruders,
     const std::vector<unsigned int>    &painting_extruders,
     PrintObjectRegions                 &print_object_regions,
-    const std::function<void(const PrintRegionConfig&, const PrintRegionConfig&, const t_config_option_keys&)> &callback_invalidate)
+    const std::function<void(const PrintRegionConfig&, const PrintRegionConfig&, const t_config_option_keys&, const t_layer_height_range&)> &callback_invalidate)
 {
     // Sort by ModelVolume ID.
     model_volumes_sort_by_id(model_volumes);
@@ -710,7 +796,7 @@ bool verify_update_print_object_regions(
                         // Region is referenced for the first time. Just change its parameters.
                         // Stop the background process before assigning new configuration to the regions.
                         t_config_option_keys diff = region.region->config().diff(cfg);
-                        callback_invalidate(region.region->config(), cfg, diff);
+                        callback_invalidate(region.region->config(), cfg, diff, print_region_z_extents(print_object_regions, *region.region));
                         region.region->config_apply_only(cfg, diff, false);
                     } else {
                         // Region is referenced multiple times, thus the region is being split. We need to reslice.
@@ -735,7 +821,7 @@ bool verify_update_print_object_regions(
                     // Region is referenced for the first time. Just change its parameters.
                     // Stop the background process before assigning new configuration to the regions.
                     t_config_option_keys diff = region.region->config().diff(cfg);
-                    callback_invalidate(region.region->config(), cfg, diff);
+                    callback_invalidate(region.region->config(), cfg, diff, print_region_z_extents(print_object_regions, *region.region));
                     region.region->config_apply_only(cfg, diff, false);
                 } else {
                     // Region is referenced multiple times, thus the region is being split. We need to reslice.
@@ -967,6 +1053,9 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
     check_model_ids_validity(model);
 #endif /* _DEBUG */
 
+    // The layers spilled to the scratch file may be modified or deleted now.
+    m_layer_spill.restore();
+
     // Normalize the config.
 	new_full_config.option("print_settings_id",            true);
 	new_full_config.option("filament_settings_id",         true);
@@ -1264,10 +1353,33 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
         PrintObjectPtrs print_objects_new;
         print_objects_new.reserve(std::max(m_objects.size(), m_model.objects.size()));
         bool new_objects = false;
+        // ModelObjects printed by the PrintObjects of the first ModelObject identical to them, indexed by this first ModelObject.
+        std::map<const ModelObject*, std::vector<const ModelObject*>> identical_model_objects;
+        std::set<const ModelObject*>                                  merged_model_objects;
+        if (m_merge_identical_objects) {
+            std::multimap<size_t, const ModelObject*> by_hash;
+            for (const ModelObject *model_object : m_model.objects) {
+                const size_t hash = model_object_print_hash(*model_object);
+                auto range = by_hash.equal_range(hash);
+                auto it = std::find_if(range.first, range.second, [model_object](const auto &kvp) { return model_objects_print_identical(*kvp.second, *model_object); });
+                if (it == range.second) {
+                    by_hash.emplace(hash, model_object);
+                } else {
+                    identical_model_objects[it->second].emplace_back(model_object);
+                    merged_model_objects.insert(model_object);
+                }
+            }
+        }
         // Walk over all new model objects and check, whether there are matching PrintObjects.
         for (ModelObject *model_object : m_model.objects) {
+            if (merged_model_objects.count(model_object))
+                // Printed by the PrintObjects of an identical ModelObject.
+                continue;
             ModelObjectStatus &model_object_status = const_cast<ModelObjectStatus&>(model_object_status_db.reuse(*model_object));
-            model_object_status.print_instances    = print_objects_from_model_object(*model_object);
+            if (auto it = identical_model_objects.find(model_object); it != identical_model_objects.end())
+                model_object_status.print_instances = print_objects_from_model_object(*model_object, it->second);
+            else
+                model_object_status.print_instances = print_objects_from_model_object(*model_object);
             std::vector<const PrintObjectStatus*> old;
             old.reserve(print_object_status_db.count(*model_object));
             for (const PrintObjectStatus &print_object_status : print_object_status_db.get_range(*model_object))
@@ -1384,10 +1496,11 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
                     num_extruders,
                     painting_extruders,
                     *print_object_regions,
-                    [it_print_object, it_print_object_end, &update_apply_status](const PrintRegionConfig &old_config, const PrintRegionConfig &new_config, const t_config_option_keys &diff_keys) {
+                    [it_print_object, it_print_object_end, &update_apply_status](const PrintRegionConfig &old_config, const PrintRegionConfig &new_config, const t_config_option_keys &diff_keys, const t_layer_height_range &z_range) {
                         for (auto it = it_print_object; it != it_print_object_end; ++it)
                             if ((*it)->m_shared_regions != nullptr)
-                                update_apply_status((*it)->invalidate_state_by_config_options(old_config, new_config, diff_keys));
+                                update_apply_status((*it)->invalidate_state_by_config_options(old_config, new_config, diff_keys,
+                                    z_range.first <= z_range.second ? &z_range : nullptr));
                     })) {
                 // Regions are valid, just keep them.
             } else {
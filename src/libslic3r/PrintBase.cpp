@@ -166,6 +166,11 @@ std::function<void()> PrintObjectBase::cancel_callback(PrintBase *print)
 	return print->cancel_callback();
 }
 
+void PrintObjectBase::step_event(PrintBase *print, int step, bool started) const
+{
+    print->step_event(step, started, this);
+}
+
 void PrintObjectBase::status_update_warnings(PrintBase *print, int step, PrintStateBase::WarningLevel warning_level, const std::string &message)
 {
     print->status_update_warnings(step, warning_level, message, this);
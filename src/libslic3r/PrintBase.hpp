@@ -312,6 +312,8 @@ protected:
     // Declared here to allow access from PrintBase through friendship.
 	static std::mutex&                  state_mutex(PrintBase *print);
 	static std::function<void()>        cancel_callback(PrintBase *print);
+	// Notify the step callback registered on print that a step of this PrintObjectBase was started or done.
+	void								step_event(PrintBase *print, int step, bool started) const;
 	// Notify UI about a new warning of a milestone "step" on this PrintObjectBase.
 	// The UI will be notified by calling a status callback registered on print.
 	// If no status callback is registered, the message is printed to console.
@@ -466,6 +468,12 @@ public:
         else printf("%d => %s\n", percent, message.c_str());
     }
 
+    // Called when a step of this print or of one of its objects is started (started == true) or done,
+    // with the PrintStep / PrintObjectStep (or their SLA counterparts) cast to int.
+    // print_object is null for the steps of the print itself. Used to profile the steps (see tests/bench).
+    typedef std::function<void(int step, const PrintObjectBase *print_object, bool started)> step_callback_type;
+    void                    set_step_callback(step_callback_type cb) { m_step_callback = cb; }
+
     typedef std::function<void()>  cancel_callback_type;
     // Various methods will call this callback to stop the background processing (the Print::process() call)
     // in case a successive change of the Print / PrintObject / PrintRegion instances changed
@@ -516,6 +524,9 @@ protected:
 	// The UI will be notified by calling a status callback.
 	// If no status callback is registered, the message is printed to console.
     void 				   status_update_warnings(int step, PrintStateBase::WarningLevel warning_level, const std::string &message, const PrintObjectBase* print_object = nullptr);
+    // Call the registered step callback, if any.
+    void                   step_event(int step, bool started, const PrintObjectBase *print_object = nullptr) const
+        { if (m_step_callback) m_step_callback(step, print_object, started); }
 
     // Wrapper around this->throw_if_canceled(), so that throw_if_canceled() may be passed to a function without making throw_if_canceled() public.
     PrintTryCancel         make_try_cancel() const { return PrintTryCancel(this); }
@@ -532,6 +543,8 @@ protected:
 
     // Callback to be evoked regularly to update state of the UI thread.
     status_callback_type                    m_status_callback;
+    // Callback to be evoked when a step is started or done.
+    step_callback_type                      m_step_callback;
 
     //for gui status update
     inline static std::chrono::time_point<std::chrono::system_clock>
@@ -561,9 +574,15 @@ public:
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintStepEnum step) const { return m_state.state_with_warnings(step, this->state_mutex()); }
 
 protected:
-    bool            set_started(PrintStepEnum step) { return m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); }); }
+    bool            set_started(PrintStepEnum step) {
+        bool started = m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); });
+        if (started)
+            this->step_event(static_cast<int>(step), true);
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintStepEnum step) { 
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, this->state_mutex(), [this](){ this->throw_if_canceled(); });
+        this->step_event(static_cast<int>(step), false);
         if (status.second)
             this->status_update_warnings(static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
         return status.first;
@@ -609,10 +628,15 @@ public:
 protected:
 	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) {}
 
-    bool            set_started(PrintObjectStepEnum step) 
-        { return m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); }); }
+    bool            set_started(PrintObjectStepEnum step) {
+        bool started = m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        if (started)
+            this->step_event(m_print, static_cast<int>(step), true);
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintObjectStepEnum step) { 
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        this->step_event(m_print, static_cast<int>(step), false);
         if (status.second)
             this->status_update_warnings(m_print, static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
         return status.first;
@@ -563,6 +563,25 @@ void PrintConfigDef::init_fff_params()
     def->mode = comExpert | comSuSi;
     def->set_default_value(new ConfigOptionBool(false));
 
+    def = this->add("arc_fitting", coBool);
+    def->label = L("Arc fitting");
+    def->category = OptionCategory::firmware;
+    def->tooltip = L("Replace the runs of small G1 extrusions that lie on a circle (curved perimeters, holes) by G2/G3 arcs."
+        " It greatly reduces the G-code size and the number of commands the firmware has to process."
+        "\nYour firmware must support arcs (ARC_SUPPORT in Marlin, [gcode_arcs] in Klipper)."
+        "\nSee 'Arc fitting tolerance' for the precision.");
+    def->mode = comExpert | comSuSi;
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("arc_fitting_tolerance", coFloat);
+    def->label = L("Arc fitting tolerance");
+    def->category = OptionCategory::firmware;
+    def->tooltip = L("Maximum distance between the original path and the arc that replaces it.");
+    def->sidetext = L("mm");
+    def->min = 0.001;
+    def->mode = comExpert | comSuSi;
+    def->set_default_value(new ConfigOptionFloat(0.05));
+
     def = this->add("avoid_crossing_perimeters", coBool);
     def->label = L("Avoid crossing perimeters");
     def->category = OptionCategory::perimeter;
@@ -628,6 +647,17 @@ void PrintConfigDef::init_fff_params()
     def->mode = comExpert | comPrusa;
     def->set_default_value(new ConfigOptionString(""));
 
+    def = this->add("binary_gcode", coBool);
+    def->label = L("Binary G-code (experimental)");
+    def->category = OptionCategory::firmware;
+    def->tooltip = L("Experimental: write the G-code as a compressed binary file (.ssbg) instead of a text file."
+        " This is an internal Slic3r container (see doc/Binary G-code format.md), not the binary G-code (.bgcode) of other slicers:"
+        " nothing downstream reads it, no firmware and no print host, so it doesn't make the transfer to the printer any faster."
+        " Only Slic3r reads it back (G-code viewer, loading the configuration back)."
+        "\nThe post-processing scripts receive the binary file.");
+    def->mode = comExpert | comSuSi;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("bottom_solid_layers", coInt);
     //TRN To be shown in Print Settings "Bottom solid layers"
     def->label = L("Bottom");
@@ -7105,7 +7135,10 @@ void ModelConfig::convert_from_prusa(const DynamicPrintConfig& global_config) {
 
 std::unordered_set<std::string> prusa_export_to_remove_keys = {
 "allow_empty_layers",
+"arc_fitting",
+"arc_fitting_tolerance",
 "avoid_crossing_not_first_layer",
+"binary_gcode",
 "bridge_internal_acceleration",
 "bridge_internal_fan_speed",
 "bridge_overlap",
@@ -8504,6 +8537,43 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->label = L("Data directory");
     def->tooltip = L("Load and store settings at the given directory. This is useful for maintaining different profiles or including configurations from a network storage.");
 
+    def = this->add("slicing_cache", coString);
+    def->label = L("Slicing cache directory");
+    def->tooltip = L("Store the slices of the objects in the given directory, to reuse them when the same objects are sliced again "
+                     "with the same transformation, layer heights and slicing parameters. The directory isn't cleaned, it grows with each new object.");
+
+    def = this->add("sla_archive_memory", coInt);
+    def->label = L("SLA archive memory");
+    def->tooltip = L("Memory budget (MB) of the layers of the SLA archive being rasterized, encoded and compressed in parallel. "
+                     "The layers are rasterized while the archive is written instead of being all kept in memory until the export. "
+                     "0 keeps all the rasterized layers in memory.");
+    def->sidetext = L("MB");
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(1024));
+
+    def = this->add("layer_memory", coInt);
+    def->label = L("Layer memory");
+    def->tooltip = L("Memory budget (MB) of the extrusions of the sliced layers waiting for the G-code export. "
+                     "The layers over the budget are written into a scratch file in the temporary directory and read back when they are exported, "
+                     "to slice the prints too big for the memory. 0 keeps all the layers in memory.");
+    def->sidetext = L("MB");
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("gcode_spool", coBool);
+    def->label = L("Spool the G-code");
+    def->tooltip = L("Generate the G-code into a scratch file in the temporary directory, and write the output file only once, "
+                     "when the remaining times and the estimated printing time are inserted. "
+                     "Otherwise the output file is written, read back and written again, which is slow on a network share.");
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("plates", coBool);
+    def->label = L("Plates");
+    def->tooltip = L("Arrange the objects over as many beds as needed instead of failing when they don't fit on one bed, "
+                     "then slice all the plates concurrently, each one into its own output file suffixed with its number. "
+                     "The meshes and the configuration are loaded once for all the plates.");
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("loglevel", coInt);
     def->label = L("Logging level");
     def->tooltip = L("Sets logging sensitivity. 0:fatal, 1:error, 2:warning, 3:info, 4:debug, 5:trace\n"
@@ -390,9 +390,38 @@ std::vector<std::reference_wrapper<const PrintRegion>> PrintObject::all_regions(
             BOOST_LOG_TRIVIAL(debug) << "Generating milling post-process in parallel - end";
         }
 
+        // The G-code export queries the lslices of the layers for the seams and the travels, it's cheaper to build their grids here in parallel
+        // than in the serial G-code generation. Not with a layer memory budget: the G-code generation then builds the grids
+        // of the layers it is printing only.
+        if (! m_print->layer_spill().enabled())
+            this->make_lslices_grids();
+
         this->set_done(posPerimeters);
     }
 
+    void PrintObject::make_lslices_grids()
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Generating the lslices edge grids in parallel - start";
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_layers.size()),
+            [this](const tbb::blocked_range<size_t>& range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+                m_print->throw_if_canceled();
+                if (m_layers[layer_idx]->lslices_grid() == nullptr)
+                    m_layers[layer_idx]->make_lslices_grid();
+            }
+        }
+        );
+        m_print->throw_if_canceled();
+        BOOST_LOG_TRIVIAL(debug) << "Generating the lslices edge grids in parallel - end";
+    }
+
+    void PrintObject::clear_lslices_grids()
+    {
+        for (Layer *layer : m_layers)
+            layer->clear_lslices_grid();
+    }
+
     void PrintObject::prepare_infill()
     {
         if (!this->set_started(posPrepareInfill))
@@ -553,25 +582,30 @@ std::vector<std::reference_wrapper<const PrintRegion>> PrintObject::all_regions(
         m_print->set_status(0, L("Infilling layer %s / %s"), { std::to_string(0), std::to_string(m_layers.size()) }, PrintBase::SlicingStatus::SECONDARY_STATE);
         if (this->set_started(posInfill)) {
             auto [adaptive_fill_octree, support_fill_octree] = this->prepare_adaptive_infill_data();
+            // only the layers modified since the last call if the infill was invalidated by invalidate_infill_in_range()
+            const LayerPtrs layers = this->infill_dirty_layers();
 
             // atomic counter for gui progress
             std::atomic<int> atomic_count{ 0 };
-            int nb_layers_update = std::max(1, (int)m_layers.size() / 20);
+            int nb_layers_update = std::max(1, (int)layers.size() / 20);
 
-            BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start";
+            BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start (" << layers.size() << " / " << m_layers.size() << " layers)";
             tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, m_layers.size()),
-                [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree, &atomic_count, nb_layers_update](const tbb::blocked_range<size_t>& range) {
+                tbb::blocked_range<size_t>(0, layers.size()),
+                [this, &layers, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree, &atomic_count, nb_layers_update](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                     std::chrono::time_point<std::chrono::system_clock> start_make_fill = std::chrono::system_clock::now();
                     m_print->throw_if_canceled();
-                    m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get());
+                    layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get());
+                    // With a layer memory budget, the extrusions of the layer are done: spill them right away,
+                    // the support generation pages them in to look for the bridges.
+                    m_print->layer_spill().spill(*layers[layer_idx]);
 
                     // updating progress
                     int nb_layers_done = (++atomic_count);
                     std::chrono::time_point<std::chrono::system_clock> end_make_fill = std::chrono::system_clock::now();
                     if (nb_layers_done % nb_layers_update == 0 || (static_cast<std::chrono::duration<double>>(end_make_fill - start_make_fill)).count() > 5) {
-                        m_print->set_status( int((nb_layers_done * 100) / m_layers.size()), L("Infilling layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(m_layers.size()) }, PrintBase::SlicingStatus::SECONDARY_STATE);
+                        m_print->set_status( int((nb_layers_done * 100) / layers.size()), L("Infilling layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(layers.size()) }, PrintBase::SlicingStatus::SECONDARY_STATE);
                     }
                 }
             }
@@ -593,19 +627,22 @@ std::vector<std::reference_wrapper<const PrintRegion>> PrintObject::all_regions(
     void PrintObject::ironing()
     {
         if (this->set_started(posIroning)) {
+            // same layers as the ones filled by infill(), as make_fills() clears the ironing.
+            const LayerPtrs layers = this->infill_dirty_layers();
             BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
             tbb::parallel_for(
             // Ironing starting with layer 0 to support ironing all surfaces.
-            tbb::blocked_range<size_t>(0, m_layers.size()),
-                [this](const tbb::blocked_range<size_t>& range) {
+            tbb::blocked_range<size_t>(0, layers.size()),
+                [this, &layers](const tbb::blocked_range<size_t>& range) {
                     for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                         m_print->throw_if_canceled();
-                        m_layers[layer_idx]->make_ironing();
+                        layers[layer_idx]->make_ironing();
                     }
                 }
             );
             m_print->throw_if_canceled();
             BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - end";
+            m_infill_dirty_ranges.clear();
             this->set_done(posIroning);
         }
     }
@@ -703,7 +740,8 @@ SupportLayerPtrs::iterator PrintObject::insert_support_layer(SupportLayerPtrs::c
     // Called by Print::apply().
     // This method only accepts PrintObjectConfig and PrintRegionConfig option keys.
 bool PrintObject::invalidate_state_by_config_options(
-    const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys)
+    const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys,
+    const t_layer_height_range *z_range)
     {
         if (opt_keys.empty())
             return false;
@@ -974,15 +1012,52 @@ bool PrintObject::invalidate_state_by_config_options(
         }
 
         sort_remove_duplicates(steps);
-        for (PrintObjectStep step : steps)
-            invalidated |= this->invalidate_step(step);
+        if (z_range != nullptr && steps.size() == 1 && steps.front() == posInfill) {
+            // Only the infill of some layers has to be recomputed (fill pattern changed by a modifier...).
+            invalidated |= this->invalidate_infill_in_range(*z_range);
+        } else {
+            for (PrintObjectStep step : steps)
+                invalidated |= this->invalidate_step(step);
+        }
+        return invalidated;
+    }
+
+    bool PrintObject::invalidate_infill_in_range(const t_layer_height_range &z_range)
+    {
+        // The infill of the other layers can only be kept if it was computed, or if it's already waiting for a partial update.
+        bool partial = ! m_infill_dirty_ranges.empty() || this->is_step_done_unguarded(posInfill);
+        std::vector<t_layer_height_range> dirty_ranges = std::move(m_infill_dirty_ranges);
+        bool invalidated = this->invalidate_step(posInfill);
+        if (partial) {
+            m_infill_dirty_ranges = std::move(dirty_ranges);
+            m_infill_dirty_ranges.push_back(z_range);
+        }
         return invalidated;
     }
 
+    LayerPtrs PrintObject::infill_dirty_layers() const
+    {
+        if (m_infill_dirty_ranges.empty())
+            return m_layers;
+        LayerPtrs layers;
+        for (Layer *layer : m_layers)
+            if (std::any_of(m_infill_dirty_ranges.begin(), m_infill_dirty_ranges.end(), [layer](const t_layer_height_range &range) {
+                    return layer->slice_z > range.first - EPSILON && layer->slice_z < range.second + EPSILON; }))
+                layers.push_back(layer);
+        return layers;
+    }
+
     bool PrintObject::invalidate_step(PrintObjectStep step)
     {
         bool invalidated = Inherited::invalidate_step(step);
 
+        // the infill of all the layers is invalidated
+        if (step == posSlice || step == posPerimeters || step == posPrepareInfill || step == posInfill)
+            m_infill_dirty_ranges.clear();
+        // the lslices grids are rebuilt with the perimeters
+        if (step == posSlice || step == posPerimeters)
+            this->clear_lslices_grids();
+
         // propagate to dependent steps
         if (step == posPerimeters) {
             invalidated |= this->invalidate_steps({ posPrepareInfill, posInfill, posIroning });
@@ -1016,6 +1091,7 @@ bool PrintObject::invalidate_state_by_config_options(
         bool result = Inherited::invalidate_all_steps() | m_print->invalidate_all_steps();
         // Then reset some of the depending values.
         m_slicing_params.valid = false;
+        m_infill_dirty_ranges.clear();
         return result;
     }
 
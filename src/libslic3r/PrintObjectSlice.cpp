@@ -4,6 +4,7 @@
 #include "MultiMaterialSegmentation.hpp"
 #include "Print.hpp"
 #include "ClipperUtils.hpp"
+#include "SlicingCache.hpp"
 
 #include <boost/log/trivial.hpp>
 
@@ -40,23 +41,55 @@ LayerPtrs new_layers(
 }
 
 // Slice single triangle mesh.
+// The mesh is indexed for slicing once, the index is kept in slicing_indices to slice it again at other zs.
+// Without slicing_indices, the mesh is sliced without any index.
 static std::vector<ExPolygons> slice_volume(
-    const ModelVolume             &volume,
-    const std::vector<float>      &zs, 
-    const MeshSlicingParamsEx     &params,
-    const std::function<void()>   &throw_on_cancel_callback)
+    const ModelVolume                       &volume,
+    const std::vector<float>                &zs, 
+    const MeshSlicingParamsEx               &params,
+    std::vector<ModelVolumeSlicingIndex>    *slicing_indices,
+    const std::function<void()>             &throw_on_cancel_callback)
 {
     std::vector<ExPolygons> layers;
-    if (! zs.empty()) {
-        indexed_triangle_set its = volume.mesh().its;
-        if (its.indices.size() > 0) {
+    if (! zs.empty() && ! volume.mesh().its.indices.empty()) {
+        const Transform3d trafo = params.trafo * volume.get_matrix();
+        // The slices may have been stored by a previous run.
+        std::string cache_key;
+        if (SlicingCache::enabled()) {
+            MeshSlicingParamsEx params_cache { params };
+            params_cache.trafo = trafo;
+            cache_key = SlicingCache::key(volume.mesh().its, zs, params_cache);
+            if (SlicingCache::load(cache_key, layers) && layers.size() == zs.size()) {
+                BOOST_LOG_TRIVIAL(debug) << "Slices of volume " << volume.name << " loaded from the slicing cache";
+                return layers;
+            }
+            layers.clear();
+        }
+        if (slicing_indices == nullptr) {
+            indexed_triangle_set its = volume.mesh().its;
             MeshSlicingParamsEx params2 { params };
-            params2.trafo = params2.trafo * volume.get_matrix();
+            params2.trafo = trafo;
             if (params2.trafo.rotation().determinant() < 0.)
                 its_flip_triangles(its);
             layers = slice_mesh_ex(its, zs, params2, throw_on_cancel_callback);
-            throw_on_cancel_callback();
+        } else {
+            auto it = std::find_if(slicing_indices->begin(), slicing_indices->end(), [&volume](const ModelVolumeSlicingIndex &si) { return si.volume_id == volume.id(); });
+            if (it == slicing_indices->end())
+                it = slicing_indices->insert(it, ModelVolumeSlicingIndex{ volume.id() });
+            if (! it->index || it->mesh.lock() != volume.get_mesh_shared_ptr() || it->index->trafo.matrix() != trafo.matrix()) {
+                // The mesh or its transformation changed.
+                it->index.reset();
+                indexed_triangle_set its = volume.mesh().its;
+                if (trafo.rotation().determinant() < 0.)
+                    its_flip_triangles(its);
+                it->mesh  = volume.get_mesh_shared_ptr();
+                it->index = std::make_shared<const MeshSlicingIndex>(its, trafo);
+            }
+            layers = slice_mesh_ex(*it->index, zs, params, throw_on_cancel_callback);
         }
+        throw_on_cancel_callback();
+        if (! cache_key.empty())
+            SlicingCache::store(cache_key, layers);
     }
 
     return layers;
@@ -69,13 +102,14 @@ static std::vector<ExPolygons> slice_volume(
     const std::vector<float>                    &z,
     const std::vector<t_layer_height_range>     &ranges,
     const MeshSlicingParamsEx                   &params,
+    std::vector<ModelVolumeSlicingIndex>        *slicing_indices,
     const std::function<void()>                 &throw_on_cancel_callback)
 {
     std::vector<ExPolygons> out;
     if (! z.empty() && ! ranges.empty()) {
         if (ranges.size() == 1 && z.front() >= ranges.front().first && z.back() < ranges.front().second) {
             // All layers fit into a single range.
-            out = slice_volume(volume, z, params, throw_on_cancel_callback);
+            out = slice_volume(volume, z, params, slicing_indices, throw_on_cancel_callback);
         } else {
             std::vector<float>                     z_filtered;
             std::vector<std::pair<size_t, size_t>> n_filtered;
@@ -91,7 +125,7 @@ static std::vector<ExPolygons> slice_volume(
                     n_filtered.emplace_back(std::make_pair(first, i));
             }
             if (! n_filtered.empty()) {
-                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, throw_on_cancel_callback);
+                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, slicing_indices, throw_on_cancel_callback);
                 out.assign(z.size(), ExPolygons());
                 i = 0;
                 for (const std::pair<size_t, size_t> &span : n_filtered)
@@ -127,6 +161,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
     ModelVolumePtrs                                           model_volumes,
     const std::vector<PrintObjectRegions::LayerRangeRegions> &layer_ranges,
     const std::vector<float>                                 &zs,
+    std::vector<ModelVolumeSlicingIndex>                     *slicing_indices,
     const std::function<void()>                              &throw_on_cancel_callback)
 {
     model_volumes_sort_by_id(model_volumes);
@@ -182,7 +217,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                     }
                     out.push_back({
                         model_volume->id(), 
-                        slice_volume(*model_volume, zs, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, params, slicing_indices, throw_on_cancel_callback)
                     });
                 }
             } else {
@@ -194,7 +229,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                 if (! slicing_ranges.empty())
                     out.push_back({ 
                         model_volume->id(), 
-                        slice_volume(*model_volume, zs, slicing_ranges, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, slicing_ranges, params, slicing_indices, throw_on_cancel_callback)
                     });
             }
             if (! out.empty() && out.back().slices.empty())
@@ -429,6 +464,50 @@ static std::vector<std::vector<ExPolygons>> slices_to_regions(
     return slices_by_region;
 }
 
+// Key of the slices of the regions of an object in the slicing cache: they depend on the meshes of its volumes and their transformations,
+// on the layer ranges and the volumes of its regions, and on the configuration of the object and of its regions.
+// The volumes are identified by their position in the object, their ObjectIDs change from a run to the next one.
+static std::string region_slices_cache_key(const PrintConfig &print_config, const PrintObject &print_object, const std::vector<float> &zs)
+{
+    const ModelVolumePtrs    &volumes = print_object.model_object()->volumes;
+    const PrintObjectRegions &regions = *print_object.shared_regions();
+    auto volume_idx = [&volumes](const ModelVolume *model_volume) { return uint64_t(std::find(volumes.begin(), volumes.end(), model_volume) - volumes.begin()); };
+
+    SlicingCache::KeyBuilder key;
+    key.add(std::string("regions"));
+    key.add(zs);
+    key.add(print_object.trafo_centered());
+    key.add_value(uint64_t(print_object.config().hash()));
+    key.add_value(print_config.resolution.value);
+    key.add_value(print_config.spiral_vase.value);
+    key.add_value(uint64_t(print_config.nozzle_diameter.size()));
+    key.add_value(uint64_t(print_config.filament_shrink.hash()));
+    for (const ModelVolume *model_volume : volumes)
+        if (model_volume_needs_slicing(*model_volume)) {
+            key.add_value(volume_idx(model_volume));
+            key.add_value(model_volume->type());
+            key.add_value(model_volume->is_mm_painted());
+            key.add(model_volume->get_matrix());
+            key.add(model_volume->mesh().its);
+        }
+    for (const PrintObjectRegions::LayerRangeRegions &layer_range : regions.layer_ranges) {
+        key.add_value(layer_range.layer_height_range.first);
+        key.add_value(layer_range.layer_height_range.second);
+        key.add_value(uint64_t(layer_range.volume_regions.size()));
+        for (const PrintObjectRegions::VolumeRegion &volume_region : layer_range.volume_regions) {
+            key.add_value(volume_idx(volume_region.model_volume));
+            key.add_value(volume_region.parent);
+            key.add_value(volume_region.region ? volume_region.region->print_object_region_id() : -1);
+            key.add(volume_region.bbox->min().data(), 3 * sizeof(float));
+            key.add(volume_region.bbox->max().data(), 3 * sizeof(float));
+        }
+    }
+    key.add_value(uint64_t(regions.all_regions.size()));
+    for (const std::unique_ptr<PrintRegion> &region : regions.all_regions)
+        key.add_value(uint64_t(region ? region->config_hash() : 0));
+    return key.key();
+}
+
 std::string fix_slicing_errors(LayerPtrs &layers, const std::function<void()> &throw_if_canceled)
 {
     // Collect layers with slicing errors.
@@ -897,26 +976,56 @@ void PrintObject::slice_volumes()
             layer->m_regions.emplace_back(new LayerRegion(layer, pr.get()));
     }
 
-    std::vector<float>                   slice_zs      = zs_from_layers(m_layers);
-    std::vector<VolumeSlices> volume_slices = slice_volumes_inner(
-        print->config(),
-        this->config(),
-        this->trafo_centered(),
-        this->model_object()->volumes,
-        m_shared_regions->layer_ranges,
-        slice_zs,
-        throw_on_cancel_callback);
-
-    std::vector<std::vector<ExPolygons>> region_slices = slices_to_regions(
-        print->config(),
-        *this,
-        this->model_object()->volumes, 
-        *m_shared_regions, 
-        slice_zs,
-        std::move(volume_slices),
-        m_config.clip_multipart_objects,
-        throw_on_cancel_callback);
+    // Forget the indices of the deleted volumes.
+    m_volume_slicing_indices.erase(std::remove_if(m_volume_slicing_indices.begin(), m_volume_slicing_indices.end(),
+        [this](const ModelVolumeSlicingIndex &si) {
+            return std::none_of(this->model_object()->volumes.begin(), this->model_object()->volumes.end(), [&si](const ModelVolume *mv) { return mv->id() == si.volume_id; });
+        }), m_volume_slicing_indices.end());
 
+    std::vector<float>                   slice_zs      = zs_from_layers(m_layers);
+    std::vector<std::vector<ExPolygons>> region_slices;
+    // The slices of the regions may have been stored by a previous run, the volumes are then not sliced at all.
+    // They are stored as a single entry, the layers of a region after the ones of the previous region.
+    const std::string                    cache_key     = SlicingCache::enabled() ? region_slices_cache_key(print->config(), *this, slice_zs) : std::string();
+    if (! cache_key.empty()) {
+        std::vector<ExPolygons> layers;
+        if (SlicingCache::load(cache_key, layers) && layers.size() == m_shared_regions->all_regions.size() * slice_zs.size()) {
+            BOOST_LOG_TRIVIAL(debug) << "Slices of the regions of object " << this->model_object()->name << " loaded from the slicing cache";
+            region_slices.assign(m_shared_regions->all_regions.size(), std::vector<ExPolygons>());
+            for (size_t region_id = 0; region_id < region_slices.size(); ++ region_id)
+                region_slices[region_id].assign(std::make_move_iterator(layers.begin() + region_id * slice_zs.size()),
+                                                std::make_move_iterator(layers.begin() + (region_id + 1) * slice_zs.size()));
+        }
+    }
+    if (region_slices.empty()) {
+        std::vector<VolumeSlices> volume_slices = slice_volumes_inner(
+            print->config(),
+            this->config(),
+            this->trafo_centered(),
+            this->model_object()->volumes,
+            m_shared_regions->layer_ranges,
+            slice_zs,
+            &m_volume_slicing_indices,
+            throw_on_cancel_callback);
+
+        region_slices = slices_to_regions(
+            print->config(),
+            *this,
+            this->model_object()->volumes, 
+            *m_shared_regions, 
+            slice_zs,
+            std::move(volume_slices),
+            m_config.clip_multipart_objects,
+            throw_on_cancel_callback);
+
+        if (! cache_key.empty()) {
+            std::vector<ExPolygons> layers;
+            layers.reserve(region_slices.size() * slice_zs.size());
+            for (const std::vector<ExPolygons> &by_layer : region_slices)
+                layers.insert(layers.end(), by_layer.begin(), by_layer.end());
+            SlicingCache::store(cache_key, layers);
+        }
+    }
 
 
     for (size_t region_id = 0; region_id < region_slices.size(); ++ region_id) {
@@ -1137,9 +1246,10 @@ std::vector<Polygons> PrintObject::slice_support_volumes(const ModelVolumeType m
         auto               throw_on_cancel_callback = std::function<void()>([print](){ print->throw_if_canceled(); });
         MeshSlicingParamsEx params;
         params.trafo = this->trafo_centered();
+        // Support blockers / enforcers are usually simple meshes, they are sliced without an index.
         for (; it_volume != it_volume_end; ++ it_volume)
             if ((*it_volume)->type() == model_volume_type) {
-                std::vector<ExPolygons> slices2 = slice_volume(*(*it_volume), zs, params, throw_on_cancel_callback);
+                std::vector<ExPolygons> slices2 = slice_volume(*(*it_volume), zs, params, nullptr, throw_on_cancel_callback);
                 if (slices.empty()) {
                     slices.reserve(slices2.size());
                     for (ExPolygons &src : slices2)
@@ -390,6 +390,8 @@ struct SLAPrintStatistics
 class SLAArchive {
 protected:
     std::vector<sla::EncodedRaster> m_layers;
+    // Memory budget of the layers in flight in the streaming mode, 0 if not streaming. See set_streaming().
+    size_t m_streaming_memory_budget = 0;
     
     virtual std::unique_ptr<sla::RasterBase> create_raster() const = 0;
     virtual sla::RasterEncoder get_encoder() const = 0;
@@ -398,6 +400,12 @@ public:
     virtual ~SLAArchive() = default;
     
     virtual void apply(const SLAPrinterConfig &cfg) = 0;
+
+    // In the streaming mode, the layers are not rasterized by draw_layers() and kept in memory until the export:
+    // the export rasterizes, encodes and compresses them on the worker threads and writes them in order as soon
+    // as they are ready, with at most memory_budget bytes of layers in flight. 0 disables the streaming mode.
+    void set_streaming(size_t memory_budget) { m_streaming_memory_budget = memory_budget; m_layers = {}; }
+    bool streaming() const { return m_streaming_memory_budget > 0; }
     
     // Fn have to be thread safe: void(sla::RasterBase& raster, size_t lyrid);
     template<class Fn, class CancelFn, class EP = ExecutionTBB>
@@ -407,6 +415,11 @@ public:
         CancelFn cancelfn = []() { return false; },
         const EP & ep       = {})
     {
+        if (this->streaming()) {
+            // The layers are drawn by the export.
+            m_layers = {};
+            return;
+        }
         m_layers.resize(layer_num);
         execution::for_each(
             ep, size_t(0), m_layers.size(),
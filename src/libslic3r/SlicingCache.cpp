@@ -0,0 +1,213 @@
+#include "SlicingCache.hpp"
+#include "Utils.hpp"
+
+#include "libslic3r_version.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+//FIXME replace with <boost/md5.hpp> after it becomes mainstream.
+#include <boost/uuid/detail/md5.hpp>
+
+namespace Slic3r {
+namespace SlicingCache {
+
+// To be increased each time the slicing or the file format changes.
+static constexpr const char *format_version = "SLICES01";
+
+bool enabled()
+{
+    return ! slicing_cache_dir().empty();
+}
+
+struct KeyBuilder::Impl
+{
+    // boost::uuids::detail::md5 is an internal namespace thus it may change in the future.
+    boost::uuids::detail::md5 md5_hash;
+};
+
+KeyBuilder::KeyBuilder() : m_impl(std::make_unique<Impl>())
+{
+    this->add(format_version, strlen(format_version));
+    this->add(SLIC3R_VERSION, strlen(SLIC3R_VERSION));
+}
+
+KeyBuilder::~KeyBuilder() = default;
+
+void KeyBuilder::add(const void *data, size_t size)
+{
+    m_impl->md5_hash.process_bytes(data, size);
+}
+
+void KeyBuilder::add(const std::string &str)
+{
+    this->add_value(uint64_t(str.size()));
+    this->add(str.data(), str.size());
+}
+
+void KeyBuilder::add(const indexed_triangle_set &its)
+{
+    this->add_value(uint64_t(its.vertices.size()));
+    this->add(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+    this->add_value(uint64_t(its.indices.size()));
+    this->add(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+}
+
+void KeyBuilder::add(const std::vector<float> &zs)
+{
+    this->add_value(uint64_t(zs.size()));
+    this->add(zs.data(), zs.size() * sizeof(float));
+}
+
+void KeyBuilder::add(const Transform3d &trafo)
+{
+    this->add(trafo.matrix().data(), 16 * sizeof(double));
+}
+
+std::string KeyBuilder::key()
+{
+    boost::uuids::detail::md5::digest_type md5_digest{};
+    m_impl->md5_hash.get_digest(md5_digest);
+    std::string out;
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(out));
+    return out;
+}
+
+std::string key(const indexed_triangle_set &its, const std::vector<float> &zs, const MeshSlicingParamsEx &params)
+{
+    KeyBuilder key;
+    key.add(its);
+    key.add(zs);
+    key.add_value(params.mode);
+    key.add_value(uint64_t(params.slicing_mode_normal_below_layer));
+    key.add_value(params.mode_below);
+    key.add(params.trafo);
+    key.add_value(params.closing_radius);
+    key.add_value(params.extra_offset);
+    key.add_value(params.resolution);
+    key.add_value(params.model_resolution);
+    return key.key();
+}
+
+// The entries are spread into 256 sub-directories.
+static boost::filesystem::path entry_path(const std::string &key)
+{
+    return boost::filesystem::path(slicing_cache_dir()) / key.substr(0, 2) / (key + ".slices");
+}
+
+bool load(const std::string &key, std::vector<ExPolygons> &slices)
+{
+    const boost::filesystem::path path = entry_path(key);
+    std::vector<char> data;
+    {
+        boost::system::error_code ec;
+        const uintmax_t size = boost::filesystem::file_size(path, ec);
+        if (ec)
+            return false;
+        FILE *file = boost::nowide::fopen(path.string().c_str(), "rb");
+        if (file == nullptr)
+            return false;
+        data.assign(size_t(size), 0);
+        const bool ok = fread(data.data(), 1, data.size(), file) == data.size();
+        fclose(file);
+        if (! ok)
+            return false;
+    }
+
+    // Reader checking that the entry isn't truncated.
+    size_t pos = 0;
+    auto read = [&data, &pos](void *dst, size_t size) {
+        if (pos + size > data.size())
+            return false;
+        memcpy(dst, data.data() + pos, size);
+        pos += size;
+        return true;
+    };
+    auto read_polygon = [&read](Polygon &polygon) {
+        uint32_t nb_points;
+        if (! read(&nb_points, sizeof(nb_points)))
+            return false;
+        polygon.points.assign(nb_points, Point());
+        return read(polygon.points.data(), nb_points * sizeof(Point));
+    };
+
+    char     magic[8];
+    uint32_t point_size;
+    uint32_t nb_layers;
+    if (! read(magic, sizeof(magic)) || memcmp(magic, format_version, sizeof(magic)) != 0 ||
+        ! read(&point_size, sizeof(point_size)) || point_size != sizeof(Point) ||
+        ! read(&nb_layers, sizeof(nb_layers))) {
+        BOOST_LOG_TRIVIAL(warning) << "Invalid slicing cache entry " << path.string();
+        return false;
+    }
+    std::vector<ExPolygons> out(nb_layers);
+    for (ExPolygons &layer : out) {
+        uint32_t nb_expolygons;
+        if (! read(&nb_expolygons, sizeof(nb_expolygons)))
+            return false;
+        layer.assign(nb_expolygons, ExPolygon());
+        for (ExPolygon &expoly : layer) {
+            uint32_t nb_holes;
+            if (! read(&nb_holes, sizeof(nb_holes)) || ! read_polygon(expoly.contour))
+                return false;
+            expoly.holes.assign(nb_holes, Polygon());
+            for (Polygon &hole : expoly.holes)
+                if (! read_polygon(hole))
+                    return false;
+        }
+    }
+    slices = std::move(out);
+    return true;
+}
+
+void store(const std::string &key, const std::vector<ExPolygons> &slices)
+{
+    std::vector<char> data;
+    auto write = [&data](const void *src, size_t size) { data.insert(data.end(), static_cast<const char*>(src), static_cast<const char*>(src) + size); };
+    auto write_uint32 = [&write](size_t value) { uint32_t v = uint32_t(value); write(&v, sizeof(v)); };
+    auto write_polygon = [&write, &write_uint32](const Polygon &polygon) {
+        write_uint32(polygon.points.size());
+        write(polygon.points.data(), polygon.points.size() * sizeof(Point));
+    };
+    write(format_version, strlen(format_version));
+    write_uint32(sizeof(Point));
+    write_uint32(slices.size());
+    for (const ExPolygons &layer : slices) {
+        write_uint32(layer.size());
+        for (const ExPolygon &expoly : layer) {
+            write_uint32(expoly.holes.size());
+            write_polygon(expoly.contour);
+            for (const Polygon &hole : expoly.holes)
+                write_polygon(hole);
+        }
+    }
+
+    // Another process may write the same entry at the same time: write into a unique file, then rename it.
+    const boost::filesystem::path path     = entry_path(key);
+    const boost::filesystem::path tmp_path = path.parent_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(path.parent_path(), ec);
+    FILE *file = boost::nowide::fopen(tmp_path.string().c_str(), "wb");
+    if (file == nullptr) {
+        BOOST_LOG_TRIVIAL(warning) << "Can't write the slicing cache entry " << tmp_path.string();
+        return;
+    }
+    const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (fclose(file) != 0 || ! ok) {
+        BOOST_LOG_TRIVIAL(warning) << "Can't write the slicing cache entry " << tmp_path.string();
+        boost::filesystem::remove(tmp_path, ec);
+        return;
+    }
+    boost::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(warning) << "Can't write the slicing cache entry " << path.string() << ": " << ec.message();
+        boost::filesystem::remove(tmp_path, ec);
+    }
+}
+
+} // namespace SlicingCache
+} // namespace Slic3r
@@ -0,0 +1,59 @@
+#ifndef slic3r_SlicingCache_hpp_
+#define slic3r_SlicingCache_hpp_
+
+#include "ExPolygon.hpp"
+#include "TriangleMesh.hpp"
+#include "TriangleMeshSlicer.hpp"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Slic3r {
+
+// Persistent cache of the mesh slices, stored in slicing_cache_dir() to be reused by the next runs
+// (a print farm slicing the same parts with the same profiles again and again).
+// The slices of a mesh only depend on its triangles, its transformation, the slicing heights and the slicing parameters,
+// so they are stored under a hash of all of these: a modified mesh or profile can't hit a stale entry.
+// The cache directory is shared between the processes, the entries are written to a temporary file and then renamed.
+// Nothing is ever removed from the directory.
+namespace SlicingCache {
+
+// Is slicing_cache_dir() set?
+bool        enabled();
+
+// Hash of all the values an entry depends on, to make its key.
+class KeyBuilder
+{
+public:
+    KeyBuilder();
+    ~KeyBuilder();
+
+    void        add(const void *data, size_t size);
+    void        add(const std::string &str);
+    void        add(const indexed_triangle_set &its);
+    void        add(const std::vector<float> &zs);
+    void        add(const Transform3d &trafo);
+    // Only for the values without padding bytes, whose bytes are all set.
+    template<typename T>
+    void        add_value(const T &value) { static_assert(std::is_trivially_copyable<T>::value, "add_value() of a non trivial type"); this->add(&value, sizeof(value)); }
+    std::string key();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Key of the slices of the mesh transformed by params.trafo at the heights zs.
+std::string key(const indexed_triangle_set &its, const std::vector<float> &zs, const MeshSlicingParamsEx &params);
+// Read the slices stored under key, returns false if there is no such entry or if it can't be read.
+bool        load(const std::string &key, std::vector<ExPolygons> &slices);
+// Store the slices under key, errors are only logged.
+void        store(const std::string &key, const std::vector<ExPolygons> &slices);
+
+} // namespace SlicingCache
+
+} // namespace Slic3r
+
+#endif // slic3r_SlicingCache_hpp_
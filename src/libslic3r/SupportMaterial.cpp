@@ -2032,6 +2032,8 @@ PrintObjectSupportMaterial::MyLayersPtr PrintObjectSupportMaterial::top_contact_
             for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) 
             {
                 const Layer        &layer                = *object.layers()[layer_id];
+                // The bridging perimeters and fills of the layer are looked for.
+                LayerSpill::Loader  loader(&layer);
                 Polygons            lower_layer_polygons = (layer_id == 0) ? Polygons() : to_polygons(object.layers()[layer_id - 1]->lslices);
                 SlicesMarginCache   slices_margin;
 
@@ -2933,6 +2935,7 @@ void PrintObjectSupportMaterial::trim_support_layers_by_object(
                     // Collect all bottom surfaces, which will be extruded with a bridging flow.
                     for (; i < object.layers().size(); ++ i) {
                         const Layer &object_layer = *object.layers()[i];
+                        LayerSpill::Loader loader(&object_layer);
                         bool some_region_overlaps = false;
                         for (LayerRegion *region : object_layer.regions()) {
                             coordf_t bridging_height = m_object_config->support_material_contact_distance_type.value == zdFilament
@@ -303,39 +303,78 @@ static FacetSliceType slice_facet(
     return FacetSliceType::NoSlice;
 }
 
+// Number of facets sliced at once by slice_facets_at_zs().
+static constexpr const size_t slice_facets_block_size = 256;
+
+// Slice a block of facets [face_begin, face_end) at all zs.
+// The z extents of the facets are computed over SoA copies of the vertex zs of the block, so that the compiler vectorizes them,
+// and the intersection lines are collected locally and appended to the layers with a single lock per layer.
 template<typename TransformVertex>
-void slice_facet_at_zs(
+static void slice_facets_at_zs(
     // Scaled or unscaled vertices. transform_vertex_fn may scale zs.
     const std::vector<Vec3f>                         &mesh_vertices,
     const TransformVertex                            &transform_vertex_fn,
-    const stl_triangle_vertex_indices                &indices,
-    const Vec3i32                                    &edge_ids,
+    const std::vector<stl_triangle_vertex_indices>   &indices,
+    const std::vector<Vec3i32>                       &face_edge_ids,
+    const size_t                                      face_begin,
+    const size_t                                      face_end,
     // Scaled or unscaled zs. If vertices have their zs scaled or transform_vertex_fn scales them, then zs have to be scaled as well.
     const std::vector<float>                         &zs,
     std::vector<IntersectionLines>                   &lines,
     std::array<std::mutex, 64>                       &lines_mutex)
 {
-    stl_vertex vertices[3] { transform_vertex_fn(mesh_vertices[indices(0)]), transform_vertex_fn(mesh_vertices[indices(1)]), transform_vertex_fn(mesh_vertices[indices(2)]) };
-
+    assert(face_end - face_begin <= slice_facets_block_size);
+    const size_t num_faces = face_end - face_begin;
+    std::array<stl_vertex, slice_facets_block_size * 3>  vertices;
+    std::array<float, slice_facets_block_size>           z0, z1, z2, min_z, max_z;
+    for (size_t i = 0; i < num_faces; ++ i) {
+        const stl_triangle_vertex_indices &face = indices[face_begin + i];
+        stl_vertex *v = &vertices[i * 3];
+        v[0] = transform_vertex_fn(mesh_vertices[face(0)]);
+        v[1] = transform_vertex_fn(mesh_vertices[face(1)]);
+        v[2] = transform_vertex_fn(mesh_vertices[face(2)]);
+        z0[i] = v[0].z();
+        z1[i] = v[1].z();
+        z2[i] = v[2].z();
+    }
     // find facet extents
-    const float min_z = fminf(vertices[0].z(), fminf(vertices[1].z(), vertices[2].z()));
-    const float max_z = fmaxf(vertices[0].z(), fmaxf(vertices[1].z(), vertices[2].z()));
-    
-    // find layer extents
-    auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z); // first layer whose slice_z is >= min_z
-    auto max_layer = std::upper_bound(min_layer, zs.end(), max_z); // first layer whose slice_z is > max_z
-    int  idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
-    
-    for (auto it = min_layer; it != max_layer; ++ it) {
-        IntersectionLine il;
+    for (size_t i = 0; i < num_faces; ++ i) {
+        min_z[i] = std::min(z0[i], std::min(z1[i], z2[i]));
+        max_z[i] = std::max(z0[i], std::max(z1[i], z2[i]));
+    }
+
+    std::vector<std::pair<size_t, IntersectionLine>> block_lines;
+    for (size_t i = 0; i < num_faces; ++ i) {
         // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
-        if (min_z != max_z && slice_facet(*it, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
-            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
-            size_t slice_id = it - zs.begin();
-            boost::lock_guard<std::mutex> l(lines_mutex[slice_id % lines_mutex.size()]);
-            lines[slice_id].emplace_back(il);
+        if (min_z[i] == max_z[i])
+            continue;
+        // find layer extents
+        auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z[i]); // first layer whose slice_z is >= min_z
+        auto max_layer = std::upper_bound(min_layer, zs.end(), max_z[i]); // first layer whose slice_z is > max_z
+        if (min_layer == max_layer)
+            continue;
+        const stl_vertex *v = &vertices[i * 3];
+        int  idx_vertex_lowest = (z1[i] == min_z[i]) ? 1 : ((z2[i] == min_z[i]) ? 2 : 0);
+        for (auto it = min_layer; it != max_layer; ++ it) {
+            IntersectionLine il;
+            if (slice_facet(*it, v, indices[face_begin + i], face_edge_ids[face_begin + i], idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
+                assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+                block_lines.emplace_back(it - zs.begin(), il);
+            }
         }
     }
+
+    // Append the lines to their layers, one lock per layer.
+    // Stable: the lines of a layer keep the order of their facets, as when they were appended facet by facet.
+    std::stable_sort(block_lines.begin(), block_lines.end(), [](const auto &l, const auto &r) { return l.first < r.first; });
+    for (auto it = block_lines.begin(); it != block_lines.end();) {
+        const size_t slice_id = it->first;
+        auto it_end = it;
+        for (++ it_end; it_end != block_lines.end() && it_end->first == slice_id; ++ it_end) ;
+        boost::lock_guard<std::mutex> l(lines_mutex[slice_id % lines_mutex.size()]);
+        for (; it != it_end; ++ it)
+            lines[slice_id].emplace_back(it->second);
+    }
 }
 
 template<typename TransformVertex, typename ThrowOnCancel>
@@ -350,12 +389,14 @@ static inline std::vector<IntersectionLines> slice_make_lines(
     std::vector<IntersectionLines>  lines(zs.size(), IntersectionLines());
     std::array<std::mutex, 64>      lines_mutex;
     tbb::parallel_for(
-        tbb::blocked_range<int>(0, int(indices.size())),
-        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &lines_mutex, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
-            for (int face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
-                if ((face_idx & 0x0ffff) == 0)
+        tbb::blocked_range<size_t>(0, (indices.size() + slice_facets_block_size - 1) / slice_facets_block_size),
+        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &lines_mutex, throw_on_cancel_fn](const tbb::blocked_range<size_t> &range) {
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx) {
+                if ((block_idx & 0x0ff) == 0)
                     throw_on_cancel_fn();
-                slice_facet_at_zs(vertices, transform_vertex_fn, indices[face_idx], face_edge_ids[face_idx], zs, lines, lines_mutex);
+                const size_t face_begin = block_idx * slice_facets_block_size;
+                slice_facets_at_zs(vertices, transform_vertex_fn, indices, face_edge_ids,
+                    face_begin, std::min(face_begin + slice_facets_block_size, indices.size()), zs, lines, lines_mutex);
             }
         }
     );
@@ -1700,6 +1741,130 @@ static std::vector<stl_vertex> transform_mesh_vertices_for_slicing(const indexed
     return out;
 }
 
+MeshSlicingIndex::MeshSlicingIndex(const indexed_triangle_set &mesh, const Transform3d &trafo) :
+    trafo(trafo), vertices(transform_mesh_vertices_for_slicing(mesh, trafo))
+{
+    std::vector<Vec3i32> edge_ids = its_face_edge_ids(mesh);
+    std::vector<std::pair<float, float>> extents;
+    extents.reserve(mesh.indices.size());
+    std::vector<uint32_t> order;
+    order.reserve(mesh.indices.size());
+    for (const stl_triangle_vertex_indices &face : mesh.indices) {
+        const float z0 = this->vertices[face(0)].z();
+        const float z1 = this->vertices[face(1)].z();
+        const float z2 = this->vertices[face(2)].z();
+        extents.emplace_back(std::min(z0, std::min(z1, z2)), std::max(z0, std::max(z1, z2)));
+        // Horizontal triangles are never sliced, see slice_facets_at_zs().
+        if (extents.back().first != extents.back().second)
+            order.emplace_back(uint32_t(extents.size() - 1));
+    }
+    std::sort(order.begin(), order.end(), [&extents](const uint32_t l, const uint32_t r) { return extents[l].first < extents[r].first; });
+    this->indices.reserve(order.size());
+    this->face_edge_ids.reserve(order.size());
+    this->min_z.reserve(order.size());
+    this->max_z.reserve(order.size());
+    for (const uint32_t face_idx : order) {
+        this->indices.emplace_back(mesh.indices[face_idx]);
+        this->face_edge_ids.emplace_back(edge_ids[face_idx]);
+        this->min_z.emplace_back(extents[face_idx].first);
+        this->max_z.emplace_back(extents[face_idx].second);
+    }
+}
+
+size_t MeshSlicingIndex::memsize() const
+{
+    return sizeof(*this) + this->vertices.capacity() * sizeof(stl_vertex) + this->indices.capacity() * sizeof(stl_triangle_vertex_indices) +
+        this->face_edge_ids.capacity() * sizeof(Vec3i32) + (this->min_z.capacity() + this->max_z.capacity()) * sizeof(float);
+}
+
+// Slice the facets of the index by sweeping the zs: the zs are split into slabs of consecutive layers sliced in parallel,
+// each slab slicing the facets reaching its first plane from below and the facets starting inside the slab.
+// The lines of a layer are produced by a single thread, thus they don't need any lock.
+template<typename ThrowOnCancel>
+static std::vector<IntersectionLines> slice_make_lines(
+    const MeshSlicingIndex          &index,
+    // Unscaled Zs, sorted.
+    const std::vector<float>        &zs,
+    const ThrowOnCancel              throw_on_cancel_fn)
+{
+    struct Slab {
+        size_t                layer_begin;
+        size_t                layer_end;
+        // Facets starting below the first plane of the slab, and reaching it: range of active_facets.
+        size_t                active_begin;
+        size_t                active_end;
+        // Facets starting inside the slab.
+        size_t                facet_begin;
+        size_t                facet_end;
+    };
+    static constexpr const size_t slab_num_layers = 16;
+    std::vector<Slab> slabs;
+    slabs.reserve((zs.size() + slab_num_layers - 1) / slab_num_layers);
+    // The active facets of all the slabs, one after the other, to not allocate a set per slab.
+    std::vector<uint32_t> active_facets;
+    {
+        std::vector<uint32_t> active;
+        size_t                next_facet = 0;
+        for (size_t layer_begin = 0; layer_begin < zs.size(); layer_begin += slab_num_layers) {
+            const size_t layer_end = std::min(layer_begin + slab_num_layers, zs.size());
+            const float  z_begin   = zs[layer_begin];
+            for (; next_facet < index.min_z.size() && index.min_z[next_facet] <= z_begin; ++ next_facet)
+                active.emplace_back(uint32_t(next_facet));
+            active.erase(std::remove_if(active.begin(), active.end(), [&index, z_begin](const uint32_t facet_idx) { return index.max_z[facet_idx] < z_begin; }), active.end());
+            const size_t facet_end = std::upper_bound(index.min_z.begin() + next_facet, index.min_z.end(), zs[layer_end - 1]) - index.min_z.begin();
+            slabs.push_back({ layer_begin, layer_end, active_facets.size(), active_facets.size() + active.size(), next_facet, facet_end });
+            active_facets.insert(active_facets.end(), active.begin(), active.end());
+        }
+    }
+
+    std::vector<IntersectionLines> lines(zs.size(), IntersectionLines());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, slabs.size()),
+        [&index, &zs, &slabs, &active_facets, &lines, throw_on_cancel_fn](const tbb::blocked_range<size_t> &range) {
+            for (size_t slab_idx = range.begin(); slab_idx < range.end(); ++ slab_idx) {
+                throw_on_cancel_fn();
+                const Slab &slab     = slabs[slab_idx];
+                const auto  zs_begin = zs.begin() + slab.layer_begin;
+                const auto  zs_end   = zs.begin() + slab.layer_end;
+                auto slice_facet_at_slab_zs = [&index, &zs, &lines, zs_begin, zs_end](const size_t facet_idx) {
+                    const float min_z     = index.min_z[facet_idx];
+                    auto        min_layer = std::lower_bound(zs_begin, zs_end, min_z); // first layer whose slice_z is >= min_z
+                    auto        max_layer = std::upper_bound(min_layer, zs_end, index.max_z[facet_idx]); // first layer whose slice_z is > max_z
+                    const stl_triangle_vertex_indices &indices = index.indices[facet_idx];
+                    const stl_vertex vertices[3] { index.vertices[indices(0)], index.vertices[indices(1)], index.vertices[indices(2)] };
+                    const int        idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
+                    for (auto it = min_layer; it != max_layer; ++ it) {
+                        IntersectionLine il;
+                        if (slice_facet(*it, vertices, indices, index.face_edge_ids[facet_idx], idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
+                            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+                            lines[it - zs.begin()].emplace_back(il);
+                        }
+                    }
+                };
+                for (size_t i = slab.active_begin; i < slab.active_end; ++ i)
+                    slice_facet_at_slab_zs(active_facets[i]);
+                for (size_t facet_idx = slab.facet_begin; facet_idx < slab.facet_end; ++ facet_idx)
+                    slice_facet_at_slab_zs(facet_idx);
+            }
+        }
+    );
+    return lines;
+}
+
+std::vector<Polygons> slice_mesh(
+    const MeshSlicingIndex           &index,
+    // Unscaled Zs
+    const std::vector<float>         &zs,
+    const MeshSlicingParams          &params,
+    std::function<void()>             throw_on_cancel)
+{
+    BOOST_LOG_TRIVIAL(debug) << "slice_mesh to polygons, indexed";
+
+    std::vector<IntersectionLines> lines = slice_make_lines(index, zs, throw_on_cancel);
+    throw_on_cancel();
+    return make_loops(lines, params, throw_on_cancel);
+}
+
 std::vector<Polygons> slice_mesh(
     const indexed_triangle_set       &mesh,
     // Unscaled Zs
@@ -1839,22 +2004,22 @@ Polygons slice_mesh(
     return layers.front();
 }
 
-std::vector<ExPolygons> slice_mesh_ex(
-    const indexed_triangle_set       &mesh,
-    const std::vector<float>         &zs,
+// Parameters of slice_mesh() called by slice_mesh_ex().
+static inline MeshSlicingParams slice_mesh_ex_slicing_params(const MeshSlicingParamsEx &params)
+{
+    MeshSlicingParams slicing_params(params);
+    if (params.mode == MeshSlicingParams::SlicingMode::PositiveLargestContour)
+        slicing_params.mode = MeshSlicingParams::SlicingMode::Positive;
+    if (params.mode_below == MeshSlicingParams::SlicingMode::PositiveLargestContour)
+        slicing_params.mode_below = MeshSlicingParams::SlicingMode::Positive;
+    return slicing_params;
+}
+
+static std::vector<ExPolygons> slice_mesh_ex_make_expolygons(
+    const std::vector<Polygons>      &layers_p,
     const MeshSlicingParamsEx        &params,
     std::function<void()>             throw_on_cancel)
 {
-    std::vector<Polygons> layers_p;
-    {
-        MeshSlicingParams slicing_params(params);
-        if (params.mode == MeshSlicingParams::SlicingMode::PositiveLargestContour)
-            slicing_params.mode = MeshSlicingParams::SlicingMode::Positive;
-        if (params.mode_below == MeshSlicingParams::SlicingMode::PositiveLargestContour)
-            slicing_params.mode_below = MeshSlicingParams::SlicingMode::Positive;
-        layers_p = slice_mesh(mesh, zs, slicing_params, throw_on_cancel);
-    }
-    
 //    BOOST_LOG_TRIVIAL(debug) << "slice_mesh make_expolygons in parallel - start";
     std::vector<ExPolygons> layers(layers_p.size(), ExPolygons{});
     tbb::parallel_for(
@@ -1888,6 +2053,24 @@ std::vector<ExPolygons> slice_mesh_ex(
     return layers;
 }
 
+std::vector<ExPolygons> slice_mesh_ex(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    std::function<void()>             throw_on_cancel)
+{
+    return slice_mesh_ex_make_expolygons(slice_mesh(mesh, zs, slice_mesh_ex_slicing_params(params), throw_on_cancel), params, throw_on_cancel);
+}
+
+std::vector<ExPolygons> slice_mesh_ex(
+    const MeshSlicingIndex           &index,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    std::function<void()>             throw_on_cancel)
+{
+    return slice_mesh_ex_make_expolygons(slice_mesh(index, zs, slice_mesh_ex_slicing_params(params), throw_on_cancel), params, throw_on_cancel);
+}
+
 // Slice a triangle set with a set of Z slabs (thick layers).
 // The effect is similar to producing the usual top / bottom layers from a sliced mesh by 
 // subtracting layer[i] from layer[i - 1] for the top surfaces resp.
@@ -48,6 +48,28 @@ struct MeshSlicingParamsEx : public MeshSlicingParams
     double        model_resolution{ 0 };
 };
 
+// Facets of a mesh transformed for slicing and sorted by their lowest z.
+// slice_mesh() sweeps the slicing planes over the sorted facets instead of searching the slicing planes of each facet,
+// thus each slicing plane is filled by a single thread.
+// The index depends only on the mesh and on the transformation, thus it may be built once and kept
+// to slice the mesh again at other zs, for example when only the layer heights are edited.
+struct MeshSlicingIndex
+{
+    MeshSlicingIndex(const indexed_triangle_set &mesh, const Transform3d &trafo);
+
+    bool   empty() const { return indices.empty(); }
+    size_t memsize() const;
+
+    Transform3d                                 trafo;
+    // Mesh vertices transformed by trafo, scaled in XY, not in Z.
+    std::vector<stl_vertex>                     vertices;
+    // Facets with their edge ids and z extents, sorted by min_z.
+    std::vector<stl_triangle_vertex_indices>    indices;
+    std::vector<Vec3i32>                        face_edge_ids;
+    std::vector<float>                          min_z;
+    std::vector<float>                          max_z;
+};
+
 // All the following slicing functions shall produce consistent results with the same mesh, same transformation matrix and slicing parameters.
 // Namely, slice_mesh_slabs() shall produce consistent results with slice_mesh() and slice_mesh_ex() in the sense, that projections made by 
 // slice_mesh_slabs() shall fall onto slicing planes produced by slice_mesh().
@@ -65,6 +87,13 @@ std::vector<Polygons>           slice_mesh(
     const MeshSlicingParams          &params,
     std::function<void()>             throw_on_cancel = []{});
 
+// Slice a mesh indexed by MeshSlicingIndex, params.trafo is ignored in favor of index.trafo.
+std::vector<Polygons>           slice_mesh(
+    const MeshSlicingIndex           &index,
+    const std::vector<float>         &zs,
+    const MeshSlicingParams          &params,
+    std::function<void()>             throw_on_cancel = []{});
+
 // Specialized version for a single slicing plane only, running on a single thread.
 Polygons                        slice_mesh(
     const indexed_triangle_set       &mesh,
@@ -77,6 +106,12 @@ std::vector<ExPolygons>         slice_mesh_ex(
     const MeshSlicingParamsEx        &params,
     std::function<void()>             throw_on_cancel = []{});
 
+std::vector<ExPolygons>         slice_mesh_ex(
+    const MeshSlicingIndex           &index,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    std::function<void()>             throw_on_cancel = []{});
+
 inline std::vector<ExPolygons>  slice_mesh_ex(
     const indexed_triangle_set       &mesh,
     const std::vector<float>         &zs,
@@ -27,6 +27,8 @@ extern std::string log_memory_info(bool ignore_loglevel = false);
 extern void disable_multi_threading();
 // Returns the size of physical memory (RAM) in bytes.
 extern size_t total_physical_memory();
+// Returns the peak resident memory of this process in bytes, 0 if unknown.
+extern size_t peak_memory_usage();
 
 // Set a path with GUI resource files.
 void set_var_dir(const std::string &path);
@@ -58,6 +60,11 @@ void set_data_dir(const std::string &path);
 // Return a full path to the GUI resource files.
 const std::string& data_dir();
 
+// Set a directory to store the mesh slices for the next runs, empty to disable the cache (see SlicingCache.hpp).
+void set_slicing_cache_dir(const std::string &path);
+// Return a full path to the slicing cache directory, empty if the cache is disabled.
+const std::string& slicing_cache_dir();
+
 // Format an output path for debugging purposes.
 // Writes out the output path prefix to the console for the first time the function is called,
 // so the user knows where to search for the debugging output.
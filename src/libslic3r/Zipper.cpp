@@ -92,42 +92,56 @@ void Zipper::add_entry(const std::string &name)
     m_entry = name;
 }
 
+static mz_uint compression_level(Zipper::e_compression compression)
+{
+    switch (compression) {
+    case Zipper::NO_COMPRESSION: return MZ_NO_COMPRESSION;
+    case Zipper::FAST_COMPRESSION: return MZ_BEST_SPEED;
+    case Zipper::TIGHT_COMPRESSION: return MZ_BEST_COMPRESSION;
+    }
+    return MZ_NO_COMPRESSION;
+}
+
 void Zipper::add_entry(const std::string &name, const void *data, size_t l)
 {
     if(!m_impl->is_alive()) return;
 
     finish_entry();
-    mz_uint cmpr = MZ_NO_COMPRESSION;
-    switch (m_compression) {
-    case NO_COMPRESSION: cmpr = MZ_NO_COMPRESSION; break;
-    case FAST_COMPRESSION: cmpr = MZ_BEST_SPEED; break;
-    case TIGHT_COMPRESSION: cmpr = MZ_BEST_COMPRESSION; break;
-    }
 
-    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, cmpr))
+    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, compression_level(m_compression)))
         m_impl->blow_up();
 
     m_entry.clear();
     m_data.clear();
 }
 
-void Zipper::finish_entry()
+DeflatedChunk Zipper::deflate_entry(const void *data, size_t bytes) const
+{
+    DeflatedChunk chunk;
+    if (!deflate_chunk(data, bytes, int(compression_level(m_compression)), true, chunk))
+        throw Slic3r::ExportError(L("Error with zip archive") + " " + m_impl->m_zipname + ": " + MZ_Archive::get_errorstr(MZ_ZIP_COMPRESSION_FAILED));
+    return chunk;
+}
+
+void Zipper::add_entry(const std::string &name, const DeflatedChunk &chunk)
 {
     if(!m_impl->is_alive()) return;
 
-    if(!m_data.empty() && !m_entry.empty()) {
-        mz_uint compression = MZ_NO_COMPRESSION;
+    finish_entry();
 
-        switch (m_compression) {
-        case NO_COMPRESSION: compression = MZ_NO_COMPRESSION; break;
-        case FAST_COMPRESSION: compression = MZ_BEST_SPEED; break;
-        case TIGHT_COMPRESSION: compression = MZ_BEST_COMPRESSION; break;
-        }
+    if(!add_deflated_file(&m_impl->arch, name, chunk))
+        m_impl->blow_up();
+}
 
+void Zipper::finish_entry()
+{
+    if(!m_impl->is_alive()) return;
+
+    if(!m_data.empty() && !m_entry.empty()) {
         if(!mz_zip_writer_add_mem(&m_impl->arch, m_entry.c_str(),
                                   m_data.c_str(),
                                   m_data.size(),
-                                  compression)) m_impl->blow_up();
+                                  compression_level(m_compression))) m_impl->blow_up();
     }
 
     m_data.clear();
@@ -7,6 +7,8 @@
 
 namespace Slic3r {
 
+struct DeflatedChunk;
+
 // Class for creating zip archives.
 class Zipper {
 public:
@@ -51,6 +53,15 @@ public:
     /// This method throws exactly like finish_entry() does.
     void add_entry(const std::string& name, const void* data, size_t bytes);
 
+    /// Compress a byte buffer with the compression level of this archive, to be
+    /// added by add_entry(name, chunk). It is thread safe: the entries may be
+    /// compressed in parallel and then added in order.
+    DeflatedChunk deflate_entry(const void* data, size_t bytes) const;
+
+    /// Add a new binary file entry compressed by deflate_entry().
+    /// This method throws exactly like finish_entry() does.
+    void add_entry(const std::string& name, const DeflatedChunk& chunk);
+
     // Writing data to the archive works like with standard streams. The target
     // within the zip file is the entry created with the add_entry method.
 
@@ -1,4 +1,5 @@
 #include <exception>
+#include <memory>
 
 #include "miniz_extension.hpp"
 
@@ -76,6 +77,34 @@ bool open_zip_writer(mz_zip_archive *zip, const std::string &fname)
 bool close_zip_reader(mz_zip_archive *zip) { return close_zip(zip, true); }
 bool close_zip_writer(mz_zip_archive *zip) { return close_zip(zip, false); }
 
+bool deflate_chunk(const void *data, size_t size, int level, bool last, DeflatedChunk &out)
+{
+    out.data.clear();
+    out.uncompressed_size = size;
+    out.crc32 = mz_uint32(mz_crc32(MZ_CRC32_INIT, static_cast<const unsigned char*>(data), size));
+    // The compressor is big (~300kB), it is allocated on the heap.
+    std::unique_ptr<tdefl_compressor, void(*)(tdefl_compressor*)> compressor(tdefl_compressor_alloc(), tdefl_compressor_free);
+    if (! compressor)
+        return false;
+    out.data.reserve(size / 4 + 64);
+    auto put_buf = [](const void *buf, int len, void *user) -> mz_bool {
+        auto *dst = static_cast<std::vector<unsigned char>*>(user);
+        dst->insert(dst->end(), static_cast<const unsigned char*>(buf), static_cast<const unsigned char*>(buf) + len);
+        return MZ_TRUE;
+    };
+    // Negative window bits: raw deflate, without the zlib header.
+    if (tdefl_init(compressor.get(), put_buf, &out.data, tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY)) != TDEFL_STATUS_OKAY)
+        return false;
+    tdefl_status status = tdefl_compress_buffer(compressor.get(), data, size, last ? TDEFL_FINISH : TDEFL_FULL_FLUSH);
+    return status == (last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+}
+
+bool add_deflated_file(mz_zip_archive *zip, const std::string &name, const DeflatedChunk &chunk)
+{
+    return mz_zip_writer_add_mem_ex(zip, name.c_str(), chunk.data.data(), chunk.data.size(), nullptr, 0,
+        MZ_DEFAULT_LEVEL | MZ_ZIP_FLAG_COMPRESSED_DATA, chunk.uncompressed_size, chunk.crc32);
+}
+
 MZ_Archive::MZ_Archive()
 {
     mz_zip_zero_struct(&arch);
@@ -2,6 +2,7 @@
 #define MINIZ_EXTENSION_HPP
 
 #include <string>
+#include <vector>
 #include <miniz.h>
 
 namespace Slic3r {
@@ -11,6 +12,23 @@ bool open_zip_writer(mz_zip_archive *zip, const std::string &fname_utf8);
 bool close_zip_reader(mz_zip_archive *zip);
 bool close_zip_writer(mz_zip_archive *zip);
 
+// A piece of a file compressed into a raw deflate stream independently from the rest of the file,
+// so that the pieces of a big file may be compressed in parallel and then appended to a staged
+// archive entry with mz_zip_writer_add_staged_compressed_data(), or a small file may be compressed
+// on a worker thread and stored with add_deflated_file().
+struct DeflatedChunk
+{
+    std::vector<unsigned char> data;
+    size_t                     uncompressed_size = 0;
+    mz_uint32                  crc32 = MZ_CRC32_INIT;
+};
+
+// Compress the buffer with a compression level 0 (no compression) to 10 (MZ_UBER_COMPRESSION).
+// If last, the chunk terminates the deflate stream, otherwise it ends with a full flush.
+bool deflate_chunk(const void *data, size_t size, int level, bool last, DeflatedChunk &out);
+// Store a file compressed by deflate_chunk(..., last = true) into the archive.
+bool add_deflated_file(mz_zip_archive *zip, const std::string &name, const DeflatedChunk &chunk);
+
 class MZ_Archive {
 public:
     mz_zip_archive arch;
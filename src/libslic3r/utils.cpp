@@ -215,6 +215,18 @@ const std::string& data_dir()
     return g_data_dir;
 }
 
+static std::string g_slicing_cache_dir;
+
+void set_slicing_cache_dir(const std::string &dir)
+{
+	g_slicing_cache_dir = dir.empty() ? dir : boost::filesystem::path(dir).make_preferred().string();
+}
+
+const std::string& slicing_cache_dir()
+{
+    return g_slicing_cache_dir;
+}
+
 std::string custom_shapes_dir()
 {
     return (boost::filesystem::path(g_data_dir) / "shapes").string();
@@ -788,7 +800,8 @@ bool is_idx_file(const boost::filesystem::directory_entry &dir_entry)
 bool is_gcode_file(const std::string &path)
 {
 	return boost::iends_with(path, ".gcode") || boost::iends_with(path, ".gco") ||
-		   boost::iends_with(path, ".g")     || boost::iends_with(path, ".ngc");
+		   boost::iends_with(path, ".g")     || boost::iends_with(path, ".ngc")   ||
+		   boost::iends_with(path, ".ssbg");
 }
 
 bool is_img_file(const std::string &path)
@@ -1127,6 +1140,25 @@ std::string log_memory_info(bool ignore_loglevel)
     return out;
 }
 
+size_t peak_memory_usage()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return size_t(pmc.PeakWorkingSetSize);
+#elif defined(__linux__) or defined(__APPLE__)
+    rusage memory_info;
+    if (getrusage(RUSAGE_SELF, &memory_info) == 0) {
+        size_t peak_mem_usage = (size_t)memory_info.ru_maxrss;
+    #ifdef __linux__
+        peak_mem_usage *= 1024;// getrusage returns the value in kB on linux
+    #endif
+        return peak_mem_usage;
+    }
+#endif
+    return 0;
+}
+
 // Returns the size of physical memory (RAM) in bytes.
 // http://nadeausoftware.com/articles/2012/09/c_c_tip_how_get_physical_memory_size_system
 size_t total_physical_memory()
@@ -152,6 +152,69 @@ mz_ulong mz_crc32(mz_ulong crc, const mz_uint8 *ptr, size_t buf_len)
 }
 #endif
 
+/* CRC-32 of concatenated buffers, derived from zlib's crc32_combine(): applies len2 zero bytes to crc1 using the GF(2) matrix of the CRC operator. */
+static mz_uint32 mz_gf2_matrix_times(const mz_uint32 *mat, mz_uint32 vec)
+{
+    mz_uint32 sum = 0;
+    while (vec)
+    {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static void mz_gf2_matrix_square(mz_uint32 *square, const mz_uint32 *mat)
+{
+    int n;
+    for (n = 0; n < 32; n++)
+        square[n] = mz_gf2_matrix_times(mat, mat[n]);
+}
+
+mz_ulong mz_crc32_combine(mz_ulong crc1, mz_ulong crc2, mz_uint64 len2)
+{
+    int n;
+    mz_uint32 row;
+    mz_uint32 even[32]; /* even-power-of-two zeros operator */
+    mz_uint32 odd[32];  /* odd-power-of-two zeros operator */
+    mz_uint32 crc = (mz_uint32)crc1;
+
+    if (len2 == 0)
+        return crc1;
+
+    /* put operator for one zero bit in odd */
+    odd[0] = 0xedb88320UL; /* CRC-32 polynomial */
+    row = 1;
+    for (n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    /* put operator for two zero bits in even, then for four zero bits in odd */
+    mz_gf2_matrix_square(even, odd);
+    mz_gf2_matrix_square(odd, even);
+
+    /* apply len2 zeros to crc1 (first square will put the operator for one zero byte, eight zero bits, in even) */
+    do
+    {
+        mz_gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc = mz_gf2_matrix_times(even, crc);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        mz_gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc = mz_gf2_matrix_times(odd, crc);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc ^ (mz_uint32)crc2;
+}
+
 void mz_free(void *p)
 {
     MZ_FREE(p);
@@ -6867,6 +6930,8 @@ mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context *pContext, co
 
     pContext->file_ofs += n;
     pContext->uncomp_crc32 = (mz_uint32)mz_crc32(pContext->uncomp_crc32, (const mz_uint8 *)pRead_buf, n);
+    if (n > 0)
+        pContext->compressor_has_data = MZ_TRUE;
 
     if (pContext->pZip->m_pNeeds_keepalive != NULL && pContext->pZip->m_pNeeds_keepalive(pContext->pZip->m_pIO_opaque))
         flush = TDEFL_FULL_FLUSH;
@@ -6883,6 +6948,51 @@ mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context *pContext, co
     return MZ_FALSE;
 }
 
+mz_bool mz_zip_writer_add_staged_compressed_data(mz_zip_writer_staged_context *pContext, const void *pComp_buf, size_t comp_size, mz_uint64 uncomp_size, mz_uint32 uncomp_crc32)
+{
+    if (! pContext->pCompressor)
+        return MZ_FALSE;
+
+    if (pContext->file_ofs + uncomp_size > pContext->max_size)
+    {
+        mz_zip_set_error(pContext->pZip, MZ_ZIP_FILE_READ_FAILED);
+        pContext->pZip->m_pFree(pContext->pZip->m_pAlloc_opaque, pContext->pCompressor);
+        pContext->pCompressor = NULL;
+        return MZ_FALSE;
+    }
+
+    /* Terminate the data compressed by the staged compressor on a byte boundary, reset its dictionary as it must not refer to the appended data. */
+    if (pContext->compressor_has_data)
+    {
+        tdefl_status status = tdefl_compress_buffer(pContext->pCompressor, NULL, 0, TDEFL_FULL_FLUSH);
+        if (status != TDEFL_STATUS_OKAY)
+        {
+            mz_zip_set_error(pContext->pZip, MZ_ZIP_COMPRESSION_FAILED);
+            pContext->pZip->m_pFree(pContext->pZip->m_pAlloc_opaque, pContext->pCompressor);
+            pContext->pCompressor = NULL;
+            return MZ_FALSE;
+        }
+        pContext->compressor_has_data = MZ_FALSE;
+    }
+
+    if (comp_size > 0)
+    {
+        if (pContext->pZip->m_pWrite(pContext->pZip->m_pIO_opaque, pContext->add_state.m_cur_archive_file_ofs, pComp_buf, comp_size) != comp_size)
+        {
+            mz_zip_set_error(pContext->pZip, MZ_ZIP_FILE_WRITE_FAILED);
+            pContext->pZip->m_pFree(pContext->pZip->m_pAlloc_opaque, pContext->pCompressor);
+            pContext->pCompressor = NULL;
+            return MZ_FALSE;
+        }
+        pContext->add_state.m_cur_archive_file_ofs += comp_size;
+        pContext->add_state.m_comp_size += comp_size;
+    }
+
+    pContext->file_ofs += uncomp_size;
+    pContext->uncomp_crc32 = (mz_uint32)mz_crc32_combine(pContext->uncomp_crc32, uncomp_crc32, uncomp_size);
+    return MZ_TRUE;
+}
+
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context *pContext)
 {
     if (! mz_zip_writer_add_staged_data(pContext, NULL, 0) ||
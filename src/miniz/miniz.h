@@ -563,6 +563,9 @@ extern void *miniz_def_realloc_func(void *opaque, void *address, size_t items, s
 #define MZ_UINT16_MAX (0xFFFFU)
 #define MZ_UINT32_MAX (0xFFFFFFFFU)
 
+/* mz_crc32_combine() returns the CRC-32 of two concatenated buffers given the CRC-32 of both and the length of the second one (same as zlib's crc32_combine()). */
+mz_ulong mz_crc32_combine(mz_ulong crc1, mz_ulong crc2, mz_uint64 len2);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1332,6 +1335,8 @@ typedef struct mz_zip_writer_staged_context
     mz_zip_writer_add_state  add_state;
     tdefl_compressor        *pCompressor;
     mz_uint64                file_ofs;
+    /* Was some data passed to the compressor since it was flushed last? */
+    mz_bool                  compressor_has_data;
 
     /*
      * The following data is passed to the "finish" stage, the referenced pointers must still be valid!
@@ -1350,6 +1355,11 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     const char* user_extra_data, mz_uint user_extra_data_len, const char* user_extra_data_central, mz_uint user_extra_data_central_len);
 mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context* pContext, const char* pRead_buf, size_t n);
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context* pContext);
+/* Appends a piece of raw deflate stream compressed outside of the archive (for example on another thread) to the staged file. */
+/* The piece has to consist of complete non-final blocks ending on a byte boundary, without back references before its start, */
+/* that is it has to be compressed by a fresh tdefl_compressor finished with TDEFL_FULL_FLUSH. */
+/* uncomp_size and uncomp_crc32 are the size and the CRC-32 of the uncompressed data of the piece. */
+mz_bool mz_zip_writer_add_staged_compressed_data(mz_zip_writer_staged_context* pContext, const void* pComp_buf, size_t comp_size, mz_uint64 uncomp_size, mz_uint32 uncomp_crc32);
 
 /* Adds a file to an archive by fully cloning the data from another archive. */
 /* This function fully clones the source file's compressed data (no recompression), along with its full filename, extra data (it may add or modify the zip64 local header extra data field), and the optional descriptor following the compressed data. */
@@ -32,12 +32,15 @@
 #include <boost/nowide/fstream.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
-#include <wx/progdlg.h>
-#include <wx/numformatter.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 #include <array>
 #include <algorithm>
 #include <chrono>
+#include <numeric>
 
 namespace Slic3r {
 namespace GUI {
@@ -117,6 +120,7 @@ void GCodeViewer::InstanceVBuffer::reset()
 {
     s_ids.clear();
     buffer.clear();
+    offsets.clear();
     render_ranges.reset();
 }
 
@@ -181,7 +185,7 @@ void GCodeViewer::TBuffer::reset()
     model.reset();
 }
 
-void GCodeViewer::TBuffer::add_path(const GCodeProcessorResult::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id)
+void GCodeViewer::TBuffer::add_path(std::vector<Path>& paths, const GCodeProcessorResult::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id)
 {
     Path::Endpoint endpoint = { b_id, i_id, s_id, move.position };
     // use rounding to reduce the number of generated paths
@@ -719,6 +723,19 @@ bool GCodeViewer::is_loaded(const GCodeProcessorResult& gcode_result) {
     return (m_last_result_id == gcode_result.id);
 }
 
+// Max size of the toolpaths data on gpu, in bytes, over it the chunks out of the visible layers are released:
+// "gcode_viewer_gpu_budget" of the app config in MB if set, otherwise half of the video memory reported by the driver,
+// otherwise 1GB.
+static size_t toolpaths_gpu_budget_bytes()
+{
+    const int budget_mb = std::atoi(get_app_config()->get("gcode_viewer_gpu_budget").c_str());
+    if (budget_mb > 0)
+        return size_t(budget_mb) * 1024 * 1024;
+    // leave the other half to the textures and to the 3D scene
+    const size_t video_memory = OpenGLManager::get_gl_info().get_video_memory_bytes();
+    return (video_memory > 0) ? video_memory / 2 : size_t(1024) * 1024 * 1024;
+}
+
 void GCodeViewer::load(const GCodeProcessorResult& gcode_result, const Print& print, bool initialized)
 {
     // avoid processing if called with the same gcode_result
@@ -841,12 +858,13 @@ void GCodeViewer::refresh(const GCodeProcessorResult& gcode_result, const std::v
 
     // update ranges for coloring / legend
     m_extrusions.reset_ranges();
+    GCodeProcessorResult::MoveVertices::Cursor cursor;
     for (size_t i = 0; i < m_moves_count; ++i) {
         // skip first vertex
         if (i == 0)
             continue;
 
-        const GCodeProcessorResult::MoveVertex& curr = gcode_result.moves[i];
+        const GCodeProcessorResult::MoveVertex curr = gcode_result.moves.get(i, cursor);
 
         switch (curr.type)
         {
@@ -898,6 +916,14 @@ void GCodeViewer::update_shells_color_by_extruder(const DynamicPrintConfig* conf
 
 void GCodeViewer::reset()
 {
+    // the loader threads read the chunks and the moves
+    stop_loader();
+    m_chunks.clear();
+    m_chunks_appended = 0;
+    m_moves.reset();
+    m_biased_seams_ids = std::vector<size_t>();
+    m_options_zs = std::vector<float>();
+
     m_moves_count = 0;
     for (TBuffer& buffer : m_buffers) {
         buffer.reset();
@@ -936,6 +962,9 @@ void GCodeViewer::render()
     if (m_roles.empty())
         return;
 
+    // append the toolpaths built by the loader threads since the last frame
+    update_toolpaths_chunks();
+
     glsafe(::glEnable(GL_DEPTH_TEST));
     render_toolpaths();
     render_shells();
@@ -953,7 +982,7 @@ void GCodeViewer::render()
 
 bool GCodeViewer::can_export_toolpaths() const
 {
-    return has_data() && m_buffers[buffer_id(EMoveType::Extrude)].render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle;
+    return has_data() && !is_loading() && m_buffers[buffer_id(EMoveType::Extrude)].render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle;
 }
 
 void GCodeViewer::update_sequential_view_current(unsigned int first, unsigned int last)
@@ -1142,11 +1171,14 @@ void GCodeViewer::export_toolpaths_to_obj(const char* filename) const
 
     // get vertices/normals data from vertex buffers on gpu
     for (size_t i = 0; i < t_buffer.vertices.vbos.size(); ++i) {
-        const size_t floats_count = t_buffer.vertices.sizes[i] / sizeof(float);
+        // the vertex buffers released to stay into the gpu memory budget are not exported
+        const size_t floats_count = (t_buffer.vertices.vbos[i] > 0) ? t_buffer.vertices.sizes[i] / sizeof(float) : 0;
         VertexBuffer vertices(floats_count);
-        glsafe(::glBindBuffer(GL_ARRAY_BUFFER, t_buffer.vertices.vbos[i]));
-        glsafe(::glGetBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(t_buffer.vertices.sizes[i]), static_cast<void*>(vertices.data())));
-        glsafe(::glBindBuffer(GL_ARRAY_BUFFER, 0));
+        if (floats_count > 0) {
+            glsafe(::glBindBuffer(GL_ARRAY_BUFFER, t_buffer.vertices.vbos[i]));
+            glsafe(::glGetBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(t_buffer.vertices.sizes[i]), static_cast<void*>(vertices.data())));
+            glsafe(::glBindBuffer(GL_ARRAY_BUFFER, 0));
+        }
         const size_t vertices_count = floats_count / floats_per_vertex;
         for (size_t j = 0; j < vertices_count; ++j) {
             const size_t base = j * floats_per_vertex;
@@ -1181,6 +1213,9 @@ void GCodeViewer::export_toolpaths_to_obj(const char* filename) const
                 continue;
 
             const IBuffer& ibuffer = t_buffer.indices[render_path.ibuffer_id];
+            if (ibuffer.ibo == 0)
+                continue;
+
             size_t vertices_offset = 0;
             for (size_t j = 0; j < vertices_offsets.size(); ++j) {
                 const VerticesOffset& offset = vertices_offsets[j];
@@ -1216,26 +1251,198 @@ void GCodeViewer::export_toolpaths_to_obj(const char* filename) const
     fclose(fp);
 }
 
+// returns the index into the moves of the result of the move with the given id, as counted without the seams
+static size_t extract_move_id(const std::vector<size_t>& biased_seams_ids, size_t id)
+{
+    size_t new_id = size_t(-1);
+    auto it = std::lower_bound(biased_seams_ids.begin(), biased_seams_ids.end(), id);
+    if (it == biased_seams_ids.end())
+        new_id = id + biased_seams_ids.size();
+    else {
+        if (it == biased_seams_ids.begin() && *it < id)
+            new_id = id;
+        else if (it != biased_seams_ids.begin())
+            new_id = id + std::distance(biased_seams_ids.begin(), it);
+    }
+    return (new_id == size_t(-1)) ? id : new_id;
+}
+
+size_t GCodeViewer::ToolpathsChunk::data_size_bytes() const
+{
+    size_t size = 0;
+    for (const MultiVertexBuffer& buffers : vertices) {
+        for (const VertexBuffer& buffer : buffers) {
+            size += buffer.size() * sizeof(float);
+        }
+    }
+    for (const MultiIndexBuffer& buffers : indices) {
+        for (const IndexBuffer& buffer : buffers) {
+            size += buffer.size() * sizeof(IBufferType);
+        }
+    }
+    return size;
+}
+
+void GCodeViewer::ToolpathsChunk::release_data()
+{
+    std::vector<std::vector<Path>>().swap(paths);
+    std::vector<MultiVertexBuffer>().swap(vertices);
+    std::vector<MultiIndexBuffer>().swap(indices);
+    std::vector<std::vector<unsigned int>>().swap(vbo_indices);
+    std::vector<InstanceBuffer>().swap(instances);
+    std::vector<InstanceIdBuffer>().swap(instances_ids);
+    std::vector<InstancesOffsets>().swap(instances_offsets);
+}
+
 void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 {
-    // max index buffer size, in bytes
-    static const size_t IBUFFER_THRESHOLD_BYTES = 64 * 1024 * 1024;
+    // min count of moves of a chunk, the toolpaths are built by ranges of layers
+    static const size_t CHUNK_MIN_MOVES = 100000;
 
-    auto log_memory_usage = [this](const std::string& label, const std::vector<MultiVertexBuffer>& vertices, const std::vector<MultiIndexBuffer>& indices) {
-        int64_t vertices_size = 0;
-        for (const MultiVertexBuffer& buffers : vertices) {
-            for (const VertexBuffer& buffer : buffers) {
-                vertices_size += SLIC3R_STDVEC_MEMSIZE(buffer, float);
-            }
+#if ENABLE_GCODE_VIEWER_STATISTICS
+    m_load_start_time = std::chrono::high_resolution_clock::now();
+    m_statistics.results_size = gcode_result.moves.memory_size();
+    m_statistics.results_time = gcode_result.time;
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+
+    m_moves_count = gcode_result.moves.size();
+    if (m_moves_count == 0)
+        return;
+
+    m_extruders_count = gcode_result.extruders_count;
+
+    wxBusyCursor busy;
+
+    // extract approximate paths bounding box from result
+    for (const GCodeProcessorResult::MoveVertex& move : gcode_result.moves) {
+        if (wxGetApp().is_gcode_viewer())
+            // for the gcode viewer we need to take in account all moves to correctly size the printbed
+            m_paths_bounding_box.merge(move.position.cast<double>());
+        else {
+            if (move.type == EMoveType::Extrude && move.extrusion_role != erCustom && move.width != 0.0f && move.height != 0.0f)
+                m_paths_bounding_box.merge(move.position.cast<double>());
         }
-        int64_t indices_size = 0;
-        for (const MultiIndexBuffer& buffers : indices) {
-            for (const IndexBuffer& buffer : buffers) {
-                indices_size += SLIC3R_STDVEC_MEMSIZE(buffer, IBufferType);
-            }
+    }
+
+    // set approximate max bounding box (take in account also the tool marker)
+    m_max_bounding_box = m_paths_bounding_box;
+    m_max_bounding_box.merge(m_paths_bounding_box.max + m_sequential_view.marker.get_bounding_box().size().z() * Vec3d::UnitZ());
+
+    if (wxGetApp().is_editor())
+        m_contained_in_bed = wxGetApp().plater()->build_volume().all_paths_inside(gcode_result, m_paths_bounding_box);
+
+    m_sequential_view.gcode_ids.clear();
+    for (const GCodeProcessorResult::MoveVertex& move : gcode_result.moves) {
+        if (move.type != EMoveType::Seam)
+            m_sequential_view.gcode_ids.push_back(move.gcode_id);
+    }
+
+    // layers zs / roles / extruder ids / seams / options zs -> extract from result
+    size_t last_travel_s_id = 0;
+    size_t seams_count = 0;
+    GCodeProcessorResult::MoveVertices::Cursor curr_cursor;
+    for (size_t i = 0; i < m_moves_count; ++i) {
+        const GCodeProcessorResult::MoveVertex move = gcode_result.moves.get(i, curr_cursor);
+        if (move.type == EMoveType::Seam) {
+            ++seams_count;
+            m_biased_seams_ids.push_back(i - seams_count);
         }
-        log_memory_used(label, vertices_size + indices_size);
-    };
+
+        size_t move_id = i - seams_count;
+
+        if (move.type == EMoveType::Extrude) {
+            // layers zs
+            const double* const last_z = m_layers.empty() ? nullptr : &m_layers.get_zs().back();
+            const double z = static_cast<double>(move.position.z());
+            if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z)
+                m_layers.append(z, { last_travel_s_id, move_id });
+            else
+                m_layers.get_endpoints().back().last = move_id;
+            // extruder ids
+            m_extruder_ids.emplace_back(move.extruder_id);
+            // roles
+            if (i > 0)
+                m_roles.emplace_back(move.extrusion_role);
+        }
+        else if (move.type == EMoveType::Travel) {
+            if (move_id - last_travel_s_id > 1 && !m_layers.empty())
+                m_layers.get_endpoints().back().last = move_id;
+
+            last_travel_s_id = move_id;
+        }
+        else if (i > 0 && (move.type == EMoveType::Pause_Print || move.type == EMoveType::Custom_GCode)) {
+            // collect options zs for later use
+            const float* const last_z = m_options_zs.empty() ? nullptr : &m_options_zs.back();
+            if (last_z == nullptr || move.position[2] < *last_z - EPSILON || *last_z + EPSILON < move.position[2])
+                m_options_zs.emplace_back(move.position[2]);
+        }
+    }
+
+    // roles -> remove duplicates
+    sort_remove_duplicates(m_roles);
+    m_roles.shrink_to_fit();
+
+    // extruder ids -> remove duplicates
+    sort_remove_duplicates(m_extruder_ids);
+    m_extruder_ids.shrink_to_fit();
+
+#if ENABLE_SPIRAL_VASE_LAYERS
+    // replace layers for spiral vase mode
+    if (!gcode_result.spiral_vase_layers.empty()) {
+        m_layers.reset();
+        for (const auto& layer : gcode_result.spiral_vase_layers) {
+            m_layers.append(layer.first, { layer.second.first, layer.second.second });
+        }
+    }
+#endif // ENABLE_SPIRAL_VASE_LAYERS
+
+    if (m_layers.empty())
+        return;
+
+    // set layers z range
+    m_layers_z_range = { 0, static_cast<unsigned int>(m_layers.size() - 1) };
+
+    // toolpaths data -> split the moves into ranges of layers, built by the loader threads
+    // (the copy shares the columns of the moves, it doesn't copy them)
+    m_moves = std::make_shared<const GCodeProcessorResult::MoveVertices>(gcode_result.moves);
+    m_gpu_budget_bytes = toolpaths_gpu_budget_bytes();
+    size_t first_move = 0;
+    size_t seams_before = 0;
+    unsigned int first_layer = 0;
+    for (unsigned int l = 1; l <= static_cast<unsigned int>(m_layers.size()); ++l) {
+        size_t last_move = m_moves_count;
+        size_t next_seams_before = seams_count;
+        if (l < static_cast<unsigned int>(m_layers.size())) {
+            // the chunks start with the travel to their first layer
+            const size_t s_id = m_layers.get_endpoints_at(l).first;
+            last_move = extract_move_id(m_biased_seams_ids, s_id);
+            if (last_move < first_move + CHUNK_MIN_MOVES || last_move >= m_moves_count)
+                continue;
+            next_seams_before = last_move - s_id;
+        }
+
+        m_chunks.push_back(std::make_unique<ToolpathsChunk>());
+        ToolpathsChunk& chunk = *m_chunks.back();
+        chunk.first_move = first_move;
+        chunk.last_move = last_move;
+        chunk.seams_before = seams_before;
+        chunk.first_layer = first_layer;
+        chunk.last_layer = l - 1;
+
+        first_move = last_move;
+        seams_before = next_seams_before;
+        first_layer = l;
+    }
+
+    std::vector<size_t> chunks_ids(m_chunks.size());
+    std::iota(chunks_ids.begin(), chunks_ids.end(), 0);
+    start_loader(std::move(chunks_ids));
+}
+
+void GCodeViewer::build_toolpaths_chunk(ToolpathsChunk& chunk) const
+{
+    // max index buffer size, in bytes
+    static const size_t IBUFFER_THRESHOLD_BYTES = 64 * 1024 * 1024;
 
     // format data into the buffers to be rendered as points
     auto add_vertices_as_point = [](const GCodeProcessorResult::MoveVertex& curr, VertexBuffer& vertices) {
@@ -1243,9 +1450,9 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         vertices.push_back(curr.position.y());
         vertices.push_back(curr.position.z());
     };
-    auto add_indices_as_point = [](const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_point = [](const GCodeProcessorResult::MoveVertex& curr, std::vector<Path>& paths,
         unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            buffer.add_path(curr, ibuffer_id, indices.size(), move_id);
+            TBuffer::add_path(paths, curr, ibuffer_id, indices.size(), move_id);
             indices.push_back(static_cast<IBufferType>(indices.size()));
     };
 
@@ -1272,16 +1479,16 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         // add current vertex
         add_vertex(curr);
     };
-    auto add_indices_as_line = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_line = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, std::vector<Path>& paths,
         unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            if (buffer.paths.empty() || prev.type != curr.type || !buffer.paths.back().matches(curr)) {
+            if (paths.empty() || prev.type != curr.type || !paths.back().matches(curr)) {
                 // add starting index
                 indices.push_back(static_cast<IBufferType>(indices.size()));
-                buffer.add_path(curr, ibuffer_id, indices.size() - 1, move_id - 1);
-                buffer.paths.back().sub_paths.front().first.position = prev.position;
+                TBuffer::add_path(paths, curr, ibuffer_id, indices.size() - 1, move_id - 1);
+                paths.back().sub_paths.front().first.position = prev.position;
             }
 
-            Path& last_path = buffer.paths.back();
+            Path& last_path = paths.back();
             if (last_path.sub_paths.front().first.i_id != last_path.sub_paths.back().last.i_id) {
                 // add previous index
                 indices.push_back(static_cast<IBufferType>(indices.size()));
@@ -1293,7 +1500,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
     };
 
     // format data into the buffers to be rendered as solid
-    auto add_vertices_as_solid = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, TBuffer& buffer, unsigned int vbuffer_id, VertexBuffer& vertices, size_t move_id) {
+    auto add_vertices_as_solid = [](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, std::vector<Path>& paths, unsigned int vbuffer_id, VertexBuffer& vertices, size_t move_id) {
         auto store_vertex = [](VertexBuffer& vertices, const Vec3f& position, const Vec3f& normal) {
             // append position
             vertices.push_back(position.x());
@@ -1305,12 +1512,12 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
             vertices.push_back(normal.z());
         };
 
-        if (buffer.paths.empty() || prev.type != curr.type || !buffer.paths.back().matches(curr)) {
-            buffer.add_path(curr, vbuffer_id, vertices.size(), move_id - 1);
-            buffer.paths.back().sub_paths.back().first.position = prev.position;
+        if (paths.empty() || prev.type != curr.type || !paths.back().matches(curr)) {
+            TBuffer::add_path(paths, curr, vbuffer_id, vertices.size(), move_id - 1);
+            paths.back().sub_paths.back().first.position = prev.position;
         }
 
-        Path& last_path = buffer.paths.back();
+        Path& last_path = paths.back();
 
         const Vec3f dir = (curr.position - prev.position).normalized();
         const Vec3f right = Vec3f(dir.y(), -dir.x(), 0.0f).normalized();
@@ -1350,11 +1557,13 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 
         last_path.sub_paths.back().last = { vbuffer_id, vertices.size(), move_id, curr.position };
     };
+    // direction of the previous segment, used to build the corners
+    Vec3f prev_dir;
+    Vec3f prev_up;
+    float sq_prev_length = 0.0f;
+    // the last segment of a chunk gets the ending cap of its path, as the path is continued by another one in the next chunk
     auto add_indices_as_solid = [&](const GCodeProcessorResult::MoveVertex& prev, const GCodeProcessorResult::MoveVertex& curr, const GCodeProcessorResult::MoveVertex* next,
-        TBuffer& buffer, size_t& vbuffer_size, unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            static Vec3f prev_dir;
-            static Vec3f prev_up;
-            static float sq_prev_length;
+        bool last_of_chunk, std::vector<Path>& paths, size_t& vbuffer_size, unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
             auto store_triangle = [](IndexBuffer& indices, IBufferType i1, IBufferType i2, IBufferType i3) {
                 indices.push_back(i1);
                 indices.push_back(i2);
@@ -1396,12 +1605,12 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                 store_triangle(indices, v_offsets[4], v_offsets[5], v_offsets[6]);
             };
 
-            if (buffer.paths.empty() || prev.type != curr.type || !buffer.paths.back().matches(curr)) {
-                buffer.add_path(curr, ibuffer_id, indices.size(), move_id - 1);
-                buffer.paths.back().sub_paths.back().first.position = prev.position;
+            if (paths.empty() || prev.type != curr.type || !paths.back().matches(curr)) {
+                TBuffer::add_path(paths, curr, ibuffer_id, indices.size(), move_id - 1);
+                paths.back().sub_paths.back().first.position = prev.position;
             }
 
-            Path& last_path = buffer.paths.back();
+            Path& last_path = paths.back();
 
             const Vec3f dir = (curr.position - prev.position).normalized();
             const Vec3f right = Vec3f(dir.y(), -dir.x(), 0.0f).normalized();
@@ -1480,7 +1689,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                 vbuffer_size += 6;
             }
 
-            if (next != nullptr && (curr.type != next->type || !last_path.matches(*next)))
+            if (next != nullptr && (last_of_chunk || curr.type != next->type || !last_path.matches(*next)))
                 // ending cap triangles
                 append_ending_cap_triangles(indices, is_first_segment ? first_seg_v_offsets : non_first_seg_v_offsets);
 
@@ -1548,68 +1757,32 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto start_time = std::chrono::high_resolution_clock::now();
-    m_statistics.results_size = SLIC3R_STDVEC_MEMSIZE(gcode_result.moves, GCodeProcessorResult::MoveVertex);
-    m_statistics.results_time = gcode_result.time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
-    m_moves_count = gcode_result.moves.size();
-    if (m_moves_count == 0)
-        return;
-
-    m_extruders_count = gcode_result.extruders_count;
-
-    unsigned int progress_count = 0;
-    static const unsigned int progress_threshold = 1000;
-    wxProgressDialog* progress_dialog = wxGetApp().is_gcode_viewer() ?
-        new wxProgressDialog(_L("Generating toolpaths"), "...",
-            100, wxGetApp().mainframe, wxPD_AUTO_HIDE | wxPD_APP_MODAL) : nullptr;
-
-    wxBusyCursor busy;
+    const GCodeProcessorResult::MoveVertices& moves = *m_moves;
+    const size_t moves_count = moves.size();
 
-    // extract approximate paths bounding box from result
-    for (const GCodeProcessorResult::MoveVertex& move : gcode_result.moves) {
-        if (wxGetApp().is_gcode_viewer())
-            // for the gcode viewer we need to take in account all moves to correctly size the printbed
-            m_paths_bounding_box.merge(move.position.cast<double>());
-        else {
-            if (move.type == EMoveType::Extrude && move.extrusion_role != erCustom && move.width != 0.0f && move.height != 0.0f)
-                m_paths_bounding_box.merge(move.position.cast<double>());
-        }
-    }
-
-    // set approximate max bounding box (take in account also the tool marker)
-    m_max_bounding_box = m_paths_bounding_box;
-    m_max_bounding_box.merge(m_paths_bounding_box.max + m_sequential_view.marker.get_bounding_box().size().z() * Vec3d::UnitZ());
-
-    if (wxGetApp().is_editor())
-        m_contained_in_bed = wxGetApp().plater()->build_volume().all_paths_inside(gcode_result, m_paths_bounding_box);
-
-    m_sequential_view.gcode_ids.clear();
-    for (size_t i = 0; i < gcode_result.moves.size(); ++i) {
-        const GCodeProcessorResult::MoveVertex& move = gcode_result.moves[i];
-        if (move.type != EMoveType::Seam)
-            m_sequential_view.gcode_ids.push_back(move.gcode_id);
-    }
-
-    std::vector<MultiVertexBuffer> vertices(m_buffers.size());
-    std::vector<MultiIndexBuffer> indices(m_buffers.size());
-    std::vector<InstanceBuffer> instances(m_buffers.size());
-    std::vector<InstanceIdBuffer> instances_ids(m_buffers.size());
-    std::vector<InstancesOffsets> instances_offsets(m_buffers.size());
-    std::vector<float> options_zs;
-
-    size_t seams_count = 0;
-    std::vector<size_t> biased_seams_ids;
+    // paths of the vertex buffers, used to smooth the corners
+    std::vector<std::vector<Path>> paths(m_buffers.size());
+    std::vector<MultiVertexBuffer>& vertices = chunk.vertices;
+    vertices.assign(m_buffers.size(), MultiVertexBuffer());
+    chunk.instances.assign(m_buffers.size(), InstanceBuffer());
+    chunk.instances_ids.assign(m_buffers.size(), InstanceIdBuffer());
+    chunk.instances_offsets.assign(m_buffers.size(), InstancesOffsets());
 
     // toolpaths data -> extract vertices from result
-    for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessorResult::MoveVertex& curr = gcode_result.moves[i];
+    size_t seams_count = chunk.seams_before;
+    GCodeProcessorResult::MoveVertices::Cursor prev_cursor;
+    GCodeProcessorResult::MoveVertices::Cursor curr_cursor;
+    for (size_t i = chunk.first_move; i < chunk.last_move; ++i) {
+        if ((i & 0xFFFF) == 0 && m_loader_cancel)
+            return;
+
+        const GCodeProcessorResult::MoveVertex curr = moves.get(i, curr_cursor);
         if (curr.type == EMoveType::Noop)
             continue;
-        if (curr.type == EMoveType::Seam) {
+        if (curr.type == EMoveType::Seam)
             ++seams_count;
-            biased_seams_ids.push_back(i - biased_seams_ids.size() - 1);
-        }
 
         size_t move_id = i - seams_count;
 
@@ -1617,24 +1790,16 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         if (i == 0)
             continue;
 
-        const GCodeProcessorResult::MoveVertex& prev = gcode_result.moves[i - 1];
+        const GCodeProcessorResult::MoveVertex prev = moves.get(i - 1, prev_cursor);
 
-        // update progress dialog
-        ++progress_count;
-        if (progress_dialog != nullptr && progress_count % progress_threshold == 0) {
-            progress_dialog->Update(int(100.0f * float(i) / (2.0f * float(m_moves_count))),
-                _L("Generating vertex buffer") + ": " + wxNumberFormatter::ToString(100.0 * double(i) / double(m_moves_count), 0, wxNumberFormatter::Style_None) + "%");
-            progress_dialog->Fit();
-            progress_count = 0;
-        }
-        
         assert(curr.type > EMoveType::Noop);
         const unsigned char id = buffer_id(curr.type);
-        TBuffer& t_buffer = m_buffers[id];
+        const TBuffer& t_buffer = m_buffers[id];
+        std::vector<Path>& t_paths = paths[id];
         MultiVertexBuffer& v_multibuffer = vertices[id];
-        InstanceBuffer& inst_buffer = instances[id];
-        InstanceIdBuffer& inst_id_buffer = instances_ids[id];
-        InstancesOffsets& inst_offsets = instances_offsets[id];
+        InstanceBuffer& inst_buffer = chunk.instances[id];
+        InstanceIdBuffer& inst_id_buffer = chunk.instances_ids[id];
+        InstancesOffsets& inst_offsets = chunk.instances_offsets[id];
 
         // ensure there is at least one vertex buffer
         if (v_multibuffer.empty())
@@ -1646,7 +1811,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         if (v_multibuffer.back().size() * sizeof(float) > t_buffer.vertices.max_size_bytes() - vertices_size_to_add) {
             v_multibuffer.push_back(VertexBuffer());
             if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle) {
-                Path& last_path = t_buffer.paths.back();
+                Path& last_path = t_paths.back();
                 if (prev.type == curr.type && last_path.matches(curr))
                     last_path.add_sub_path(prev, static_cast<unsigned int>(v_multibuffer.size()) - 1, 0, move_id - 1);
             }
@@ -1658,37 +1823,24 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         {
         case TBuffer::ERenderPrimitiveType::Point:    { add_vertices_as_point(curr, v_buffer); break; }
         case TBuffer::ERenderPrimitiveType::Line:     { add_vertices_as_line(prev, curr, v_buffer); break; }
-        case TBuffer::ERenderPrimitiveType::Triangle: { add_vertices_as_solid(prev, curr, t_buffer, static_cast<unsigned int>(v_multibuffer.size()) - 1, v_buffer, move_id); break; }
+        case TBuffer::ERenderPrimitiveType::Triangle: { add_vertices_as_solid(prev, curr, t_paths, static_cast<unsigned int>(v_multibuffer.size()) - 1, v_buffer, move_id); break; }
         case TBuffer::ERenderPrimitiveType::InstancedModel:
         {
             add_model_instance(curr, inst_buffer, inst_id_buffer, move_id);
             inst_offsets.push_back(prev.position - curr.position);
-#if ENABLE_GCODE_VIEWER_STATISTICS
-            ++m_statistics.instances_count;
-#endif // ENABLE_GCODE_VIEWER_STATISTICS
             break;
         }
         case TBuffer::ERenderPrimitiveType::BatchedModel:
         {
             add_vertices_as_model_batch(curr, t_buffer.model.data, v_buffer, inst_buffer, inst_id_buffer, move_id);
             inst_offsets.push_back(prev.position - curr.position);
-#if ENABLE_GCODE_VIEWER_STATISTICS
-            ++m_statistics.batched_count;
-#endif // ENABLE_GCODE_VIEWER_STATISTICS
             break;
         }
         }
-
-        // collect options zs for later use
-        if (curr.type == EMoveType::Pause_Print || curr.type == EMoveType::Custom_GCode) {
-            const float* const last_z = options_zs.empty() ? nullptr : &options_zs.back();
-            if (last_z == nullptr || curr.position[2] < *last_z - EPSILON || *last_z + EPSILON < curr.position[2])
-                options_zs.emplace_back(curr.position[2]);
-        }
     }
 
-    // smooth toolpaths corners for the given TBuffer using triangles
-    auto smooth_triangle_toolpaths_corners = [&gcode_result, &biased_seams_ids](const TBuffer& t_buffer, MultiVertexBuffer& v_multibuffer) {
+    // smooth toolpaths corners for the given paths using triangles
+    auto smooth_triangle_toolpaths_corners = [this, &moves](const std::vector<Path>& t_paths, size_t vertex_size_floats, MultiVertexBuffer& v_multibuffer) {
         auto extract_position_at = [](const VertexBuffer& vertices, size_t offset) {
             return Vec3f(vertices[offset + 0], vertices[offset + 1], vertices[offset + 2]);
         };
@@ -1703,7 +1855,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                     VertexBuffer& vbuffer = v_multibuffer[prev_sub_path.first.b_id];
                     // offset into the vertex buffer of the next segment 1st vertex
                     const size_t next_1st_offset = (prev_sub_path.last.s_id - curr_s_id) * 6 * vertex_size_floats;
-                    // offset into the vertex buffer of the right vertex of the previous segment 
+                    // offset into the vertex buffer of the right vertex of the previous segment
                     const size_t prev_right_offset = prev_sub_path.last.i_id - next_1st_offset - 3 * vertex_size_floats;
                     // new position of the right vertices
                     const Vec3f shared_vertex = extract_position_at(vbuffer, prev_right_offset) + displacement_vec;
@@ -1717,7 +1869,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                 else { // previous and next segment are contained into different vertex buffers
                     VertexBuffer& prev_vbuffer = v_multibuffer[prev_sub_path.first.b_id];
                     VertexBuffer& next_vbuffer = v_multibuffer[next_sub_path.first.b_id];
-                    // offset into the previous vertex buffer of the right vertex of the previous segment 
+                    // offset into the previous vertex buffer of the right vertex of the previous segment
                     const size_t prev_right_offset = prev_sub_path.last.i_id - 3 * vertex_size_floats;
                     // new position of the right vertices
                     const Vec3f shared_vertex = extract_position_at(prev_vbuffer, prev_right_offset) + displacement_vec;
@@ -1735,7 +1887,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                     VertexBuffer& vbuffer = v_multibuffer[prev_sub_path.first.b_id];
                     // offset into the vertex buffer of the next segment 1st vertex
                     const size_t next_1st_offset = (prev_sub_path.last.s_id - curr_s_id) * 6 * vertex_size_floats;
-                    // offset into the vertex buffer of the left vertex of the previous segment 
+                    // offset into the vertex buffer of the left vertex of the previous segment
                     const size_t prev_left_offset = prev_sub_path.last.i_id - next_1st_offset - 1 * vertex_size_floats;
                     // new position of the left vertices
                     const Vec3f shared_vertex = extract_position_at(vbuffer, prev_left_offset) + displacement_vec;
@@ -1749,7 +1901,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                 else { // previous and next segment are contained into different vertex buffers
                     VertexBuffer& prev_vbuffer = v_multibuffer[prev_sub_path.first.b_id];
                     VertexBuffer& next_vbuffer = v_multibuffer[next_sub_path.first.b_id];
-                    // offset into the previous vertex buffer of the left vertex of the previous segment 
+                    // offset into the previous vertex buffer of the left vertex of the previous segment
                     const size_t prev_left_offset = prev_sub_path.last.i_id - 1 * vertex_size_floats;
                     // new position of the left vertices
                     const Vec3f shared_vertex = extract_position_at(prev_vbuffer, prev_left_offset) + displacement_vec;
@@ -1762,22 +1914,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
                 }
         };
 
-        auto extract_move_id = [&biased_seams_ids](size_t id) {
-            size_t new_id = size_t(-1);
-            auto it = std::lower_bound(biased_seams_ids.begin(), biased_seams_ids.end(), id);
-            if (it == biased_seams_ids.end())
-                new_id = id + biased_seams_ids.size();
-            else {
-                if (it == biased_seams_ids.begin() && *it < id)
-                    new_id = id;
-                else if (it != biased_seams_ids.begin())
-                    new_id = id + std::distance(biased_seams_ids.begin(), it);
-            }
-            return (new_id == size_t(-1)) ? id : new_id;
-        };
-
-        const size_t vertex_size_floats = t_buffer.vertices.vertex_size_floats();
-        for (const Path& path : t_buffer.paths) {
+        for (const Path& path : t_paths) {
             // the two segments of the path sharing the current vertex may belong
             // to two different vertex buffers
             size_t prev_sub_path_id = 0;
@@ -1786,10 +1923,10 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
             const float half_width = 0.5f * path.width;
             for (size_t j = 1; j < path_vertices_count - 1; ++j) {
                 const size_t curr_s_id = path.sub_paths.front().first.s_id + j;
-                const size_t move_id = extract_move_id(curr_s_id);
-                const Vec3f& prev = gcode_result.moves[move_id - 1].position;
-                const Vec3f& curr = gcode_result.moves[move_id].position;
-                const Vec3f& next = gcode_result.moves[move_id + 1].position;
+                const size_t move_id = extract_move_id(m_biased_seams_ids, curr_s_id);
+                const Vec3f& prev = moves.position(move_id - 1);
+                const Vec3f& curr = moves.position(move_id);
+                const Vec3f& next = moves.position(move_id + 1);
 
                 // select the subpaths which contains the previous/next segments
                 if (!path.sub_paths[prev_sub_path_id].contains(curr_s_id))
@@ -1845,19 +1982,16 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto load_vertices_time = std::chrono::high_resolution_clock::now();
-    m_statistics.load_vertices = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+    chunk.load_vertices = std::chrono::duration_cast<std::chrono::milliseconds>(load_vertices_time - start_time).count();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
     // smooth toolpaths corners for TBuffers using triangles
     for (size_t i = 0; i < m_buffers.size(); ++i) {
         const TBuffer& t_buffer = m_buffers[i];
         if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle)
-            smooth_triangle_toolpaths_corners(t_buffer, vertices[i]);
+            smooth_triangle_toolpaths_corners(paths[i], t_buffer.vertices.vertex_size_floats(), vertices[i]);
     }
 
-    // dismiss, no more needed
-    std::vector<size_t>().swap(biased_seams_ids);
-
     for (MultiVertexBuffer& v_multibuffer : vertices) {
         for (VertexBuffer& v_buffer : v_multibuffer) {
             v_buffer.shrink_to_fit();
@@ -1872,81 +2006,33 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         }
     }
 
-    // send vertices data to gpu, where needed
-    for (size_t i = 0; i < m_buffers.size(); ++i) {
-        TBuffer& t_buffer = m_buffers[i];
-        if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::InstancedModel) {
-            const InstanceBuffer& inst_buffer = instances[i];
-            if (!inst_buffer.empty()) {
-                t_buffer.model.instances.buffer = inst_buffer;
-                t_buffer.model.instances.s_ids = instances_ids[i];
-                t_buffer.model.instances.offsets = instances_offsets[i];
-            }
-        }
-        else {
-            if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::BatchedModel) {
-                const InstanceBuffer& inst_buffer = instances[i];
-                if (!inst_buffer.empty()) {
-                    t_buffer.model.instances.buffer = inst_buffer;
-                    t_buffer.model.instances.s_ids = instances_ids[i];
-                    t_buffer.model.instances.offsets = instances_offsets[i];
-                }
-            }
-            const MultiVertexBuffer& v_multibuffer = vertices[i];
-            for (const VertexBuffer& v_buffer : v_multibuffer) {
-                const size_t size_elements = v_buffer.size();
-                const size_t size_bytes = size_elements * sizeof(float);
-                const size_t vertices_count = size_elements / t_buffer.vertices.vertex_size_floats();
-                t_buffer.vertices.count += vertices_count;
-
-#if ENABLE_GCODE_VIEWER_STATISTICS
-                m_statistics.total_vertices_gpu_size += static_cast<int64_t>(size_bytes);
-                m_statistics.max_vbuffer_gpu_size = std::max(m_statistics.max_vbuffer_gpu_size, static_cast<int64_t>(size_bytes));
-                ++m_statistics.vbuffers_count;
-#endif // ENABLE_GCODE_VIEWER_STATISTICS
-
-                GLuint id = 0;
-                glsafe(::glGenBuffers(1, &id));
-                glsafe(::glBindBuffer(GL_ARRAY_BUFFER, id));
-                glsafe(::glBufferData(GL_ARRAY_BUFFER, size_bytes, v_buffer.data(), GL_STATIC_DRAW));
-                glsafe(::glBindBuffer(GL_ARRAY_BUFFER, 0));
-
-                t_buffer.vertices.vbos.push_back(static_cast<unsigned int>(id));
-                t_buffer.vertices.sizes.push_back(size_bytes);
-            }
-        }
-    }
-
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto smooth_vertices_time = std::chrono::high_resolution_clock::now();
-    m_statistics.smooth_vertices = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - load_vertices_time).count();
+    chunk.smooth_vertices = std::chrono::duration_cast<std::chrono::milliseconds>(smooth_vertices_time - load_vertices_time).count();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
-    log_memory_usage("Loaded G-code generated vertex buffers ", vertices, indices);
-
-    // dismiss vertices data, no more needed
-    std::vector<MultiVertexBuffer>().swap(vertices);
-    std::vector<InstanceBuffer>().swap(instances);
-    std::vector<InstanceIdBuffer>().swap(instances_ids);
 
     // toolpaths data -> extract indices from result
-    // paths may have been filled while extracting vertices,
-    // so reset them, they will be filled again while extracting indices
-    for (TBuffer& buffer : m_buffers) {
-        buffer.paths.clear();
-    }
+    // paths have been filled while extracting vertices,
+    // they are filled again while extracting indices
+    std::vector<std::vector<Path>>().swap(paths);
+    chunk.paths.assign(m_buffers.size(), std::vector<Path>());
+    chunk.indices.assign(m_buffers.size(), MultiIndexBuffer());
+    chunk.vbo_indices.assign(m_buffers.size(), std::vector<unsigned int>());
 
     // variable used to keep track of the current vertex buffers index and size
     using CurrVertexBuffer = std::pair<unsigned int, size_t>;
     std::vector<CurrVertexBuffer> curr_vertex_buffers(m_buffers.size(), { 0, 0 });
 
-    // variable used to keep track of the vertex buffers ids
-    using VboIndexList = std::vector<unsigned int>;
-    std::vector<VboIndexList> vbo_indices(m_buffers.size());
+    seams_count = chunk.seams_before;
 
-    seams_count = 0;
+    GCodeProcessorResult::MoveVertices::Cursor next_cursor;
+    prev_cursor = GCodeProcessorResult::MoveVertices::Cursor();
+    curr_cursor = GCodeProcessorResult::MoveVertices::Cursor();
+    for (size_t i = chunk.first_move; i < chunk.last_move; ++i) {
+        if ((i & 0xFFFF) == 0 && m_loader_cancel)
+            return;
 
-    for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessorResult::MoveVertex& curr = gcode_result.moves[i];
+        const GCodeProcessorResult::MoveVertex curr = moves.get(i, curr_cursor);
         if (curr.type == EMoveType::Noop)
             continue;
         if (curr.type == EMoveType::Seam)
@@ -1958,31 +2044,26 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         if (i == 0)
             continue;
 
-        const GCodeProcessorResult::MoveVertex& prev = gcode_result.moves[i - 1];
+        const GCodeProcessorResult::MoveVertex prev = moves.get(i - 1, prev_cursor);
+        GCodeProcessorResult::MoveVertex next_vertex;
         const GCodeProcessorResult::MoveVertex* next = nullptr;
-        if (i < m_moves_count - 1)
-            next = &gcode_result.moves[i + 1];
-
-        ++progress_count;
-        if (progress_dialog != nullptr && progress_count % progress_threshold == 0) {
-            progress_dialog->Update(int(100.0f * float(m_moves_count + i) / (2.0f * float(m_moves_count))),
-                _L("Generating index buffers") + ": " + wxNumberFormatter::ToString(100.0 * double(i) / double(m_moves_count), 0, wxNumberFormatter::Style_None) + "%");
-            progress_dialog->Fit();
-            progress_count = 0;
+        if (i < moves_count - 1) {
+            next_vertex = moves.get(i + 1, next_cursor);
+            next = &next_vertex;
         }
 
         assert(curr.type > EMoveType::Noop);
         const unsigned char id = buffer_id(curr.type);
-        TBuffer& t_buffer = m_buffers[id];
-        MultiIndexBuffer& i_multibuffer = indices[id];
+        const TBuffer& t_buffer = m_buffers[id];
+        std::vector<Path>& t_paths = chunk.paths[id];
+        MultiIndexBuffer& i_multibuffer = chunk.indices[id];
         CurrVertexBuffer& curr_vertex_buffer = curr_vertex_buffers[id];
-        VboIndexList& vbo_index_list = vbo_indices[id];
+        std::vector<unsigned int>& vbo_index_list = chunk.vbo_indices[id];
 
         // ensure there is at least one index buffer
         if (i_multibuffer.empty()) {
             i_multibuffer.push_back(IndexBuffer());
-            if (!t_buffer.vertices.vbos.empty())
-                vbo_index_list.push_back(t_buffer.vertices.vbos[curr_vertex_buffer.first]);
+            vbo_index_list.push_back(curr_vertex_buffer.first);
         }
 
         // if adding the indices for the current segment exceeds the threshold size of the current index buffer
@@ -1990,10 +2071,10 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         size_t indiced_size_to_add = (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::BatchedModel) ? t_buffer.model.data.indices_size_bytes() : t_buffer.max_indices_per_segment_size_bytes();
         if (i_multibuffer.back().size() * sizeof(IBufferType) >= IBUFFER_THRESHOLD_BYTES - indiced_size_to_add) {
             i_multibuffer.push_back(IndexBuffer());
-            vbo_index_list.push_back(t_buffer.vertices.vbos[curr_vertex_buffer.first]);
+            vbo_index_list.push_back(curr_vertex_buffer.first);
             if (t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Point &&
                 t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::BatchedModel) {
-                Path& last_path = t_buffer.paths.back();
+                Path& last_path = t_paths.back();
                 last_path.add_sub_path(prev, static_cast<unsigned int>(i_multibuffer.size()) - 1, 0, move_id - 1);
             }
         }
@@ -2006,11 +2087,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 
             ++curr_vertex_buffer.first;
             curr_vertex_buffer.second = 0;
-            vbo_index_list.push_back(t_buffer.vertices.vbos[curr_vertex_buffer.first]);
+            vbo_index_list.push_back(curr_vertex_buffer.first);
 
             if (t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Point &&
                 t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::BatchedModel) {
-                Path& last_path = t_buffer.paths.back();
+                Path& last_path = t_paths.back();
                 last_path.add_sub_path(prev, static_cast<unsigned int>(i_multibuffer.size()) - 1, 0, move_id - 1);
             }
         }
@@ -2020,17 +2101,17 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         switch (t_buffer.render_primitive_type)
         {
         case TBuffer::ERenderPrimitiveType::Point: {
-            add_indices_as_point(curr, t_buffer, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, move_id);
+            add_indices_as_point(curr, t_paths, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, move_id);
             curr_vertex_buffer.second += t_buffer.max_vertices_per_segment();
             break;
         }
         case TBuffer::ERenderPrimitiveType::Line: {
-            add_indices_as_line(prev, curr, t_buffer, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, move_id);
+            add_indices_as_line(prev, curr, t_paths, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, move_id);
             curr_vertex_buffer.second += t_buffer.max_vertices_per_segment();
             break;
         }
         case TBuffer::ERenderPrimitiveType::Triangle: {
-            add_indices_as_solid(prev, curr, next, t_buffer, curr_vertex_buffer.second, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, move_id);
+            add_indices_as_solid(prev, curr, next, i + 1 == chunk.last_move, t_paths, curr_vertex_buffer.second, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, move_id);
             break;
         }
         case TBuffer::ERenderPrimitiveType::BatchedModel: {
@@ -2042,147 +2123,337 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         }
     }
 
-    for (MultiIndexBuffer& i_multibuffer : indices) {
+    for (MultiIndexBuffer& i_multibuffer : chunk.indices) {
         for (IndexBuffer& i_buffer : i_multibuffer) {
             i_buffer.shrink_to_fit();
         }
     }
 
-    // toolpaths data -> send indices data to gpu
+#if ENABLE_GCODE_VIEWER_STATISTICS
+    chunk.load_indices = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - smooth_vertices_time).count();
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+}
+
+void GCodeViewer::start_loader(std::vector<size_t>&& chunks_ids)
+{
+    assert(!m_loader.joinable());
+    m_loader_running = true;
+    m_loader = std::thread([this, chunks_ids = std::move(chunks_ids)]() {
+        // the chunks are taken in order, to show the layers from the bottom
+        std::atomic<size_t> next_id{ 0 };
+        try {
+            const size_t workers_count = std::min(chunks_ids.size(), static_cast<size_t>(tbb::this_task_arena::max_concurrency()));
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, workers_count, 1), [this, &chunks_ids, &next_id](const tbb::blocked_range<size_t>& range) {
+                for (size_t worker = range.begin(); worker < range.end(); ++worker) {
+                    for (size_t id = next_id++; id < chunks_ids.size() && !m_loader_cancel; id = next_id++) {
+                        ToolpathsChunk& chunk = *m_chunks[chunks_ids[id]];
+                        build_toolpaths_chunk(chunk);
+                        if (!m_loader_cancel)
+                            chunk.state = ToolpathsChunk::EState::Built;
+                    }
+                }
+            });
+        }
+        catch (const std::exception& ex) {
+            BOOST_LOG_TRIVIAL(error) << "GCodeViewer: Unable to build the toolpaths: " << ex.what();
+        }
+        m_loader_running = false;
+    });
+}
+
+void GCodeViewer::stop_loader()
+{
+    if (m_loader.joinable()) {
+        m_loader_cancel = true;
+        m_loader.join();
+        m_loader_cancel = false;
+    }
+    m_loader_running = false;
+}
+
+bool GCodeViewer::is_loading() const
+{
+    if (m_loader_running)
+        return true;
+    for (const std::unique_ptr<ToolpathsChunk>& chunk : m_chunks) {
+        if (chunk->state == ToolpathsChunk::EState::Built)
+            return true;
+    }
+    return false;
+}
+
+bool GCodeViewer::update_toolpaths_chunks()
+{
+    if (m_chunks.empty())
+        return false;
+
+    size_t gpu_size = 0;
+    for (const std::unique_ptr<ToolpathsChunk>& chunk : m_chunks) {
+        gpu_size += chunk->gpu_size_bytes;
+    }
+
+    bool updated = false;
+
+    // the paths of the chunks are appended to the TBuffers in the order of the moves
+    while (m_chunks_appended < m_chunks.size() && m_chunks[m_chunks_appended]->state == ToolpathsChunk::EState::Built) {
+        ToolpathsChunk& chunk = *m_chunks[m_chunks_appended++];
+        append_toolpaths_chunk(chunk, chunk.intersects(m_layers_z_range) || gpu_size + chunk.data_size_bytes() <= m_gpu_budget_bytes);
+        gpu_size += chunk.gpu_size_bytes;
+        updated = true;
+
+        if (m_chunks_appended == m_chunks.size()) {
+#if ENABLE_GCODE_VIEWER_STATISTICS
+            m_statistics.load_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_load_start_time).count();
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+            log_memory_used("Loaded G-code toolpaths, ");
+        }
+    }
+
+    // chunks built again after their gpu data were released
+    for (size_t i = 0; i < m_chunks_appended; ++i) {
+        ToolpathsChunk& chunk = *m_chunks[i];
+        if (chunk.state == ToolpathsChunk::EState::Built) {
+            send_toolpaths_chunk_to_gpu(chunk);
+            chunk.release_data();
+            gpu_size += chunk.gpu_size_bytes;
+            updated = true;
+        }
+    }
+
+    // release the gpu data of the chunks farthest from the visible layers
+    while (gpu_size > m_gpu_budget_bytes) {
+        ToolpathsChunk* farthest = nullptr;
+        unsigned int max_distance = 0;
+        for (size_t i = 0; i < m_chunks_appended; ++i) {
+            ToolpathsChunk& chunk = *m_chunks[i];
+            if (chunk.state != ToolpathsChunk::EState::Uploaded || chunk.intersects(m_layers_z_range))
+                continue;
+            const unsigned int distance = (chunk.last_layer < m_layers_z_range[0]) ? m_layers_z_range[0] - chunk.last_layer : chunk.first_layer - m_layers_z_range[1];
+            if (farthest == nullptr || distance > max_distance) {
+                farthest = &chunk;
+                max_distance = distance;
+            }
+        }
+        if (farthest == nullptr)
+            break;
+        gpu_size -= farthest->gpu_size_bytes;
+        evict_toolpaths_chunk(*farthest);
+        updated = true;
+    }
+
+    // build again the chunks of the visible layers whose gpu data were released
+    if (!m_loader_running) {
+        if (m_loader.joinable())
+            m_loader.join();
+        std::vector<size_t> chunks_ids;
+        for (size_t i = 0; i < m_chunks_appended; ++i) {
+            ToolpathsChunk& chunk = *m_chunks[i];
+            if (chunk.state == ToolpathsChunk::EState::Evicted && chunk.intersects(m_layers_z_range)) {
+                chunk.state = ToolpathsChunk::EState::Queued;
+                chunks_ids.push_back(i);
+            }
+        }
+        if (!chunks_ids.empty())
+            start_loader(std::move(chunks_ids));
+    }
+
+    if (updated) {
+        // keep the sequential range only if it was set by the user
+        const bool keep_sequential_current_first = m_sequential_view.current.first != m_sequential_view.global.first;
+        const bool keep_sequential_current_last = m_sequential_view.current.last != m_sequential_view.global.last;
+        refresh_render_paths(keep_sequential_current_first, keep_sequential_current_last);
+        wxGetApp().plater()->CallAfter([]() { wxGetApp().plater()->update_preview_moves_slider(); });
+    }
+
+    if (is_loading())
+        // poll the loader threads
+        wxGetApp().plater()->get_current_canvas3D()->schedule_extra_frame(100);
+
+    return updated;
+}
+
+void GCodeViewer::append_toolpaths_chunk(ToolpathsChunk& chunk, bool send_to_gpu)
+{
+    chunk.slots.assign(m_buffers.size(), ToolpathsChunk::Slots());
     for (size_t i = 0; i < m_buffers.size(); ++i) {
         TBuffer& t_buffer = m_buffers[i];
-        if (t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::InstancedModel) {
-            const MultiIndexBuffer& i_multibuffer = indices[i];
-            for (const IndexBuffer& i_buffer : i_multibuffer) {
-                const size_t size_elements = i_buffer.size();
-                const size_t size_bytes = size_elements * sizeof(IBufferType);
+        ToolpathsChunk::Slots& slots = chunk.slots[i];
+        if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::InstancedModel ||
+            t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::BatchedModel) {
+            append(t_buffer.model.instances.buffer, std::move(chunk.instances[i]));
+            append(t_buffer.model.instances.s_ids, std::move(chunk.instances_ids[i]));
+            append(t_buffer.model.instances.offsets, std::move(chunk.instances_offsets[i]));
+#if ENABLE_GCODE_VIEWER_STATISTICS
+            if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::InstancedModel)
+                m_statistics.instances_count += static_cast<int64_t>(chunk.instances_ids[i].size());
+            else
+                m_statistics.batched_count += static_cast<int64_t>(chunk.instances_ids[i].size());
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+        }
 
-                // stores index buffer informations into TBuffer
+        if (t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::InstancedModel) {
+            // the vbos and ibos are generated by send_toolpaths_chunk_to_gpu()
+            slots.first_vbo = t_buffer.vertices.vbos.size();
+            slots.vbos_count = chunk.vertices[i].size();
+            for (const VertexBuffer& v_buffer : chunk.vertices[i]) {
+                t_buffer.vertices.vbos.push_back(0);
+                t_buffer.vertices.sizes.push_back(v_buffer.size() * sizeof(float));
+                t_buffer.vertices.count += v_buffer.size() / t_buffer.vertices.vertex_size_floats();
+            }
+            slots.first_ibuffer = t_buffer.indices.size();
+            slots.ibuffers_count = chunk.indices[i].size();
+            for (const IndexBuffer& i_buffer : chunk.indices[i]) {
                 t_buffer.indices.push_back(IBuffer());
-                IBuffer& ibuf = t_buffer.indices.back();
-                ibuf.count = size_elements;
-                ibuf.vbo = vbo_indices[i][t_buffer.indices.size() - 1];
+                t_buffer.indices.back().count = i_buffer.size();
+            }
+        }
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
-                m_statistics.total_indices_gpu_size += static_cast<int64_t>(size_bytes);
-                m_statistics.max_ibuffer_gpu_size = std::max(m_statistics.max_ibuffer_gpu_size, static_cast<int64_t>(size_bytes));
-                ++m_statistics.ibuffers_count;
+        if (i == buffer_id(EMoveType::Travel) || i == buffer_id(EMoveType::Wipe) || i == buffer_id(EMoveType::Extrude)) {
+            int64_t indices_count = 0;
+            for (const IndexBuffer& buffer : chunk.indices[i]) {
+                indices_count += buffer.size();
+            }
+            if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle)
+                indices_count -= static_cast<int64_t>(12 * chunk.paths[i].size()); // remove the starting + ending caps = 4 triangles
+
+            int64_t& count = (i == buffer_id(EMoveType::Travel)) ? m_statistics.travel_segments_count :
+                (i == buffer_id(EMoveType::Wipe)) ? m_statistics.wipe_segments_count : m_statistics.extrude_segments_count;
+            count += indices_count / t_buffer.indices_per_segment();
+        }
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
-                glsafe(::glGenBuffers(1, &ibuf.ibo));
-                glsafe(::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibuf.ibo));
-                glsafe(::glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_bytes, i_buffer.data(), GL_STATIC_DRAW));
-                glsafe(::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+        // the index buffers of the chunk follow the ones of the previous chunks
+        const bool is_extrude = i == buffer_id(EMoveType::Extrude);
+        for (Path& path : chunk.paths[i]) {
+            for (Path::Sub_Path& sub_path : path.sub_paths) {
+                sub_path.first.b_id += static_cast<unsigned int>(slots.first_ibuffer);
+                sub_path.last.b_id += static_cast<unsigned int>(slots.first_ibuffer);
             }
-        }
-    }
 
-    if (progress_dialog != nullptr) {
-        progress_dialog->Update(100, "");
-        progress_dialog->Fit();
+            // change color of paths whose layer contains option points
+            if (is_extrude && !m_options_zs.empty()) {
+                const float z = path.sub_paths.front().first.position.z();
+                if (std::find_if(m_options_zs.begin(), m_options_zs.end(), [z](float f) { return f - EPSILON <= z && z <= f + EPSILON; }) != m_options_zs.end())
+                    path.cp_color_id = 255 - path.cp_color_id;
+            }
+        }
+        append(t_buffer.paths, std::move(chunk.paths[i]));
     }
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
+    m_statistics.load_vertices += chunk.load_vertices;
+    m_statistics.smooth_vertices += chunk.smooth_vertices;
+    m_statistics.load_indices += chunk.load_indices;
+    m_statistics.paths_size = 0;
     for (const TBuffer& buffer : m_buffers) {
         m_statistics.paths_size += SLIC3R_STDVEC_MEMSIZE(buffer.paths, Path);
     }
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
 
-    auto update_segments_count = [&](EMoveType type, int64_t& count) {
-        unsigned int id = buffer_id(type);
-        const MultiIndexBuffer& buffers = indices[id];
-        int64_t indices_count = 0;
-        for (const IndexBuffer& buffer : buffers) {
-            indices_count += buffer.size();
-        }
-        const TBuffer& t_buffer = m_buffers[id];
-        if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle)
-            indices_count -= static_cast<int64_t>(12 * t_buffer.paths.size()); // remove the starting + ending caps = 4 triangles
-
-        count += indices_count / t_buffer.indices_per_segment();
-    };
+    if (send_to_gpu)
+        send_toolpaths_chunk_to_gpu(chunk);
+    else
+        chunk.state = ToolpathsChunk::EState::Evicted;
 
-    update_segments_count(EMoveType::Travel, m_statistics.travel_segments_count);
-    update_segments_count(EMoveType::Wipe, m_statistics.wipe_segments_count);
-    update_segments_count(EMoveType::Extrude, m_statistics.extrude_segments_count);
+    chunk.release_data();
+}
 
-    m_statistics.load_indices = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - smooth_vertices_time).count();
-#endif // ENABLE_GCODE_VIEWER_STATISTICS
+void GCodeViewer::send_toolpaths_chunk_to_gpu(ToolpathsChunk& chunk)
+{
+    chunk.gpu_size_bytes = 0;
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        TBuffer& t_buffer = m_buffers[i];
+        if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::InstancedModel)
+            continue;
 
-    log_memory_usage("Loaded G-code generated indices buffers ", vertices, indices);
+        const ToolpathsChunk::Slots& slots = chunk.slots[i];
+        // a chunk built again contains the same buffers
+        assert(chunk.vertices[i].size() == slots.vbos_count && chunk.indices[i].size() == slots.ibuffers_count);
 
-    // dismiss indices data, no more needed
-    std::vector<MultiIndexBuffer>().swap(indices);
+        // toolpaths data -> send vertices data to gpu
+        for (size_t j = 0; j < slots.vbos_count; ++j) {
+            const VertexBuffer& v_buffer = chunk.vertices[i][j];
+            const size_t size_bytes = v_buffer.size() * sizeof(float);
 
-    // layers zs / roles / extruder ids -> extract from result
-    size_t last_travel_s_id = 0;
-    seams_count = 0;
-    for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessorResult::MoveVertex& move = gcode_result.moves[i];
-        if (move.type == EMoveType::Seam)
-            ++seams_count;
+#if ENABLE_GCODE_VIEWER_STATISTICS
+            m_statistics.total_vertices_gpu_size += static_cast<int64_t>(size_bytes);
+            m_statistics.max_vbuffer_gpu_size = std::max(m_statistics.max_vbuffer_gpu_size, static_cast<int64_t>(size_bytes));
+            ++m_statistics.vbuffers_count;
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
 
-        size_t move_id = i - seams_count;
+            GLuint id = 0;
+            glsafe(::glGenBuffers(1, &id));
+            glsafe(::glBindBuffer(GL_ARRAY_BUFFER, id));
+            glsafe(::glBufferData(GL_ARRAY_BUFFER, size_bytes, v_buffer.data(), GL_STATIC_DRAW));
+            glsafe(::glBindBuffer(GL_ARRAY_BUFFER, 0));
 
-        if (move.type == EMoveType::Extrude) {
-            // layers zs
-            const double* const last_z = m_layers.empty() ? nullptr : &m_layers.get_zs().back();
-            const double z = static_cast<double>(move.position.z());
-            if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z)
-                m_layers.append(z, { last_travel_s_id, move_id });
-            else
-                m_layers.get_endpoints().back().last = move_id;
-            // extruder ids
-            m_extruder_ids.emplace_back(move.extruder_id);
-            // roles
-            if (i > 0)
-                m_roles.emplace_back(move.extrusion_role);
+            t_buffer.vertices.vbos[slots.first_vbo + j] = static_cast<unsigned int>(id);
+            chunk.gpu_size_bytes += size_bytes;
         }
-        else if (move.type == EMoveType::Travel) {
-            if (move_id - last_travel_s_id > 1 && !m_layers.empty())
-                m_layers.get_endpoints().back().last = move_id;
 
-            last_travel_s_id = move_id;
-        }
-    }
+        // toolpaths data -> send indices data to gpu
+        for (size_t j = 0; j < slots.ibuffers_count; ++j) {
+            const IndexBuffer& i_buffer = chunk.indices[i][j];
+            const size_t size_bytes = i_buffer.size() * sizeof(IBufferType);
 
-    // roles -> remove duplicates
-    sort_remove_duplicates(m_roles);
-    m_roles.shrink_to_fit();
+            IBuffer& ibuf = t_buffer.indices[slots.first_ibuffer + j];
+            ibuf.vbo = t_buffer.vertices.vbos[slots.first_vbo + chunk.vbo_indices[i][j]];
 
-    // extruder ids -> remove duplicates
-    sort_remove_duplicates(m_extruder_ids);
-    m_extruder_ids.shrink_to_fit();
+#if ENABLE_GCODE_VIEWER_STATISTICS
+            m_statistics.total_indices_gpu_size += static_cast<int64_t>(size_bytes);
+            m_statistics.max_ibuffer_gpu_size = std::max(m_statistics.max_ibuffer_gpu_size, static_cast<int64_t>(size_bytes));
+            ++m_statistics.ibuffers_count;
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
 
-#if ENABLE_SPIRAL_VASE_LAYERS
-    // replace layers for spiral vase mode
-    if (!gcode_result.spiral_vase_layers.empty()) {
-        m_layers.reset();
-        for (const auto& layer : gcode_result.spiral_vase_layers) {
-            m_layers.append(layer.first, { layer.second.first, layer.second.second });
+            glsafe(::glGenBuffers(1, &ibuf.ibo));
+            glsafe(::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibuf.ibo));
+            glsafe(::glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_bytes, i_buffer.data(), GL_STATIC_DRAW));
+            glsafe(::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+
+            chunk.gpu_size_bytes += size_bytes;
         }
     }
-#endif // ENABLE_SPIRAL_VASE_LAYERS
 
-    // set layers z range
-    if (!m_layers.empty())
-        m_layers_z_range = { 0, static_cast<unsigned int>(m_layers.size() - 1) };
+    chunk.state = ToolpathsChunk::EState::Uploaded;
+}
 
-    // change color of paths whose layer contains option points
-    if (!options_zs.empty()) {
-        TBuffer& extrude_buffer = m_buffers[buffer_id(EMoveType::Extrude)];
-        for (Path& path : extrude_buffer.paths) {
-            const float z = path.sub_paths.front().first.position.z();
-            if (std::find_if(options_zs.begin(), options_zs.end(), [z](float f) { return f - EPSILON <= z && z <= f + EPSILON; }) != options_zs.end())
-                path.cp_color_id = 255 - path.cp_color_id;
-        }
-    }
+void GCodeViewer::evict_toolpaths_chunk(ToolpathsChunk& chunk)
+{
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        TBuffer& t_buffer = m_buffers[i];
+        if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::InstancedModel)
+            continue;
 
+        const ToolpathsChunk::Slots& slots = chunk.slots[i];
+        for (size_t j = slots.first_vbo; j < slots.first_vbo + slots.vbos_count; ++j) {
+            unsigned int& vbo = t_buffer.vertices.vbos[j];
+            if (vbo > 0) {
+                glsafe(::glDeleteBuffers(1, static_cast<const GLuint*>(&vbo)));
+                vbo = 0;
+#if ENABLE_GCODE_VIEWER_STATISTICS
+                m_statistics.total_vertices_gpu_size -= static_cast<int64_t>(t_buffer.vertices.sizes[j]);
+                --m_statistics.vbuffers_count;
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+            }
+        }
+        // the count of the indices is kept, as the batched models find their instances with it
+        for (size_t j = slots.first_ibuffer; j < slots.first_ibuffer + slots.ibuffers_count; ++j) {
+            IBuffer& ibuf = t_buffer.indices[j];
+            if (ibuf.ibo > 0) {
+                glsafe(::glDeleteBuffers(1, &ibuf.ibo));
+                ibuf.ibo = 0;
 #if ENABLE_GCODE_VIEWER_STATISTICS
-    m_statistics.load_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+                m_statistics.total_indices_gpu_size -= static_cast<int64_t>(ibuf.count * sizeof(IBufferType));
+                --m_statistics.ibuffers_count;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
+            }
+            ibuf.vbo = 0;
+        }
+    }
 
-    if (progress_dialog != nullptr)
-        progress_dialog->Destroy();
+    chunk.gpu_size_bytes = 0;
+    chunk.state = ToolpathsChunk::EState::Evicted;
 }
 
 void GCodeViewer::load_shells(const Print& print, bool initialized)
@@ -2455,8 +2726,17 @@ void GCodeViewer::refresh_render_paths(bool keep_sequential_current_first, bool
                         }
                         offset += static_cast<unsigned int>(sub_path.first.i_id);
 
-                        // gets the vertex index from the index buffer on gpu
                         const IBuffer& i_buffer = buffer.indices[sub_path.first.b_id];
+                        if (i_buffer.ibo == 0) {
+                            // the index buffer was released to stay into the gpu memory budget and it's being built again,
+                            // use the position of the move
+                            sequential_view->current_position = m_moves->position(extract_move_id(m_biased_seams_ids, m_sequential_view.current.last));
+                            sequential_view->current_offset = Vec3f::Zero();
+                            found = true;
+                            break;
+                        }
+
+                        // gets the vertex index from the index buffer on gpu
                         unsigned int index = 0;
                         glsafe(::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, i_buffer.ibo));
                         glsafe(::glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLintptr>(offset * sizeof(IBufferType)), static_cast<GLsizeiptr>(sizeof(IBufferType)), static_cast<void*>(&index)));
@@ -2649,7 +2929,7 @@ void GCodeViewer::refresh_render_paths(bool keep_sequential_current_first, bool
     if (m_sequential_view.current.first != m_sequential_view.current.last) {
         for (const auto& [tbuffer_id, ibuffer_id, path_id, sub_path_id] : paths) {
             TBuffer& buffer = const_cast<TBuffer&>(m_buffers[tbuffer_id]);
-            if (buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Triangle)
+            if (buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Triangle || buffer.indices[ibuffer_id].ibo == 0)
                 continue;
 
             const Path& path = buffer.paths[path_id];
@@ -2901,6 +3181,11 @@ void GCodeViewer::render_toolpaths()
         for (size_t j = 0; j < buffer.indices.size(); ++j) {
             const IBuffer& i_buffer = buffer.indices[j];
             buffer_range.last = buffer_range.first + i_buffer.count / indices_per_instance;
+            if (i_buffer.ibo == 0) {
+                // released to stay into the gpu memory budget
+                buffer_range.first = buffer_range.last;
+                continue;
+            }
             glsafe(::glBindBuffer(GL_ARRAY_BUFFER, i_buffer.vbo));
             glsafe(::glVertexPointer(buffer.vertices.position_size_floats(), GL_FLOAT, buffer.vertices.vertex_size_bytes(), (const void*)buffer.vertices.position_offset_bytes()));
             glsafe(::glEnableClientState(GL_VERTEX_ARRAY));
@@ -2982,6 +3267,9 @@ void GCodeViewer::render_toolpaths()
                     if (it_path == buffer.render_paths.end() || it_path->ibuffer_id > ibuffer_id)
                         // Not found. This shall not happen.
                         continue;
+                    if (i_buffer.ibo == 0)
+                        // Released to stay into the gpu memory budget.
+                        continue;
 
                     glsafe(::glBindBuffer(GL_ARRAY_BUFFER, i_buffer.vbo));
                     glsafe(::glVertexPointer(buffer.vertices.position_size_floats(), GL_FLOAT, buffer.vertices.vertex_size_bytes(), (const void*)buffer.vertices.position_offset_bytes()));
@@ -7,9 +7,13 @@
 
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <float.h>
+#include <memory>
 #include <set>
+#include <thread>
 #include <unordered_set>
 
 namespace Slic3r {
@@ -322,7 +326,8 @@ class GCodeViewer
         // b_id index of buffer contained in this->indices
         // i_id index of first index contained in this->indices[b_id]
         // s_id index of first vertex contained in this->vertices
-        void add_path(const GCodeProcessorResult::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id);
+        // paths are the paths of this TBuffer being built, see ToolpathsChunk
+        static void add_path(std::vector<Path>& paths, const GCodeProcessorResult::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id);
 
         unsigned int max_vertices_per_segment() const {
             switch (render_primitive_type)
@@ -363,18 +368,84 @@ class GCodeViewer
             case ERenderPrimitiveType::Point:
             case ERenderPrimitiveType::Line:
             case ERenderPrimitiveType::Triangle: {
-                return !vertices.vbos.empty() && vertices.vbos.front() != 0 && !indices.empty() && indices.front().ibo != 0;
+                // the vbos and ibos of the evicted chunks are zero, see ToolpathsChunk
+                return !vertices.vbos.empty() && !indices.empty();
             }
             case ERenderPrimitiveType::InstancedModel: { return model.model.is_initialized() && !model.instances.buffer.empty(); }
             case ERenderPrimitiveType::BatchedModel: {
                 return model.data.vertices_count() > 0 && model.data.indices_count() &&
-                    !vertices.vbos.empty() && vertices.vbos.front() != 0 && !indices.empty() && indices.front().ibo != 0;
+                    !vertices.vbos.empty() && !indices.empty();
             }
             default: { return false; }
             }
         }
     };
 
+    // Toolpaths data of a range of layers.
+    // The cpu data are built by the loader threads (see build_toolpaths_chunk()), then the ui thread appends
+    // the paths to the TBuffers and sends the vertices and indices to gpu (see update_toolpaths_chunks()).
+    // The gpu buffers of the chunks far from the visible layers are released when over the memory budget
+    // and the chunks are built again once their layers are visible.
+    struct ToolpathsChunk
+    {
+        enum class EState : unsigned char
+        {
+            // waiting for a loader thread
+            Queued,
+            // cpu data ready to be sent to gpu
+            Built,
+            // cpu data sent to gpu and released
+            Uploaded,
+            // gpu data released
+            Evicted
+        };
+
+        // where the data of the chunk are stored into a TBuffer
+        struct Slots
+        {
+            // index of the first vbo in TBuffer::vertices.vbos
+            size_t first_vbo{ 0 };
+            size_t vbos_count{ 0 };
+            // index of the first index buffer in TBuffer::indices
+            size_t first_ibuffer{ 0 };
+            size_t ibuffers_count{ 0 };
+        };
+
+        // moves [first_move, last_move) of the result
+        size_t first_move{ 0 };
+        size_t last_move{ 0 };
+        // count of seams before first_move
+        size_t seams_before{ 0 };
+        // layers [first_layer, last_layer] of the moves
+        unsigned int first_layer{ 0 };
+        unsigned int last_layer{ 0 };
+        std::atomic<EState> state{ EState::Queued };
+        // set by the first upload, one per TBuffer
+        std::vector<Slots> slots;
+        // size of the gpu data, in bytes
+        size_t gpu_size_bytes{ 0 };
+
+        // cpu data, one per TBuffer
+        // paths b_id are indices into the index buffers of this chunk
+        std::vector<std::vector<Path>> paths;
+        std::vector<MultiVertexBuffer> vertices;
+        std::vector<MultiIndexBuffer> indices;
+        // index into vertices of the vertex buffer of each index buffer
+        std::vector<std::vector<unsigned int>> vbo_indices;
+        std::vector<InstanceBuffer> instances;
+        std::vector<InstanceIdBuffer> instances_ids;
+        std::vector<InstancesOffsets> instances_offsets;
+#if ENABLE_GCODE_VIEWER_STATISTICS
+        int64_t load_vertices{ 0 };
+        int64_t smooth_vertices{ 0 };
+        int64_t load_indices{ 0 };
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+
+        bool intersects(const std::array<unsigned int, 2>& layers_range) const { return first_layer <= layers_range[1] && layers_range[0] <= last_layer; }
+        size_t data_size_bytes() const;
+        void release_data();
+    };
+
     // helper to render shells
     struct Shells
     {
@@ -741,6 +812,24 @@ private:
 
     bool m_contained_in_bed{ true };
 
+    // copy of the moves of the loaded result, read by the loader threads
+    std::shared_ptr<const GCodeProcessorResult::MoveVertices> m_moves;
+    // move ids of the seams, biased by the count of the previous seams
+    std::vector<size_t> m_biased_seams_ids;
+    // zs of the layers containing pause prints and custom gcodes
+    std::vector<float> m_options_zs;
+    std::vector<std::unique_ptr<ToolpathsChunk>> m_chunks;
+    // count of the first chunks whose paths have been appended to the TBuffers
+    size_t m_chunks_appended{ 0 };
+    // max size of the toolpaths data on gpu, see toolpaths_gpu_budget_bytes()
+    size_t m_gpu_budget_bytes{ 0 };
+    std::thread m_loader;
+    std::atomic<bool> m_loader_running{ false };
+    std::atomic<bool> m_loader_cancel{ false };
+#if ENABLE_GCODE_VIEWER_STATISTICS
+    std::chrono::high_resolution_clock::time_point m_load_start_time;
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+
 public:
     GCodeViewer();
     ~GCodeViewer() { reset(); }
@@ -759,6 +848,8 @@ public:
     void render();
 
     bool has_data() const { return !m_roles.empty(); }
+    // whether some toolpaths are still being built by the loader threads
+    bool is_loading() const;
     bool can_export_toolpaths() const;
 
     const BoundingBoxf3& get_paths_bounding_box() const { return m_paths_bounding_box; }
@@ -799,6 +890,15 @@ public:
 
 private:
     void load_toolpaths(const GCodeProcessorResult& gcode_result);
+    // called from the loader threads, reads only the moves and the layout of the TBuffers set by init()
+    void build_toolpaths_chunk(ToolpathsChunk& chunk) const;
+    void start_loader(std::vector<size_t>&& chunks_ids);
+    void stop_loader();
+    // sends the built chunks to gpu and releases the gpu data of the far chunks, returns true if any chunk was updated
+    bool update_toolpaths_chunks();
+    void append_toolpaths_chunk(ToolpathsChunk& chunk, bool send_to_gpu);
+    void send_toolpaths_chunk_to_gpu(ToolpathsChunk& chunk);
+    void evict_toolpaths_chunk(ToolpathsChunk& chunk);
     void load_shells(const Print& print, bool initialized);
     void refresh_render_paths(bool keep_sequential_current_first, bool keep_sequential_current_last) const;
     void render_toolpaths();
@@ -89,6 +89,14 @@ float OpenGLManager::GLInfo::get_max_anisotropy() const
     return m_max_anisotropy;
 }
 
+size_t OpenGLManager::GLInfo::get_video_memory_bytes() const
+{
+    if (!m_detected)
+        detect();
+
+    return m_video_memory_bytes;
+}
+
 void OpenGLManager::GLInfo::detect() const
 {
     *const_cast<std::string*>(&m_version) = gl_get_string_safe(GL_VERSION, "N/A");
@@ -108,6 +116,14 @@ void OpenGLManager::GLInfo::detect() const
         float* max_anisotropy = const_cast<float*>(&m_max_anisotropy);
         glsafe(::glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, max_anisotropy));
     }
+
+    // in kB
+    GLint video_memory[4] = { 0, 0, 0, 0 };
+    if (GLEW_NVX_gpu_memory_info)
+        glsafe(::glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, video_memory));
+    else if (GLEW_ATI_meminfo)
+        glsafe(::glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, video_memory));
+    *const_cast<size_t*>(&m_video_memory_bytes) = size_t(std::max(video_memory[0], 0)) * 1024;
     *const_cast<bool*>(&m_detected) = true;
 }
 
@@ -26,6 +26,7 @@ public:
         bool m_detected{ false };
         int m_max_tex_size{ 0 };
         float m_max_anisotropy{ 0.0f };
+        size_t m_video_memory_bytes{ 0 };
 
         std::string m_version;
         std::string m_glsl_version;
@@ -42,6 +43,8 @@ public:
 
         int get_max_tex_size() const;
         float get_max_anisotropy() const;
+        // Dedicated video memory as reported by the driver (NVX_gpu_memory_info, or the free texture memory of ATI_meminfo), 0 if unknown.
+        size_t get_video_memory_bytes() const;
 
         bool is_version_greater_or_equal_to(unsigned int major, unsigned int minor) const;
         bool is_glsl_version_greater_or_equal_to(unsigned int major, unsigned int minor) const;
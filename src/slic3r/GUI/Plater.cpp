@@ -6113,6 +6113,7 @@ void Plater::export_platter()
                 OptionStore3mf{}
                 .set_fullpath_sources(wxGetApp().app_config->get("export_sources_full_pathnames") == "1")
                 .set_thumbnail_data(&thumbnail_data)
+                .set_compression_level(atoi(wxGetApp().app_config->get("3mf_compression_level").c_str()))
                 .set_export_config(extra_options->with_config())
                 .set_export_modifiers(extra_options->with_modifers())
             );
@@ -6324,7 +6325,8 @@ bool Plater::export_3mf(const boost::filesystem::path& output_path)
         show_bed_on_thumbnails, // show_bed
         true}; // transparent_background
     p->generate_thumbnail(thumbnail_data, THUMBNAIL_SIZE_3MF.first, THUMBNAIL_SIZE_3MF.second, thumbnail_params, Camera::EType::Ortho);
-    bool ret = Slic3r::store_3mf(path_u8.c_str(), &p->model, &cfg, OptionStore3mf{}.set_fullpath_sources(full_pathnames).set_thumbnail_data(&thumbnail_data));
+    bool ret = Slic3r::store_3mf(path_u8.c_str(), &p->model, &cfg, OptionStore3mf{}.set_fullpath_sources(full_pathnames).set_thumbnail_data(&thumbnail_data)
+        .set_compression_level(atoi(wxGetApp().app_config->get("3mf_compression_level").c_str())));
     if (ret) {
         // Success
 //        p->statusbar()->set_status_text(format_wxstr(_L("3MF file exported to %s"), path));
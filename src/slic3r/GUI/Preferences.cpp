@@ -275,6 +275,19 @@ void PreferencesDialog::build(size_t selected_tab)
         option = Option(def, "export_sources_full_pathnames");
         m_optgroups_general.back()->append_single_option_line(option);
 
+        def.label = L("Compression level of the 3mf files");
+        def.type = coInt;
+        def.tooltip = L("Deflate level used to compress the project and 3mf files. 0 stores them without any compression (big but very fast to save), "
+            "1 is the fastest compression, up to 10 for the smallest files. The default is 6.");
+        def.min = 0;
+        def.max = 10;
+        def.set_default_value(new ConfigOptionInt{ atoi(app_config->get("3mf_compression_level").c_str()) });
+        option = Option(def, "3mf_compression_level");
+        option.opt.width = 6;
+        m_optgroups_general.back()->append_single_option_line(option);
+        def.min = INT_MIN;
+        def.max = INT_MAX;
+
 #ifdef _WIN32
 		// Please keep in sync with ConfigWizard
 		def.label = (boost::format(_u8L("Associate .3mf files to %1%")) % SLIC3R_APP_NAME).str();
@@ -3326,6 +3326,9 @@ void TabPrinter::toggle_options()
     field = get_field("remaining_times_type");
     if (field) field->toggle(have_remaining_times);
 
+    field = get_field("arc_fitting_tolerance");
+    if (field) field->toggle(m_config->opt_bool("arc_fitting"));
+
     auto flavor = m_config->option<ConfigOptionEnum<GCodeFlavor>>("gcode_flavor")->value;
     bool is_marlin_flavor = flavor == gcfMarlinLegacy || flavor == gcfMarlinFirmware;
     // Disable silent mode for non-marlin firmwares.
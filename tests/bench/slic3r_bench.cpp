@@ -0,0 +1,277 @@
+// Benchmark of the FFF slicing pipeline.
+// Slices a fixed corpus (the test meshes and a few generated big meshes) and reports
+// the wall time, the CPU time and the peak resident memory of each PrintObjectStep / PrintStep,
+// to compare the performance of two builds: run it on both and diff the JSON output.
+//
+// Usage: slic3r_bench [--json <file>] [--repeat <n>] [--case <name>]...
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r_version.h"
+
+#include "test_data.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/chrono/process_cpu_clocks.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+using namespace Slic3r;
+using namespace Slic3r::Test;
+
+namespace {
+
+struct BenchCase {
+    std::string                                                name;
+    std::function<std::vector<TriangleMesh>()>                 meshes;
+    // Config values set over the defaults.
+    std::vector<std::pair<std::string, std::string>>           config;
+};
+
+struct StepStats {
+    // Sum over the objects and the runs, in seconds.
+    double  wall = 0.;
+    double  cpu  = 0.;
+    // Peak resident memory of the process when the step was done.
+    size_t  peak_rss = 0;
+    size_t  count = 0;
+};
+
+// Measures the intervals between the start and the end of the steps, given by Print::set_step_callback().
+// The steps of different objects run concurrently (see Print::process()): their wall times are summed,
+// and the CPU time being the one of the whole process, the CPU time of overlapping steps is counted for each of them.
+class StepTimer
+{
+public:
+    struct Sample {
+        std::chrono::steady_clock::time_point   wall;
+        boost::chrono::process_cpu_clock::times cpu;
+    };
+    static Sample now() { return { std::chrono::steady_clock::now(), boost::chrono::process_cpu_clock::now().time_since_epoch().count() }; }
+    static double cpu_seconds(const Sample &start, const Sample &end)
+        { return 1e-9 * double((end.cpu.user - start.cpu.user) + (end.cpu.system - start.cpu.system)); }
+
+    void start(const std::string &name, const void *object = nullptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_started[{ name, object }] = now();
+    }
+    void done(const std::string &name, const void *object = nullptr) {
+        Sample end = now();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_started.find({ name, object });
+        if (it == m_started.end())
+            return;
+        StepStats &stats = m_stats[name];
+        stats.wall    += std::chrono::duration<double>(end.wall - it->second.wall).count();
+        stats.cpu     += cpu_seconds(it->second, end);
+        stats.peak_rss = std::max(stats.peak_rss, peak_memory_usage());
+        ++ stats.count;
+        m_started.erase(it);
+    }
+    // Steps in the order of the pipeline.
+    std::vector<std::pair<std::string, StepStats>> stats() const {
+        std::vector<std::pair<std::string, StepStats>> out(m_stats.begin(), m_stats.end());
+        std::sort(out.begin(), out.end(), [](const auto &l, const auto &r) { return order(l.first) < order(r.first); });
+        return out;
+    }
+
+private:
+    static int order(const std::string &name) {
+        static const char *names[] = { "apply", "slice", "perimeters", "prepare_infill", "infill", "ironing", "support_material",
+                                       "wipe_tower", "skirt_brim", "gcode_export", "total" };
+        for (int i = 0; i < int(std::size(names)); ++ i)
+            if (name == names[i])
+                return i;
+        return int(std::size(names));
+    }
+
+    std::mutex                          m_mutex;
+    std::map<std::pair<std::string, const void*>, Sample> m_started;
+    std::map<std::string, StepStats>    m_stats;
+};
+
+std::string step_name(int step, const PrintObjectBase *print_object)
+{
+    if (print_object != nullptr) {
+        switch (PrintObjectStep(step)) {
+        case posSlice:              return "slice";
+        case posPerimeters:         return "perimeters";
+        case posPrepareInfill:      return "prepare_infill";
+        case posInfill:             return "infill";
+        case posIroning:            return "ironing";
+        case posSupportMaterial:    return "support_material";
+        default:                    break;
+        }
+    } else {
+        switch (PrintStep(step)) {
+        case psWipeTower:           return "wipe_tower";
+        case psSkirtBrim:           return "skirt_brim";
+        case psGCodeExport:         return "gcode_export";
+        default:                    break;
+        }
+    }
+    return "step_" + std::to_string(step);
+}
+
+std::vector<BenchCase> bench_cases()
+{
+    std::vector<BenchCase> cases;
+    // The meshes of the unit tests, with the default config.
+    for (const auto &[test_mesh, name] : mesh_names) {
+        TestMesh m = test_mesh;
+        cases.push_back({ name, [m]() { return std::vector<TriangleMesh>{ mesh(m) }; }, {} });
+    }
+    std::sort(cases.begin(), cases.end(), [](const BenchCase &l, const BenchCase &r) { return l.name < r.name; });
+    // A sphere of ~1M triangles: slicing of a big mesh.
+    cases.push_back({ "sphere_1M_triangles", []() { return std::vector<TriangleMesh>{ make_sphere(50., PI / 500.) }; }, {} });
+    // Many fine objects: object loops, arrangement and G-code export.
+    cases.push_back({ "cylinders_x20", []() {
+            std::vector<TriangleMesh> meshes;
+            for (int i = 0; i < 20; ++ i)
+                meshes.emplace_back(make_cylinder(8., 30., PI / 360.));
+            return meshes;
+        }, {} });
+    // Support generation.
+    cases.push_back({ "overhang_support", []() { return std::vector<TriangleMesh>{ mesh(TestMesh::overhang) }; },
+        { { "support_material", "1" }, { "raft_layers", "2" } } });
+    // Expensive infill pattern.
+    cases.push_back({ "sphere_gyroid", []() { return std::vector<TriangleMesh>{ mesh(TestMesh::sphere_50mm) }; },
+        { { "fill_pattern", "gyroid" }, { "fill_density", "30%" } } });
+    return cases;
+}
+
+void run_case(const BenchCase &bench_case, StepTimer &timer)
+{
+    // The generation of the meshes is not part of the timings.
+    std::vector<TriangleMesh> meshes = bench_case.meshes();
+    timer.start("total");
+
+    Print print;
+    Model model;
+    print.set_step_callback([&timer](int step, const PrintObjectBase *print_object, bool started) {
+        // The steps of all the objects are summed.
+        std::string name = step_name(step, print_object);
+        if (started)
+            timer.start(name, print_object);
+        else
+            timer.done(name, print_object);
+    });
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    for (const auto &[key, value] : bench_case.config)
+        config.set_deserialize_strict(key, value);
+    timer.start("apply");
+    init_print(std::move(meshes), print, model, config);
+    timer.done("apply");
+
+    print.process();
+    boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slic3r_bench_%%%%-%%%%.gcode");
+    print.export_gcode(temp.string(), nullptr, nullptr);
+    boost::nowide::remove(temp.string().c_str());
+
+    timer.done("total");
+}
+
+void write_json(FILE *file, const std::vector<std::pair<std::string, std::vector<std::pair<std::string, StepStats>>>> &results, int repeat)
+{
+    fprintf(file, "{\n  \"version\": \"%s\",\n  \"repeat\": %d,\n  \"cases\": [", SLIC3R_VERSION, repeat);
+    for (size_t i = 0; i < results.size(); ++ i) {
+        fprintf(file, "%s\n    {\n      \"name\": \"%s\",\n      \"steps\": [", i == 0 ? "" : ",", results[i].first.c_str());
+        const auto &steps = results[i].second;
+        for (size_t j = 0; j < steps.size(); ++ j) {
+            const StepStats &stats = steps[j].second;
+            // Times are averaged over the runs.
+            fprintf(file, "%s\n        { \"name\": \"%s\", \"wall_s\": %.6f, \"cpu_s\": %.6f, \"peak_rss_bytes\": %zu }",
+                j == 0 ? "" : ",", steps[j].first.c_str(), stats.wall / repeat, stats.cpu / repeat, stats.peak_rss);
+        }
+        fprintf(file, "\n      ]\n    }");
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
+
+void print_usage()
+{
+    printf("Usage: slic3r_bench [--json <file>] [--repeat <n>] [--case <name>]...\n"
+           "Slices the benchmark corpus and prints the timings of each slicing step.\n"
+           "  --json <file>    write the results as JSON into file (\"-\" for the standard output, the table is then\n"
+           "                   printed to the standard error)\n"
+           "  --repeat <n>     slice each case n times, the times are averaged (default 1)\n"
+           "  --case <name>    only run this case, can be repeated\n"
+           "  --list           list the cases\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string              json_path;
+    int                      repeat = 1;
+    std::vector<std::string> selected;
+    bool                     list = false;
+    for (int i = 1; i < argc; ++ i) {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--json") == 0 && has_value)
+            json_path = argv[++ i];
+        else if (strcmp(argv[i], "--repeat") == 0 && has_value)
+            repeat = std::max(1, atoi(argv[++ i]));
+        else if (strcmp(argv[i], "--case") == 0 && has_value)
+            selected.emplace_back(argv[++ i]);
+        else if (strcmp(argv[i], "--list") == 0)
+            list = true;
+        else {
+            print_usage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    // No logging in the middle of the timings.
+    set_logging_level(1);
+    // The JSON written to the standard output is not mixed with the table.
+    FILE *table = json_path == "-" ? stderr : stdout;
+
+    std::vector<std::pair<std::string, std::vector<std::pair<std::string, StepStats>>>> results;
+    for (const BenchCase &bench_case : bench_cases()) {
+        if (list) {
+            printf("%s\n", bench_case.name.c_str());
+            continue;
+        }
+        if (! selected.empty() && std::find(selected.begin(), selected.end(), bench_case.name) == selected.end())
+            continue;
+        StepTimer timer;
+        try {
+            for (int run = 0; run < repeat; ++ run)
+                run_case(bench_case, timer);
+        } catch (const std::exception &ex) {
+            fprintf(stderr, "%s: %s\n", bench_case.name.c_str(), ex.what());
+            return 1;
+        }
+        results.emplace_back(bench_case.name, timer.stats());
+        fprintf(table, "%s\n", bench_case.name.c_str());
+        for (const auto &[name, stats] : results.back().second)
+            fprintf(table, "    %-20s wall %10.3f s   cpu %10.3f s   peak rss %8zu MB\n", name.c_str(), stats.wall / repeat, stats.cpu / repeat, stats.peak_rss >> 20);
+        fflush(table);
+    }
+
+    if (! json_path.empty() && ! list) {
+        FILE *file = json_path == "-" ? stdout : boost::nowide::fopen(json_path.c_str(), "w");
+        if (file == nullptr) {
+            fprintf(stderr, "Can't write %s\n", json_path.c_str());
+            return 1;
+        }
+        write_json(file, results, repeat);
+        if (file != stdout)
+            fclose(file);
+    }
+    return 0;
+}
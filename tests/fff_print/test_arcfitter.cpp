@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <sstream>
+
+#include "libslic3r/GCode/ArcFitter.hpp"
+#include "libslic3r/LocalesUtils.hpp"
+
+using namespace Slic3r;
+
+// A quarter of a circle of radius 10 around the origin, starting at (10,0), with 20 segments.
+static std::string quarter_circle_gcode(bool ccw, bool relative_e)
+{
+    std::string gcode = "G1 X10 Y0 F9000\n";
+    double e = 0;
+    for (int i = 1; i <= 20; ++i) {
+        double angle = (ccw ? 1 : -1) * i * PI / 40;
+        double de = 0.05 * 2 * 10 * std::sin(PI / 80);
+        e += de;
+        gcode += "G1 X" + to_string_nozero(10 * std::cos(angle), 3) + " Y" + to_string_nozero(10 * std::sin(angle), 3)
+            + " E" + to_string_nozero(relative_e ? de : e, 5) + "\n";
+    }
+    return gcode;
+}
+
+SCENARIO("Arc fitting", "[ArcFitter]") {
+    GCodeConfig config;
+    config.gcode_precision_xyz.value = 3;
+    config.gcode_precision_e.value = 5;
+    GIVEN("A quarter of circle with relative extrusion") {
+        config.use_relative_e_distances.value = true;
+        WHEN("it's counter-clockwise") {
+            ArcFitter arc_fitter(config, 0.05);
+            std::string result = arc_fitter.process_layer(quarter_circle_gcode(true, true));
+            THEN("it's replaced by a single G3") {
+                REQUIRE(result == "G1 X10 Y0 F9000\nG3 X0 Y10 I-10 J0 E0.7852\n");
+            }
+        }
+        WHEN("it's clockwise") {
+            ArcFitter arc_fitter(config, 0.05);
+            std::string result = arc_fitter.process_layer(quarter_circle_gcode(false, true));
+            THEN("it's replaced by a single G2") {
+                REQUIRE(result == "G1 X10 Y0 F9000\nG2 X0 Y-10 I-10 J0 E0.7852\n");
+            }
+        }
+    }
+    GIVEN("A quarter of circle with absolute extrusion") {
+        config.use_relative_e_distances.value = false;
+        ArcFitter arc_fitter(config, 0.05);
+        std::string result = arc_fitter.process_layer(quarter_circle_gcode(true, false));
+        THEN("the arc ends with the last E value") {
+            REQUIRE(result == "G1 X10 Y0 F9000\nG3 X0 Y10 I-10 J0 E0.7852\n");
+        }
+    }
+    GIVEN("Straight lines, travels and retractions") {
+        config.use_relative_e_distances.value = true;
+        const std::string gcode =
+            "G1 X0 Y0 F9000\n"
+            "G1 X1 Y0 E0.1\n"
+            "G1 X2 Y0 E0.1\n"
+            "G1 X3 Y0 E0.1\n"
+            "G1 X4 Y0 E0.1\n"
+            "G1 E-1 F2400\n"
+            "G1 X4 Y4 F9000\n"
+            "G1 Z0.4\n";
+        ArcFitter arc_fitter(config, 0.05);
+        THEN("the G-code is left untouched") {
+            REQUIRE(arc_fitter.process_layer(gcode) == gcode);
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/GCode/BinaryGCode.hpp"
+#include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r_version.h"
+
+#include "test_data.hpp"
+
+#include <cstdio>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+using namespace Slic3r;
+using namespace Slic3r::Test;
+
+// Encode the text into a binary G-code file, fed by pieces of piece_size bytes.
+static void encode(const std::string &text, const std::string &path, size_t piece_size)
+{
+    FILE *file = boost::nowide::fopen(path.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    {
+        BinaryGCode::Encoder encoder(file, "test");
+        for (size_t i = 0; i < text.size(); i += piece_size)
+            encoder.append(text.data() + i, text.data() + std::min(text.size(), i + piece_size));
+        REQUIRE(encoder.finish());
+    }
+    fclose(file);
+}
+
+SCENARIO("Binary G-code encoding", "[BinaryGCode]") {
+    const std::string path = boost::filesystem::unique_path().string();
+    GIVEN("A G-code with a thumbnail and a config section") {
+        std::string header = "; generated by " SLIC3R_APP_NAME "\n;\n";
+        // "abcd" in base64.
+        std::string thumbnail = "; thumbnail begin 2x2 8\n; YWJjZA==\n; thumbnail end\n";
+        std::string gcode;
+        for (int i = 0; i < 50000; ++ i)
+            gcode += "G1 X" + std::to_string(i % 200) + " Y" + std::to_string((i * 7) % 200) + " E0.05\n";
+        std::string config = "; " SLIC3R_APP_NAME "_config = begin\n; layer_height = 0.2\n; " SLIC3R_APP_NAME "_config = end\n";
+        const std::string text = header + thumbnail + ";\n" + gcode + config;
+        WHEN("it's encoded by small pieces") {
+            encode(text, path, 1000);
+            THEN("the file is recognized as a binary G-code, smaller than the text") {
+                REQUIRE(BinaryGCode::is_binary_gcode_file(path));
+                REQUIRE(boost::filesystem::file_size(path) < text.size() / 2);
+            }
+            THEN("the decoded G-code is the text without its thumbnail") {
+                std::string decoded, error;
+                REQUIRE(BinaryGCode::decode_gcode(path, [&decoded](const char *begin, const char *end) { decoded.append(begin, end); return true; }, error));
+                REQUIRE(decoded == header + ";\n" + gcode + config);
+            }
+            THEN("the thumbnail is stored as an image") {
+                BinaryGCode::Reader reader(path);
+                BinaryGCode::Block  block;
+                size_t              thumbnails = 0;
+                while (reader.next_block(block))
+                    if (block.type == BinaryGCode::BlockType::Thumbnail) {
+                        ++ thumbnails;
+                        REQUIRE(block.thumbnail_format == BinaryGCode::ThumbnailFormat::PNG);
+                        REQUIRE(block.thumbnail_width == 2);
+                        REQUIRE(std::string(block.data.begin(), block.data.end()) == "abcd");
+                    }
+                REQUIRE(reader.is_valid());
+                REQUIRE(thumbnails == 1);
+            }
+            THEN("the config is stored as slicer metadata") {
+                std::vector<std::pair<std::string, std::string>> key_values;
+                REQUIRE(BinaryGCode::read_slicer_metadata(path, key_values));
+                REQUIRE(key_values == std::vector<std::pair<std::string, std::string>>{ { "layer_height", "0.2" } });
+            }
+        }
+        WHEN("the file is corrupted") {
+            encode(text, path, text.size());
+            FILE *file = boost::nowide::fopen(path.c_str(), "r+b");
+            fseek(file, long(boost::filesystem::file_size(path) / 2), SEEK_SET);
+            int c = fgetc(file);
+            fseek(file, long(boost::filesystem::file_size(path) / 2), SEEK_SET);
+            fputc(c ^ 0xff, file);
+            fclose(file);
+            THEN("the decoding fails") {
+                std::string error;
+                REQUIRE(! BinaryGCode::decode_gcode(path, [](const char*, const char*) { return true; }, error));
+                REQUIRE(! error.empty());
+            }
+        }
+    }
+    boost::nowide::remove(path.c_str());
+}
+
+SCENARIO("Binary G-code export", "[BinaryGCode]") {
+    GIVEN("A cube sliced into a text and a binary G-code") {
+        auto export_gcode = [](bool binary, const std::string &path) {
+            Print print;
+            Model model;
+            init_print({ TestMesh::cube_20x20x20 }, print, model, { { "binary_gcode", binary } });
+            print.set_status_silent();
+            print.process();
+            print.export_gcode(path, nullptr, nullptr);
+        };
+        const std::string text_path   = boost::filesystem::unique_path().string();
+        const std::string binary_path = boost::filesystem::unique_path().string();
+        export_gcode(false, text_path);
+        export_gcode(true, binary_path);
+        THEN("the binary G-code is smaller") {
+            REQUIRE(BinaryGCode::is_binary_gcode_file(binary_path));
+            REQUIRE(boost::filesystem::file_size(binary_path) < boost::filesystem::file_size(text_path));
+        }
+        THEN("the GCodeReader reads the same lines from both") {
+            auto read_lines = [](const std::string &path) {
+                std::vector<std::string> lines;
+                GCodeReader reader;
+                REQUIRE(reader.parse_file_raw(path, [&lines](GCodeReader&, const char *begin, const char *end) { lines.emplace_back(begin, end); }));
+                return lines;
+            };
+            std::vector<std::string> text_lines   = read_lines(text_path);
+            std::vector<std::string> binary_lines = read_lines(binary_path);
+            // Only the thumbnails (none here), the binary_gcode value and the time stamp differ.
+            REQUIRE(text_lines.size() == binary_lines.size());
+            size_t different = 0;
+            for (size_t i = 0; i < text_lines.size(); ++ i)
+                if (text_lines[i] != binary_lines[i] && text_lines[i].rfind("; generated by", 0) != 0) {
+                    ++ different;
+                    REQUIRE(text_lines[i] == "; binary_gcode = 0");
+                    REQUIRE(binary_lines[i] == "; binary_gcode = 1");
+                }
+            REQUIRE(different == 1);
+        }
+        THEN("the config is loaded from the binary G-code") {
+            DynamicPrintConfig config;
+            config.load_from_gcode_file(binary_path, ForwardCompatibilitySubstitutionRule::Disable);
+            REQUIRE(config.opt_bool("binary_gcode"));
+        }
+        boost::nowide::remove(text_path.c_str());
+        boost::nowide::remove(binary_path.c_str());
+    }
+}
+
+SCENARIO("Binary G-code file name", "[BinaryGCode]") {
+    GIVEN("A print exporting a binary G-code") {
+        Print print;
+        Model model;
+        init_print({ TestMesh::cube_20x20x20 }, print, model, { { "binary_gcode", true }, { "output_filename_format", "[input_filename_base].gcode" } });
+        THEN("the file gets its own extension, not the one of the binary G-code of other slicers") {
+            REQUIRE(boost::iends_with(print.output_filename(), ".ssbg"));
+            REQUIRE(is_gcode_file("cube.ssbg"));
+            REQUIRE(! is_gcode_file("cube.bgcode"));
+        }
+    }
+}
@@ -4,6 +4,7 @@
 
 #include "libslic3r/ExtrusionEntityCollection.hpp"
 #include "libslic3r/ExtrusionEntity.hpp"
+#include "libslic3r/ExtrusionEntityPacked.hpp"
 #include "libslic3r/Point.hpp"
 #include "libslic3r/libslic3r.h"
 
@@ -83,3 +84,49 @@ SCENARIO("ExtrusionEntityCollection: Polygon flattening", "[ExtrusionEntity]") {
         }
     }
 }
+
+SCENARIO("PackedExtrusionEntities: packing and unpacking", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF);
+
+    GIVEN("A collection of paths, loops and multipaths with a nested no-sort collection") {
+        ExtrusionEntityCollection sub_nosort;
+        sub_nosort.append(random_paths(5));
+        sub_nosort.set_can_sort_reverse(false, false);
+
+        ExtrusionPath3D path3D(erGapFill, 0.5, 0.6f, 0.2f);
+        for (size_t i = 0; i < 10; ++ i)
+            path3D.push_back(random_point(), coord_t(i * 1000));
+
+        ExtrusionPath loop_path = random_path();
+        loop_path.polyline.append(loop_path.first_point());
+
+        ExtrusionEntityCollection sample;
+        sample.append(random_paths(3));
+        sample.append(sub_nosort);
+        sample.append(ExtrusionLoop(loop_path, elrHole));
+        sample.append(ExtrusionMultiPath(random_paths(1).front()));
+        sample.append(path3D);
+
+        PackedExtrusionEntities packed(sample);
+        THEN("It counts the same extrusions") {
+            REQUIRE(packed.items_count() == sample.items_count());
+        }
+        THEN("It has the same role") {
+            REQUIRE(packed.role() == sample.role());
+        }
+        THEN("The unpacked collection is the same as the original one") {
+            ExtrusionEntityCollection unpacked = packed.unpack();
+            REQUIRE(ExtrusionPrinter(1.).print(unpacked) == ExtrusionPrinter(1.).print(sample));
+            REQUIRE(unpacked.entities().size() == sample.entities().size());
+            REQUIRE(! static_cast<const ExtrusionEntityCollection*>(unpacked.entities()[3])->can_sort());
+        }
+        THEN("The paths share a single buffer of points") {
+            size_t num_points = 0;
+            packed.for_each_path([&num_points](const PackedExtrusionEntities::Path &path, const Point *begin, const Point *end) { num_points += end - begin; });
+            Points points;
+            sample.collect_points(points);
+            REQUIRE(num_points == points.size());
+            REQUIRE(packed.points().size() == points.size());
+        }
+    }
+}
@@ -1,8 +1,19 @@
 #include <catch2/catch.hpp>
 
 #include <memory>
+#include <set>
+#include <string_view>
 
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+#include "libslic3r/GCode/SeamPlacer.hpp"
+#include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/Layer.hpp"
+
+#include "test_data.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
 
 using namespace Slic3r;
 
@@ -20,3 +31,346 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("Parsing a G-code file by chunks in parallel", "[GCode]") {
+    GIVEN("A G-code file of several chunks, with CRLF line ends and a last line not ended") {
+        std::string gcode = "G92 E0\n";
+        for (int i = 0; i < 60000; ++ i) {
+            gcode += "G1 X" + std::to_string(i % 200) + " Y" + std::to_string((i * 7) % 200) + " E" + std::to_string(i) + ".5 ; move\n";
+            if (i % 1000 == 0)
+                gcode += ";LAYER_CHANGE\r\n\nG1 Z" + std::to_string(i / 1000) + "\r\n";
+        }
+        gcode += "G1 X1 Y2";
+        const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+        {
+            FILE *file = boost::nowide::fopen(path.c_str(), "wb");
+            REQUIRE(file != nullptr);
+            REQUIRE(fwrite(gcode.data(), 1, gcode.size(), file) == gcode.size());
+            fclose(file);
+        }
+        REQUIRE(gcode.size() > 2 * (1 << 20));
+        struct Parsed {
+            std::string raw;
+            float       x, y, z, e;
+        };
+        auto collect = [](std::vector<Parsed> &out) {
+            return [&out](GCodeReader &reader, const GCodeReader::GCodeLine &line) { out.push_back({ line.raw(), reader.x(), reader.y(), reader.z(), reader.e() }); };
+        };
+        std::vector<Parsed> from_buffer;
+        GCodeReader().parse_buffer(gcode, collect(from_buffer));
+        WHEN("the file is parsed") {
+            std::vector<Parsed> from_file;
+            std::vector<size_t> lines_ends;
+            REQUIRE(GCodeReader().parse_file(path, collect(from_file), lines_ends));
+            THEN("the lines and the positions are the ones of the buffer parsed serially") {
+                REQUIRE(from_file.size() == from_buffer.size());
+                for (size_t i = 0; i < from_file.size(); ++ i) {
+                    REQUIRE(from_file[i].raw == from_buffer[i].raw);
+                    REQUIRE(from_file[i].x == from_buffer[i].x);
+                    REQUIRE(from_file[i].y == from_buffer[i].y);
+                    REQUIRE(from_file[i].z == from_buffer[i].z);
+                    REQUIRE(from_file[i].e == from_buffer[i].e);
+                }
+            }
+            THEN("the line ends are the positions after the newlines") {
+                std::vector<size_t> expected;
+                for (size_t i = 0; i < gcode.size(); ++ i)
+                    if (gcode[i] == '\n')
+                        expected.emplace_back(i + 1);
+                REQUIRE(lines_ends == expected);
+            }
+        }
+        WHEN("the callback stops the parsing") {
+            size_t num_lines = 0;
+            REQUIRE(GCodeReader().parse_file(path, [&num_lines](GCodeReader &reader, const GCodeReader::GCodeLine &) {
+                if (++ num_lines == 50000)
+                    reader.quit_parsing();
+            }));
+            THEN("no other line is given to the callback") {
+                REQUIRE(num_lines == 50000);
+            }
+        }
+        boost::filesystem::remove(path);
+    }
+}
+
+SCENARIO("Columnar storage of the processed moves", "[GCode]") {
+    GIVEN("Moves with runs of constant attributes") {
+        std::vector<GCodeProcessorResult::MoveVertex> moves;
+        moves.emplace_back();
+        for (uint32_t i = 1; i < 1000; ++ i)
+            moves.emplace_back(i * 3, (i % 5 == 0) ? EMoveType::Travel : EMoveType::Extrude, (i < 500) ? erPerimeter : erSolidInfill,
+                uint8_t(i / 300), uint8_t(i / 400), Vec3f(float(i), float(i % 7), float(i / 100)), 0.01f * float(i % 5), 40.f, 0.45f, 0.2f,
+                (i % 5 == 0) ? 0.f : 0.05f, (i < 100) ? 0.f : 100.f, 215.f, float(i), float(i / 100));
+        GCodeProcessorResult::MoveVertices store;
+        store.assign(moves);
+        auto same = [](const GCodeProcessorResult::MoveVertex &m1, const GCodeProcessorResult::MoveVertex &m2) {
+            return m1.gcode_id == m2.gcode_id && m1.type == m2.type && m1.extrusion_role == m2.extrusion_role && m1.extruder_id == m2.extruder_id &&
+                m1.cp_color_id == m2.cp_color_id && m1.position == m2.position && m1.delta_extruder == m2.delta_extruder && m1.feedrate == m2.feedrate &&
+                m1.width == m2.width && m1.height == m2.height && m1.mm3_per_mm == m2.mm3_per_mm && m1.fan_speed == m2.fan_speed &&
+                m1.temperature == m2.temperature && m1.time == m2.time && m1.layer_duration == m2.layer_duration;
+        };
+        THEN("The moves are read back unchanged in sequence") {
+            REQUIRE(store.size() == moves.size());
+            size_t id = 0;
+            bool all_same = true;
+            for (const GCodeProcessorResult::MoveVertex &move : store)
+                all_same &= same(move, moves[id ++]);
+            REQUIRE(all_same);
+        }
+        THEN("The moves are read back unchanged by random access") {
+            bool all_same = true;
+            for (int id = int(moves.size()) - 1; id >= 0; id -= 7)
+                all_same &= same(store[id], moves[id]);
+            REQUIRE(all_same);
+        }
+        THEN("The storage is smaller than the vector of moves") {
+            REQUIRE(store.memory_size() < moves.size() * sizeof(GCodeProcessorResult::MoveVertex) / 2);
+        }
+        THEN("A copy shares the moves and keeps them when the original is assigned again") {
+            GCodeProcessorResult::MoveVertices copy = store;
+            store.assign(std::vector<GCodeProcessorResult::MoveVertex>(moves.begin(), moves.begin() + 10));
+            REQUIRE(store.size() == 10);
+            REQUIRE(copy.size() == moves.size());
+            REQUIRE(same(copy.back(), moves.back()));
+            store.clear();
+            REQUIRE(store.empty());
+            REQUIRE(copy.size() == moves.size());
+        }
+        WHEN("The moves are appended in blocks, then their gcode ids and layer durations are updated") {
+            GCodeProcessorResult::MoveVertices::Builder builder;
+            for (size_t id = 0; id < moves.size(); id += 128)
+                for (size_t i = id; i < std::min(id + 128, moves.size()); ++ i)
+                    builder.append(moves[i]);
+            for (uint32_t &gcode_id : builder.gcode_ids())
+                gcode_id += 10;
+            const std::vector<float> layers_times { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f };
+            builder.set_layer_durations(layers_times);
+            GCodeProcessorResult::MoveVertices built;
+            builder.build(built);
+            THEN("The moves are read back updated") {
+                REQUIRE(builder.size() == 0);
+                REQUIRE(built.size() == moves.size());
+                bool all_same = true;
+                size_t id = 0;
+                for (const GCodeProcessorResult::MoveVertex &move : built) {
+                    GCodeProcessorResult::MoveVertex expected = moves[id ++];
+                    expected.gcode_id += 10;
+                    const size_t layer_id = size_t(expected.layer_duration);
+                    expected.layer_duration = (layer_id > 0 && layer_id <= layers_times.size()) ? layers_times[layer_id - 1] : 0.f;
+                    all_same &= same(move, expected);
+                }
+                REQUIRE(all_same);
+            }
+        }
+    }
+}
+
+SCENARIO("Tokenized G-code passed between the filters", "[GCode]") {
+    GIVEN("A layer of G-code") {
+        MoveBuffer::Syntax syntax;
+        MoveBuffer gcode(std::string(";TYPE:External perimeter\nG1 X10.5 Y2 E0.123 F1800 ;_EXTRUDE_SET_SPEED\nT1\nM106 S255\nG1 Z0.4"), syntax);
+        THEN("the lines are tokenized") {
+            REQUIRE(gcode.size() == 5);
+            REQUIRE(gcode.text().back() == '\n');
+            const std::vector<MoveBuffer::Line> &lines = gcode.lines();
+            REQUIRE(lines[0].has_marker(MoveBuffer::mkRole));
+            REQUIRE(lines[0].role == erExternalPerimeter);
+            REQUIRE(lines[1].is_linear_move());
+            REQUIRE(lines[1].has_marker(MoveBuffer::mkExtrudeSetSpeed));
+            REQUIRE(lines[1].value(X) == Approx(10.5));
+            REQUIRE(lines[1].value(F) == Approx(1800.));
+            REQUIRE(gcode.value_text(lines[1], E) == "0.123");
+            REQUIRE(! lines[1].has(Z));
+            REQUIRE(! lines[1].has(UNKNOWN_AXIS));
+            REQUIRE(lines[2].letter == 'T');
+            REQUIRE(lines[2].code == 1);
+            REQUIRE(lines[1].extruder == 0);
+            REQUIRE(lines[2].extruder == 1);
+            REQUIRE(lines[4].extruder == 1);
+            REQUIRE(gcode.extruder() == 1);
+            REQUIRE(lines[3].is_M(106));
+            REQUIRE(lines[3].has(UNKNOWN_AXIS));
+        }
+        WHEN("its lines are copied into another buffer and some G-code is appended") {
+            MoveBuffer out(syntax);
+            out.append_gcode("M107");
+            out.append(gcode, 1, 3);
+            out.append(gcode, gcode.lines().back());
+            THEN("the text and the lines are moved together") {
+                REQUIRE(out.text() == "M107\nG1 X10.5 Y2 E0.123 F1800 ;_EXTRUDE_SET_SPEED\nT1\nG1 Z0.4\n");
+                REQUIRE(out.size() == 4);
+                REQUIRE(out.text(out.lines()[1]) == "G1 X10.5 Y2 E0.123 F1800 ;_EXTRUDE_SET_SPEED");
+                REQUIRE(out.comment(out.lines()[1]) == ";_EXTRUDE_SET_SPEED");
+                REQUIRE(out.value_text(out.lines()[3], Z) == "0.4");
+            }
+            THEN("the lines keep their extruder and the appended G-code gets the one of the last line") {
+                REQUIRE(out.lines()[0].extruder == 0);
+                REQUIRE(out.lines()[2].extruder == 1);
+                out.append_gcode("M106 S128\nT-1\nTx");
+                REQUIRE(out.lines()[4].extruder == 1);
+                REQUIRE(out.lines()[5].code == -1);
+                REQUIRE(out.lines()[6].code == -1);
+                REQUIRE(out.extruder() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("G-code filters on the tokenized layers of a sliced print", "[GCode]") {
+    // Run the vase mode, the cooling buffer and the fan mover on the layers of the G-code of a print, passing the tokenized
+    // layers from a filter to the next one as GCode::process_layers() does, or the text, each filter parsing it again
+    // as it was before the MoveBuffer: the G-code has to be the same.
+    auto run_filters = [](const Print &print, const std::string &gcode, size_t first_vase_layer, bool parse_text) {
+        GCode gcodegen;
+        gcodegen.apply_print_config(print.config());
+        std::set<uint16_t> extruders = print.extruders();
+        gcodegen.writer().set_extruders(std::vector<uint16_t>(extruders.begin(), extruders.end()));
+        const MoveBuffer::Syntax syntax(gcodegen.config(), gcodegen.writer().toolchange_prefix());
+        SpiralVase    spiral_vase(print.config());
+        CoolingBuffer cooling_buffer(gcodegen);
+        FanMover      fan_mover(gcodegen.writer(), 1.f, false, print.config().use_relative_e_distances.value, false, 0.f);
+        auto pass = [parse_text](MoveBuffer &&buffer) -> MoveBuffer {
+            if (! parse_text)
+                return std::move(buffer);
+            const MoveBuffer::Syntax syntax   = buffer.syntax();
+            const uint16_t           extruder = buffer.start_extruder();
+            return MoveBuffer(buffer.release_text(), syntax, extruder);
+        };
+        // Split the G-code at the layer changes, the first block is the start G-code. The cooling markers
+        // are removed from the exported G-code, put back the ones of the extrusion speeds.
+        std::vector<std::string> layers(1);
+        for (size_t begin = 0; begin < gcode.size();) {
+            size_t end = std::min(gcode.find('\n', begin), gcode.size() - 1) + 1;
+            std::string_view line(gcode.data() + begin, end - begin);
+            if (line == ";LAYER_CHANGE\n")
+                layers.emplace_back();
+            if (line.compare(0, 4, "G1 F") == 0 && line.find(' ', 4) == std::string_view::npos)
+                layers.back() += std::string(line.substr(0, line.size() - 1)) + " ;_EXTRUDE_SET_SPEED\n";
+            else
+                layers.back() += line;
+            begin = end;
+        }
+        std::string out = layers.front();
+        uint16_t    extruder = 0;
+        for (size_t i = 1; i < layers.size(); ++ i) {
+            MoveBuffer layer(std::move(layers[i]), syntax, extruder);
+            extruder = layer.extruder();
+            spiral_vase.enable(i > first_vase_layer);
+            layer = pass(spiral_vase.process_layer(std::move(layer)));
+            layer = pass(cooling_buffer.process_layer(std::move(layer), i - 1, true));
+            out += fan_mover.process_gcode(std::move(layer), true).release_text();
+        }
+        return out;
+    };
+    GIVEN("A cube sliced for the vase mode") {
+        Print print;
+        Test::init_and_process_print({ Test::TestMesh::cube_20x20x20 }, print, {
+            { "perimeters",                 1 },
+            { "fill_density",               0 },
+            { "top_solid_layers",           0 },
+            { "bottom_solid_layers",        3 },
+            { "skirts",                     0 },
+            { "layer_height",               0.4 },
+            { "first_layer_height",         0.4 },
+            { "use_relative_e_distances",   true },
+            { "cooling",                    true },
+            { "slowdown_below_layer_time",  60 },
+            { "fan_below_layer_time",       60 },
+            { "disable_fan_first_layers",   2 },
+            { "before_layer_gcode",         ";LAYER_CHANGE" }
+        });
+        const std::string gcode = Test::gcode(print);
+        THEN("The filters give the same G-code from the tokens and from the text") {
+            const std::string out = run_filters(print, gcode, 3, false);
+            REQUIRE(out.find("; Began spiral") != std::string::npos);
+            REQUIRE(out == run_filters(print, gcode, 3, true));
+        }
+    }
+    GIVEN("A cube sliced with its infill printed by a second extruder") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_num_extruders(2);
+        config.set_deserialize_strict({
+            { "infill_extruder",            2 },
+            { "solid_infill_extruder",      2 },
+            { "cooling",                    true },
+            { "slowdown_below_layer_time",  60 },
+            { "fan_below_layer_time",       60 },
+            { "before_layer_gcode",         ";LAYER_CHANGE" }
+        });
+        Print print;
+        Test::init_and_process_print({ Test::TestMesh::cube_20x20x20 }, print, config);
+        const std::string gcode = Test::gcode(print);
+        THEN("The filters give the same G-code from the tokens and from the text") {
+            REQUIRE(gcode.find("\nT1") != std::string::npos);
+            const std::string out = run_filters(print, gcode, size_t(-1), false);
+            REQUIRE(out != gcode);
+            REQUIRE(out == run_filters(print, gcode, size_t(-1), true));
+        }
+    }
+}
+
+SCENARIO("Fan mover kickstart", "[GCode]") {
+    GIVEN("A fan mover with a kickstart and no delay") {
+        GCodeWriter writer;
+        writer.config.gcode_comments.value  = false;
+        writer.config.gcode_flavor.value    = gcfRepRap;
+        writer.config.fan_percentage.value  = false;
+        FanMover fan_mover(writer, 0.f, false, true, false, 1.f);
+        WHEN("the fan is set to half its speed before some moves at 10mm/s") {
+            const std::string gcode = "G1 X0 Y0 F600\nM106 S128\nG1 X4.5 E0.45\nG1 X14.5 E1\nM107\n";
+            THEN("the G-code is the one of the text-based fan mover") {
+                // The full speed is written before the first move, with the empty line of its buffered line, and the
+                // half speed after the 0.5s of kickstart.
+                REQUIRE(fan_mover.process_gcode(gcode, true) == "G1 X0 Y0 F600\nM106 S255\n\nG1 X4.5 E0.45\nM106 S128\nG1 X14.5 E1\nM107\n");
+            }
+        }
+    }
+}
+
+SCENARIO("Precomputed seam candidates", "[GCode]") {
+    // Seams of all the perimeter loops of the object, placed in the order of the layers and of their perimeters.
+    auto place_seams = [](const Print &print, SeamPosition seam_position, bool precompute) {
+        SeamPlacer placer;
+        placer.init(print);
+        if (precompute)
+            placer.precompute_candidates(print);
+        const PrintObject *object = print.objects().front();
+        Points seams;
+        Point  last_pos(0, 0);
+        for (const Layer *layer : object->layers()) {
+            const EdgeGrid::Grid *lower_layer_edge_grid = layer->lower_layer ? layer->lower_layer->lslices_grid() : nullptr;
+            for (const LayerRegion *layerm : layer->regions()) {
+                const coordf_t nozzle_dmr = print.config().nozzle_diameter.get_at(std::max(1, layerm->region().config().perimeter_extruder.value) - 1);
+                std::vector<const ExtrusionEntity*> loops;
+                std::function<void(const ExtrusionEntityCollection&)> collect_loops = [&loops, &collect_loops](const ExtrusionEntityCollection &collection) {
+                    for (const ExtrusionEntity *ee : collection.entities())
+                        if (const ExtrusionEntityCollection *coll = dynamic_cast<const ExtrusionEntityCollection*>(ee))
+                            collect_loops(*coll);
+                        else if (ee->is_loop())
+                            loops.push_back(ee);
+                };
+                collect_loops(layerm->perimeters);
+                placer.plan_perimeters(loops, *layer, seam_position, last_pos, nozzle_dmr, object, 0, lower_layer_edge_grid);
+                for (const ExtrusionEntity *ee : loops) {
+                    ExtrusionLoop loop = *static_cast<const ExtrusionLoop*>(ee);
+                    placer.place_seam(loop, last_pos, false, nozzle_dmr, 0, lower_layer_edge_grid);
+                    seams.push_back(loop.first_point());
+                    last_pos = loop.last_point();
+                }
+            }
+        }
+        return seams;
+    };
+    for (Test::TestMesh mesh : { Test::TestMesh::gt2_teeth, Test::TestMesh::overhang })
+        for (SeamPosition seam_position : { spCost, spAligned, spRear })
+            GIVEN(std::string(Test::mesh_names.at(mesh)) + " sliced, seam position " + std::to_string(int(seam_position))) {
+                Print print;
+                Test::init_and_process_print({ mesh }, print, { { "layer_height", 0.3 } });
+                THEN("The seams are the same with and without the precomputed candidates") {
+                    Points seams = place_seams(print, seam_position, true);
+                    REQUIRE(! seams.empty());
+                    REQUIRE(seams == place_seams(print, seam_position, false));
+                }
+            }
+}
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "libslic3r/GCodeWriter.hpp"
+#include "libslic3r/LocalesUtils.hpp"
 
 using namespace Slic3r;
 
@@ -157,3 +158,51 @@ SCENARIO("set_fan saves state.", "[GCode][GCodeWriter]") {
         }
     }
 }
+
+SCENARIO("GCodeFormatter formats the numbers like to_string_nozero.", "[GCodeWriter]") {
+    GIVEN("Coordinates with up to 9 decimals") {
+        const std::vector<double> values { 0., -0., 1., 10., 203.2, 9.99999, 0.0005, -0.0005, 0.00049999, 2.675, 123.4565, 1e-9, 123456789.123 };
+        for (int precision : { 3, 5, 6 })
+            for (double v : values) {
+                std::string gcode;
+                GCodeFormatter(gcode).emit_axis('X', v, precision);
+                REQUIRE(gcode == " X" + to_string_nozero(v, precision));
+            }
+    }
+}
+
+SCENARIO("Appending the moves and returning them give the expected G-code.", "[GCodeWriter]") {
+    GIVEN("Two GCodeWriters with a single extruder, comments on") {
+        GCodeWriter writers[2];
+        for (GCodeWriter &writer : writers) {
+            writer.config.gcode_comments.value = true;
+            writer.set_extruders({ 0 });
+            writer.set_tool(0);
+        }
+        const std::string expected =
+            "G1 F1800 ; speed;_EXTRUDE_SET_SPEED\n"
+            "G1 X10.25 Y3 F7800 ; travel\n"
+            "G1 X20.123 Y3 E0.12346 ; extrude\n"
+            "G1 X20.5 Y4 Z0.2 E0.17346\n";
+        WHEN("the moves are returned by the first one") {
+            std::string returned;
+            returned += writers[0].set_speed(30., "speed", ";_EXTRUDE_SET_SPEED");
+            returned += writers[0].travel_to_xy(Vec2d(10.25, 3.), 0., "travel");
+            returned += writers[0].extrude_to_xy(Vec2d(20.123456, 3.00004), 0.123456789, "extrude");
+            returned += writers[0].extrude_to_xyz(Vec3d(20.5, 4., 0.2), 0.05);
+            THEN("the G-code is the expected one") {
+                REQUIRE_THAT(returned, Catch::Equals(expected));
+            }
+        }
+        WHEN("the moves are appended by the second one") {
+            std::string appended = "; before\n";
+            writers[1].set_speed(appended, 30., "speed", ";_EXTRUDE_SET_SPEED");
+            writers[1].travel_to_xy(appended, Vec2d(10.25, 3.), 0., "travel");
+            writers[1].extrude_to_xy(appended, Vec2d(20.123456, 3.00004), 0.123456789, "extrude");
+            writers[1].extrude_to_xyz(appended, Vec3d(20.5, 4., 0.2), 0.05);
+            THEN("the expected G-code is appended after the existing one") {
+                REQUIRE_THAT(appended, Catch::Equals("; before\n" + expected));
+            }
+        }
+    }
+}
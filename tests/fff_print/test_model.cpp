@@ -2,6 +2,8 @@
 
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Model.hpp"
+#include "libslic3r/Arrange.hpp"
+#include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/ModelArrange.hpp"
 
 #include <boost/nowide/cstdio.hpp>
@@ -60,3 +62,71 @@ SCENARIO("Model construction", "[Model]") {
         }
     }
 }
+
+SCENARIO("Model arranged over several plates", "[Model]") {
+    GIVEN("Six cubes too many for a 50x50 bed") {
+        Slic3r::Model model;
+        Slic3r::ModelObject *model_object = model.add_object();
+        model_object->add_volume(Slic3r::make_cube(20, 20, 20));
+        for (int i = 0; i < 6; ++ i)
+            model_object->add_instance();
+        Points bed { { 0, 0 }, { scaled(50.), 0 }, { scaled(50.), scaled(50.) }, { 0, scaled(50.) } };
+
+        WHEN("The cubes are arranged on plates") {
+            std::vector<Model> plates = arrange_plates(model, bed, ArrangeParams{ scaled(6.) });
+            THEN("All the cubes are printed once, on more than one plate") {
+                REQUIRE(plates.size() > 1);
+                size_t num_instances = 0;
+                for (const Model &plate : plates) {
+                    REQUIRE(plate.objects.size() == 1);
+                    num_instances += plate.objects.front()->instances.size();
+                }
+                REQUIRE(num_instances == 6);
+            }
+            THEN("The cubes are inside the bed") {
+                BoundingBoxf bed_bb(Vec2d(- EPSILON, - EPSILON), Vec2d(50. + EPSILON, 50. + EPSILON));
+                for (const Model &plate : plates) {
+                    BoundingBoxf3 bb = plate.bounding_box();
+                    REQUIRE(bed_bb.contains(Vec2d(bb.min.x(), bb.min.y())));
+                    REQUIRE(bed_bb.contains(Vec2d(bb.max.x(), bb.max.y())));
+                }
+            }
+            THEN("The plates share the mesh of the model") {
+                for (const Model &plate : plates)
+                    REQUIRE(plate.objects.front()->volumes.front()->get_mesh_shared_ptr() == model_object->volumes.front()->get_mesh_shared_ptr());
+            }
+        }
+    }
+}
+
+SCENARIO("Many identical items arranged on a lattice", "[Model]") {
+    GIVEN("40 identical triangles, too many for a 100x100 bed") {
+        const BoundingBox bed(Point(0, 0), Point(scaled(100.), scaled(100.)));
+        const Polygon     triangle { { 0, 0 }, { scaled(30.), 0 }, { scaled(10.), scaled(25.) } };
+        arrangement::ArrangePolygons items(40);
+        for (arrangement::ArrangePolygon &item : items)
+            item.poly = ExPolygon(triangle);
+
+        WHEN("They are arranged") {
+            arrangement::arrange(items, bed, ArrangeParams{ scaled(2.) });
+            THEN("They are all arranged, on several beds") {
+                int max_bed = 0;
+                for (const arrangement::ArrangePolygon &item : items) {
+                    REQUIRE(item.is_arranged());
+                    max_bed = std::max(max_bed, item.bed_idx);
+                }
+                REQUIRE(max_bed > 0);
+            }
+            THEN("They are inside the bed") {
+                for (const arrangement::ArrangePolygon &item : items)
+                    REQUIRE(bed.contains(get_extents(item.transformed_poly())));
+            }
+            THEN("They don't overlap") {
+                for (size_t i = 0; i < items.size(); ++ i)
+                    for (size_t j = i + 1; j < items.size(); ++ j)
+                        if (items[i].bed_idx == items[j].bed_idx)
+                            REQUIRE(intersection_ex(items[i].transformed_poly(), items[j].transformed_poly()).empty());
+            }
+        }
+    }
+}
@@ -6,6 +6,8 @@
 
 #include "test_data.hpp"
 
+#include <boost/filesystem.hpp>
+
 using namespace Slic3r;
 using namespace Slic3r::Test;
 
@@ -102,6 +104,106 @@ SCENARIO("Print: Changing number of solid surfaces does not cause all surfaces t
     }
 }
 
+SCENARIO("Print: Changing the infill of a layer range only refills these layers.", "[Print]") {
+    GIVEN("sliced 20mm cube with a layer range from 10 to 15mm") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "layer_height",       0.25 },
+            { "first_layer_height", 0.25 },
+            { "fill_density",       "20%" },
+            { "fill_pattern",       "rectilinear" }
+            });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        ModelConfig &range_config = model.objects.front()->layer_config_ranges[{ 10., 15. }];
+        range_config.set_key_value("layer_height", new ConfigOptionFloat(0.25));
+        range_config.set_key_value("fill_angle", new ConfigOptionFloat(45.));
+        print.apply(model, config);
+        print.process();
+        auto fill_lengths = [](const Print &print) {
+            std::vector<double> lengths;
+            for (const Layer *layer : print.objects().front()->layers()) {
+                lengths.push_back(0.);
+                for (const LayerRegion *layerm : layer->regions())
+                    lengths.back() += layerm->fills.length();
+            }
+            return lengths;
+        };
+        // The extrusions of the fills of each layer, a layer not filled again keeps them.
+        auto fill_entities = [](const Print &print) {
+            std::vector<std::vector<const ExtrusionEntity*>> entities;
+            for (const Layer *layer : print.objects().front()->layers()) {
+                entities.emplace_back();
+                for (const LayerRegion *layerm : layer->regions())
+                    entities.back().insert(entities.back().end(), layerm->fills.entities().begin(), layerm->fills.entities().end());
+            }
+            return entities;
+        };
+        WHEN("the fill angle of the layer range is changed") {
+            const std::vector<std::vector<const ExtrusionEntity*>> entities_before = fill_entities(print);
+            const std::vector<double>                              lengths_before  = fill_lengths(print);
+            range_config.set_key_value("fill_angle", new ConfigOptionFloat(10.));
+            print.apply(model, config);
+            print.process();
+            THEN("the fills of the layers outside of the range are kept, the ones inside are made again") {
+                const std::vector<std::vector<const ExtrusionEntity*>> entities_after = fill_entities(print);
+                const std::vector<double>                              lengths_after  = fill_lengths(print);
+                const auto layers = print.objects().front()->layers();
+                REQUIRE(entities_after.size() == entities_before.size());
+                size_t num_outside = 0;
+                size_t num_refilled = 0;
+                for (size_t i = 0; i < layers.size(); ++ i)
+                    if (layers[i]->slice_z < 10. - EPSILON || layers[i]->slice_z > 15. + EPSILON) {
+                        ++ num_outside;
+                        REQUIRE(! entities_before[i].empty());
+                        CHECK(entities_after[i] == entities_before[i]);
+                        CHECK(lengths_after[i] == lengths_before[i]);
+                    } else if (entities_after[i] != entities_before[i])
+                        ++ num_refilled;
+                REQUIRE(num_outside > 0);
+                REQUIRE(num_refilled > 0);
+            }
+            THEN("the infill is the same as the one of a print processed from scratch") {
+                Slic3r::Print print_from_scratch;
+                print_from_scratch.apply(model, config);
+                print_from_scratch.process();
+                std::vector<double> lengths = fill_lengths(print);
+                std::vector<double> lengths_from_scratch = fill_lengths(print_from_scratch);
+                REQUIRE(lengths.size() == lengths_from_scratch.size());
+                for (size_t i = 0; i < lengths.size(); ++ i)
+                    CHECK(lengths[i] == Approx(lengths_from_scratch[i]));
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Identical objects are sliced once.", "[Print]") {
+    GIVEN("two 20mm cubes loaded as separate objects") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20, TestMesh::cube_20x20x20}, print, model, config);
+        REQUIRE(print.objects().size() == 2);
+        WHEN("the identical objects are merged") {
+            print.set_merge_identical_objects(true);
+            print.apply(model, config);
+            THEN("a single PrintObject prints the instances of both objects") {
+                REQUIRE(print.objects().size() == 1);
+                REQUIRE(print.objects().front()->instances().size() == 2);
+                REQUIRE(print.objects().front()->instances()[0].model_instance->get_object() != print.objects().front()->instances()[1].model_instance->get_object());
+            }
+            AND_WHEN("the config of one of them is changed") {
+                model.objects.back()->config.set_key_value("perimeters", new ConfigOptionInt(5));
+                print.apply(model, config);
+                THEN("they are sliced separately again") {
+                    REQUIRE(print.objects().size() == 2);
+                }
+            }
+        }
+    }
+}
+
 SCENARIO("Print: Brim generation", "[Print]") {
     GIVEN("20mm cube and default config, 1mm first layer width") {
         WHEN("Brim is set to 3mm")  {
@@ -138,3 +240,93 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: Layers spilled over the memory budget", "[Print]") {
+    auto slice = [](std::initializer_list<TestMesh> meshes, std::initializer_list<Slic3r::ConfigBase::SetDeserializeItem> config_items, size_t budget, bool check_packed) {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print(meshes, print, model, config_items);
+        print.set_layer_memory_budget(budget);
+        print.set_status_silent();
+        print.process();
+        if (check_packed) {
+            const PrintObject *object = print.objects().front();
+            // The first layer is kept in memory for the skirt and brim.
+            REQUIRE(! object->layers().front()->regions().front()->extrusions_packed());
+            REQUIRE(object->layers()[1]->regions().front()->extrusions_packed());
+            REQUIRE(object->layers()[1]->has_extrusions());
+            // The support layers as well.
+            for (size_t idx = 1; idx < object->support_layers().size(); ++ idx)
+                if (object->support_layers()[idx]->has_extrusions())
+                    REQUIRE(object->support_layers()[idx]->support_fills.empty());
+        }
+        std::string gcode = Slic3r::Test::gcode(print);
+        // Drop the time stamp.
+        size_t pos = gcode.find("; generated by");
+        if (pos != std::string::npos)
+            gcode.erase(pos, gcode.find('\n', pos) - pos);
+        return gcode;
+    };
+    GIVEN("20mm cube sliced with and without a layer memory budget") {
+        auto slice_cube = [&slice](size_t budget, bool check_packed) {
+            return slice({ TestMesh::cube_20x20x20 }, { { "layer_height", 0.2 } }, budget, check_packed);
+        };
+        std::string in_memory = slice_cube(0, false);
+        THEN("the layers spilled into the scratch file give the same G-code") {
+            REQUIRE(slice_cube(1, true) == in_memory);
+        }
+        THEN("the layers packed in memory give the same G-code") {
+            REQUIRE(slice_cube(size_t(1) << 30, true) == in_memory);
+        }
+    }
+    GIVEN("20mm cube with automatic speeds sliced with and without a layer memory budget") {
+        // The automatic speed reads the flows of all the layers from their packed paths.
+        auto slice_cube = [&slice](size_t budget, bool check_packed) {
+            return slice({ TestMesh::cube_20x20x20 }, { { "layer_height", 0.2 }, { "perimeter_speed", 0 }, { "infill_speed", 0 },
+                { "solid_infill_speed", 0 }, { "max_print_speed", 80 } }, budget, check_packed);
+        };
+        std::string in_memory = slice_cube(0, false);
+        THEN("the layers spilled into the scratch file give the same G-code") {
+            REQUIRE(slice_cube(1, true) == in_memory);
+        }
+    }
+    GIVEN("Overhang with support sliced with and without a layer memory budget") {
+        // The support generation pages in the bridges of the spilled layers, the support layers are spilled too.
+        auto slice_overhang = [&slice](size_t budget, bool check_packed) {
+            return slice({ TestMesh::overhang }, { { "layer_height", 0.2 }, { "support_material", true } }, budget, check_packed);
+        };
+        std::string in_memory = slice_overhang(0, false);
+        THEN("the layers spilled into the scratch file give the same G-code") {
+            REQUIRE(slice_overhang(1, true) == in_memory);
+        }
+    }
+    GIVEN("Two objects with support sliced with and without a layer memory budget") {
+        // The layers of both objects share the scratch file, ToolOrdering and the G-code export page them in object by object.
+        auto slice_objects = [&slice](size_t budget, bool check_packed) {
+            return slice({ TestMesh::overhang, TestMesh::overhang }, { { "layer_height", 0.2 }, { "support_material", true } }, budget, check_packed);
+        };
+        std::string in_memory = slice_objects(0, false);
+        THEN("the layers spilled into the scratch file give the same G-code") {
+            REQUIRE(slice_objects(1, true) == in_memory);
+        }
+    }
+    GIVEN("A cube whose layers are spilled into the scratch file") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, { { "layer_height", 0.2 } });
+        print.set_layer_memory_budget(1);
+        print.set_status_silent();
+        print.process();
+        const std::string path = print.layer_spill().path();
+        REQUIRE(! path.empty());
+        REQUIRE(boost::filesystem::exists(path));
+        WHEN("the print is applied again") {
+            print.apply(model, print.full_print_config());
+            THEN("the layers are restored and the scratch file is removed") {
+                REQUIRE(print.layer_spill().path().empty());
+                REQUIRE(! boost::filesystem::exists(path));
+                REQUIRE(! print.objects().front()->layers()[1]->regions().front()->extrusions_packed());
+            }
+        }
+    }
+}
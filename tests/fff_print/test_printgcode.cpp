@@ -269,3 +269,28 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+SCENARIO("PrintGCode spooled to the temporary directory", "[PrintGCode]") {
+    GIVEN("20mm cube with the remaining times exported") {
+        auto export_cube = [](bool spool) {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, {
+                { "layer_height",       0.2 },
+                { "remaining_times",    true }
+                });
+            print.set_gcode_spool(spool);
+            std::string gcode = Slic3r::Test::gcode(print);
+            // Drop the time stamp.
+            size_t pos = gcode.find("; generated by");
+            if (pos != std::string::npos)
+                gcode.erase(pos, gcode.find('\n', pos) - pos);
+            return gcode;
+        };
+        std::string in_place = export_cube(false);
+        THEN("the G-code written once with its time estimates is the same") {
+            REQUIRE(in_place.find("M73 P0") != std::string::npos);
+            REQUIRE(export_cube(true) == in_place);
+        }
+    }
+}
@@ -3,6 +3,9 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include <boost/filesystem.hpp>
 
 #include "test_data.hpp"
 
@@ -299,3 +302,106 @@ SCENARIO("PrintObject: minimum horizontal shells", "[PrintObject]") {
 
     }
 }
+
+SCENARIO("PrintObject: lslices edge grids", "[PrintObject]") {
+    GIVEN("20mm cube sliced with default config") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, {});
+        THEN("Each layer has the signed distance field of its lslices") {
+            for (const Layer *layer : print.objects().front()->layers()) {
+                REQUIRE(layer->lslices_grid() != nullptr);
+                double distance;
+                // The center of the cube is 10mm inside of its contour.
+                REQUIRE(layer->lslices_grid()->signed_distance(get_extents(layer->lslices).center(), scale_(20.), distance));
+                REQUIRE(std::abs(unscaled(distance)) == Approx(10.).epsilon(0.01));
+            }
+        }
+        THEN("Each layer has the grid of its lslices for the travels, inflated by SCALED_EPSILON") {
+            for (const Layer *layer : print.objects().front()->layers()) {
+                REQUIRE(layer->lslices_travel_grid() != nullptr);
+                BoundingBox bbox = get_extents(layer->lslices);
+                bbox.offset(SCALED_EPSILON);
+                REQUIRE(layer->lslices_travel_grid()->bbox().contains(bbox.min));
+                REQUIRE(layer->lslices_travel_grid()->bbox().contains(bbox.max));
+            }
+        }
+        THEN("The grids are released after the G-code export and rebuilt by the next one") {
+            std::string gcode1 = Slic3r::Test::gcode(print);
+            for (const Layer *layer : print.objects().front()->layers())
+                REQUIRE((layer->lslices_grid() == nullptr && layer->lslices_travel_grid() == nullptr));
+            REQUIRE(Slic3r::Test::gcode(print) == gcode1);
+        }
+    }
+}
+
+SCENARIO("PrintObject: slicing indices of the volumes", "[PrintObject]") {
+    GIVEN("20mm cube sliced with 0.25mm layers") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "layer_height",       0.25 },
+            { "first_layer_height", 0.25 }
+            });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.process();
+        const ObjectID volume_id = model.objects.front()->volumes.front()->id();
+        const std::shared_ptr<const MeshSlicingIndex> index = print.objects().front()->volume_slicing_index(volume_id);
+        const size_t num_layers = print.objects().front()->layers().size();
+        REQUIRE(index != nullptr);
+        WHEN("the layer height is changed") {
+            config.set_deserialize_strict({ { "layer_height", 0.4 } });
+            print.apply(model, config);
+            print.process();
+            THEN("the volume is sliced again at the new heights with the same index") {
+                REQUIRE(print.objects().front()->layers().size() != num_layers);
+                REQUIRE(print.objects().front()->volume_slicing_index(volume_id) == index);
+            }
+        }
+        WHEN("the volume is rotated") {
+            model.objects.front()->volumes.front()->set_rotation(Vec3d(0., 0., PI / 4.));
+            print.apply(model, config);
+            print.process();
+            THEN("the volume is indexed again") {
+                REQUIRE(print.objects().front()->volume_slicing_index(volume_id) != nullptr);
+                REQUIRE(print.objects().front()->volume_slicing_index(volume_id) != index);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintObject: slices of the regions in the slicing cache", "[PrintObject]") {
+    GIVEN("20mm cube sliced with a cache directory") {
+        const boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        set_slicing_cache_dir(cache_dir.string());
+        auto region_slices = [](const Print &print) {
+            std::vector<ExPolygons> out;
+            for (const Layer *layer : print.objects().front()->layers())
+                for (const LayerRegion *layerm : layer->regions())
+                    out.emplace_back(to_expolygons(layerm->slices().surfaces));
+            return out;
+        };
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, {});
+        THEN("The slices of the volume and the slices of the regions are stored") {
+            size_t nb_entries = 0;
+            for (const boost::filesystem::directory_entry &entry : boost::filesystem::recursive_directory_iterator(cache_dir))
+                if (entry.path().extension() == ".slices")
+                    ++ nb_entries;
+            REQUIRE(nb_entries == 2);
+        }
+        THEN("Slicing it again gives the same slices") {
+            Slic3r::Print print2;
+            Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print2, {});
+            std::vector<ExPolygons> slices  = region_slices(print);
+            std::vector<ExPolygons> slices2 = region_slices(print2);
+            REQUIRE(slices.size() == slices2.size());
+            for (size_t i = 0; i < slices.size(); ++ i) {
+                REQUIRE(slices[i].size() == slices2[i].size());
+                REQUIRE(area(slices[i]) == Approx(area(slices2[i])));
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+        set_slicing_cache_dir(std::string());
+    }
+}
@@ -6,11 +6,15 @@
 #include "libslic3r/Config.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/libslic3r.h"
+#include "libslic3r/SlicingCache.hpp"
+#include "libslic3r/Utils.hpp"
 
 #include <algorithm>
 #include <future>
 #include <chrono>
 
+#include <boost/filesystem/operations.hpp>
+
 //#include "test_options.hpp"
 #include "test_data.hpp"
 
@@ -227,6 +231,65 @@ SCENARIO( "TriangleMesh: slice behavior.") {
     }
 }
 
+SCENARIO( "TriangleMesh: slicing with a MeshSlicingIndex.") {
+    GIVEN( "A sphere, rotated") {
+        indexed_triangle_set sphere = its_make_sphere(10., PI / 50.);
+        Transform3d trafo = Transform3d::Identity();
+        trafo.rotate(Eigen::AngleAxisd(0.3, Vec3d::UnitX()));
+        std::vector<float> zs;
+        for (float z = -9.95f; z < 10.f; z += 0.1f)
+            zs.emplace_back(z);
+        MeshSlicingParamsEx params;
+        params.trafo = trafo;
+        const MeshSlicingIndex index(sphere, trafo);
+        WHEN("It is sliced with and without the index") {
+            std::vector<ExPolygons> slices         = slice_mesh_ex(sphere, zs, params);
+            std::vector<ExPolygons> slices_indexed = slice_mesh_ex(index, zs, params);
+            THEN( "The slices are the same") {
+                REQUIRE(slices.size() == slices_indexed.size());
+                for (size_t i = 0; i < zs.size(); ++ i) {
+                    REQUIRE(slices[i].size() == slices_indexed[i].size());
+                    REQUIRE(area(slices[i]) == Approx(area(slices_indexed[i])));
+                }
+            }
+        }
+        WHEN("The index is reused with other zs") {
+            std::vector<float> zs2 { -5.f, 0.f, 5.f };
+            std::vector<ExPolygons> slices         = slice_mesh_ex(sphere, zs2, params);
+            std::vector<ExPolygons> slices_indexed = slice_mesh_ex(index, zs2, params);
+            THEN( "The slices are the same") {
+                for (size_t i = 0; i < zs2.size(); ++ i)
+                    REQUIRE(area(slices[i]) == Approx(area(slices_indexed[i])));
+            }
+        }
+    }
+}
+
+SCENARIO( "SlicingCache: the slices are stored and loaded back.") {
+    GIVEN( "A sphere sliced with a cache directory") {
+        const boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        set_slicing_cache_dir(cache_dir.string());
+        indexed_triangle_set sphere = its_make_sphere(10., PI / 50.);
+        std::vector<float> zs { -5.f, 0.f, 5.f };
+        MeshSlicingParamsEx params;
+        std::vector<ExPolygons> slices = slice_mesh_ex(sphere, zs, params);
+        const std::string key = SlicingCache::key(sphere, zs, params);
+        WHEN("The slices are stored") {
+            SlicingCache::store(key, slices);
+            std::vector<ExPolygons> loaded;
+            THEN("They are loaded back") {
+                REQUIRE(SlicingCache::load(key, loaded));
+                REQUIRE(loaded == slices);
+            }
+            THEN("They aren't loaded for other slicing heights") {
+                REQUIRE(! SlicingCache::load(SlicingCache::key(sphere, { -5.f, 0.f }, params), loaded));
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+        set_slicing_cache_dir(std::string());
+    }
+}
+
 SCENARIO( "make_xxx functions produce meshes.") {
     GIVEN("make_cube() function") {
         WHEN("make_cube() is called with arguments 20,20,20") {
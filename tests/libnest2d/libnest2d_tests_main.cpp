@@ -658,6 +658,30 @@ TEST_CASE("EmptyItemShouldBeUntouched", "[Nesting]") {
     for (auto &itm : items) REQUIRE(itm.binId() == BIN_ID_UNSET);
 }
 
+TEST_CASE("NfpCacheShouldNotChangeTheArrangement", "[Nesting]") {
+    auto bin = Box(250000000, 210000000);
+
+    std::vector<Item> reference(prusaParts().begin(), prusaParts().begin() + 20);
+    NestConfig<> cfg;
+    libnest2d::nest(reference, bin, 0, cfg);
+
+    // Once the cache is filled and once reading from it.
+    auto cache = std::make_shared<placers::NfpCache<PolygonImpl>>();
+    cfg.placer_config.nfp_cache = cache;
+    for (int run = 0; run < 2; ++run) {
+        std::vector<Item> input(prusaParts().begin(), prusaParts().begin() + 20);
+        libnest2d::nest(input, bin, 0, cfg);
+
+        REQUIRE(cache->size() > 0u);
+        for (size_t i = 0; i < input.size(); ++i) {
+            REQUIRE(input[i].binId() == reference[i].binId());
+            REQUIRE(getX(input[i].translation()) == getX(reference[i].translation()));
+            REQUIRE(getY(input[i].translation()) == getY(reference[i].translation()));
+            REQUIRE(double(input[i].rotation()) == Approx(double(reference[i].rotation())));
+        }
+    }
+}
+
 TEST_CASE("LargeItemShouldBeUntouched", "[Nesting]") {
     auto bin = Box(250000000, 210000000); // dummy bin
 
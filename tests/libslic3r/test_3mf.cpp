@@ -131,3 +131,46 @@ SCENARIO("2D convex hull of sinking object", "[3mf]") {
     }
 }
 
+
+SCENARIO("Export+Import of several objects to/from 3mf file with the compression levels", "[3mf]") {
+    GIVEN("a model with several objects and instances") {
+        Model src_model;
+        for (int i = 0; i < 8; ++ i) {
+            ModelObject *object = src_model.add_object();
+            object->name = "object_" + std::to_string(i);
+            object->add_volume(i % 2 == 0 ? TriangleMesh(its_make_sphere(10. + i, PI / 64.)) : TriangleMesh(its_make_cube(10. + i, 20., 30.)));
+            for (int j = 0; j <= i % 3; ++ j)
+                object->add_instance()->set_offset(Vec3d(40. * i, 40. * j, 0.));
+        }
+
+        for (int level : { 0, 1, -1 }) {
+            WHEN("model is saved+loaded to/from 3mf file with the compression level " + std::to_string(level)) {
+                std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/compression.3mf";
+                bool saved = store_3mf(test_file.c_str(), &src_model, nullptr, OptionStore3mf{}.set_fullpath_sources(false).set_compression_level(level));
+
+                Model dst_model;
+                DynamicPrintConfig dst_config;
+                bool loaded = false;
+                {
+                    ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                    loaded = load_3mf(test_file.c_str(), dst_config, ctxt, &dst_model, false);
+                }
+                boost::filesystem::remove(test_file);
+
+                THEN("the objects are loaded back in the same order with the same meshes") {
+                    REQUIRE(saved);
+                    REQUIRE(loaded);
+                    REQUIRE(dst_model.objects.size() == src_model.objects.size());
+                    for (size_t i = 0; i < src_model.objects.size(); ++ i) {
+                        const ModelObject &src = *src_model.objects[i];
+                        const ModelObject &dst = *dst_model.objects[i];
+                        REQUIRE(dst.instances.size() == src.instances.size());
+                        REQUIRE(dst.volumes.size() == 1);
+                        REQUIRE(dst.volumes.front()->mesh().its.indices.size() == src.volumes.front()->mesh().its.indices.size());
+                        REQUIRE(dst.volumes.front()->mesh().its.vertices.size() == src.volumes.front()->mesh().its.vertices.size());
+                    }
+                }
+            }
+        }
+    }
+}
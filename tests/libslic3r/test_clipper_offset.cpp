@@ -212,3 +212,45 @@ SCENARIO("Constant offset", "[ClipperUtils]") {
 		}
 	}
 }
+
+SCENARIO("Clipper with a memory arena", "[ClipperUtils]") {
+	int32_t s = 1000000;
+	GIVEN("A square with a hole and a shifted square") {
+		ClipperLib::Path square { { 0, 0 }, { 20 * s, 0 }, { 20 * s, 20 * s }, { 0, 20 * s } };
+		ClipperLib::Path hole   { { 5 * s, 5 * s }, { 5 * s, 15 * s }, { 15 * s, 15 * s }, { 15 * s, 5 * s } };
+		ClipperLib::Path square2 { { 10 * s, 10 * s }, { 30 * s, 10 * s }, { 30 * s, 30 * s }, { 10 * s, 30 * s } };
+		auto clip = [&](ClipperLib::MemoryArena *arena) {
+			ClipperLib::Clipper clipper(0, arena);
+			clipper.AddPaths(ClipperLib::Paths{ square, hole }, ClipperLib::ptSubject, true);
+			clipper.AddPath(square2, ClipperLib::ptClip, true);
+			ClipperLib::Paths out;
+			clipper.Execute(ClipperLib::ctUnion, out, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+			return out;
+		};
+		auto offset = [&](ClipperLib::MemoryArena *arena) {
+			ClipperLib::ClipperOffset co(arena);
+			co.AddPaths(ClipperLib::Paths{ square, hole }, ClipperLib::jtRound, ClipperLib::etClosedPolygon);
+			ClipperLib::Paths out;
+			co.Execute(out, 1. * s);
+			return out;
+		};
+		ClipperLib::MemoryArena arena;
+		WHEN("Clipping and offsetting with and without the arena") {
+			THEN("The results are the same") {
+				REQUIRE(clip(&arena) == clip(nullptr));
+				REQUIRE(offset(&arena) == offset(nullptr));
+			}
+			THEN("The arena memory is reused by the next operations") {
+				clip(&arena);
+				offset(&arena);
+				size_t capacity = arena.Capacity();
+				REQUIRE(capacity > 0);
+				for (int i = 0; i < 100; ++ i) {
+					clip(&arena);
+					offset(&arena);
+				}
+				REQUIRE(arena.Capacity() == capacity);
+			}
+		}
+	}
+}
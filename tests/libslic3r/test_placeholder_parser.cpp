@@ -121,3 +121,14 @@ SCENARIO("Placeholder parser scripting", "[PlaceholderParser]") {
     SECTION("complex expression2") { REQUIRE(boolean_expression("printer_notes=~/.*PRINTER_VEwerfNDOR_PRUSA3D.*/ or printer_notes=~/.*PRINTertER_MODEL_MK2.*/ or (nozzle_diameter[0]==0.6 and num_extruders>1)")); }
     SECTION("complex expression3") { REQUIRE(! boolean_expression("printer_notes=~/.*PRINTER_VEwerfNDOR_PRUSA3D.*/ or printer_notes=~/.*PRINTertER_MODEL_MK2.*/ or (nozzle_diameter[0]==0.3 and num_extruders>1)")); }
 }
+
+SCENARIO("Placeholder parser checked variables", "[PlaceholderParser]") {
+    PlaceholderParser parser;
+    PlaceholderParser other;
+    // exists() creates a stub of a missing variable, only for the parser which checked it.
+    REQUIRE(parser.process("{exists(not_a_variable)}") == "false");
+    REQUIRE(parser.process("{not_a_variable}") == "false");
+    REQUIRE_THROWS(other.process("{not_a_variable}"));
+    parser.reset();
+    REQUIRE_THROWS(parser.process("{not_a_variable}"));
+}
@@ -9,6 +9,14 @@
 #include <libslic3r/TriangleMeshSlicer.hpp>
 #include <libslic3r/SLA/SupportTreeMesher.hpp>
 #include <libslic3r/SLA/Concurrency.hpp>
+#include <libslic3r/Format/Format.hpp>
+#include <libslic3r/Format/SLAArchive.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/miniz_extension.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
 
 namespace {
 
@@ -242,3 +250,57 @@ TEST_CASE("Test concurrency")
 
     REQUIRE(s == Approx(ref));
 }
+
+// Uncompressed content of the png entries of a zip archive, by name.
+static std::map<std::string, std::string> read_png_entries(const std::string &path)
+{
+    std::map<std::string, std::string> out;
+    MZ_Archive zip;
+    REQUIRE(open_zip_reader(&zip.arch, path));
+    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&zip.arch); ++ i) {
+        mz_zip_archive_file_stat entry;
+        REQUIRE(mz_zip_reader_file_stat(&zip.arch, i, &entry));
+        std::string name = entry.m_filename;
+        if (boost::iends_with(name, ".png")) {
+            std::string data(size_t(entry.m_uncomp_size), '\0');
+            REQUIRE(mz_zip_reader_extract_file_to_mem(&zip.arch, entry.m_filename, data.data(), data.size(), 0));
+            out.emplace(std::move(name), std::move(data));
+        }
+    }
+    close_zip_reader(&zip.arch);
+    return out;
+}
+
+TEST_CASE("Streamed archive export gives the same layers", "[SLARasterOutput]")
+{
+    // Export the layers rasterized by the print (budget 0) or rasterized while the archive is written.
+    auto export_archive = [](size_t streaming_budget, const std::string &path) {
+        SLAFullPrintConfig fullcfg;
+        fullcfg.printer_technology.value = ptSLA;
+        fullcfg.supports_enable.value    = false;
+        fullcfg.pad_enable.value         = false;
+        DynamicPrintConfig cfg;
+        cfg.apply(fullcfg);
+
+        Model model;
+        model.add_object("20mm_cube", "", load_model("20mm_cube.obj"))->add_instance();
+        model.center_instances_around_point(BoundingBoxf(fullcfg.bed_shape.values).center());
+
+        std::shared_ptr<SLAAbstractArchive> archive = get_output_format(cfg);
+        archive->set_streaming(streaming_budget);
+        SLAPrint print;
+        print.set_printer(archive);
+        print.set_status_callback([](const PrintBase::SlicingStatus&) {});
+        print.apply(model, cfg);
+        print.process();
+        archive->export_print(path, print, "cube");
+        return read_png_entries(path);
+    };
+    const std::string path = boost::filesystem::unique_path().string() + ".sl1";
+    std::map<std::string, std::string> rasterized = export_archive(0, path);
+    // Small budget: a few layers in flight only.
+    std::map<std::string, std::string> streamed   = export_archive(size_t(1) << 20, path);
+    boost::nowide::remove(path.c_str());
+    REQUIRE(rasterized.size() > 10);
+    REQUIRE(streamed == rasterized);
+}